@@ -0,0 +1,229 @@
+//
+// Benchmark.cpp - Runs the kernel and queue benchmarks and compares them with a saved baseline
+//
+// Results are written as Google Benchmark-style JSON, one benchmark per line, so two runs diff
+// cleanly. --baseline compares real_time per benchmark and fails when any is slower by more than
+// --threshold (10% by default).
+//
+
+#include "ToolMain.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_DefaultThreshold = 0.10;
+
+    // Exit code when a benchmark regressed, distinct from tool errors.
+    constexpr int c_RegressionExitCode = 2;
+
+    struct BenchmarkResult
+    {
+        std::string name;
+        uint64_t    iterations;
+        double      nanoseconds;        // Wall time per iteration.
+        double      bytesPerSecond;
+        double      itemsPerSecond;
+    };
+
+    // "1,4,8" -> {1, 4, 8}, duplicates removed.
+    std::vector<uint32_t> ParseThreadList(const std::string& text)
+    {
+        std::vector<uint32_t> threads;
+        const char* cursor = text.c_str();
+        while (*cursor != '\0')
+        {
+            char* end = nullptr;
+            const unsigned long value = strtoul(cursor, &end, 10);
+            if (end == cursor || value == 0)
+                throw std::runtime_error("--threads expects a comma separated list of positive counts");
+            threads.push_back(static_cast<uint32_t>(value));
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        std::sort(threads.begin(), threads.end());
+        threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+        return threads;
+    }
+
+    BenchmarkResult RunRepetitions(const std::string& name, const BenchmarkDefinition& definition,
+        uint32_t width, uint32_t height, SimdTier tier, uint32_t threads, double minSeconds, uint32_t repetitions)
+    {
+        // The median repetition is reported; it shrugs off a single descheduled run.
+        std::vector<BenchmarkResult> runs;
+        for (uint32_t r = 0; r < repetitions; r++)
+        {
+            BenchmarkState state(width, height, tier, threads, minSeconds);
+            definition.run(state);
+
+            const double seconds = std::max(state.Seconds(), 1e-12);
+            const double iterations = double(std::max<uint64_t>(1, state.Iterations()));
+            runs.push_back({ name, state.Iterations(), 1e9 * seconds / iterations,
+                double(state.BytesPerIteration()) * iterations / seconds,
+                double(state.ItemsPerIteration()) * iterations / seconds });
+        }
+
+        std::sort(runs.begin(), runs.end(), [](const BenchmarkResult& a, const BenchmarkResult& b) { return a.nanoseconds < b.nanoseconds; });
+        return runs[runs.size() / 2];
+    }
+
+    bool WriteJson(const std::string& path, const std::vector<BenchmarkResult>& results, double minSeconds, uint32_t repetitions)
+    {
+        FILE* file = nullptr;
+#ifdef _WIN32
+        fopen_s(&file, path.c_str(), "wb");
+#else
+        file = fopen(path.c_str(), "wb");
+#endif
+        if (file == nullptr)
+            return false;
+
+        fprintf(file, "{\n  \"context\": {\"num_cpus\": %u, \"best_simd\": \"%s\", \"min_time\": %g, \"repetitions\": %u},\n  \"benchmarks\": [\n",
+            std::thread::hardware_concurrency(), SimdTierName(BestSimdTier()), minSeconds, repetitions);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchmarkResult& result = results[i];
+            fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"real_time\": %.1f, \"time_unit\": \"ns\", \"bytes_per_second\": %.0f, \"items_per_second\": %.0f}%s\n",
+                result.name.c_str(), static_cast<unsigned long long>(result.iterations), result.nanoseconds,
+                result.bytesPerSecond, result.itemsPerSecond, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+
+        const bool written = ferror(file) == 0;
+        fclose(file);
+        return written;
+    }
+
+    // Reads the name and real_time of each line WriteJson produced; other JSON layouts are not supported.
+    std::map<std::string, double> ReadBaseline(const std::string& path)
+    {
+        FILE* file = nullptr;
+#ifdef _WIN32
+        fopen_s(&file, path.c_str(), "rb");
+#else
+        file = fopen(path.c_str(), "rb");
+#endif
+        if (file == nullptr)
+            throw std::runtime_error("Cannot open " + path);
+
+        std::map<std::string, double> baseline;
+        char line[1024];
+        while (fgets(line, sizeof(line), file) != nullptr)
+        {
+            const char* name = strstr(line, "\"name\": \"");
+            const char* time = strstr(line, "\"real_time\": ");
+            if (name == nullptr || time == nullptr)
+                continue;
+
+            name += strlen("\"name\": \"");
+            const char* nameEnd = strchr(name, '"');
+            if (nameEnd != nullptr)
+                baseline[std::string(name, nameEnd)] = strtod(time + strlen("\"real_time\": "), nullptr);
+        }
+        fclose(file);
+        return baseline;
+    }
+}
+
+int DX::BenchMain(const ToolArgs& args)
+{
+    const std::string filter = args.Get("filter");
+    const double minSeconds = args.GetNumber("min-time", 0.1);
+    const uint32_t repetitions = std::max(1u, args.GetUInt("repetitions", 3));
+    const double threshold = args.GetNumber("threshold", c_DefaultThreshold);
+
+    const std::vector<uint32_t> threadCounts = ParseThreadList(
+        args.Get("threads", "1," + std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+
+    std::vector<SimdTier> tiers = { SimdTier::Scalar };
+    if (BestSimdTier() != SimdTier::Scalar)
+        tiers.push_back(BestSimdTier());
+
+    std::vector<BenchmarkResult> results;
+    for (auto const& definition : KernelBenchmarks())
+    {
+        const bool sized = (definition.axes & BenchmarkSized) != 0;
+        const bool tiered = (definition.axes & BenchmarkTiered) != 0;
+        const bool threaded = (definition.axes & BenchmarkThreaded) != 0;
+
+        for (size_t s = 0; s < (sized ? std::size(c_BenchmarkSizes) : 1); s++)
+        {
+            for (size_t t = 0; t < (tiered ? tiers.size() : 1); t++)
+            {
+                for (size_t c = 0; c < (threaded ? threadCounts.size() : 1); c++)
+                {
+                    const BenchmarkSize& size = c_BenchmarkSizes[sized ? s : 1];
+                    const SimdTier tier = tiered ? tiers[t] : BestSimdTier();
+                    const uint32_t threads = threaded ? threadCounts[c] : 1;
+
+                    std::string name = definition.name;
+                    if (sized)
+                        name += std::string("/") + size.name;
+                    if (tiered)
+                        name += std::string("/") + SimdTierName(tier);
+                    if (threaded)
+                        name += "/threads:" + std::to_string(threads);
+                    if (!filter.empty() && name.find(filter) == std::string::npos)
+                        continue;
+
+                    results.push_back(RunRepetitions(name, definition, size.width, size.height, tier, threads, minSeconds, repetitions));
+                    const BenchmarkResult& result = results.back();
+                    printf("%-48s %14.1f ns %10llu iterations", name.c_str(), result.nanoseconds, static_cast<unsigned long long>(result.iterations));
+                    if (result.bytesPerSecond > 0.0)
+                        printf(" %10.1f MB/s", result.bytesPerSecond / 1e6);
+                    if (result.itemsPerSecond > 0.0)
+                        printf(" %10.1f M items/s", result.itemsPerSecond / 1e6);
+                    printf("\n");
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+    if (results.empty())
+        throw std::runtime_error("No benchmark matches --filter " + filter);
+
+    const std::string output = args.Get("out");
+    if (!output.empty())
+    {
+        if (!WriteJson(output, results, minSeconds, repetitions))
+            throw std::runtime_error("Cannot write " + output);
+        printf("bench: wrote %zu results to %s\n", results.size(), output.c_str());
+    }
+
+    const std::string baselinePath = args.Get("baseline");
+    if (baselinePath.empty())
+        return 0;
+
+    const std::map<std::string, double> baseline = ReadBaseline(baselinePath);
+    size_t compared = 0;
+    size_t regressions = 0;
+    for (auto const& result : results)
+    {
+        auto previous = baseline.find(result.name);
+        if (previous == baseline.end() || previous->second <= 0.0)
+            continue;
+
+        compared++;
+        const double change = result.nanoseconds / previous->second - 1.0;
+        if (change > threshold)
+        {
+            printf("REGRESSION %-37s %14.1f ns -> %.1f ns (%+.1f%%)\n", result.name.c_str(), previous->second, result.nanoseconds, 100.0 * change);
+            regressions++;
+        }
+    }
+
+    printf("bench: %zu of %zu benchmarks compared with %s, %zu slower by more than %.0f%%\n",
+        compared, results.size(), baselinePath.c_str(), regressions, 100.0 * threshold);
+    return regressions == 0 ? 0 : c_RegressionExitCode;
+}
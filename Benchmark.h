@@ -0,0 +1,146 @@
+//
+// Benchmark.h - Minimal Google Benchmark-style harness for the CPU kernels and queues
+//
+
+#pragma once
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    struct BenchmarkSize
+    {
+        const char* name;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    constexpr BenchmarkSize c_BenchmarkSizes[] =
+    {
+        { "540p",  960,  540 },
+        { "1080p", 1920, 1080 },
+        { "1440p", 2560, 1440 },
+    };
+
+    // The parameters a benchmark varies over; each run gets one combination.
+    enum BenchmarkAxes : uint32_t
+    {
+        BenchmarkFixed = 0,
+        BenchmarkSized = 1,
+        BenchmarkTiered = 2,
+        BenchmarkThreaded = 4,
+    };
+
+    // Passed to each benchmark body, which loops on KeepRunning like Google Benchmark's State.
+    class BenchmarkState
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        BenchmarkState(uint32_t width, uint32_t height, SimdTier tier, uint32_t threads, double minSeconds) :
+            m_width(width), m_height(height), m_tier(tier), m_threads(threads), m_minSeconds(minSeconds) {}
+
+        uint32_t Width() const noexcept { return m_width; }
+        uint32_t Height() const noexcept { return m_height; }
+        SimdTier Tier() const noexcept { return m_tier; }
+        uint32_t Threads() const noexcept { return m_threads; }
+
+        // The first iteration is an untimed warm-up; timing then runs until minSeconds have passed.
+        bool KeepRunning()
+        {
+            const auto now = Clock::now();
+            if (!m_warmedUp)
+            {
+                m_warmedUp = true;
+                return true;
+            }
+            if (!m_timing)
+            {
+                m_timing = true;
+                m_start = now;
+                return true;
+            }
+
+            m_iterations++;
+            const double elapsed = std::chrono::duration<double>(now - m_start).count() - m_pausedSeconds;
+            if (elapsed < m_minSeconds)
+                return true;
+
+            m_seconds = elapsed;
+            return false;
+        }
+
+        // Keep per-iteration setup out of the measurement.
+        void PauseTiming() { m_pauseStart = Clock::now(); }
+        void ResumeTiming() { m_pausedSeconds += std::chrono::duration<double>(Clock::now() - m_pauseStart).count(); }
+
+        void SetBytesProcessed(uint64_t bytesPerIteration) noexcept { m_bytesPerIteration = bytesPerIteration; }
+        void SetItemsProcessed(uint64_t itemsPerIteration) noexcept { m_itemsPerIteration = itemsPerIteration; }
+
+        uint64_t Iterations() const noexcept { return m_iterations; }
+        double Seconds() const noexcept { return m_seconds; }
+        uint64_t BytesPerIteration() const noexcept { return m_bytesPerIteration; }
+        uint64_t ItemsPerIteration() const noexcept { return m_itemsPerIteration; }
+
+    private:
+        uint32_t            m_width;
+        uint32_t            m_height;
+        SimdTier            m_tier;
+        uint32_t            m_threads;
+        double              m_minSeconds;
+        bool                m_warmedUp = false;
+        bool                m_timing = false;
+        Clock::time_point   m_start;
+        Clock::time_point   m_pauseStart;
+        double              m_pausedSeconds = 0.0;
+        double              m_seconds = 0.0;
+        uint64_t            m_iterations = 0;
+        uint64_t            m_bytesPerIteration = 0;
+        uint64_t            m_itemsPerIteration = 0;
+    };
+
+    struct BenchmarkDefinition
+    {
+        const char* name;
+        uint32_t axes;
+        void (*run)(BenchmarkState& state);
+    };
+
+    // Every registered kernel and queue benchmark, defined in Benchmarks.cpp.
+    const std::vector<BenchmarkDefinition>& KernelBenchmarks();
+
+    // Split [0, count) into one contiguous chunk per thread; the calling thread takes the first.
+    template<typename TWork>
+    void ParallelFor(uint32_t count, uint32_t threads, const TWork& work)
+    {
+        threads = std::max(1u, std::min(threads, count));
+        const uint32_t chunk = (count + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (uint32_t t = 1; t < threads; t++)
+        {
+            const uint32_t first = std::min(count, t * chunk);
+            const uint32_t last = std::min(count, first + chunk);
+            workers.emplace_back([&work, first, last] { work(first, last); });
+        }
+        work(0u, std::min(count, chunk));
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // Keep a result alive so the optimiser can't drop the work that produced it.
+    template<typename T>
+    void DoNotOptimize(T value) noexcept
+    {
+        static volatile T sink;
+        sink = value;
+        (void)sink;
+    }
+}
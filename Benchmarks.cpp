@@ -0,0 +1,563 @@
+//
+// Benchmarks.cpp - Benchmarks for every CPU kernel and queue downstream of GetFrame
+//
+
+#include "Benchmark.h"
+#include "CaptureRing.h"
+#include "ColorConvert.h"
+#include "CursorShape.h"
+#include "FenceTimeline.h"
+#include "FrameConvert.h"
+#include "FrameInterpolator.h"
+#include "LatencyTracker.h"
+#include "Nv12Convert.h"
+#include "QualityMetrics.h"
+#include "ReadbackRing.h"
+#include "Resampler.h"
+#include "TexturePool.h"
+#include "Trace.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Queue benchmarks time batches so the clock read doesn't dominate.
+    constexpr uint32_t c_QueueBatch = 1000;
+
+    // Motion between the two synthetic frames, in pixels.
+    constexpr int c_MotionX = 6;
+    constexpr int c_MotionY = 2;
+
+    // Smooth, textured RGBA so motion search and SSIM see realistic gradients.
+    void FillFrame(ImageView view, int offsetX = 0, int offsetY = 0)
+    {
+        for (uint32_t y = 0; y < view.height; y++)
+        {
+            uint8_t* row = view.Row(y);
+            for (uint32_t x = 0; x < view.width; x++)
+            {
+                const int sx = int(x) + offsetX;
+                const int sy = int(y) + offsetY;
+                const uint32_t hash = uint32_t(sx / 8) * 73856093u ^ uint32_t(sy / 8) * 19349663u;
+                row[x * 4 + 0] = uint8_t((sx * 3 + (hash & 63)) & 0xFF);
+                row[x * 4 + 1] = uint8_t((sy * 2 + ((hash >> 6) & 63)) & 0xFF);
+                row[x * 4 + 2] = uint8_t(((sx + sy) + ((hash >> 12) & 63)) & 0xFF);
+                row[x * 4 + 3] = 0xFF;
+            }
+        }
+    }
+
+    // White of the SDR desktop the synthetic frames stand for, in formats with more range than rgba8.
+    constexpr float c_SdrWhiteNits = 200.0f;
+
+    // A synthetic frame in a format, converted from the rgba8 one as the capture pass would.
+    template<typename TPixel>
+    Image FormatFrame(uint32_t width, uint32_t height, int offsetX = 0, int offsetY = 0)
+    {
+        Image rgba(width, height, 4);
+        FillFrame(rgba.View(), offsetX, offsetY);
+        if constexpr (TPixel::Format == PixelFormat::Rgba8)
+            return rgba;
+        Image frame(width, height, TPixel::Bytes);
+        ConvertFromRgba8<TPixel>(rgba.View(), frame.View(), c_SdrWhiteNits);
+        return frame;
+    }
+
+    // The synthetic frame in nv12, converted as the capture pass would.
+    Image Nv12Frame(uint32_t width, uint32_t height, int offsetX = 0, int offsetY = 0)
+    {
+        Image rgba(width, height, 4);
+        FillFrame(rgba.View(), offsetX, offsetY);
+        Image frame(width, PixelFormatRows(PixelFormat::Nv12, height), 1);
+        ConvertRgba8ToNv12(rgba.View(), frame.View());
+        return frame;
+    }
+
+    ImageView RowSlice(ImageView view, uint32_t first, uint32_t last) noexcept
+    {
+        return { view.Row(first), view.width, last - first, view.pitch };
+    }
+
+    uint64_t FrameBytes(const BenchmarkState& state, uint32_t bytesPerPixel = 4) noexcept
+    {
+        return uint64_t(state.Width()) * state.Height() * bytesPerPixel;
+    }
+
+    CpuInterpolatorSettings InterpolatorSettings(const BenchmarkState& state)
+    {
+        CpuInterpolatorSettings settings;
+        settings.tier = state.Tier();
+        settings.threads = state.Threads();
+        return settings;
+    }
+
+    template<typename TPixel>
+    void BenchComputeLuma(BenchmarkState& state)
+    {
+        Image frame = FormatFrame<TPixel>(state.Width(), state.Height());
+        Image luma(state.Width(), state.Height(), 1);
+        while (state.KeepRunning())
+        {
+            ParallelFor(state.Height(), state.Threads(), [&](uint32_t first, uint32_t last) {
+                Kernels::ComputeLuma<TPixel>(RowSlice(frame.View(), first, last), RowSlice(luma.View(), first, last), state.Tier());
+            });
+        }
+        state.SetBytesProcessed(FrameBytes(state, TPixel::Bytes));
+    }
+
+    void BenchBlockSAD(BenchmarkState& state)
+    {
+        Image a(state.Width(), state.Height(), 1);
+        Image b(state.Width(), state.Height(), 1);
+        for (uint32_t y = 0; y < state.Height(); y++)
+        {
+            for (uint32_t x = 0; x < state.Width(); x++)
+            {
+                a.View().Row(y)[x] = uint8_t(x * 7 + y * 3);
+                b.View().Row(y)[x] = uint8_t(x * 7 + y * 3 + 5);
+            }
+        }
+
+        const uint32_t blocksY = state.Height() / 16;
+        while (state.KeepRunning())
+        {
+            ParallelFor(blocksY, state.Threads(), [&](uint32_t first, uint32_t last) {
+                uint32_t sum = 0;
+                for (uint32_t by = first; by < last; by++)
+                {
+                    for (uint32_t x = 0; x + 16 <= state.Width(); x += 16)
+                        sum += Kernels::BlockSAD(a.View().Row(by * 16) + x, a.Pitch(), b.View().Row(by * 16) + x, b.Pitch(), 16, 16, state.Tier());
+                }
+                DoNotOptimize(sum);
+            });
+        }
+        state.SetBytesProcessed(uint64_t(state.Width()) * state.Height() * 2);
+    }
+
+    void BenchEstimateMotion(BenchmarkState& state)
+    {
+        Image previous(state.Width(), state.Height(), 4), current(state.Width(), state.Height(), 4);
+        Image previousLuma(state.Width(), state.Height(), 1), currentLuma(state.Width(), state.Height(), 1);
+        FillFrame(previous.View());
+        FillFrame(current.View(), -c_MotionX, -c_MotionY);
+        Kernels::ComputeLuma(previous.View(), previousLuma.View(), state.Tier());
+        Kernels::ComputeLuma(current.View(), currentLuma.View(), state.Tier());
+
+        const CpuInterpolatorSettings settings = InterpolatorSettings(state);
+        const uint32_t blocksX = (state.Width() + settings.blockSize - 1) / settings.blockSize;
+        const uint32_t blocksY = (state.Height() + settings.blockSize - 1) / settings.blockSize;
+        std::vector<MotionVector> field(size_t(blocksX) * blocksY);
+        while (state.KeepRunning())
+        {
+            // Start cold each time so the coarse search runs as it does on a scene change.
+            state.PauseTiming();
+            std::fill(field.begin(), field.end(), MotionVector{});
+            state.ResumeTiming();
+
+            ParallelFor(blocksY, state.Threads(), [&](uint32_t first, uint32_t last) {
+                Kernels::EstimateMotion(previousLuma.View(), currentLuma.View(), field, settings, first, last);
+            });
+        }
+        state.SetBytesProcessed(uint64_t(state.Width()) * state.Height() * 2);
+    }
+
+    template<typename TPixel>
+    void BenchComposeMidpoint(BenchmarkState& state)
+    {
+        Image previous = FormatFrame<TPixel>(state.Width(), state.Height());
+        Image current = FormatFrame<TPixel>(state.Width(), state.Height(), -c_MotionX, -c_MotionY);
+        Image output(state.Width(), state.Height(), TPixel::Bytes);
+
+        // Half of the true motion, kept inside the frame by leaving the edge blocks still.
+        const CpuInterpolatorSettings settings = InterpolatorSettings(state);
+        const uint32_t blocksX = (state.Width() + settings.blockSize - 1) / settings.blockSize;
+        const uint32_t blocksY = (state.Height() + settings.blockSize - 1) / settings.blockSize;
+        std::vector<MotionVector> field(size_t(blocksX) * blocksY);
+        for (uint32_t by = 1; by + 1 < blocksY; by++)
+        {
+            for (uint32_t bx = 1; bx + 1 < blocksX; bx++)
+                field[size_t(by) * blocksX + bx] = { int16_t(c_MotionX / 2), int16_t(c_MotionY / 2), 0 };
+        }
+
+        while (state.KeepRunning())
+        {
+            ParallelFor(blocksY, state.Threads(), [&](uint32_t first, uint32_t last) {
+                Kernels::ComposeMidpoint<TPixel>(previous.View(), current.View(), field, settings, output.View(), first, last);
+            });
+        }
+        state.SetBytesProcessed(FrameBytes(state, TPixel::Bytes) * 3);
+    }
+
+    template<typename TPixel>
+    void BenchInterpolator(BenchmarkState& state)
+    {
+        Image frames[2] = { FormatFrame<TPixel>(state.Width(), state.Height()), FormatFrame<TPixel>(state.Width(), state.Height(), -c_MotionX, -c_MotionY) };
+        Image output(state.Width(), state.Height(), TPixel::Bytes);
+
+        CpuInterpolatorSettings settings = InterpolatorSettings(state);
+        settings.format = TPixel::Format;
+        CpuFrameInterpolator interpolator(settings);
+        interpolator.Process(frames[0].View(), 0.0, output.View(), nullptr);
+        uint32_t next = 1;
+        while (state.KeepRunning())
+        {
+            interpolator.Process(frames[next].View(), 0.0, output.View(), nullptr);
+            next ^= 1;
+        }
+        state.SetBytesProcessed(FrameBytes(state, TPixel::Bytes));
+    }
+
+    void BenchComposeMidpointNv12(BenchmarkState& state)
+    {
+        Image previous = Nv12Frame(state.Width(), state.Height());
+        Image current = Nv12Frame(state.Width(), state.Height(), -c_MotionX, -c_MotionY);
+        Image output(state.Width(), previous.Height(), 1);
+
+        const CpuInterpolatorSettings settings = InterpolatorSettings(state);
+        const uint32_t blocksX = (state.Width() + settings.blockSize - 1) / settings.blockSize;
+        const uint32_t blocksY = (state.Height() + settings.blockSize - 1) / settings.blockSize;
+        std::vector<MotionVector> field(size_t(blocksX) * blocksY);
+        for (uint32_t by = 1; by + 1 < blocksY; by++)
+        {
+            for (uint32_t bx = 1; bx + 1 < blocksX; bx++)
+                field[size_t(by) * blocksX + bx] = { int16_t(c_MotionX / 2), int16_t(c_MotionY / 2), 0 };
+        }
+
+        while (state.KeepRunning())
+        {
+            ParallelFor(blocksY, state.Threads(), [&](uint32_t first, uint32_t last) {
+                Kernels::ComposeMidpointNv12(previous.View(), current.View(), field, settings, output.View(), first, last);
+            });
+        }
+        state.SetBytesProcessed(PixelFormatFrameBytes(PixelFormat::Nv12, state.Width(), state.Height()) * 3);
+    }
+
+    void BenchInterpolatorNv12(BenchmarkState& state)
+    {
+        Image frames[2] = { Nv12Frame(state.Width(), state.Height()), Nv12Frame(state.Width(), state.Height(), -c_MotionX, -c_MotionY) };
+        Image output(state.Width(), frames[0].Height(), 1);
+
+        CpuInterpolatorSettings settings = InterpolatorSettings(state);
+        settings.format = PixelFormat::Nv12;
+        CpuFrameInterpolator interpolator(settings);
+        interpolator.Process(frames[0].View(), 0.0, output.View(), nullptr);
+        uint32_t next = 1;
+        while (state.KeepRunning())
+        {
+            interpolator.Process(frames[next].View(), 0.0, output.View(), nullptr);
+            next ^= 1;
+        }
+        state.SetBytesProcessed(PixelFormatFrameBytes(PixelFormat::Nv12, state.Width(), state.Height()));
+    }
+
+    template<ScaleFilter Filter, typename TPixel>
+    void BenchResampler(BenchmarkState& state)
+    {
+        // Half size, the viewer's default resFactor.
+        Image source = FormatFrame<TPixel>(state.Width(), state.Height());
+        Image destination(state.Width() / 2, state.Height() / 2, TPixel::Bytes);
+
+        Resampler<TPixel> resampler;
+        resampler.Configure(state.Width(), state.Height(), destination.Width(), destination.Height(), Filter);
+        while (state.KeepRunning())
+            resampler.Process(source.View(), destination.View(), state.Tier());
+        state.SetBytesProcessed(FrameBytes(state, TPixel::Bytes));
+    }
+
+    // Bytes are the BGRA desktop's, whatever the format written.
+    template<typename TPixel>
+    void BenchConvertBGRAToRGBA(BenchmarkState& state)
+    {
+        Image source(state.Width(), state.Height(), 4), destination(state.Width() / 2, state.Height() / 2, TPixel::Bytes);
+        FillFrame(source.View());
+        while (state.KeepRunning())
+            ConvertBGRAToRGBA<TPixel>(source.View(), destination.View(), c_SdrWhiteNits);
+        state.SetBytesProcessed(FrameBytes(state));
+    }
+
+    // What recording and the shared output pay per frame for a wider internal format.
+    template<typename TPixel>
+    void BenchConvertToRgba8(BenchmarkState& state)
+    {
+        Image source = FormatFrame<TPixel>(state.Width(), state.Height());
+        Image destination(state.Width(), state.Height(), 4);
+        const Srgb8Encoder encoder(c_SdrWhiteNits);
+        while (state.KeepRunning())
+            ConvertToRgba8<TPixel>(source.View(), destination.View(), encoder);
+        state.SetBytesProcessed(FrameBytes(state, TPixel::Bytes));
+    }
+
+    // Bytes are the rgba8 side's, as for I420, so the two compare directly.
+    void BenchConvertRgba8ToNv12(BenchmarkState& state)
+    {
+        Image source(state.Width(), state.Height(), 4);
+        FillFrame(source.View());
+        Image nv12(state.Width(), PixelFormatRows(PixelFormat::Nv12, state.Height()), 1);
+        while (state.KeepRunning())
+            ConvertRgba8ToNv12(source.View(), nv12.View(), state.Tier());
+        state.SetBytesProcessed(FrameBytes(state));
+    }
+
+    void BenchConvertNv12ToRgba8(BenchmarkState& state)
+    {
+        Image nv12 = Nv12Frame(state.Width(), state.Height());
+        Image destination(state.Width(), state.Height(), 4);
+        while (state.KeepRunning())
+            ConvertNv12ToRgba8(nv12.View(), destination.View(), state.Tier());
+        state.SetBytesProcessed(FrameBytes(state));
+    }
+
+    void BenchConvertRGBAToI420(BenchmarkState& state)
+    {
+        Image source(state.Width(), state.Height(), 4);
+        FillFrame(source.View());
+        I420Image yuv;
+        while (state.KeepRunning())
+            ConvertRGBAToI420(source.View(), yuv);
+        state.SetBytesProcessed(FrameBytes(state));
+    }
+
+    void BenchConvertI420ToRGBA(BenchmarkState& state)
+    {
+        Image source(state.Width(), state.Height(), 4), destination(state.Width(), state.Height(), 4);
+        FillFrame(source.View());
+        I420Image yuv;
+        ConvertRGBAToI420(source.View(), yuv);
+        while (state.KeepRunning())
+            ConvertI420ToRGBA(yuv, destination.View());
+        state.SetBytesProcessed(FrameBytes(state));
+    }
+
+    void BenchSumSquaredError(BenchmarkState& state)
+    {
+        Image a(state.Width(), state.Height(), 4), b(state.Width(), state.Height(), 4);
+        FillFrame(a.View());
+        FillFrame(b.View(), 1, 0);
+        while (state.KeepRunning())
+        {
+            ParallelFor(state.Height(), state.Threads(), [&](uint32_t first, uint32_t last) {
+                DoNotOptimize(Kernels::SumSquaredError(a.View(), b.View(), 0, first, state.Width(), last - first, state.Tier()));
+            });
+        }
+        state.SetBytesProcessed(FrameBytes(state) * 2);
+    }
+
+    void BenchQualityMeter(BenchmarkState& state)
+    {
+        Image a(state.Width(), state.Height(), 4), b(state.Width(), state.Height(), 4);
+        FillFrame(a.View());
+        FillFrame(b.View(), 1, 0);
+        QualityMeter meter(128, state.Tier());
+        while (state.KeepRunning())
+            DoNotOptimize(meter.Score(a.View(), b.View()).ssim);
+        state.SetBytesProcessed(FrameBytes(state) * 2);
+    }
+
+    // A 64x64 pointer shape of the given type filled with a repeatable pattern, as duplication would report it.
+    std::vector<uint8_t> MakeCursorShape(CursorShapeType type, CursorShapeInfo& info)
+    {
+        constexpr uint32_t c_CursorSize = 64;
+        info.type = type;
+        info.width = c_CursorSize;
+        info.height = type == CursorShapeType::Monochrome ? c_CursorSize * 2 : c_CursorSize;
+        info.pitch = type == CursorShapeType::Monochrome ? c_CursorSize / 8 : c_CursorSize * 4;
+
+        std::vector<uint8_t> buffer(size_t(info.pitch) * info.height);
+        for (size_t i = 0; i < buffer.size(); i++)
+            buffer[i] = static_cast<uint8_t>(i * 37 + (i >> 5));
+        if (type == CursorShapeType::MaskedColor)
+        {
+            for (size_t i = 3; i < buffer.size(); i += 4)
+                buffer[i] = (i / 4) % 3 == 0 ? 0xFF : 0;
+        }
+        return buffer;
+    }
+
+    template<CursorShapeType Type>
+    void BenchDecodeCursor(BenchmarkState& state)
+    {
+        CursorShapeInfo info;
+        const std::vector<uint8_t> buffer = MakeCursorShape(Type, info);
+        DecodedCursor cursor;
+        while (state.KeepRunning())
+            DoNotOptimize(DecodeCursorShape(buffer.data(), buffer.size(), info, cursor, state.Tier()));
+        state.SetBytesProcessed(uint64_t(cursor.Width()) * cursor.Height() * 4);
+    }
+
+    void BenchHashCursor(BenchmarkState& state)
+    {
+        CursorShapeInfo info;
+        const std::vector<uint8_t> buffer = MakeCursorShape(CursorShapeType::Color, info);
+        while (state.KeepRunning())
+            DoNotOptimize(HashCursorShape(buffer.data(), buffer.size(), info));
+        state.SetBytesProcessed(buffer.size());
+    }
+
+    // One capture through the whole ring lifecycle per item.
+    void BenchCaptureRing(BenchmarkState& state)
+    {
+        CaptureRing ring;
+        ring.Reset(3);
+        uint64_t fence = 0;
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++)
+            {
+                const int slot = ring.BeginCapture();
+                ring.EndCapture(slot, ++fence);
+                const int interpolating = ring.AcquireForInterpolation();
+                ring.EndInterpolation(interpolating, ++fence);
+                ring.Retire(interpolating);
+            }
+        }
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+
+    void BenchReadbackRing(BenchmarkState& state)
+    {
+        ReadbackRing ring(4, 3);
+        uint64_t frame = 0;
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++, frame++)
+            {
+                const int mapped = ring.NextToMap(frame);
+                if (mapped != ReadbackRing::InvalidSlot)
+                    ring.EndMap(mapped);
+                ring.BeginCopy(frame);
+            }
+        }
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+
+    struct NullTexture
+    {
+        TextureKey key;
+    };
+
+    struct NullTextureAllocator
+    {
+        NullTexture* Create(const TextureKey& key) { return new NullTexture{ key }; }
+        void Destroy(NullTexture* texture) { delete texture; }
+        uint64_t SizeInBytes(const TextureKey& key) const { return uint64_t(key.width) * key.height * 4; }
+    };
+
+    // Steady-state reuse: every acquire after the first hits the idle list.
+    void BenchTexturePool(BenchmarkState& state)
+    {
+        TexturePool<NullTexture, NullTextureAllocator> pool{ NullTextureAllocator{} };
+        TextureKey key;
+        key.width = 1920;
+        key.height = 1080;
+        key.format = 28;
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++)
+                pool.Release(pool.Acquire(key));
+        }
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+
+    // The GPU is always ahead, so only the bookkeeping on the no-wait path is timed.
+    struct CompletedFence
+    {
+        uint64_t GetCompletedValue() { return UINT64_MAX; }
+        bool WaitForValue(uint64_t, uint32_t) { return true; }
+    };
+
+    void BenchFenceTimeline(BenchmarkState& state)
+    {
+        FenceTimeline<CompletedFence> timeline{ CompletedFence{} };
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++)
+                timeline.WaitFor(timeline.Signal());
+        }
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+
+    template<bool Enabled>
+    void BenchTraceSpan(BenchmarkState& state)
+    {
+        const bool wasEnabled = IsTraceEnabled();
+        SetTraceEnabled(Enabled);
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++)
+            {
+                DX_TRACE_SPAN("Benchmark");
+            }
+        }
+        SetTraceEnabled(wasEnabled);
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+
+    void BenchLatencyTracker(BenchmarkState& state)
+    {
+        LatencyTracker tracker;
+        tracker.Start(0);
+        uint32_t presentId = 0;
+        uint64_t now = 1000000;
+        while (state.KeepRunning())
+        {
+            for (uint32_t i = 0; i < c_QueueBatch; i++, now += 8000000)
+            {
+                tracker.OnPresent(LatencyFrameKind::Real, now - 20000000, now, ++presentId);
+                tracker.OnDisplayed(presentId, now + 4000000);
+            }
+        }
+        state.SetItemsProcessed(c_QueueBatch);
+    }
+}
+
+const std::vector<BenchmarkDefinition>& DX::KernelBenchmarks()
+{
+    static const std::vector<BenchmarkDefinition> benchmarks =
+    {
+        { "ComputeLuma",            BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchComputeLuma<Rgba8Pixel> },
+        { "ComputeLuma/rgb10a2",    BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchComputeLuma<Rgb10a2Pixel> },
+        { "ComputeLuma/rgba16f",    BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchComputeLuma<Rgba16fPixel> },
+        { "BlockSAD",               BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchBlockSAD },
+        { "EstimateMotion",         BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchEstimateMotion },
+        { "ComposeMidpoint",        BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchComposeMidpoint<Rgba8Pixel> },
+        { "ComposeMidpoint/rgb10a2", BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,  BenchComposeMidpoint<Rgb10a2Pixel> },
+        { "ComposeMidpoint/rgba16f", BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,  BenchComposeMidpoint<Rgba16fPixel> },
+        { "ComposeMidpoint/nv12",   BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchComposeMidpointNv12 },
+        { "CpuFrameInterpolator",   BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchInterpolator<Rgba8Pixel> },
+        { "CpuFrameInterpolator/rgb10a2", BenchmarkSized | BenchmarkTiered | BenchmarkThreaded, BenchInterpolator<Rgb10a2Pixel> },
+        { "CpuFrameInterpolator/rgba16f", BenchmarkSized | BenchmarkTiered | BenchmarkThreaded, BenchInterpolator<Rgba16fPixel> },
+        { "CpuFrameInterpolator/nv12", BenchmarkSized | BenchmarkTiered | BenchmarkThreaded, BenchInterpolatorNv12 },
+        { "Resampler/bilinear",     BenchmarkSized | BenchmarkTiered,                       BenchResampler<ScaleFilter::Bilinear, Rgba8Pixel> },
+        { "Resampler/bicubic",      BenchmarkSized | BenchmarkTiered,                       BenchResampler<ScaleFilter::Bicubic, Rgba8Pixel> },
+        { "Resampler/lanczos3",     BenchmarkSized | BenchmarkTiered,                       BenchResampler<ScaleFilter::Lanczos3, Rgba8Pixel> },
+        { "Resampler/area",         BenchmarkSized | BenchmarkTiered,                       BenchResampler<ScaleFilter::Area, Rgba8Pixel> },
+        { "Resampler/bilinear/rgb10a2", BenchmarkSized | BenchmarkTiered,                   BenchResampler<ScaleFilter::Bilinear, Rgb10a2Pixel> },
+        { "Resampler/bilinear/rgba16f", BenchmarkSized | BenchmarkTiered,                   BenchResampler<ScaleFilter::Bilinear, Rgba16fPixel> },
+        { "ConvertBGRAToRGBA",      BenchmarkSized,                                         BenchConvertBGRAToRGBA<Rgba8Pixel> },
+        { "ConvertBGRAToRGBA/rgb10a2", BenchmarkSized,                                      BenchConvertBGRAToRGBA<Rgb10a2Pixel> },
+        { "ConvertBGRAToRGBA/rgba16f", BenchmarkSized,                                      BenchConvertBGRAToRGBA<Rgba16fPixel> },
+        { "ConvertToRgba8/rgb10a2", BenchmarkSized,                                         BenchConvertToRgba8<Rgb10a2Pixel> },
+        { "ConvertToRgba8/rgba16f", BenchmarkSized,                                         BenchConvertToRgba8<Rgba16fPixel> },
+        { "ConvertRgba8ToNv12",     BenchmarkSized | BenchmarkTiered,                       BenchConvertRgba8ToNv12 },
+        { "ConvertNv12ToRgba8",     BenchmarkSized | BenchmarkTiered,                       BenchConvertNv12ToRgba8 },
+        { "ConvertRGBAToI420",      BenchmarkSized,                                         BenchConvertRGBAToI420 },
+        { "ConvertI420ToRGBA",      BenchmarkSized,                                         BenchConvertI420ToRGBA },
+        { "SumSquaredError",        BenchmarkSized | BenchmarkTiered | BenchmarkThreaded,   BenchSumSquaredError },
+        { "QualityMeter",           BenchmarkSized | BenchmarkTiered,                       BenchQualityMeter },
+        { "CursorShape/monochrome", BenchmarkTiered,                                        BenchDecodeCursor<CursorShapeType::Monochrome> },
+        { "CursorShape/color",      BenchmarkTiered,                                        BenchDecodeCursor<CursorShapeType::Color> },
+        { "CursorShape/masked",     BenchmarkTiered,                                        BenchDecodeCursor<CursorShapeType::MaskedColor> },
+        { "CursorShape/Hash",       BenchmarkFixed,                                         BenchHashCursor },
+        { "CaptureRing/Cycle",      BenchmarkFixed,                                         BenchCaptureRing },
+        { "ReadbackRing/Cycle",     BenchmarkFixed,                                         BenchReadbackRing },
+        { "TexturePool/Reuse",      BenchmarkFixed,                                         BenchTexturePool },
+        { "FenceTimeline/Signal",   BenchmarkFixed,                                         BenchFenceTimeline },
+        { "Trace/SpanDisabled",     BenchmarkFixed,                                         BenchTraceSpan<false> },
+        { "Trace/SpanRecording",    BenchmarkFixed,                                         BenchTraceSpan<true> },
+        { "LatencyTracker/Present", BenchmarkFixed,                                         BenchLatencyTracker },
+    };
+    return benchmarks;
+}
@@ -0,0 +1,6 @@
+//
+// CaptureConvertFloat_CS.hlsl - CaptureConvert_CS.hlsl for half-float ring slots
+//
+
+#define FLOAT_DESTINATION 1
+#include "CaptureConvert_CS.hlsl"
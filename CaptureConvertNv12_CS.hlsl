@@ -0,0 +1,6 @@
+//
+// CaptureConvertNv12_CS.hlsl - CaptureConvert_CS.hlsl for nv12 ring slots
+//
+
+#define NV12_DESTINATION 1
+#include "CaptureConvert_CS.hlsl"
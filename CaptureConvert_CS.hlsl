@@ -0,0 +1,73 @@
+//
+// CaptureConvert_CS.hlsl - Converts the duplicated desktop into a ring slot of the internal format in one pass
+//
+
+#include "ColorTransfer.hlsli"
+
+// Half-float slots are written through a float UAV; CaptureConvertFloat_CS.hlsl sets this.
+#ifndef FLOAT_DESTINATION
+#define FLOAT_DESTINATION 0
+#endif
+// nv12 slots are written through their luma and chroma plane UAVs; CaptureConvertNv12_CS.hlsl sets this.
+#ifndef NV12_DESTINATION
+#define NV12_DESTINATION 0
+#endif
+
+Texture2D<float4> Source : register(t0);
+#if NV12_DESTINATION
+RWTexture2D<unorm float> Destination : register(u0);
+RWTexture2D<unorm float2> ChromaDestination : register(u1);
+#elif FLOAT_DESTINATION
+RWTexture2D<float4> Destination : register(u0);
+#else
+RWTexture2D<unorm float4> Destination : register(u0);
+#endif
+SamplerState LinearClamp : register(s0);
+
+cbuffer Constants : register(b0)
+{
+    uint2 DestinationSize;
+    float2 InvDestinationSize;
+    float2 SourceOrigin;        // Top-left of the crop, normalized to the source.
+    float2 SourceScale;         // Crop size over source size.
+    uint SourceTransfer;        // Of the desktop: sRGB, or scRGB for an FP16 desktop.
+    uint DestinationTransfer;   // Of the internal format.
+    float SdrWhiteNits;
+    uint Padding;
+};
+
+float3 Convert(uint2 position)
+{
+    // BGRA views already return channels in RGBA order, so the swizzle happens in the sampler.
+    float2 uv = SourceOrigin + (float2(position) + 0.5f) * InvDestinationSize * SourceScale;
+    float3 rgb = ConvertTransfer(Source.SampleLevel(LinearClamp, uv, 0).rgb, SourceTransfer, DestinationTransfer, SdrWhiteNits);
+#if !FLOAT_DESTINATION
+    rgb = saturate(rgb);
+#endif
+    return rgb;
+}
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+#if NV12_DESTINATION
+    // One thread per 2x2 block, dispatched over the chroma plane.
+    if (any(id.xy * 2 >= DestinationSize))
+        return;
+
+    float3 sum = 0.0f;
+    for (uint i = 0; i < 4; i++)
+    {
+        uint2 position = id.xy * 2 + uint2(i & 1, i >> 1);
+        float3 rgb = Convert(position);
+        Destination[position] = RgbToLuma(rgb);
+        sum += rgb;
+    }
+    ChromaDestination[id.xy] = RgbToChroma(sum * 0.25f);
+#else
+    if (any(id.xy >= DestinationSize))
+        return;
+
+    Destination[id.xy] = float4(Convert(id.xy), 1.0f);
+#endif
+}
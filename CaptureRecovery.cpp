@@ -0,0 +1,157 @@
+//
+// CaptureRecovery.cpp - Recover a duplicated output from capture failures, rebuilding as little as possible
+//
+
+#include "CaptureRecovery.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+    // The DXGI and COM results duplication reports, so this builds without the Windows headers.
+    constexpr uint32_t c_WaitTimeout            = 0x887A0027;  // DXGI_ERROR_WAIT_TIMEOUT
+    constexpr uint32_t c_AccessLost             = 0x887A0026;  // DXGI_ERROR_ACCESS_LOST
+    constexpr uint32_t c_ModeChangeInProgress   = 0x887A0025;  // DXGI_ERROR_MODE_CHANGE_IN_PROGRESS
+    constexpr uint32_t c_AccessDenied           = 0x80070005;  // E_ACCESSDENIED
+    constexpr uint32_t c_NotCurrentlyAvailable  = 0x887A0022;  // DXGI_ERROR_NOT_CURRENTLY_AVAILABLE
+    constexpr uint32_t c_SessionDisconnected    = 0x887A0028;  // DXGI_ERROR_SESSION_DISCONNECTED
+    constexpr uint32_t c_Unsupported            = 0x887A0004;  // DXGI_ERROR_UNSUPPORTED
+    constexpr uint32_t c_NotFound               = 0x887A0002;  // DXGI_ERROR_NOT_FOUND
+    constexpr uint32_t c_DeviceRemoved          = 0x887A0005;  // DXGI_ERROR_DEVICE_REMOVED
+    constexpr uint32_t c_DeviceHung             = 0x887A0006;  // DXGI_ERROR_DEVICE_HUNG
+    constexpr uint32_t c_DeviceReset            = 0x887A0007;  // DXGI_ERROR_DEVICE_RESET
+    constexpr uint32_t c_DriverInternalError    = 0x887A0020;  // DXGI_ERROR_DRIVER_INTERNAL_ERROR
+}
+
+const char* DX::CaptureFaultName(CaptureFault fault) noexcept
+{
+    switch (fault)
+    {
+    case CaptureFault::None:            return "none";
+    case CaptureFault::Timeout:         return "timeout";
+    case CaptureFault::AccessLost:      return "access-lost";
+    case CaptureFault::AccessDenied:    return "access-denied";
+    case CaptureFault::Unavailable:     return "unavailable";
+    case CaptureFault::ModeChanged:     return "mode-changed";
+    case CaptureFault::OutputGone:      return "output-gone";
+    case CaptureFault::DeviceRemoved:   return "device-removed";
+    default:                            return "other";
+    }
+}
+
+const char* DX::RecoveryLayerName(RecoveryLayer layer) noexcept
+{
+    switch (layer)
+    {
+    case RecoveryLayer::Duplication:    return "duplication";
+    case RecoveryLayer::Output:         return "output";
+    case RecoveryLayer::Device:         return "device";
+    default:                            return "none";
+    }
+}
+
+CaptureFault DX::ClassifyCaptureResult(int32_t hresult) noexcept
+{
+    if (hresult >= 0)
+        return CaptureFault::None;
+    switch (static_cast<uint32_t>(hresult))
+    {
+    case c_WaitTimeout:             return CaptureFault::Timeout;
+    case c_AccessLost:
+    case c_ModeChangeInProgress:    return CaptureFault::AccessLost;
+    case c_AccessDenied:            return CaptureFault::AccessDenied;
+    case c_NotCurrentlyAvailable:
+    case c_SessionDisconnected:
+    case c_Unsupported:             return CaptureFault::Unavailable;
+    case c_NotFound:                return CaptureFault::OutputGone;
+    case c_DeviceRemoved:
+    case c_DeviceHung:
+    case c_DeviceReset:
+    case c_DriverInternalError:     return CaptureFault::DeviceRemoved;
+    default:                        return CaptureFault::Other;
+    }
+}
+
+RecoveryLayer DX::RecoveryLayerFor(CaptureFault fault) noexcept
+{
+    switch (fault)
+    {
+    case CaptureFault::None:
+    case CaptureFault::Timeout:         return RecoveryLayer::None;
+    case CaptureFault::ModeChanged:
+    case CaptureFault::OutputGone:      return RecoveryLayer::Output;
+    case CaptureFault::DeviceRemoved:   return RecoveryLayer::Device;
+    default:                            return RecoveryLayer::Duplication;
+    }
+}
+
+RecoveryLayer CaptureRecovery::OnFault(CaptureFault fault, double now) noexcept
+{
+    const RecoveryLayer layer = RecoveryLayerFor(fault);
+    if (layer == RecoveryLayer::None)
+        return m_pending;
+
+    m_lastFault = fault;
+    if (!Recovering())
+    {
+        m_faults++;
+        m_startSeconds = now;
+    }
+    if (layer > m_pending)
+        Escalate(layer, now);
+    return m_pending;
+}
+
+RecoveryLayer CaptureRecovery::Due(double now) const noexcept
+{
+    return Recovering() && now >= m_dueSeconds ? m_pending : RecoveryLayer::None;
+}
+
+void CaptureRecovery::OnRebuilt(CaptureFault result, double now) noexcept
+{
+    if (!Recovering())
+        return;
+    if (RecoveryLayerFor(result) == RecoveryLayer::None)
+    {
+        m_lastRecoverySeconds = now - m_startSeconds;
+        m_recoveringSeconds += m_lastRecoverySeconds;
+        m_recoveries++;
+        m_pending = RecoveryLayer::None;
+        m_attempts = 0;
+        m_failures = 0;
+        return;
+    }
+
+    m_lastFault = result;
+    const RecoveryLayer needed = RecoveryLayerFor(result);
+    if (needed > m_pending)
+    {
+        Escalate(needed, now);
+        return;
+    }
+
+    // A session that keeps failing to come back may have an output behind it that changed. The
+    // secure desktop and a full set of sessions only pass with time, so they just keep backing off;
+    // nothing short of device removal rebuilds the device.
+    m_attempts++;
+    const bool waitOnly = result == CaptureFault::AccessDenied || result == CaptureFault::Unavailable;
+    m_failures += waitOnly ? 0 : 1;
+    if (m_pending == RecoveryLayer::Duplication && m_failures >= m_settings.escalateAfter)
+    {
+        Escalate(RecoveryLayer::Output, now);
+        return;
+    }
+    const double backoff = m_settings.firstBackoffSeconds * std::ldexp(1.0, static_cast<int>(std::min(m_attempts - 1, 30u)));
+    m_dueSeconds = now + std::min(backoff, m_settings.maxBackoffSeconds);
+}
+
+void CaptureRecovery::Escalate(RecoveryLayer layer, double now) noexcept
+{
+    m_pending = layer;
+    m_attempts = 0;
+    m_failures = 0;
+    m_dueSeconds = now;
+}
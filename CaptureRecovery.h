@@ -0,0 +1,100 @@
+//
+// CaptureRecovery.h - Recover a duplicated output from capture failures, rebuilding as little as possible
+//
+// Duplication fails for different reasons that need different rebuilds. An access-lost error (a mode
+// change, the UAC secure desktop, a fullscreen application) only needs a new duplication session; a
+// mode change also needs the output's description, ring and interpolator at the new size; a removed
+// device needs everything. Each output has its own recovery: a failure names the least layer that has
+// to be rebuilt, the viewer rebuilds it when it is due and reports how that went, and failed attempts
+// back off and eventually escalate to the next layer. While an output recovers, the viewer keeps
+// showing its last good frame. Nothing here touches DXGI, so the state machine runs in the tools.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace DX
+{
+    // Why a capture call or a rebuild failed.
+    enum class CaptureFault
+    {
+        None,
+        Timeout,            // No new frame; not a failure.
+        AccessLost,         // The duplication session is invalid and must be re-created.
+        AccessDenied,       // The secure desktop is shown, or duplication is not allowed right now.
+        Unavailable,        // Too many sessions, or the session is disconnected.
+        ModeChanged,        // The output's mode or rotation differs from the one captured.
+        OutputGone,         // The output is no longer on the adapter.
+        DeviceRemoved,      // The device was removed, reset or hung.
+        Other,
+    };
+
+    // What is rebuilt, from the least to the most.
+    enum class RecoveryLayer
+    {
+        None,
+        Duplication,        // Only the duplication session.
+        Output,             // The output, its session, and its ring and interpolator if its size changed.
+        Device,             // Every device resource, as on device loss.
+    };
+
+    const char* CaptureFaultName(CaptureFault fault) noexcept;
+    const char* RecoveryLayerName(RecoveryLayer layer) noexcept;
+
+    // The fault an HRESULT from AcquireNextFrame or DuplicateOutput stands for. Success is None.
+    CaptureFault ClassifyCaptureResult(int32_t hresult) noexcept;
+
+    // The least layer that recovers from a fault.
+    RecoveryLayer RecoveryLayerFor(CaptureFault fault) noexcept;
+
+    struct RecoverySettings
+    {
+        double      firstBackoffSeconds = 0.05;     // After the first failed attempt; doubles with each one.
+        double      maxBackoffSeconds = 2.0;
+        uint32_t    escalateAfter = 4;              // Failed attempts at one layer before the next is tried.
+    };
+
+    class CaptureRecovery
+    {
+    public:
+        explicit CaptureRecovery(const RecoverySettings& settings = {}) noexcept : m_settings(settings) {}
+
+        // A capture call failed. The pending layer only ever grows until an attempt succeeds; a bigger
+        // one is due at once. Returns the pending layer.
+        RecoveryLayer OnFault(CaptureFault fault, double now) noexcept;
+
+        // The layer to rebuild now, or None while running or backing off.
+        RecoveryLayer Due(double now) const noexcept;
+
+        // How rebuilding the layer Due returned went: None if the output captures again, otherwise the
+        // fault the rebuild hit, which may call for a bigger layer.
+        void OnRebuilt(CaptureFault result, double now) noexcept;
+
+        bool Recovering() const noexcept { return m_pending != RecoveryLayer::None; }
+        RecoveryLayer Pending() const noexcept { return m_pending; }
+        CaptureFault LastFault() const noexcept { return m_lastFault; }
+        uint32_t Attempts() const noexcept { return m_attempts; }   // Failed attempts at the pending layer.
+
+        // Totals: faults that started a recovery, recoveries finished, and time spent recovering.
+        uint64_t Faults() const noexcept { return m_faults; }
+        uint64_t Recoveries() const noexcept { return m_recoveries; }
+        double RecoveringSeconds() const noexcept { return m_recoveringSeconds; }
+        double LastRecoverySeconds() const noexcept { return m_lastRecoverySeconds; }
+
+    private:
+        void Escalate(RecoveryLayer layer, double now) noexcept;
+
+        RecoverySettings    m_settings;
+        RecoveryLayer       m_pending = RecoveryLayer::None;
+        CaptureFault        m_lastFault = CaptureFault::None;
+        uint32_t            m_attempts = 0;
+        uint32_t            m_failures = 0;         // Attempts that failed other than by waiting, towards escalation.
+        double              m_dueSeconds = 0.0;
+        double              m_startSeconds = 0.0;
+        uint64_t            m_faults = 0;
+        uint64_t            m_recoveries = 0;
+        double              m_recoveringSeconds = 0.0;
+        double              m_lastRecoverySeconds = 0.0;
+    };
+}
@@ -0,0 +1,97 @@
+//
+// CaptureRegion.cpp - The part of an output that is converted, kept in the ring and interpolated
+//
+
+#include "CaptureRegion.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+uint32_t DX::RegionSizeClass(uint32_t extent, uint32_t full) noexcept
+{
+    if (extent >= full)
+        return full;
+    uint32_t size = RegionMinExtent;
+    while (size < extent)
+        size = (size * 5 / 4 + 31) / 32 * 32;
+    return std::min(size, full);
+}
+
+DesktopRect DX::DesktopToImageRect(const DesktopOutput& output, const DesktopRect& desktop) noexcept
+{
+    const DesktopRect& b = output.bounds;
+    const DesktopRect clipped = { std::max(desktop.left, b.left), std::max(desktop.top, b.top), std::min(desktop.right, b.right), std::min(desktop.bottom, b.bottom) };
+    if (clipped.Width() <= 0 || clipped.Height() <= 0)
+        return {};
+
+    // Opposite corners stay opposite under any of the rotations.
+    const Point2D a = output.desktopToImage.Apply({ double(clipped.left), double(clipped.top) });
+    const Point2D c = output.desktopToImage.Apply({ double(clipped.right), double(clipped.bottom) });
+    DesktopRect image;
+    image.left = std::max(0, static_cast<int32_t>(std::floor(std::min(a.x, c.x))));
+    image.top = std::max(0, static_cast<int32_t>(std::floor(std::min(a.y, c.y))));
+    image.right = std::min(static_cast<int32_t>(output.imageWidth), static_cast<int32_t>(std::ceil(std::max(a.x, c.x))));
+    image.bottom = std::min(static_cast<int32_t>(output.imageHeight), static_cast<int32_t>(std::ceil(std::max(a.y, c.y))));
+    return image;
+}
+
+void CaptureRegion::Reset(uint32_t outputWidth, uint32_t outputHeight) noexcept
+{
+    m_outputWidth = outputWidth;
+    m_outputHeight = outputHeight;
+    m_wanted = { 0, 0, static_cast<int32_t>(outputWidth), static_cast<int32_t>(outputHeight) };
+    m_crop = m_wanted;
+    m_smallerUpdates = 0;
+    m_resizes = 0;
+}
+
+bool CaptureRegion::Update(const DesktopRect& wanted) noexcept
+{
+    const int32_t outputWidth = static_cast<int32_t>(m_outputWidth);
+    const int32_t outputHeight = static_cast<int32_t>(m_outputHeight);
+    DesktopRect region = { std::max(wanted.left, 0), std::max(wanted.top, 0), std::min(wanted.right, outputWidth), std::min(wanted.bottom, outputHeight) };
+    const bool whole = region.Width() <= 0 || region.Height() <= 0;
+    if (whole)
+        region = { 0, 0, outputWidth, outputHeight };
+    m_wanted = region;
+
+    // The class follows the region's full size, so a window moving over the output's edge keeps its
+    // class. Grow at once; shrink once the region has fitted the smaller class long enough, so a window
+    // being resized across a class boundary doesn't re-create the interpolator back and forth.
+    const uint32_t needWidth = RegionSizeClass(static_cast<uint32_t>(whole ? outputWidth : std::max(wanted.Width(), 1)), m_outputWidth);
+    const uint32_t needHeight = RegionSizeClass(static_cast<uint32_t>(whole ? outputHeight : std::max(wanted.Height(), 1)), m_outputHeight);
+    uint32_t width = Width();
+    uint32_t height = Height();
+    if (needWidth > width || needHeight > height)
+    {
+        width = std::max(width, needWidth);
+        height = std::max(height, needHeight);
+        m_smallerUpdates = 0;
+    }
+    else if (needWidth < width || needHeight < height)
+    {
+        if (++m_smallerUpdates >= RegionShrinkUpdates)
+        {
+            width = needWidth;
+            height = needHeight;
+            m_smallerUpdates = 0;
+        }
+    }
+    else
+    {
+        m_smallerUpdates = 0;
+    }
+
+    // Centre the crop on the region, inside the output.
+    const int32_t centerX = (region.left + region.right) / 2;
+    const int32_t centerY = (region.top + region.bottom) / 2;
+    const bool resized = width != Width() || height != Height();
+    m_crop.left = std::clamp(centerX - static_cast<int32_t>(width) / 2, 0, outputWidth - static_cast<int32_t>(width));
+    m_crop.top = std::clamp(centerY - static_cast<int32_t>(height) / 2, 0, outputHeight - static_cast<int32_t>(height));
+    m_crop.right = m_crop.left + static_cast<int32_t>(width);
+    m_crop.bottom = m_crop.top + static_cast<int32_t>(height);
+    m_resizes += resized ? 1 : 0;
+    return resized;
+}
@@ -0,0 +1,56 @@
+//
+// CaptureRegion.h - The part of an output that is converted, kept in the ring and interpolated
+//
+// A region of interest, such as one window's bounds, is usually much smaller than the output. The
+// crop around it is rounded up to a size class, so a window that moves or is resized a little only
+// moves the crop: the ring textures and the NvOFFRUC instance, which are sized by the crop, are
+// re-created only when the size class changes. Classes grow in steps of about a quarter, growing
+// at once and shrinking only once the region has fitted a smaller class for a while. Rectangles are
+// in the output's image pixels (scanout orientation), as captured.
+//
+
+#pragma once
+
+#include "DesktopLayout.h"
+
+#include <cstdint>
+
+namespace DX
+{
+    // Smallest crop side, and how many updates a region must fit a smaller class before it shrinks.
+    constexpr uint32_t RegionMinExtent = 256;
+    constexpr uint32_t RegionShrinkUpdates = 30;
+
+    // Smallest size class of at least extent on an axis full pixels long. Classes are multiples of 32.
+    uint32_t RegionSizeClass(uint32_t extent, uint32_t full) noexcept;
+
+    // A rectangle on the virtual desktop in the output's image pixels, clamped to the image. Empty if
+    // they don't overlap.
+    DesktopRect DesktopToImageRect(const DesktopOutput& output, const DesktopRect& desktop) noexcept;
+
+    class CaptureRegion
+    {
+    public:
+        // The whole output, until a region is set.
+        void Reset(uint32_t outputWidth, uint32_t outputHeight) noexcept;
+
+        // Follow a region of the output; empty means the whole output. Returns true when the crop
+        // changed size, so whatever is sized by it must be re-created.
+        bool Update(const DesktopRect& wanted) noexcept;
+
+        const DesktopRect& Crop() const noexcept { return m_crop; }
+        const DesktopRect& Wanted() const noexcept { return m_wanted; }
+        uint32_t Width() const noexcept { return static_cast<uint32_t>(m_crop.Width()); }
+        uint32_t Height() const noexcept { return static_cast<uint32_t>(m_crop.Height()); }
+        bool IsWholeOutput() const noexcept { return Width() == m_outputWidth && Height() == m_outputHeight; }
+        uint64_t Resizes() const noexcept { return m_resizes; }
+
+    private:
+        uint32_t    m_outputWidth = 0;
+        uint32_t    m_outputHeight = 0;
+        DesktopRect m_wanted;
+        DesktopRect m_crop;
+        uint32_t    m_smallerUpdates = 0;   // Consecutive updates the region fitted a smaller class.
+        uint64_t    m_resizes = 0;
+    };
+}
@@ -0,0 +1,184 @@
+//
+// CaptureRing.h - Slot bookkeeping for the N-deep capture ring shared by capture, interpolation and present
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+    // Lifecycle of a ring slot:
+    //     Free -> Capturing -> Ready -> Interpolating -> Presenting -> Free
+    // A capture that fails is aborted back to Free, and when the ring is full the oldest Ready slot
+    // is recycled so the capture stage always works on the newest desktop image.
+    enum class SlotState : uint8_t
+    {
+        Free,
+        Capturing,
+        Ready,
+        Interpolating,
+        Presenting,
+    };
+
+    class CaptureRing
+    {
+    public:
+        static constexpr int InvalidSlot = -1;
+
+        explicit CaptureRing(size_t depth = 3) { Reset(depth); }
+
+        // Resize the ring and mark every slot free.
+        void Reset(size_t depth)
+        {
+            m_slots.assign(depth, Slot{});
+            m_nextSequence = 1;
+            m_droppedFrames = 0;
+        }
+
+        // Claim a slot for the capture stage. Returns InvalidSlot if every slot is held by a later stage.
+        int BeginCapture()
+        {
+            int slot = FindSlot(SlotState::Free, false);
+            if (slot == InvalidSlot)
+            {
+                // Recycle the oldest captured frame that nobody has started on yet.
+                slot = FindSlot(SlotState::Ready, false);
+                if (slot == InvalidSlot)
+                    return InvalidSlot;
+                m_droppedFrames++;
+            }
+
+            m_slots[slot].state = SlotState::Capturing;
+            m_slots[slot].fenceValue = 0;
+            m_slots[slot].sequence = 0;
+            return slot;
+        }
+
+        // Publish a captured slot. fenceValue is signalled once the GPU has finished writing it.
+        bool EndCapture(int slot, uint64_t fenceValue)
+        {
+            if (!Transition(slot, SlotState::Capturing, SlotState::Ready))
+                return false;
+            m_slots[slot].fenceValue = fenceValue;
+            m_slots[slot].sequence = m_nextSequence++;
+            return true;
+        }
+
+        bool AbortCapture(int slot)
+        {
+            return Transition(slot, SlotState::Capturing, SlotState::Free);
+        }
+
+        // Hand the oldest ready frame to the interpolator. Returns InvalidSlot if nothing is ready.
+        int AcquireForInterpolation()
+        {
+            const int slot = FindSlot(SlotState::Ready, false);
+            if (slot != InvalidSlot)
+                m_slots[slot].state = SlotState::Interpolating;
+            return slot;
+        }
+
+        // The interpolator is done reading the slot; it stays resident until it has been presented.
+        bool EndInterpolation(int slot, uint64_t fenceValue)
+        {
+            if (!Transition(slot, SlotState::Interpolating, SlotState::Presenting))
+                return false;
+            m_slots[slot].fenceValue = fenceValue;
+            return true;
+        }
+
+        // The presenter no longer needs the slot.
+        bool Retire(int slot)
+        {
+            return Transition(slot, SlotState::Presenting, SlotState::Free);
+        }
+
+        // Newest slot in the given state, or InvalidSlot.
+        int NewestIn(SlotState state) const { return FindSlot(state, true); }
+
+        bool HasReady() const { return FindSlot(SlotState::Ready, false) != InvalidSlot; }
+        bool HasFree() const { return FindSlot(SlotState::Free, false) != InvalidSlot; }
+
+        size_t CountIn(SlotState state) const
+        {
+            size_t count = 0;
+            for (auto const& slot : m_slots)
+            {
+                if (slot.state == state)
+                    count++;
+            }
+            return count;
+        }
+
+        // Every slot is in exactly one state and sequences of live frames are unique.
+        bool IsConsistent() const
+        {
+            for (size_t i = 0; i < m_slots.size(); i++)
+            {
+                const bool sequenced = m_slots[i].state == SlotState::Ready
+                    || m_slots[i].state == SlotState::Interpolating
+                    || m_slots[i].state == SlotState::Presenting;
+                if (sequenced != (m_slots[i].sequence != 0))
+                    return false;
+                for (size_t j = i + 1; sequenced && j < m_slots.size(); j++)
+                {
+                    if (m_slots[j].sequence == m_slots[i].sequence)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        size_t Depth() const noexcept { return m_slots.size(); }
+        SlotState GetState(int slot) const { return m_slots[slot].state; }
+        uint64_t GetFenceValue(int slot) const { return m_slots[slot].fenceValue; }
+        uint64_t GetSequence(int slot) const { return m_slots[slot].sequence; }
+        uint64_t GetDroppedFrames() const noexcept { return m_droppedFrames; }
+
+    private:
+        struct Slot
+        {
+            SlotState state = SlotState::Free;
+            uint64_t fenceValue = 0;
+            uint64_t sequence = 0;
+        };
+
+        bool Transition(int slot, SlotState from, SlotState to)
+        {
+            if (slot < 0 || static_cast<size_t>(slot) >= m_slots.size() || m_slots[slot].state != from)
+                return false;
+            m_slots[slot].state = to;
+            if (to == SlotState::Free)
+            {
+                m_slots[slot].fenceValue = 0;
+                m_slots[slot].sequence = 0;
+            }
+            return true;
+        }
+
+        // Oldest (or newest) slot in the given state. Free slots have no sequence, so the lowest index wins.
+        int FindSlot(SlotState state, bool newest) const
+        {
+            int found = InvalidSlot;
+            for (size_t i = 0; i < m_slots.size(); i++)
+            {
+                if (m_slots[i].state != state)
+                    continue;
+                if (found == InvalidSlot
+                    || (newest ? m_slots[i].sequence > m_slots[found].sequence
+                               : m_slots[i].sequence < m_slots[found].sequence))
+                {
+                    found = static_cast<int>(i);
+                }
+            }
+            return found;
+        }
+
+        std::vector<Slot>   m_slots;
+        uint64_t            m_nextSequence = 1;
+        uint64_t            m_droppedFrames = 0;
+    };
+}
@@ -0,0 +1,275 @@
+//
+// CaptureScaler.cpp - GPU conversion and downscaling from the duplicated desktop into a ring slot
+//
+
+#include "pch.h"
+#include "CaptureScaler.h"
+
+// Compiled by FXC into the intermediate directory.
+#include "CaptureConvert_CS.inc"
+#include "CaptureConvertFloat_CS.inc"
+#include "CaptureConvertNv12_CS.inc"
+#include "ScaleH_CS.inc"
+#include "ScaleV_CS.inc"
+#include "ScaleVFloat_CS.inc"
+#include "ScaleVNv12_CS.inc"
+
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // ScaleH_CS.hlsl reads the crop; the intermediate it writes is already cropped, so ScaleV_CS.hlsl
+    // only needs the transfers.
+    struct ScaleHConstants
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t taps;
+        uint32_t padding;
+        int32_t sourceX;
+        int32_t sourceY;
+        uint32_t padding2[2];
+    };
+
+    struct ScaleVConstants
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t taps;
+        uint32_t sourceTransfer;
+        uint32_t destinationTransfer;
+        float sdrWhiteNits;
+        uint32_t padding[2];
+    };
+
+    struct ConvertConstants
+    {
+        uint32_t width;
+        uint32_t height;
+        float invWidth;
+        float invHeight;
+        float originX;
+        float originY;
+        float scaleX;
+        float scaleY;
+        uint32_t sourceTransfer;
+        uint32_t destinationTransfer;
+        float sdrWhiteNits;
+        uint32_t padding;
+    };
+
+    template<typename T>
+    void CreateImmutableBuffer(ID3D11Device* device, const T* data, size_t count, UINT bindFlags, ID3D11Buffer** buffer)
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(sizeof(T) * count), bindFlags, D3D11_USAGE_IMMUTABLE);
+        D3D11_SUBRESOURCE_DATA initData = { data, 0, 0 };
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, buffer));
+    }
+
+    // Updated with UpdateSubresource when the crop moves.
+    template<typename T>
+    void CreateConstantBuffer(ID3D11Device* device, const T& data, ID3D11Buffer** buffer)
+    {
+        CD3D11_BUFFER_DESC desc(static_cast<UINT>(sizeof(T)), D3D11_BIND_CONSTANT_BUFFER);
+        D3D11_SUBRESOURCE_DATA initData = { &data, 0, 0 };
+        ThrowIfFailed(device->CreateBuffer(&desc, &initData, buffer));
+    }
+
+    void CreateTypedBufferView(ID3D11Device* device, ID3D11Buffer* buffer, DXGI_FORMAT format, UINT count, ID3D11ShaderResourceView** view)
+    {
+        CD3D11_SHADER_RESOURCE_VIEW_DESC desc(buffer, format, 0, count);
+        ThrowIfFailed(device->CreateShaderResourceView(buffer, &desc, view));
+    }
+}
+
+void CaptureScaler::CreateDeviceResources(ID3D11Device* device)
+{
+    ThrowIfFailed(device->CreateComputeShader(g_CaptureConvert_CS, sizeof(g_CaptureConvert_CS), nullptr, m_convertCS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_ScaleH_CS, sizeof(g_ScaleH_CS), nullptr, m_horizontalCS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_ScaleV_CS, sizeof(g_ScaleV_CS), nullptr, m_verticalCS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_CaptureConvertFloat_CS, sizeof(g_CaptureConvertFloat_CS), nullptr, m_convertFloatCS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_ScaleVFloat_CS, sizeof(g_ScaleVFloat_CS), nullptr, m_verticalFloatCS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_CaptureConvertNv12_CS, sizeof(g_CaptureConvertNv12_CS), nullptr, m_convertNv12CS.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateComputeShader(g_ScaleVNv12_CS, sizeof(g_ScaleVNv12_CS), nullptr, m_verticalNv12CS.ReleaseAndGetAddressOf()));
+
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    ThrowIfFailed(device->CreateSamplerState(&samplerDesc, m_linearClampSampler.ReleaseAndGetAddressOf()));
+}
+
+// Rebuild constants, weight tables and the intermediate texture for a new size or filter.
+void CaptureScaler::Resize(ID3D11Device* device, uint32_t srcWidth, uint32_t srcHeight,
+                           uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter)
+{
+    if (m_convertConstants && filter == m_filter && srcWidth == m_srcWidth && srcHeight == m_srcHeight
+        && dstWidth == m_dstWidth && dstHeight == m_dstHeight)
+        return;
+
+    m_filter = filter;
+    m_srcWidth = srcWidth;
+    m_srcHeight = srcHeight;
+    m_dstWidth = dstWidth;
+    m_dstHeight = dstHeight;
+    m_sourceDirty = true;
+
+    const ConvertConstants convert = { dstWidth, dstHeight, 1.f / dstWidth, 1.f / dstHeight, 0.f, 0.f, 1.f, 1.f, 0, 0, m_sdrWhiteNits, 0 };
+    CreateConstantBuffer(device, convert, m_convertConstants.ReleaseAndGetAddressOf());
+
+    m_intermediate.Reset();
+    m_intermediateSRV.Reset();
+    m_intermediateUAV.Reset();
+    m_horizontal = Axis{};
+    m_vertical = Axis{};
+    if (filter == ScaleFilter::Bilinear)
+        return;
+
+    CreateAxis(device, BuildResampleWeights(srcWidth, dstWidth, filter), srcHeight, true, m_horizontal);
+    CreateAxis(device, BuildResampleWeights(srcHeight, dstHeight, filter), dstWidth, false, m_vertical);
+
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R16G16B16A16_FLOAT, dstWidth, srcHeight, 1, 1,
+        D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS);
+    ThrowIfFailed(device->CreateTexture2D(&desc, nullptr, m_intermediate.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateShaderResourceView(m_intermediate.Get(), nullptr, m_intermediateSRV.ReleaseAndGetAddressOf()));
+    ThrowIfFailed(device->CreateUnorderedAccessView(m_intermediate.Get(), nullptr, m_intermediateUAV.ReleaseAndGetAddressOf()));
+}
+
+void CaptureScaler::CreateAxis(ID3D11Device* device, const ResampleWeights& table, uint32_t otherSize, bool horizontal, Axis& axis)
+{
+    if (horizontal)
+        CreateConstantBuffer(device, ScaleHConstants{ table.dstSize, otherSize, table.taps, 0, 0, 0, {} }, axis.m_constants.ReleaseAndGetAddressOf());
+    else
+        CreateConstantBuffer(device, ScaleVConstants{ otherSize, table.dstSize, table.taps, 0, 0, m_sdrWhiteNits, {} }, axis.m_constants.ReleaseAndGetAddressOf());
+    axis.m_taps = table.taps;
+
+    ComPtr<ID3D11Buffer> weights;
+    CreateImmutableBuffer(device, table.weights.data(), table.weights.size(), D3D11_BIND_SHADER_RESOURCE, weights.GetAddressOf());
+    CreateTypedBufferView(device, weights.Get(), DXGI_FORMAT_R32_FLOAT, static_cast<UINT>(table.weights.size()), axis.m_weights.ReleaseAndGetAddressOf());
+
+    ComPtr<ID3D11Buffer> starts;
+    CreateImmutableBuffer(device, table.start.data(), table.start.size(), D3D11_BIND_SHADER_RESOURCE, starts.GetAddressOf());
+    CreateTypedBufferView(device, starts.Get(), DXGI_FORMAT_R32_SINT, static_cast<UINT>(table.start.size()), axis.m_starts.ReleaseAndGetAddressOf());
+}
+
+void CaptureScaler::SetSourceRegion(uint32_t x, uint32_t y, uint32_t sourceWidth, uint32_t sourceHeight) noexcept
+{
+    if (x == m_sourceX && y == m_sourceY && sourceWidth == m_sourceWidth && sourceHeight == m_sourceHeight)
+        return;
+    m_sourceX = x;
+    m_sourceY = y;
+    m_sourceWidth = sourceWidth;
+    m_sourceHeight = sourceHeight;
+    m_sourceDirty = true;
+}
+
+void CaptureScaler::SetTransfer(TransferFunction source, PixelFormat destination, float sdrWhiteNits) noexcept
+{
+    if (source == m_sourceTransfer && destination == m_destinationFormat && sdrWhiteNits == m_sdrWhiteNits)
+        return;
+    m_sourceTransfer = source;
+    m_destinationFormat = destination;
+    m_sdrWhiteNits = sdrWhiteNits;
+    m_sourceDirty = true;
+}
+
+// Point the sampled pass and the horizontal pass at the crop, and the last pass at the transfers.
+void CaptureScaler::UpdateSourceConstants(ID3D11DeviceContext* context)
+{
+    const uint32_t sourceTransfer = uint32_t(m_sourceTransfer);
+    const uint32_t destinationTransfer = uint32_t(PixelFormatTransfer(m_destinationFormat));
+    const float sourceWidth = float(m_sourceWidth != 0 ? m_sourceWidth : m_srcWidth);
+    const float sourceHeight = float(m_sourceHeight != 0 ? m_sourceHeight : m_srcHeight);
+    const ConvertConstants convert = { m_dstWidth, m_dstHeight, 1.f / m_dstWidth, 1.f / m_dstHeight,
+        float(m_sourceX) / sourceWidth, float(m_sourceY) / sourceHeight, float(m_srcWidth) / sourceWidth, float(m_srcHeight) / sourceHeight,
+        sourceTransfer, destinationTransfer, m_sdrWhiteNits, 0 };
+    context->UpdateSubresource(m_convertConstants.Get(), 0, nullptr, &convert, 0, 0);
+
+    if (m_horizontal.m_constants)
+    {
+        const ScaleHConstants constants = { m_dstWidth, m_srcHeight, m_horizontal.m_taps, 0, int32_t(m_sourceX), int32_t(m_sourceY), {} };
+        context->UpdateSubresource(m_horizontal.m_constants.Get(), 0, nullptr, &constants, 0, 0);
+    }
+    if (m_vertical.m_constants)
+    {
+        const ScaleVConstants constants = { m_dstWidth, m_dstHeight, m_vertical.m_taps, sourceTransfer, destinationTransfer, m_sdrWhiteNits, {} };
+        context->UpdateSubresource(m_vertical.m_constants.Get(), 0, nullptr, &constants, 0, 0);
+    }
+    m_sourceDirty = false;
+}
+
+void CaptureScaler::Process(ID3D11DeviceContext* context, ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* destination,
+                            ID3D11UnorderedAccessView* chromaDestination)
+{
+    if (m_sourceDirty)
+        UpdateSourceConstants(context);
+
+    // nv12's last pass runs a thread per 2x2 block, over the chroma plane.
+    const bool floatDestination = m_destinationFormat == PixelFormat::Rgba16f;
+    const bool nv12Destination = m_destinationFormat == PixelFormat::Nv12;
+    const uint32_t threadsX = nv12Destination ? m_dstWidth / 2 : m_dstWidth;
+    const uint32_t threadsY = nv12Destination ? m_dstHeight / 2 : m_dstHeight;
+    if (m_filter == ScaleFilter::Bilinear)
+    {
+        ID3D11Buffer* constants = m_convertConstants.Get();
+        ID3D11SamplerState* sampler = m_linearClampSampler.Get();
+        ID3D11UnorderedAccessView* destinations[] = { destination, chromaDestination };
+        context->CSSetShader(nv12Destination ? m_convertNv12CS.Get() : floatDestination ? m_convertFloatCS.Get() : m_convertCS.Get(), nullptr, 0);
+        context->CSSetConstantBuffers(0, 1, &constants);
+        context->CSSetSamplers(0, 1, &sampler);
+        context->CSSetShaderResources(0, 1, &source);
+        context->CSSetUnorderedAccessViews(0, 2, destinations, nullptr);
+        context->Dispatch((threadsX + 7) / 8, (threadsY + 7) / 8, 1);
+    }
+    else
+    {
+        ID3D11ComputeShader* vertical = nv12Destination ? m_verticalNv12CS.Get() : floatDestination ? m_verticalFloatCS.Get() : m_verticalCS.Get();
+        Dispatch(context, m_horizontalCS.Get(), m_horizontal, source, m_intermediateUAV.Get(), nullptr, m_dstWidth, m_srcHeight);
+        Dispatch(context, vertical, m_vertical, m_intermediateSRV.Get(), destination, chromaDestination, threadsX, threadsY);
+    }
+
+    // Unbind so the slot can be read by NvOFFRUC and the presenter.
+    ID3D11ShaderResourceView* nullSRV = nullptr;
+    ID3D11UnorderedAccessView* nullUAVs[] = { nullptr, nullptr };
+    context->CSSetShaderResources(0, 1, &nullSRV);
+    context->CSSetUnorderedAccessViews(0, 2, nullUAVs, nullptr);
+}
+
+// width and height count threads, which for an nv12 destination are 2x2 blocks.
+void CaptureScaler::Dispatch(ID3D11DeviceContext* context, ID3D11ComputeShader* shader, const Axis& axis,
+                             ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* destination, ID3D11UnorderedAccessView* chromaDestination,
+                             uint32_t width, uint32_t height)
+{
+    ID3D11Buffer* constants = axis.m_constants.Get();
+    ID3D11ShaderResourceView* views[] = { source, axis.m_weights.Get(), axis.m_starts.Get() };
+    ID3D11ShaderResourceView* nullViews[] = { nullptr, nullptr, nullptr };
+    ID3D11UnorderedAccessView* destinations[] = { destination, chromaDestination };
+
+    // Binding the output first releases the previous pass's UAV before it is read as an input.
+    context->CSSetUnorderedAccessViews(0, 2, destinations, nullptr);
+    context->CSSetShader(shader, nullptr, 0);
+    context->CSSetConstantBuffers(0, 1, &constants);
+    context->CSSetShaderResources(0, 3, views);
+    context->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+    context->CSSetShaderResources(0, 3, nullViews);
+}
+
+void CaptureScaler::ReleaseResources() noexcept
+{
+    m_convertCS.Reset();
+    m_horizontalCS.Reset();
+    m_verticalCS.Reset();
+    m_convertFloatCS.Reset();
+    m_verticalFloatCS.Reset();
+    m_convertNv12CS.Reset();
+    m_verticalNv12CS.Reset();
+    m_linearClampSampler.Reset();
+    m_convertConstants.Reset();
+    m_intermediate.Reset();
+    m_intermediateSRV.Reset();
+    m_intermediateUAV.Reset();
+    m_horizontal = Axis{};
+    m_vertical = Axis{};
+    m_srcWidth = m_srcHeight = m_dstWidth = m_dstHeight = 0;
+    m_sourceDirty = true;
+}
@@ -0,0 +1,83 @@
+//
+// CaptureScaler.h - GPU conversion and downscaling from the duplicated desktop into a ring slot
+//
+
+#pragma once
+
+#include "PixelFormat.h"
+#include "Resampler.h"
+
+namespace DX
+{
+    // Bilinear uses a single sampled pass. The other filters run two compute passes driven by
+    // the same weight tables as the CPU Resampler. The source may be a crop of a larger texture,
+    // which only changes a constant as it moves. The last pass also converts from the desktop's
+    // transfer function to the internal format's.
+    class CaptureScaler
+    {
+    public:
+        void CreateDeviceResources(ID3D11Device* device);
+        void Resize(ID3D11Device* device, uint32_t srcWidth, uint32_t srcHeight,
+                    uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter);
+
+        // Where the srcWidth x srcHeight crop sits in the textures passed to Process. Defaults to a
+        // source of exactly that size.
+        void SetSourceRegion(uint32_t x, uint32_t y, uint32_t sourceWidth, uint32_t sourceHeight) noexcept;
+        // The desktop's transfer function and the internal format written to the ring. Defaults to an
+        // sRGB desktop and rgba8 slots, which convert nothing.
+        void SetTransfer(TransferFunction source, PixelFormat destination, float sdrWhiteNits) noexcept;
+        // nv12 slots take their luma plane as destination and their chroma plane as chromaDestination.
+        void Process(ID3D11DeviceContext* context, ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* destination,
+                     ID3D11UnorderedAccessView* chromaDestination = nullptr);
+        void ReleaseResources() noexcept;
+
+        ScaleFilter GetFilter() const noexcept { return m_filter; }
+
+    private:
+        struct Axis
+        {
+            Microsoft::WRL::ComPtr<ID3D11Buffer>                m_constants;
+            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_weights;
+            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_starts;
+            uint32_t                                            m_taps = 0;
+        };
+
+        void CreateAxis(ID3D11Device* device, const ResampleWeights& table, uint32_t otherSize, bool horizontal, Axis& axis);
+        void UpdateSourceConstants(ID3D11DeviceContext* context);
+        void Dispatch(ID3D11DeviceContext* context, ID3D11ComputeShader* shader, const Axis& axis,
+                      ID3D11ShaderResourceView* source, ID3D11UnorderedAccessView* destination, ID3D11UnorderedAccessView* chromaDestination,
+                      uint32_t width, uint32_t height);
+
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_convertCS;
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_horizontalCS;
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_verticalCS;
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_convertFloatCS;       // For half-float slots.
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_verticalFloatCS;
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_convertNv12CS;        // For nv12 slots, one thread per 2x2 block.
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_verticalNv12CS;
+        Microsoft::WRL::ComPtr<ID3D11SamplerState>          m_linearClampSampler;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_convertConstants;
+
+        // Horizontal pass output: destination width by source height, FP16 so negative lobes survive.
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>             m_intermediate;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_intermediateSRV;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView>   m_intermediateUAV;
+
+        Axis                                                m_horizontal;
+        Axis                                                m_vertical;
+
+        ScaleFilter                                         m_filter = ScaleFilter::Bilinear;
+        uint32_t                                            m_srcWidth = 0;
+        uint32_t                                            m_srcHeight = 0;
+        uint32_t                                            m_dstWidth = 0;
+        uint32_t                                            m_dstHeight = 0;
+        uint32_t                                            m_sourceX = 0;
+        uint32_t                                            m_sourceY = 0;
+        uint32_t                                            m_sourceWidth = 0;      // Zero while the source is the crop.
+        uint32_t                                            m_sourceHeight = 0;
+        TransferFunction                                    m_sourceTransfer = TransferFunction::Srgb;
+        PixelFormat                                         m_destinationFormat = PixelFormat::Rgba8;
+        float                                               m_sdrWhiteNits = Transfer::ScRgbWhiteNits;
+        bool                                                m_sourceDirty = true;
+    };
+}
@@ -0,0 +1,201 @@
+//
+// CaptureScheduler.cpp - Share one GPU and CPU budget between the outputs being captured
+//
+
+#include "CaptureScheduler.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+namespace
+{
+    // Weight of a new measurement in the running cost estimate.
+    constexpr double c_EstimateGain = 1.0 / 8.0;
+
+    bool Fits(const SchedulerCost& cost, const SchedulerCost& remaining) noexcept
+    {
+        return cost.gpuSeconds <= remaining.gpuSeconds && cost.cpuSeconds <= remaining.cpuSeconds;
+    }
+}
+
+void CaptureScheduler::Resize(size_t outputs)
+{
+    m_outputs.resize(outputs);
+    m_reserved.erase(std::remove_if(m_reserved.begin(), m_reserved.end(), [outputs](size_t i) { return i >= outputs; }), m_reserved.end());
+    m_next = outputs == 0 ? 0 : m_next % outputs;
+}
+
+void CaptureScheduler::ResetStats() noexcept
+{
+    for (Output& output : m_outputs)
+        output.stats = {};
+    m_rounds = 0;
+    m_overBudgetRounds = 0;
+}
+
+double CaptureScheduler::NormalizedCost(const Output& output, const SchedulerCost& budget) const noexcept
+{
+    // An output that has never been served costs nothing until it has been measured once.
+    if (!output.measured)
+        return 0.0;
+    const double gpu = budget.gpuSeconds > 0.0 ? output.estimate.gpuSeconds / budget.gpuSeconds : 0.0;
+    const double cpu = budget.cpuSeconds > 0.0 ? output.estimate.cpuSeconds / budget.cpuSeconds : 0.0;
+    return std::max(gpu, cpu);
+}
+
+void CaptureScheduler::Serve(size_t index, double cost, double advance, SchedulerCost& remaining)
+{
+    Output& output = m_outputs[index];
+    m_plan.push_back(index);
+    output.start += advance;
+    output.stats.served++;
+    output.stats.serviceShare += cost;
+    output.stats.wait = 0;
+    remaining.gpuSeconds -= output.estimate.gpuSeconds;
+    remaining.cpuSeconds -= output.estimate.cpuSeconds;
+}
+
+const std::vector<size_t>& CaptureScheduler::Plan(const SchedulerCost& budget)
+{
+    m_plan.clear();
+    m_rounds++;
+    const size_t count = m_outputs.size();
+
+    // A non-positive budget leaves that resource unconstrained. What an oversize serve overspent is
+    // paid back out of the following rounds, so the budget holds on average.
+    const bool limitGpu = budget.gpuSeconds > 0.0;
+    const bool limitCpu = budget.cpuSeconds > 0.0;
+    const bool inDebt = m_debt.gpuSeconds > 0.0 || m_debt.cpuSeconds > 0.0;
+    SchedulerCost remaining = {
+        limitGpu ? budget.gpuSeconds - m_debt.gpuSeconds : 1e300,
+        limitCpu ? budget.cpuSeconds - m_debt.cpuSeconds : 1e300,
+    };
+
+    // An output that just got work joins at the current virtual time: it can't spend credit it
+    // didn't use while idle.
+    std::vector<size_t> order;
+    double totalWeight = 0.0;
+    for (size_t k = 0; k < count; k++)
+    {
+        const size_t i = (m_next + k) % count;
+        Output& output = m_outputs[i];
+        if (!output.hasWork || output.weight <= 0.0)
+        {
+            output.backlogged = false;
+            output.stats.wait = 0;
+            continue;
+        }
+        if (!output.backlogged)
+            output.start = std::max(output.start, m_virtualTime);
+        output.backlogged = true;
+        output.stats.rounds++;
+        totalWeight += output.weight;
+        order.push_back(i);
+    }
+
+    // An output cheaper than its share can't be served more than once a round, so it mustn't bank
+    // the rest and fall behind in virtual time.
+    std::vector<double> costs(count, 0.0), advance(count, 0.0), finish(count, 0.0);
+    for (size_t i : order)
+    {
+        const Output& output = m_outputs[i];
+        costs[i] = NormalizedCost(output, budget);
+        advance[i] = std::max(costs[i] / output.weight, 1.0 / totalWeight);
+        finish[i] = output.start + advance[i];
+    }
+    std::stable_sort(order.begin(), order.end(), [&finish](size_t a, size_t b) { return finish[a] < finish[b]; });
+
+    // Reserved outputs go first, in the order they were reserved, until one doesn't fit. It is
+    // served anyway if it is the first and nothing is still owed, which only happens when it is
+    // bigger than the budget.
+    std::vector<bool> served(count, false);
+    m_reserved.erase(std::remove_if(m_reserved.begin(), m_reserved.end(), [this](size_t i) { return !m_outputs[i].backlogged; }), m_reserved.end());
+    size_t reservedServed = 0;
+    for (; reservedServed < m_reserved.size(); reservedServed++)
+    {
+        const size_t i = m_reserved[reservedServed];
+        const bool fits = Fits(m_outputs[i].estimate, remaining);
+        if (!fits && !(m_plan.empty() && !inDebt))
+            break;
+        m_overBudgetRounds += fits ? 0 : 1;
+        Serve(i, costs[i], advance[i], remaining);
+        served[i] = true;
+    }
+    const bool blocked = reservedServed < m_reserved.size();
+    m_reserved.erase(m_reserved.begin(), m_reserved.begin() + reservedServed);
+
+    // Fair pass: in finish order until one doesn't fit. An output bigger than the budget that
+    // stops the pass is reserved.
+    size_t next = 0;
+    for (; next < order.size() && !blocked; next++)
+    {
+        const size_t i = order[next];
+        if (served[i])
+            continue;
+        const bool fits = Fits(m_outputs[i].estimate, remaining);
+        if (!fits && !(m_plan.empty() && !inDebt))
+        {
+            if (costs[i] > 1.0 && std::find(m_reserved.begin(), m_reserved.end(), i) == m_reserved.end())
+                m_reserved.push_back(i);
+            break;
+        }
+        m_overBudgetRounds += fits ? 0 : 1;
+        Serve(i, costs[i], advance[i], remaining);
+        served[i] = true;
+    }
+
+    // Spare budget goes to whoever still fits, short of those already a round or more ahead.
+    for (size_t i : order)
+    {
+        if (!served[i] && m_outputs[i].start < m_virtualTime + 1.0 / totalWeight && Fits(m_outputs[i].estimate, remaining))
+        {
+            Serve(i, costs[i], advance[i], remaining);
+            served[i] = true;
+        }
+    }
+
+    // Waiting more rounds than it takes its share to earn a serve reserves the next one.
+    for (size_t i : order)
+    {
+        const double quantum = m_outputs[i].weight / totalWeight;
+        if (!served[i] && double(m_outputs[i].stats.wait + 1) * quantum >= costs[i]
+            && std::find(m_reserved.begin(), m_reserved.end(), i) == m_reserved.end())
+        {
+            m_reserved.push_back(i);
+        }
+    }
+
+    double virtualTime = -1.0;
+    for (size_t i : order)
+    {
+        SchedulerStats& stats = m_outputs[i].stats;
+        if (!served[i])
+        {
+            stats.wait++;
+            stats.maxWait = std::max(stats.maxWait, stats.wait);
+        }
+        if (virtualTime < 0.0 || m_outputs[i].start < virtualTime)
+            virtualTime = m_outputs[i].start;
+    }
+    if (virtualTime >= 0.0)
+        m_virtualTime = std::max(m_virtualTime, virtualTime);
+
+    m_debt.gpuSeconds = limitGpu ? std::max(0.0, -remaining.gpuSeconds) : 0.0;
+    m_debt.cpuSeconds = limitCpu ? std::max(0.0, -remaining.cpuSeconds) : 0.0;
+    m_next = count == 0 ? 0 : (m_next + 1) % count;
+    return m_plan;
+}
+
+void CaptureScheduler::Report(size_t output, const SchedulerCost& measured) noexcept
+{
+    Output& entry = m_outputs[output];
+    if (!entry.measured)
+    {
+        entry.estimate = measured;
+        entry.measured = true;
+        return;
+    }
+    entry.estimate.gpuSeconds += (measured.gpuSeconds - entry.estimate.gpuSeconds) * c_EstimateGain;
+    entry.estimate.cpuSeconds += (measured.cpuSeconds - entry.estimate.cpuSeconds) * c_EstimateGain;
+}
@@ -0,0 +1,93 @@
+//
+// CaptureScheduler.h - Share one GPU and CPU budget between the outputs being captured
+//
+// Every output has its own duplication session and NvOFFRUC instance, but they all draw on the same
+// GPU and the same render thread. Each round (one interpolated present) the scheduler picks which
+// outputs with a fresh frame get interpolated. It is start-time fair queueing on the dominant
+// resource: an output's cost is the larger of its GPU and CPU estimates as a fraction of the
+// round's budget, each serve advances the output's virtual time by cost / weight (at least a
+// round of its share, since it can't be served twice in a round), and the outputs furthest behind
+// go first until one doesn't fit. Budget left after that goes to whoever still fits and isn't
+// already ahead. Whole serves don't always pack, so an output that has waited longer than its
+// weight entitles it to, or that is bigger than the whole budget, has the next round reserved.
+// Costs are measured by the caller and fed back through Report.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+    struct SchedulerCost
+    {
+        double gpuSeconds = 0.0;
+        double cpuSeconds = 0.0;
+    };
+
+    struct SchedulerStats
+    {
+        uint64_t    rounds = 0;         // Rounds the output had work in.
+        uint64_t    served = 0;
+        uint32_t    wait = 0;           // Rounds since it was last served, while it had work.
+        uint32_t    maxWait = 0;
+        double      serviceShare = 0.0; // Sum of the normalized costs it was served at.
+    };
+
+    class CaptureScheduler
+    {
+    public:
+        explicit CaptureScheduler(size_t outputs = 0) { Resize(outputs); }
+
+        // Outputs keep their state across a resize; new ones start with weight 1 and no work.
+        void Resize(size_t outputs);
+        size_t OutputCount() const noexcept { return m_outputs.size(); }
+
+        // Relative share of the budget. Zero never schedules the output.
+        void SetWeight(size_t output, double weight) noexcept { m_outputs[output].weight = weight < 0.0 ? 0.0 : weight; }
+        double Weight(size_t output) const noexcept { return m_outputs[output].weight; }
+
+        // Whether the output has a frame to interpolate this round.
+        void SetWork(size_t output, bool hasWork) noexcept { m_outputs[output].hasWork = hasWork; }
+
+        // Outputs to serve this round, in order. An output bigger than the whole budget is served
+        // anyway when its turn comes; that round counts as over budget and the overspend comes out
+        // of the rounds after it.
+        const std::vector<size_t>& Plan(const SchedulerCost& budget);
+
+        // What serving the output actually cost; folded into its estimate.
+        void Report(size_t output, const SchedulerCost& measured) noexcept;
+        const SchedulerCost& Estimate(size_t output) const noexcept { return m_outputs[output].estimate; }
+
+        const SchedulerStats& Stats(size_t output) const noexcept { return m_outputs[output].stats; }
+        uint64_t Rounds() const noexcept { return m_rounds; }
+        uint64_t OverBudgetRounds() const noexcept { return m_overBudgetRounds; }
+        void ResetStats() noexcept;
+
+    private:
+        struct Output
+        {
+            double          weight = 1.0;
+            bool            hasWork = false;
+            bool            backlogged = false;
+            bool            measured = false;
+            double          start = 0.0;        // Virtual time of the output's next serve.
+            SchedulerCost   estimate;
+            SchedulerStats  stats;
+        };
+
+        double NormalizedCost(const Output& output, const SchedulerCost& budget) const noexcept;
+        void Serve(size_t index, double cost, double advance, SchedulerCost& remaining);
+
+        std::vector<Output> m_outputs;
+        std::vector<size_t> m_plan;
+        SchedulerCost       m_debt;                 // Overspend still to be paid back.
+        double              m_virtualTime = 0.0;    // Earliest start among backlogged outputs.
+        size_t              m_next = 0;             // Round robin among outputs with equal finish times.
+        std::vector<size_t> m_reserved;             // Go first next round, in this order.
+        uint64_t            m_rounds = 0;
+        uint64_t            m_overBudgetRounds = 0;
+    };
+}
@@ -0,0 +1,95 @@
+//
+// ColorConvert.h - RGBA <-> planar YUV 4:2:0 conversion (BT.709, limited range)
+//
+
+#pragma once
+
+#include "Image.h"
+
+#include <algorithm>
+
+namespace DX
+{
+    // Three 8-bit planes with chroma subsampled 2x2.
+    struct I420Image
+    {
+        Image y;
+        Image u;
+        Image v;
+
+        void Resize(uint32_t width, uint32_t height)
+        {
+            y.Resize(width, height, 1);
+            u.Resize((width + 1) / 2, (height + 1) / 2, 1);
+            v.Resize((width + 1) / 2, (height + 1) / 2, 1);
+        }
+
+        uint32_t Width() const noexcept { return y.Width(); }
+        uint32_t Height() const noexcept { return y.Height(); }
+    };
+
+    namespace Detail
+    {
+        inline uint8_t ClampByte(int value) noexcept
+        {
+            return static_cast<uint8_t>(std::clamp(value, 0, 255));
+        }
+
+        // BT.709 limited range in 8.8 fixed point.
+        inline uint8_t RgbToY(int r, int g, int b) noexcept { return ClampByte(((47 * r + 157 * g + 16 * b + 128) >> 8) + 16); }
+        inline uint8_t RgbToU(int r, int g, int b) noexcept { return ClampByte(((-26 * r - 87 * g + 112 * b + 128) >> 8) + 128); }
+        inline uint8_t RgbToV(int r, int g, int b) noexcept { return ClampByte(((112 * r - 102 * g - 10 * b + 128) >> 8) + 128); }
+    }
+
+    // Chroma is the average of each 2x2 block.
+    inline void ConvertRGBAToI420(ConstImageView rgba, I420Image& yuv)
+    {
+        yuv.Resize(rgba.width, rgba.height);
+        for (uint32_t y = 0; y < rgba.height; y++)
+        {
+            const uint8_t* in = rgba.Row(y);
+            uint8_t* out = yuv.y.View().Row(y);
+            for (uint32_t x = 0; x < rgba.width; x++)
+                out[x] = Detail::RgbToY(in[x * 4], in[x * 4 + 1], in[x * 4 + 2]);
+        }
+
+        for (uint32_t cy = 0; cy < yuv.u.Height(); cy++)
+        {
+            const uint8_t* row0 = rgba.Row(cy * 2);
+            const uint8_t* row1 = rgba.Row(std::min(cy * 2 + 1, rgba.height - 1));
+            uint8_t* outU = yuv.u.View().Row(cy);
+            uint8_t* outV = yuv.v.View().Row(cy);
+            for (uint32_t cx = 0; cx < yuv.u.Width(); cx++)
+            {
+                const uint32_t x0 = cx * 2 * 4;
+                const uint32_t x1 = std::min(cx * 2 + 1, rgba.width - 1) * 4;
+                const int r = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+                const int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) >> 2;
+                const int b = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) >> 2;
+                outU[cx] = Detail::RgbToU(r, g, b);
+                outV[cx] = Detail::RgbToV(r, g, b);
+            }
+        }
+    }
+
+    inline void ConvertI420ToRGBA(const I420Image& yuv, ImageView rgba)
+    {
+        for (uint32_t y = 0; y < rgba.height; y++)
+        {
+            const uint8_t* inY = yuv.y.View().Row(y);
+            const uint8_t* inU = yuv.u.View().Row(y / 2);
+            const uint8_t* inV = yuv.v.View().Row(y / 2);
+            uint8_t* out = rgba.Row(y);
+            for (uint32_t x = 0; x < rgba.width; x++)
+            {
+                const int c = (inY[x] - 16) * 298;
+                const int d = inU[x / 2] - 128;
+                const int e = inV[x / 2] - 128;
+                out[x * 4 + 0] = Detail::ClampByte((c + 459 * e + 128) >> 8);
+                out[x * 4 + 1] = Detail::ClampByte((c - 55 * d - 136 * e + 128) >> 8);
+                out[x * 4 + 2] = Detail::ClampByte((c + 541 * d + 128) >> 8);
+                out[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
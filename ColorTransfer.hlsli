@@ -0,0 +1,102 @@
+//
+// ColorTransfer.hlsli - Transfer functions shared by the capture and present shaders
+//
+// Mirrors the Transfer namespace in PixelFormat.h: conversions go through scRGB, linear BT.709 where
+// 1.0 is 80 nits. The transfer ids match DX::TransferFunction.
+//
+
+#define TRANSFER_SRGB   0
+#define TRANSFER_LINEAR 1
+#define TRANSFER_PQ     2
+
+static const float ScRgbWhiteNits = 80.0f;
+static const float PqPeakNits = 10000.0f;
+static const float SoftClipKnee = 0.9f;
+
+static const float3x3 Bt709ToBt2020 =
+{
+    0.6274040f, 0.3292820f, 0.0433136f,
+    0.0690970f, 0.9195400f, 0.0113612f,
+    0.0163916f, 0.0880132f, 0.8955950f,
+};
+
+static const float3x3 Bt2020ToBt709 =
+{
+     1.6604910f, -0.5876411f, -0.0728499f,
+    -0.1245505f,  1.1328999f, -0.0083494f,
+    -0.0181508f, -0.1005789f,  1.1187297f,
+};
+
+float3 SrgbToLinear(float3 v)
+{
+    v = max(v, 0.0f);
+    return v <= 0.04045f ? v / 12.92f : pow((v + 0.055f) / 1.055f, 2.4f);
+}
+
+float3 LinearToSrgb(float3 v)
+{
+    v = saturate(v);
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+float3 LinearToPq(float3 v)
+{
+    float3 p = pow(max(v, 0.0f), 0.1593017578125f);
+    return pow((0.8359375f + 18.8515625f * p) / (1.0f + 18.6875f * p), 78.84375f);
+}
+
+float3 PqToLinear(float3 v)
+{
+    float3 p = pow(saturate(v), 1.0f / 78.84375f);
+    return pow(max(p - 0.8359375f, 0.0f) / (18.8515625f - 18.6875f * p), 1.0f / 0.1593017578125f);
+}
+
+float3 SoftClip(float3 v)
+{
+    float range = 1.0f - SoftClipKnee;
+    return v <= SoftClipKnee ? v : SoftClipKnee + range * (1.0f - exp(-(v - SoftClipKnee) / range));
+}
+
+float3 DecodeTransfer(float3 v, uint transfer, float sdrWhiteNits)
+{
+    if (transfer == TRANSFER_SRGB)
+        return SrgbToLinear(v) * (sdrWhiteNits / ScRgbWhiteNits);
+    if (transfer == TRANSFER_PQ)
+        return mul(Bt2020ToBt709, PqToLinear(v) * (PqPeakNits / ScRgbWhiteNits));
+    return v;
+}
+
+float3 EncodeTransfer(float3 v, uint transfer, float sdrWhiteNits)
+{
+    if (transfer == TRANSFER_SRGB)
+        return LinearToSrgb(SoftClip(v * (ScRgbWhiteNits / sdrWhiteNits)));
+    if (transfer == TRANSFER_PQ)
+        return LinearToPq(mul(Bt709ToBt2020, v) * (ScRgbWhiteNits / PqPeakNits));
+    return v;
+}
+
+// BT.709 limited range on sRGB codes, as ColorConvert.h, for nv12 slots. Chroma is (Cb, Cr).
+float RgbToLuma(float3 rgb)
+{
+    return (16.0f + dot(rgb, float3(46.559f, 156.629f, 15.812f))) / 255.0f;
+}
+
+float2 RgbToChroma(float3 rgb)
+{
+    return (128.0f + float2(dot(rgb, float3(-25.664f, -86.336f, 112.0f)), dot(rgb, float3(112.0f, -101.730f, -10.270f)))) / 255.0f;
+}
+
+float3 LumaChromaToRgb(float luma, float2 chroma)
+{
+    float y = (luma * 255.0f - 16.0f) / 219.0f;
+    float2 c = (chroma * 255.0f - 128.0f) / 224.0f;
+    return saturate(float3(y + 1.5748f * c.y, y - 0.1873f * c.x - 0.4681f * c.y, y + 1.8556f * c.x));
+}
+
+// The transfers are constants, so the branches are uniform; matching ones cost nothing.
+float3 ConvertTransfer(float3 v, uint source, uint destination, float sdrWhiteNits)
+{
+    if (source == destination)
+        return v;
+    return EncodeTransfer(DecodeTransfer(v, source, sdrWhiteNits), destination, sdrWhiteNits);
+}
@@ -0,0 +1,83 @@
+//
+// CursorCache.h - Uploaded cursor shapes keyed by shape hash, least recently used evicted first
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    struct CursorCacheStats
+    {
+        uint64_t hits = 0;
+        uint64_t uploads = 0;
+        uint64_t evictions = 0;
+    };
+
+    // A handful of shapes (arrow, I-beam, resize, busy) cover nearly every session, so a short
+    // vector scanned linearly beats a map. TEntry holds whatever was uploaded and releases it when destroyed.
+    template<typename TEntry>
+    class CursorCache
+    {
+    public:
+        explicit CursorCache(size_t capacity = 16) : m_capacity(capacity == 0 ? 1 : capacity) {}
+
+        // The entry for hash, or nullptr. Counts a hit and marks the entry most recently used.
+        TEntry* Find(uint64_t hash)
+        {
+            for (auto& slot : m_slots)
+            {
+                if (slot.hash != hash)
+                    continue;
+                slot.lastUse = ++m_clock;
+                m_stats.hits++;
+                return &slot.entry;
+            }
+            return nullptr;
+        }
+
+        // Store a newly uploaded shape, evicting the least recently used one if the cache is full.
+        // Pointers from earlier calls may dangle afterwards.
+        TEntry& Insert(uint64_t hash, TEntry entry)
+        {
+            m_stats.uploads++;
+            if (m_slots.size() < m_capacity)
+            {
+                m_slots.push_back({ hash, ++m_clock, std::move(entry) });
+                return m_slots.back().entry;
+            }
+
+            size_t oldest = 0;
+            for (size_t i = 1; i < m_slots.size(); i++)
+            {
+                if (m_slots[i].lastUse < m_slots[oldest].lastUse)
+                    oldest = i;
+            }
+            m_stats.evictions++;
+            m_slots[oldest] = { hash, ++m_clock, std::move(entry) };
+            return m_slots[oldest].entry;
+        }
+
+        void Clear() { m_slots.clear(); }
+
+        size_t Size() const noexcept { return m_slots.size(); }
+        const CursorCacheStats& GetStats() const noexcept { return m_stats; }
+
+    private:
+        struct Slot
+        {
+            uint64_t hash;
+            uint64_t lastUse;
+            TEntry entry;
+        };
+
+        std::vector<Slot>   m_slots;
+        size_t              m_capacity;
+        uint64_t            m_clock = 0;
+        CursorCacheStats    m_stats;
+    };
+}
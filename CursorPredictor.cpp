@@ -0,0 +1,251 @@
+//
+// CursorPredictor.cpp - Extrapolate the pointer to the vblank a frame will be shown on
+//
+
+#include "CursorPredictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DX;
+
+namespace
+{
+    // Initial velocity variance after a rest, in px^2/s^2: the first samples decide the velocity.
+    constexpr double c_RestVelocityVariance = 1.0e6;
+
+    // Accepted range of measured refresh periods around the nominal one.
+    constexpr double c_MinPeriodRatio = 0.25;
+    constexpr double c_MaxPeriodRatio = 4.0;
+
+    constexpr double c_TraceTicksPerMillisecond = 1e6;
+}
+
+void CursorPredictor::KalmanAxis::Reset(double measured, double measurementNoise) noexcept
+{
+    position = measured;
+    velocity = 0.0;
+    p00 = measurementNoise;
+    p01 = 0.0;
+    p11 = c_RestVelocityVariance;
+}
+
+void CursorPredictor::KalmanAxis::Update(double measured, double dt, const CursorPredictorSettings& settings) noexcept
+{
+    // Predict with constant velocity; white-noise acceleration grows the covariance.
+    const double q = settings.accelerationNoise;
+    position += velocity * dt;
+    const double q00 = p00 + 2.0 * dt * p01 + dt * dt * p11 + q * dt * dt * dt / 3.0;
+    const double q01 = p01 + dt * p11 + q * dt * dt / 2.0;
+    const double q11 = p11 + q * dt;
+
+    // Correct with the measured position.
+    const double s = q00 + settings.measurementNoise;
+    const double k0 = q00 / s;
+    const double k1 = q01 / s;
+    const double residual = measured - position;
+    position += k0 * residual;
+    velocity += k1 * residual;
+    p00 = (1.0 - k0) * q00;
+    p01 = (1.0 - k0) * q01;
+    p11 = q11 - k1 * q01;
+}
+
+CursorPredictor::CursorPredictor(uint64_t ticksPerSecond, CursorPrediction prediction, const CursorPredictorSettings& settings) noexcept :
+    m_ticksPerSecond(std::max<uint64_t>(ticksPerSecond, 1)),
+    m_prediction(prediction),
+    m_settings(settings)
+{
+}
+
+void CursorPredictor::Reset() noexcept
+{
+    m_head = 0;
+    m_count = 0;
+}
+
+void CursorPredictor::AddSample(const PointerSample& sample) noexcept
+{
+    if (m_count != 0 && sample.ticks <= Newest().ticks)
+        return;
+
+    // After a rest the pointer starts from standstill; both predictors forget the old motion.
+    const bool rested = m_count == 0 || Seconds(sample.ticks - Newest().ticks) > m_settings.restSeconds;
+    if (rested)
+    {
+        m_kalmanX.Reset(sample.x, m_settings.measurementNoise);
+        m_kalmanY.Reset(sample.y, m_settings.measurementNoise);
+    }
+    else
+    {
+        const double dt = Seconds(sample.ticks - Newest().ticks);
+        m_kalmanX.Update(sample.x, dt, m_settings);
+        m_kalmanY.Update(sample.y, dt, m_settings);
+    }
+
+    m_history[m_head] = sample;
+    m_head = (m_head + 1) % HistoryCapacity;
+    m_count = std::min(m_count + 1, HistoryCapacity);
+}
+
+bool CursorPredictor::LeastSquaresVelocity(double& vx, double& vy) const noexcept
+{
+    // Walk back from the newest sample while samples are recent and not separated by a rest.
+    const PointerSample& newest = Newest();
+    size_t used = 1;
+    double times[HistoryCapacity] = {};
+    const PointerSample* samples[HistoryCapacity] = { &newest };
+    double sumT = 0.0, sumX = newest.x, sumY = newest.y;
+    for (size_t i = 1; i < m_count; i++)
+    {
+        const PointerSample& sample = m_history[(m_head + HistoryCapacity - 1 - i) % HistoryCapacity];
+        const PointerSample& later = *samples[used - 1];
+        if (Seconds(newest.ticks - sample.ticks) > m_settings.historySeconds || Seconds(later.ticks - sample.ticks) > m_settings.restSeconds)
+            break;
+        times[used] = -Seconds(newest.ticks - sample.ticks);
+        samples[used] = &sample;
+        sumT += times[used];
+        sumX += sample.x;
+        sumY += sample.y;
+        used++;
+    }
+    if (used < 2)
+        return false;
+
+    const double meanT = sumT / double(used);
+    const double meanX = sumX / double(used);
+    const double meanY = sumY / double(used);
+    double stt = 0.0, stx = 0.0, sty = 0.0;
+    for (size_t i = 0; i < used; i++)
+    {
+        const double dt = times[i] - meanT;
+        stt += dt * dt;
+        stx += dt * (samples[i]->x - meanX);
+        sty += dt * (samples[i]->y - meanY);
+    }
+    if (stt <= 0.0)
+        return false;
+    vx = stx / stt;
+    vy = sty / stt;
+    return true;
+}
+
+bool CursorPredictor::Predict(uint64_t targetTicks, double& x, double& y) const noexcept
+{
+    if (m_count == 0)
+        return false;
+
+    const PointerSample& newest = Newest();
+    x = newest.x;
+    y = newest.y;
+    if (m_prediction == CursorPrediction::Off || targetTicks <= newest.ticks)
+        return true;
+
+    // A pointer that hasn't reported for a while has stopped; extrapolating would only make it drift.
+    const double ahead = Seconds(targetTicks - newest.ticks);
+    if (ahead > m_settings.restSeconds)
+        return true;
+    const double dt = std::min(ahead, m_settings.maxHorizonSeconds);
+
+    if (m_prediction == CursorPrediction::Kalman)
+    {
+        x = m_kalmanX.position + m_kalmanX.velocity * dt;
+        y = m_kalmanY.position + m_kalmanY.velocity * dt;
+        return true;
+    }
+
+    double vx = 0.0, vy = 0.0;
+    if (LeastSquaresVelocity(vx, vy))
+    {
+        x += vx * dt;
+        y += vy * dt;
+    }
+    return true;
+}
+
+void VblankClock::OnVblank(uint32_t refreshCount, uint64_t ticks) noexcept
+{
+    if (ticks == 0 || (m_lastTicks != 0 && (refreshCount == m_lastCount || ticks <= m_lastTicks)))
+        return;
+
+    if (m_lastTicks != 0 && refreshCount > m_lastCount)
+    {
+        // Smooth the measured period; a mode change or a bogus report shouldn't throw it off.
+        const double period = double(ticks - m_lastTicks) / double(refreshCount - m_lastCount);
+        const double nominal = double(m_nominalPeriod);
+        if (m_nominalPeriod == 0 || (period > nominal * c_MinPeriodRatio && period < nominal * c_MaxPeriodRatio))
+            m_period = m_period > 0.0 ? m_period + (period - m_period) / 8.0 : period;
+    }
+    m_lastTicks = ticks;
+    m_lastCount = refreshCount;
+}
+
+uint64_t VblankClock::NextAfter(uint64_t ticks) const noexcept
+{
+    if (m_period <= 0.0)
+        return ticks;
+    if (m_lastTicks == 0)
+        return ticks + Period();
+    if (ticks < m_lastTicks)
+        return m_lastTicks;
+
+    const double periods = std::floor(double(ticks - m_lastTicks) / m_period) + 1.0;
+    return m_lastTicks + static_cast<uint64_t>(periods * m_period);
+}
+
+bool DX::WritePointerTrace(const std::string& path, const std::vector<PointerSample>& samples, uint64_t ticksPerSecond)
+{
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, path.c_str(), "wb");
+#else
+    file = fopen(path.c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "ms,x,y\n");
+    const uint64_t start = samples.empty() ? 0 : samples.front().ticks;
+    for (const PointerSample& sample : samples)
+        fprintf(file, "%.3f,%.2f,%.2f\n", 1000.0 * double(sample.ticks - start) / double(ticksPerSecond), sample.x, sample.y);
+
+    const bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+bool DX::ReadPointerTrace(const std::string& path, std::vector<PointerSample>& samples)
+{
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, path.c_str(), "rb");
+#else
+    file = fopen(path.c_str(), "rb");
+#endif
+    if (file == nullptr)
+        return false;
+
+    samples.clear();
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        double fields[3] = {};
+        const char* cursor = line;
+        size_t parsed = 0;
+        for (; parsed < 3; parsed++)
+        {
+            char* end = nullptr;
+            fields[parsed] = strtod(cursor, &end);
+            if (end == cursor || (parsed < 2 && *end != ','))
+                break;
+            cursor = end + 1;
+        }
+        if (parsed != 3 || fields[0] < 0.0)
+            continue;
+        samples.push_back({ static_cast<uint64_t>(fields[0] * c_TraceTicksPerMillisecond), fields[1], fields[2] });
+    }
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,142 @@
+//
+// CursorPredictor.h - Extrapolate the pointer to the vblank a frame will be shown on
+//
+// The cursor is drawn after interpolation, at present time, from the newest pointer sample. By the
+// time the frame scans out the pointer has moved on, so the sample history is extrapolated to the
+// expected vblank. Positions are in desktop pixels and timestamps are raw ticks of one clock (QPC in
+// the viewer, simulated time in the cursorsim tool), as in LatencyTracker.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    enum class CursorPrediction
+    {
+        Off,                // Newest sample as is.
+        ConstantVelocity,   // Least-squares velocity over the recent samples.
+        Kalman,             // Constant-velocity Kalman filter, which smooths jittery samples.
+        Count,
+    };
+
+    inline const char* CursorPredictionName(CursorPrediction prediction) noexcept
+    {
+        switch (prediction)
+        {
+        case CursorPrediction::ConstantVelocity:    return "velocity";
+        case CursorPrediction::Kalman:              return "kalman";
+        default:                                    return "off";
+        }
+    }
+
+    // Inverse of CursorPredictionName. Returns false for unknown names.
+    inline bool CursorPredictionFromName(const char* name, CursorPrediction& prediction) noexcept
+    {
+        for (int i = 0; i < static_cast<int>(CursorPrediction::Count); i++)
+        {
+            if (std::strcmp(name, CursorPredictionName(static_cast<CursorPrediction>(i))) == 0)
+            {
+                prediction = static_cast<CursorPrediction>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    struct PointerSample
+    {
+        uint64_t    ticks = 0;
+        double      x = 0.0;
+        double      y = 0.0;
+    };
+
+    struct CursorPredictorSettings
+    {
+        double historySeconds = 0.05;       // Samples older than this don't inform the velocity.
+        double restSeconds = 0.04;          // No sample for this long means the pointer stopped.
+        double maxHorizonSeconds = 0.033;   // Never extrapolate further than this past the newest sample.
+        double accelerationNoise = 2.0e7;   // Kalman process noise, in px^2/s^3.
+        double measurementNoise = 0.25;     // Kalman measurement noise, in px^2.
+    };
+
+    class CursorPredictor
+    {
+    public:
+        static constexpr size_t HistoryCapacity = 16;
+
+        explicit CursorPredictor(uint64_t ticksPerSecond = 1000000000, CursorPrediction prediction = CursorPrediction::ConstantVelocity,
+            const CursorPredictorSettings& settings = {}) noexcept;
+
+        void SetPrediction(CursorPrediction prediction) noexcept { m_prediction = prediction; }
+        CursorPrediction Prediction() const noexcept { return m_prediction; }
+        void Reset() noexcept;
+
+        // Samples must arrive in time order; one no newer than the last is ignored.
+        void AddSample(const PointerSample& sample) noexcept;
+
+        // Where the pointer is expected to be at targetTicks. Returns false before the first sample.
+        bool Predict(uint64_t targetTicks, double& x, double& y) const noexcept;
+
+        bool HasSamples() const noexcept { return m_count != 0; }
+        const PointerSample& Newest() const noexcept { return m_history[(m_head + HistoryCapacity - 1) % HistoryCapacity]; }
+
+    private:
+        // Position and velocity along one axis, with their covariance.
+        struct KalmanAxis
+        {
+            double position = 0.0;
+            double velocity = 0.0;
+            double p00 = 0.0;
+            double p01 = 0.0;
+            double p11 = 0.0;
+
+            void Reset(double measured, double measurementNoise) noexcept;
+            void Update(double measured, double dt, const CursorPredictorSettings& settings) noexcept;
+        };
+
+        bool LeastSquaresVelocity(double& vx, double& vy) const noexcept;
+        double Seconds(uint64_t ticks) const noexcept { return double(ticks) / double(m_ticksPerSecond); }
+
+        uint64_t                                    m_ticksPerSecond;
+        CursorPrediction                            m_prediction;
+        CursorPredictorSettings                     m_settings;
+        std::array<PointerSample, HistoryCapacity>  m_history = {};
+        size_t                                      m_head = 0;
+        size_t                                      m_count = 0;
+        KalmanAxis                                  m_kalmanX;
+        KalmanAxis                                  m_kalmanY;
+    };
+
+    // Phase and period of the display refresh, from present statistics, to find when a Present will show.
+    class VblankClock
+    {
+    public:
+        explicit VblankClock(uint64_t nominalPeriodTicks = 0) noexcept : m_period(double(nominalPeriodTicks)), m_nominalPeriod(nominalPeriodTicks) {}
+
+        // Present statistics: refresh number refreshCount happened at ticks.
+        void OnVblank(uint32_t refreshCount, uint64_t ticks) noexcept;
+
+        // The first vblank after ticks. Without statistics yet, one nominal period later.
+        uint64_t NextAfter(uint64_t ticks) const noexcept;
+        uint64_t Period() const noexcept { return static_cast<uint64_t>(m_period); }
+
+    private:
+        double      m_period;
+        uint64_t    m_nominalPeriod;
+        uint64_t    m_lastTicks = 0;
+        uint32_t    m_lastCount = 0;
+    };
+
+    // "milliseconds,x,y" rows, one per sample, relative to the first sample's time.
+    bool WritePointerTrace(const std::string& path, const std::vector<PointerSample>& samples, uint64_t ticksPerSecond);
+
+    // Read a WritePointerTrace file into nanosecond ticks. Lines that don't parse, such as a header, are skipped.
+    bool ReadPointerTrace(const std::string& path, std::vector<PointerSample>& samples);
+}
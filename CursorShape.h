@@ -0,0 +1,275 @@
+//
+// CursorShape.h - Decode Desktop Duplication pointer shapes into RGBA sprites
+//
+// Duplication reports three kinds of shape (DXGI_OUTDUPL_POINTER_SHAPE_TYPE):
+//     Monochrome   1 bpp AND mask over 1 bpp XOR mask, so the buffer is twice the cursor's height.
+//                  AND 0 / XOR 0 is black, 0 / 1 white, 1 / 0 transparent and 1 / 1 inverts the screen.
+//     Color        32 bpp BGRA with straight alpha.
+//     MaskedColor  32 bpp BGRX whose top byte is a mask: 0 draws the colour opaque, 0xFF XORs it with the screen.
+// Sprites can't read the screen, so each shape decodes into two images: premultiplied RGBA for the usual
+// alpha blend, and the colour to XOR with, drawn with a blend of src * (1 - dst) + dst * (1 - src). That is
+// exact for inverting with white and a close stand-in for XOR with other colours.
+//
+
+#pragma once
+
+#include "Image.h"
+#include "Simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace DX
+{
+    // Values match DXGI_OUTDUPL_POINTER_SHAPE_TYPE.
+    enum class CursorShapeType : uint32_t
+    {
+        Monochrome = 1,
+        Color = 2,
+        MaskedColor = 4,
+    };
+
+    // Mirrors DXGI_OUTDUPL_POINTER_SHAPE_INFO. For monochrome shapes height covers both masks.
+    struct CursorShapeInfo
+    {
+        CursorShapeType type = CursorShapeType::Color;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t pitch = 0;
+        int32_t hotspotX = 0;
+        int32_t hotspotY = 0;
+    };
+
+    struct DecodedCursor
+    {
+        Image color;            // Premultiplied RGBA.
+        Image xorMask;          // RGB to XOR with the screen, zero where the screen is left alone.
+        bool hasXor = false;
+        int32_t hotspotX = 0;
+        int32_t hotspotY = 0;
+
+        uint32_t Width() const noexcept { return color.Width(); }
+        uint32_t Height() const noexcept { return color.Height(); }
+    };
+
+    namespace Detail
+    {
+        // Swap B and R of packed little-endian pixels.
+        inline uint32_t SwapRedBlue(uint32_t pixel) noexcept
+        {
+            return (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+        }
+
+        // x * a / 255, rounded; exact for every 8-bit input.
+        inline uint32_t MulDiv255(uint32_t x, uint32_t a) noexcept
+        {
+            const uint32_t t = x * a + 128;
+            return (t + (t >> 8)) >> 8;
+        }
+
+        inline uint32_t LoadPixel(const uint8_t* p) noexcept
+        {
+            return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+        }
+
+        inline void StorePixel(uint8_t* p, uint32_t pixel) noexcept
+        {
+            p[0] = static_cast<uint8_t>(pixel);
+            p[1] = static_cast<uint8_t>(pixel >> 8);
+            p[2] = static_cast<uint8_t>(pixel >> 16);
+            p[3] = static_cast<uint8_t>(pixel >> 24);
+        }
+
+        // Returns a non-zero value if any pixel is XORed.
+        inline uint32_t DecodeMonochromeRow(const uint8_t* andBits, const uint8_t* xorBits, uint32_t width, uint8_t* color, uint8_t* xorOut, SimdTier tier) noexcept
+        {
+            uint32_t anyXor = 0;
+            uint32_t x = 0;
+#if DX_HAS_SSE2
+            if (tier == SimdTier::SSE2)
+            {
+                // Four pixels per vector: broadcast the byte and test one bit per lane.
+                const __m128i highBits = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+                const __m128i lowBits = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+                const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+                __m128i any = _mm_setzero_si128();
+                for (; x + 8 <= width; x += 8)
+                {
+                    const __m128i andByte = _mm_set1_epi32(andBits[x / 8]);
+                    const __m128i xorByte = _mm_set1_epi32(xorBits[x / 8]);
+                    for (int half = 0; half < 2; half++)
+                    {
+                        const __m128i bits = half == 0 ? highBits : lowBits;
+                        const __m128i andMask = _mm_cmpeq_epi32(_mm_and_si128(andByte, bits), bits);
+                        const __m128i xorMask = _mm_cmpeq_epi32(_mm_and_si128(xorByte, bits), bits);
+                        const __m128i opaque = _mm_andnot_si128(andMask, _mm_or_si128(xorMask, alpha));
+                        const __m128i inverted = _mm_and_si128(andMask, xorMask);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(color + (x + half * 4) * 4), opaque);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(xorOut + (x + half * 4) * 4), inverted);
+                        any = _mm_or_si128(any, inverted);
+                    }
+                }
+                anyXor = static_cast<uint32_t>(_mm_movemask_epi8(any));
+            }
+#endif
+            for (; x < width; x++)
+            {
+                const uint32_t bit = 0x80u >> (x & 7);
+                const bool andSet = (andBits[x / 8] & bit) != 0;
+                const bool xorSet = (xorBits[x / 8] & bit) != 0;
+                StorePixel(color + x * 4, andSet ? 0 : (xorSet ? 0xFFFFFFFFu : 0xFF000000u));
+                StorePixel(xorOut + x * 4, andSet && xorSet ? 0xFFFFFFFFu : 0);
+                anyXor |= andSet && xorSet ? 1 : 0;
+            }
+            return anyXor;
+        }
+
+        inline void DecodeColorRow(const uint8_t* bgra, uint32_t width, uint8_t* color, uint8_t* xorOut, SimdTier tier) noexcept
+        {
+            uint32_t x = 0;
+#if DX_HAS_SSE2
+            if (tier == SimdTier::SSE2)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i lowByte = _mm_set1_epi32(0xFF);
+                const __m128i middle = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+                const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+                const __m128i rounding = _mm_set1_epi16(128);
+                for (; x + 4 <= width; x += 4)
+                {
+                    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bgra + x * 4));
+                    const __m128i rgba = _mm_or_si128(_mm_and_si128(in, middle),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in, 16), lowByte), _mm_slli_epi32(_mm_and_si128(in, lowByte), 16)));
+
+                    // Premultiply in 16 bits with the same rounding as MulDiv255.
+                    __m128i lo = _mm_unpacklo_epi8(rgba, zero);
+                    __m128i hi = _mm_unpackhi_epi8(rgba, zero);
+                    const __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                    const __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                    lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), rounding);
+                    hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), rounding);
+                    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+                    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+                    const __m128i premultiplied = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi)), _mm_and_si128(rgba, alphaMask));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(color + x * 4), premultiplied);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(xorOut + x * 4), zero);
+                }
+            }
+#endif
+            for (; x < width; x++)
+            {
+                const uint32_t pixel = SwapRedBlue(LoadPixel(bgra + x * 4));
+                const uint32_t a = pixel >> 24;
+                StorePixel(color + x * 4, MulDiv255(pixel & 0xFF, a) | MulDiv255((pixel >> 8) & 0xFF, a) << 8
+                    | MulDiv255((pixel >> 16) & 0xFF, a) << 16 | a << 24);
+                StorePixel(xorOut + x * 4, 0);
+            }
+        }
+
+        // Returns a non-zero value if any pixel is XORed with a non-black colour.
+        inline uint32_t DecodeMaskedColorRow(const uint8_t* bgrx, uint32_t width, uint8_t* color, uint8_t* xorOut, SimdTier tier) noexcept
+        {
+            uint32_t anyXor = 0;
+            uint32_t x = 0;
+#if DX_HAS_SSE2
+            if (tier == SimdTier::SSE2)
+            {
+                const __m128i lowByte = _mm_set1_epi32(0xFF);
+                const __m128i middle = _mm_set1_epi32(0x0000FF00);
+                const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+                __m128i any = _mm_setzero_si128();
+                for (; x + 4 <= width; x += 4)
+                {
+                    const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bgrx + x * 4));
+                    const __m128i rgb = _mm_or_si128(_mm_and_si128(in, middle),
+                        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in, 16), lowByte), _mm_slli_epi32(_mm_and_si128(in, lowByte), 16)));
+                    const __m128i masked = _mm_cmpeq_epi32(_mm_and_si128(in, alphaMask), alphaMask);
+                    const __m128i inverted = _mm_and_si128(masked, rgb);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(color + x * 4), _mm_andnot_si128(masked, _mm_or_si128(rgb, alphaMask)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(xorOut + x * 4), inverted);
+                    any = _mm_or_si128(any, inverted);
+                }
+                anyXor = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(any, _mm_setzero_si128())) ^ 0xFFFF);
+            }
+#endif
+            for (; x < width; x++)
+            {
+                const uint32_t pixel = LoadPixel(bgrx + x * 4);
+                const uint32_t rgb = SwapRedBlue(pixel) & 0x00FFFFFFu;
+                const bool masked = (pixel >> 24) == 0xFF;
+                StorePixel(color + x * 4, masked ? 0 : rgb | 0xFF000000u);
+                StorePixel(xorOut + x * 4, masked ? rgb : 0);
+                anyXor |= masked ? rgb : 0;
+            }
+            return anyXor;
+        }
+    }
+
+    // Decode a pointer shape buffer. Returns false if the buffer is too small for info.
+    inline bool DecodeCursorShape(const uint8_t* buffer, size_t size, const CursorShapeInfo& info, DecodedCursor& cursor, SimdTier tier = BestSimdTier())
+    {
+        const bool monochrome = info.type == CursorShapeType::Monochrome;
+        const uint32_t height = monochrome ? info.height / 2 : info.height;
+        const size_t rowBytes = monochrome ? (size_t(info.width) + 7) / 8 : size_t(info.width) * 4;
+        if (info.width == 0 || height == 0 || info.pitch < rowBytes || size < size_t(info.pitch) * (monochrome ? height * 2 : height))
+            return false;
+        if (!monochrome && info.type != CursorShapeType::Color && info.type != CursorShapeType::MaskedColor)
+            return false;
+
+        cursor.color.Resize(info.width, height, 4);
+        cursor.xorMask.Resize(info.width, height, 4);
+        cursor.hotspotX = info.hotspotX;
+        cursor.hotspotY = info.hotspotY;
+
+        uint32_t anyXor = 0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* row = buffer + size_t(y) * info.pitch;
+            uint8_t* color = cursor.color.View().Row(y);
+            uint8_t* xorOut = cursor.xorMask.View().Row(y);
+            switch (info.type)
+            {
+            case CursorShapeType::Monochrome:
+                anyXor |= Detail::DecodeMonochromeRow(row, row + size_t(height) * info.pitch, info.width, color, xorOut, tier);
+                break;
+            case CursorShapeType::Color:
+                Detail::DecodeColorRow(row, info.width, color, xorOut, tier);
+                break;
+            case CursorShapeType::MaskedColor:
+                anyXor |= Detail::DecodeMaskedColorRow(row, info.width, color, xorOut, tier);
+                break;
+            }
+        }
+        cursor.hasXor = anyXor != 0;
+        return true;
+    }
+
+    // FNV-1a over the shape description and buffer, so equal shapes share a texture.
+    inline uint64_t HashCursorShape(const uint8_t* buffer, size_t size, const CursorShapeInfo& info) noexcept
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 1099511628211ull;
+        };
+        mix(static_cast<uint32_t>(info.type));
+        mix(info.width);
+        mix(info.height);
+        mix(static_cast<uint32_t>(info.hotspotX));
+        mix(static_cast<uint32_t>(info.hotspotY));
+
+        // Eight bytes per step; shapes are at most a few hundred KB and change rarely.
+        const size_t words = size / 8;
+        for (size_t i = 0; i < words; i++)
+        {
+            uint64_t word;
+            std::memcpy(&word, buffer + i * 8, sizeof(word));
+            mix(word);
+        }
+        for (size_t i = words * 8; i < size; i++)
+            mix(buffer[i]);
+        return hash;
+    }
+}
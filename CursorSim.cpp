@@ -0,0 +1,334 @@
+//
+// CursorSim.cpp - Replay a pointer trace through CursorPredictor and measure the error at scanout
+//
+// Mirrors the viewer: duplication reports the newest pointer sample once per source frame, and
+// every Present late-latches the pointer once more before predicting it to the vblank the frame
+// will be shown on. The trace is either a recorded one (F7 in the viewer writes cursor-*.csv) or
+// a synthetic one, and the error is the distance from the true pointer position at that vblank.
+//
+
+#include "ToolMain.h"
+#include "CursorPredictor.h"
+#include "CursorShape.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_TicksPerSecond = 1e9;
+    constexpr double c_Pi = 3.14159265358979323846;
+
+    uint64_t ToTicks(double seconds) noexcept
+    {
+        return static_cast<uint64_t>(seconds * c_TicksPerSecond);
+    }
+
+    double SmoothStep(double t) noexcept
+    {
+        t = std::clamp(t, 0.0, 1.0);
+        return t * t * (3.0 - 2.0 * t);
+    }
+
+    // One expected pixel of a decoded shape, as RGBA bytes packed little-endian.
+    struct ExpectedPixel
+    {
+        uint32_t color;
+        uint32_t xorMask;
+    };
+
+    // The shape, straight from the rules in CursorShape.h, rather than from the decoder.
+    ExpectedPixel ExpectedShapePixel(CursorShapeType type, const uint8_t* buffer, const CursorShapeInfo& info, uint32_t x, uint32_t y)
+    {
+        if (type == CursorShapeType::Monochrome)
+        {
+            const uint32_t height = info.height / 2;
+            const bool andSet = (buffer[size_t(y) * info.pitch + x / 8] >> (7 - x % 8)) & 1;
+            const bool xorSet = (buffer[size_t(y + height) * info.pitch + x / 8] >> (7 - x % 8)) & 1;
+            if (!andSet)
+                return { xorSet ? 0xFFFFFFFFu : 0xFF000000u, 0 };
+            return { 0, xorSet ? 0xFFFFFFFFu : 0 };
+        }
+
+        const uint8_t* bgra = buffer + size_t(y) * info.pitch + x * 4;
+        const uint32_t rgb = uint32_t(bgra[2]) | uint32_t(bgra[1]) << 8 | uint32_t(bgra[0]) << 16;
+        if (type == CursorShapeType::MaskedColor)
+            return bgra[3] == 0xFF ? ExpectedPixel{ 0, rgb } : ExpectedPixel{ rgb | 0xFF000000u, 0 };
+
+        const uint32_t a = bgra[3];
+        uint32_t premultiplied = a << 24;
+        for (int c = 0; c < 3; c++)
+            premultiplied |= uint32_t(std::lround(((rgb >> (8 * c)) & 0xFF) * a / 255.0)) << (8 * c);
+        return { premultiplied, 0 };
+    }
+
+    // Random shapes of every type, at widths that leave the SIMD loops a tail, decoded on every tier:
+    // each pixel against the rules, and the tiers against each other byte for byte.
+    uint64_t CheckCursorShapes(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        const CursorShapeType types[] = { CursorShapeType::Monochrome, CursorShapeType::Color, CursorShapeType::MaskedColor };
+        std::uniform_int_distribution<uint32_t> byte(0, 255);
+        for (uint32_t round = 0; round < count; round++)
+        {
+            const CursorShapeType type = types[round % 3];
+            const bool monochrome = type == CursorShapeType::Monochrome;
+            CursorShapeInfo info;
+            info.type = type;
+            info.width = round < 3 * 20 ? round / 3 + 1 : std::uniform_int_distribution<uint32_t>(1, 70)(random);
+            const uint32_t height = std::uniform_int_distribution<uint32_t>(1, 9)(random);
+            info.height = monochrome ? height * 2 : height;
+            info.pitch = (monochrome ? (info.width + 7) / 8 : info.width * 4) + std::uniform_int_distribution<uint32_t>(0, 5)(random);
+            info.hotspotX = int32_t(round % 7);
+            info.hotspotY = int32_t(round % 5);
+
+            // Opaque, transparent, masked and plain pixels in every mix; the padding is noise.
+            std::vector<uint8_t> buffer(size_t(info.pitch) * info.height);
+            for (size_t i = 0; i < buffer.size(); i++)
+            {
+                const uint32_t value = byte(random);
+                buffer[i] = uint8_t(!monochrome && i % 4 == 3 && value < 96 ? (value < 48 ? 0 : 0xFF) : value);
+            }
+
+            bool anyXor = false;
+            DecodedCursor decoded[2];
+            const SimdTier tiers[2] = { SimdTier::Scalar, BestSimdTier() };
+            for (int t = 0; t < 2; t++)
+            {
+                failures += DecodeCursorShape(buffer.data(), buffer.size(), info, decoded[t], tiers[t]) ? 0 : 1;
+                failures += decoded[t].Width() == info.width && decoded[t].Height() == height ? 0 : 1;
+                failures += decoded[t].hotspotX == info.hotspotX && decoded[t].hotspotY == info.hotspotY ? 0 : 1;
+                for (uint32_t y = 0; y < height && decoded[t].Height() == height; y++)
+                {
+                    for (uint32_t x = 0; x < info.width; x++)
+                    {
+                        const ExpectedPixel expected = ExpectedShapePixel(type, buffer.data(), info, x, y);
+                        anyXor |= expected.xorMask != 0;
+                        failures += Detail::LoadPixel(decoded[t].color.View().Row(y) + x * 4) == expected.color ? 0 : 1;
+                        failures += Detail::LoadPixel(decoded[t].xorMask.View().Row(y) + x * 4) == expected.xorMask ? 0 : 1;
+                    }
+                }
+                failures += decoded[t].hasXor == anyXor ? 0 : 1;
+            }
+            for (uint32_t y = 0; y < height; y++)
+            {
+                failures += std::memcmp(decoded[0].color.View().Row(y), decoded[1].color.View().Row(y), size_t(info.width) * 4) == 0 ? 0 : 1;
+                failures += std::memcmp(decoded[0].xorMask.View().Row(y), decoded[1].xorMask.View().Row(y), size_t(info.width) * 4) == 0 ? 0 : 1;
+            }
+
+            // A buffer a byte short, or a type Duplication doesn't report, is refused.
+            DecodedCursor refused;
+            failures += DecodeCursorShape(buffer.data(), buffer.size() - 1, info, refused) ? 1 : 0;
+            CursorShapeInfo unknown = info;
+            unknown.type = CursorShapeType(3);
+            failures += DecodeCursorShape(buffer.data(), buffer.size(), unknown, refused) ? 1 : 0;
+        }
+        return failures;
+    }
+
+    // A mouse polled at pollHz, reporting whole pixels.
+    std::vector<PointerSample> SynthesizeTrace(const std::string& pattern, double seconds, double pollHz, std::mt19937& random)
+    {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        // Flicks: rest, then ease to a random point, as when moving between widgets.
+        struct Flick { double start, duration, fromX, fromY, toX, toY; };
+        std::vector<Flick> flicks;
+        double x = 960.0, y = 540.0;
+        for (double t = 0.0; t < seconds;)
+        {
+            t += 0.1 + 0.4 * uniform(random);
+            const Flick flick = { t, 0.12 + 0.25 * uniform(random), x, y, 100.0 + 1720.0 * uniform(random), 100.0 + 880.0 * uniform(random) };
+            flicks.push_back(flick);
+            t += flick.duration;
+            x = flick.toX;
+            y = flick.toY;
+        }
+
+        std::vector<PointerSample> samples;
+        const size_t count = static_cast<size_t>(seconds * pollHz);
+        size_t flick = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            const double t = double(i) / pollHz;
+            if (pattern == "circle")
+            {
+                x = 960.0 + 300.0 * std::cos(2.0 * c_Pi * t / 1.5);
+                y = 540.0 + 300.0 * std::sin(2.0 * c_Pi * t / 1.5);
+            }
+            else if (pattern == "scribble")
+            {
+                x = 960.0 + 400.0 * std::sin(2.0 * c_Pi * 0.7 * t) + 120.0 * std::sin(2.0 * c_Pi * 2.3 * t);
+                y = 540.0 + 250.0 * std::sin(2.0 * c_Pi * 0.5 * t + 1.0) + 90.0 * std::cos(2.0 * c_Pi * 3.1 * t);
+            }
+            else if (pattern == "flick")
+            {
+                while (flick + 1 < flicks.size() && flicks[flick + 1].start <= t)
+                    flick++;
+                const Flick& f = flicks[flick];
+                const double s = SmoothStep((t - f.start) / f.duration);
+                x = f.fromX + (f.toX - f.fromX) * s;
+                y = f.fromY + (f.toY - f.fromY) * s;
+            }
+            else
+                throw std::runtime_error("--pattern must be flick, circle or scribble");
+            samples.push_back({ ToTicks(t), std::round(x), std::round(y) });
+        }
+        return samples;
+    }
+
+    // The newest trace sample at or before ticks; the trace is sorted by time.
+    const PointerSample& SampleAt(const std::vector<PointerSample>& trace, uint64_t ticks)
+    {
+        auto next = std::upper_bound(trace.begin(), trace.end(), ticks, [](uint64_t t, const PointerSample& s) { return t < s.ticks; });
+        return next == trace.begin() ? trace.front() : *(next - 1);
+    }
+
+    // Where the pointer really was at ticks, interpolating between trace samples.
+    void TruthAt(const std::vector<PointerSample>& trace, uint64_t ticks, double& x, double& y)
+    {
+        auto next = std::upper_bound(trace.begin(), trace.end(), ticks, [](uint64_t t, const PointerSample& s) { return t < s.ticks; });
+        if (next == trace.begin() || next == trace.end())
+        {
+            const PointerSample& edge = next == trace.end() ? trace.back() : trace.front();
+            x = edge.x;
+            y = edge.y;
+            return;
+        }
+        const PointerSample& a = *(next - 1);
+        const PointerSample& b = *next;
+        const double f = double(ticks - a.ticks) / double(b.ticks - a.ticks);
+        x = a.x + (b.x - a.x) * f;
+        y = a.y + (b.y - a.y) * f;
+    }
+
+    struct Present
+    {
+        uint64_t ticks;
+        uint64_t nextVblank;        // First vblank after the Present.
+        uint64_t shownTicks;        // The vblank that shows the frame, vblanks - 1 refreshes later.
+    };
+
+    struct ErrorStats
+    {
+        double mean = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+    };
+
+    ErrorStats Summarize(std::vector<double> errors)
+    {
+        ErrorStats stats;
+        if (errors.empty())
+            return stats;
+        std::sort(errors.begin(), errors.end());
+        for (double error : errors)
+            stats.mean += error;
+        stats.mean /= double(errors.size());
+        stats.p95 = errors[std::min(errors.size() - 1, errors.size() * 95 / 100)];
+        stats.max = errors.back();
+        return stats;
+    }
+}
+
+int DX::CursorSimMain(const ToolArgs& args)
+{
+    const double sourceFps = args.GetNumber("source-fps", 60.0);
+    const double refreshHz = args.GetNumber("refresh", 120.0);
+    const uint32_t vblanks = std::max(1u, args.GetUInt("vblanks", 1));
+    const bool latch = !args.Has("no-latch");
+    if (sourceFps <= 0.0 || refreshHz <= 0.0)
+        throw std::runtime_error("--source-fps and --refresh must be positive");
+
+    std::mt19937 random(args.GetUInt("seed", 1));
+    std::vector<PointerSample> trace;
+    const std::string tracePath = args.Get("trace");
+    const std::string pattern = args.Get("pattern", "flick");
+    if (!tracePath.empty())
+    {
+        if (!ReadPointerTrace(tracePath, trace))
+            throw std::runtime_error("Cannot read " + tracePath);
+        std::stable_sort(trace.begin(), trace.end(), [](const PointerSample& a, const PointerSample& b) { return a.ticks < b.ticks; });
+    }
+    else
+        trace = SynthesizeTrace(pattern, args.GetNumber("seconds", 20.0), args.GetNumber("poll-hz", 1000.0), random);
+    if (trace.size() < 2)
+        throw std::runtime_error("The trace needs at least two samples");
+
+    const std::string output = args.Get("out");
+    if (!output.empty() && !WritePointerTrace(output, trace, ToTicks(1.0)))
+        throw std::runtime_error("Cannot write " + output);
+
+    // Presents land anywhere in the refresh before the vblank that shows them.
+    const uint64_t refreshPeriod = ToTicks(1.0 / refreshHz);
+    const uint64_t sourcePeriod = ToTicks(1.0 / sourceFps);
+    std::uniform_real_distribution<double> phase(0.0, 1.0);
+    std::vector<Present> presents;
+    for (uint64_t vblank = trace.front().ticks + 2 * refreshPeriod; vblank + vblanks * refreshPeriod <= trace.back().ticks; vblank += refreshPeriod)
+        presents.push_back({ vblank - static_cast<uint64_t>(phase(random) * double(refreshPeriod)), vblank, vblank + (vblanks - 1) * refreshPeriod });
+
+    printf("cursorsim: %s, %zu samples over %.1f s; %.0f fps source, %.0f Hz refresh, %s, %u vblank%s ahead\n",
+        tracePath.empty() ? (pattern + " trace").c_str() : tracePath.c_str(), trace.size(), double(trace.back().ticks - trace.front().ticks) / c_TicksPerSecond,
+        sourceFps, refreshHz, latch ? "late-latched" : "duplication samples only", vblanks, vblanks == 1 ? "" : "s");
+
+    ErrorStats results[static_cast<size_t>(CursorPrediction::Count)];
+    for (size_t mode = 0; mode < static_cast<size_t>(CursorPrediction::Count); mode++)
+    {
+        CursorPredictor predictor(ToTicks(1.0), static_cast<CursorPrediction>(mode));
+        VblankClock clock(refreshPeriod);
+        std::vector<double> errors;
+        errors.reserve(presents.size());
+        uint64_t sourceFrame = trace.front().ticks;
+        for (const Present& present : presents)
+        {
+            // Duplication stamps each pointer update with when the mouse last moved.
+            for (; sourceFrame <= present.ticks; sourceFrame += sourcePeriod)
+                predictor.AddSample(SampleAt(trace, sourceFrame));
+            if (latch)
+            {
+                const PointerSample& latest = SampleAt(trace, present.ticks);
+                predictor.AddSample({ present.ticks, latest.x, latest.y });
+            }
+
+            // The viewer learns the vblank phase from present statistics a couple of refreshes late.
+            const uint64_t reported = present.nextVblank - 2 * refreshPeriod;
+            clock.OnVblank(static_cast<uint32_t>(reported / refreshPeriod), reported);
+            const uint64_t target = clock.NextAfter(present.ticks) + (vblanks - 1) * clock.Period();
+
+            double x = 0.0, y = 0.0, trueX = 0.0, trueY = 0.0;
+            predictor.Predict(target, x, y);
+            TruthAt(trace, present.shownTicks, trueX, trueY);
+            errors.push_back(std::hypot(x - trueX, y - trueY));
+        }
+
+        results[mode] = Summarize(std::move(errors));
+        printf("cursorsim: %-9s error %6.2f px mean, %6.2f px p95, %7.2f px max\n", CursorPredictionName(static_cast<CursorPrediction>(mode)),
+            results[mode].mean, results[mode].p95, results[mode].max);
+    }
+
+    // --check fails the run if either predictor does worse than drawing the newest sample, or if a
+    // pointer shape decodes differently from its rules or between SIMD tiers.
+    if (args.Has("check"))
+    {
+        const uint32_t shapes = 300;
+        const uint64_t failures = CheckCursorShapes(random, shapes);
+        printf("cursorsim: %u shapes, %llu failures\n", shapes, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Cursor shape decoding failed its checks");
+
+        const double baseline = results[static_cast<size_t>(CursorPrediction::Off)].mean;
+        for (CursorPrediction mode : { CursorPrediction::ConstantVelocity, CursorPrediction::Kalman })
+        {
+            if (results[static_cast<size_t>(mode)].mean > baseline)
+                throw std::runtime_error(std::string(CursorPredictionName(mode)) + " prediction is worse than none on this trace");
+        }
+    }
+    return 0;
+}
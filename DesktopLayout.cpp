@@ -0,0 +1,179 @@
+//
+// DesktopLayout.cpp - Outputs on the virtual desktop and the mapping from desktop points to the viewer
+//
+
+#include "DesktopLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_HalfPi = 1.57079632679489661923;
+
+    // Desktop-oriented point relative to the output's top-left, to a pixel of the image in scanout
+    // orientation. The image is the desktop turned back by the output's rotation.
+    Affine2D LocalToImage(OutputRotation rotation, double width, double height) noexcept
+    {
+        switch (rotation)
+        {
+        case OutputRotation::Rotate90:  return { 0.0, 1.0, 0.0, -1.0, 0.0, width };
+        case OutputRotation::Rotate180: return { -1.0, 0.0, width, 0.0, -1.0, height };
+        case OutputRotation::Rotate270: return { 0.0, -1.0, height, 1.0, 0.0, 0.0 };
+        default:                        return {};
+        }
+    }
+}
+
+double DX::ImageRotationRadians(OutputRotation rotation) noexcept
+{
+    switch (rotation)
+    {
+    case OutputRotation::Rotate90:  return -c_HalfPi;
+    case OutputRotation::Rotate180: return 2.0 * c_HalfPi;
+    case OutputRotation::Rotate270: return c_HalfPi;
+    default:                        return 0.0;
+    }
+}
+
+Affine2D Affine2D::Then(const Affine2D& next) const noexcept
+{
+    return {
+        next.xx * xx + next.xy * yx, next.xx * xy + next.xy * yy, next.xx * tx + next.xy * ty + next.tx,
+        next.yx * xx + next.yy * yx, next.yx * xy + next.yy * yy, next.yx * tx + next.yy * ty + next.ty,
+    };
+}
+
+bool Affine2D::Invert(Affine2D& inverse) const noexcept
+{
+    const double determinant = xx * yy - xy * yx;
+    if (std::fabs(determinant) < 1e-12)
+        return false;
+
+    const double ixx = yy / determinant;
+    const double ixy = -xy / determinant;
+    const double iyx = -yx / determinant;
+    const double iyy = xx / determinant;
+    inverse = { ixx, ixy, -(ixx * tx + ixy * ty), iyx, iyy, -(iyx * tx + iyy * ty) };
+    return true;
+}
+
+Affine2D DX::FitImage(double imageWidth, double imageHeight, const ViewerRect& rect) noexcept
+{
+    if (imageWidth <= 0.0 || imageHeight <= 0.0)
+        return Affine2D::Translation(rect.left, rect.top);
+    const double scale = std::min(rect.width / imageWidth, rect.height / imageHeight);
+    return Affine2D::Scale(scale, scale).Then(Affine2D::Translation(
+        rect.left + (rect.width - imageWidth * scale) / 2.0, rect.top + (rect.height - imageHeight * scale) / 2.0));
+}
+
+ViewerRect DX::TileRect(size_t index, size_t count, double width, double height) noexcept
+{
+    if (count <= 1)
+        return { 0.0, 0.0, width, height };
+
+    // Enough columns for a square grid; the rows that fit them.
+    const size_t columns = static_cast<size_t>(std::ceil(std::sqrt(double(count))));
+    const size_t rows = (count + columns - 1) / columns;
+    const double cellWidth = width / double(columns);
+    const double cellHeight = height / double(rows);
+    return { double(index % columns) * cellWidth, double(index / columns) * cellHeight, cellWidth, cellHeight };
+}
+
+void DesktopLayout::Clear() noexcept
+{
+    m_outputs.clear();
+    m_bounds.clear();
+    m_virtualBounds = {};
+}
+
+int DesktopLayout::AddOutput(uint64_t id, const std::string& name, const DesktopRect& bounds, OutputRotation rotation)
+{
+    DesktopOutput output;
+    output.id = id;
+    output.name = name;
+    output.bounds = bounds;
+    output.rotation = rotation;
+
+    const bool sideways = rotation == OutputRotation::Rotate90 || rotation == OutputRotation::Rotate270;
+    output.imageWidth = static_cast<uint32_t>(std::max(0, sideways ? bounds.Height() : bounds.Width()));
+    output.imageHeight = static_cast<uint32_t>(std::max(0, sideways ? bounds.Width() : bounds.Height()));
+    output.desktopToImage = Affine2D::Translation(-double(bounds.left), -double(bounds.top))
+        .Then(LocalToImage(rotation, double(bounds.Width()), double(bounds.Height())));
+    output.desktopToViewer = output.desktopToImage.Then(m_imageToViewer);
+
+    if (m_outputs.empty())
+        m_virtualBounds = bounds;
+    else
+    {
+        m_virtualBounds.left = std::min(m_virtualBounds.left, bounds.left);
+        m_virtualBounds.top = std::min(m_virtualBounds.top, bounds.top);
+        m_virtualBounds.right = std::max(m_virtualBounds.right, bounds.right);
+        m_virtualBounds.bottom = std::max(m_virtualBounds.bottom, bounds.bottom);
+    }
+
+    m_outputs.push_back(output);
+    m_bounds.push_back(bounds);
+    return static_cast<int>(m_outputs.size() - 1);
+}
+
+void DesktopLayout::SetImageToViewer(const Affine2D& imageToViewer) noexcept
+{
+    m_imageToViewer = imageToViewer;
+    for (DesktopOutput& output : m_outputs)
+        output.desktopToViewer = output.desktopToImage.Then(m_imageToViewer);
+}
+
+void DesktopLayout::SetImageToViewer(size_t index, const Affine2D& imageToViewer) noexcept
+{
+    m_outputs[index].desktopToViewer = m_outputs[index].desktopToImage.Then(imageToViewer);
+}
+
+int DesktopLayout::FindOutput(Point2D point, int hint) const noexcept
+{
+    // Overlapping outputs resolve to the first added, so the hint only short-circuits when none earlier matches.
+    if (hint >= 0 && static_cast<size_t>(hint) < m_bounds.size() && m_bounds[hint].Contains(point.x, point.y))
+    {
+        bool shadowed = false;
+        for (int i = 0; i < hint && !shadowed; i++)
+            shadowed = m_bounds[i].Contains(point.x, point.y);
+        if (!shadowed)
+            return hint;
+    }
+
+    if (!m_virtualBounds.Contains(point.x, point.y))
+        return NoOutput;
+    for (size_t i = 0; i < m_bounds.size(); i++)
+    {
+        if (m_bounds[i].Contains(point.x, point.y))
+            return static_cast<int>(i);
+    }
+    return NoOutput;
+}
+
+int DesktopLayout::FindOutputById(uint64_t id) const noexcept
+{
+    for (size_t i = 0; i < m_outputs.size(); i++)
+    {
+        if (m_outputs[i].id == id)
+            return static_cast<int>(i);
+    }
+    return NoOutput;
+}
+
+std::string DesktopLayout::Describe() const
+{
+    std::string text;
+    char line[256];
+    for (size_t i = 0; i < m_outputs.size(); i++)
+    {
+        const DesktopOutput& output = m_outputs[i];
+        snprintf(line, sizeof(line), "%zu: %s at (%d, %d) %dx%d, rotated %s\n", i, output.name.c_str(), output.bounds.left, output.bounds.top,
+            output.bounds.Width(), output.bounds.Height(), OutputRotationName(output.rotation));
+        text += line;
+    }
+    return text;
+}
@@ -0,0 +1,141 @@
+//
+// DesktopLayout.h - Outputs on the virtual desktop and the mapping from desktop points to the viewer
+//
+// Built from each output's DXGI_OUTPUT_DESC: its DesktopCoordinates (in desktop orientation) and
+// rotation. Desktop Duplication hands out the image in the output's scanout orientation, so a point
+// on a rotated output is rotated back before it lands in the captured image. Each output carries
+// that desktop-to-image transform and, once the viewer's placement of the image is known, the
+// desktop-to-viewer one.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    // DXGI_MODE_ROTATION minus one; unspecified counts as identity.
+    enum class OutputRotation
+    {
+        Identity,
+        Rotate90,
+        Rotate180,
+        Rotate270,
+    };
+
+    inline const char* OutputRotationName(OutputRotation rotation) noexcept
+    {
+        switch (rotation)
+        {
+        case OutputRotation::Rotate90:  return "90";
+        case OutputRotation::Rotate180: return "180";
+        case OutputRotation::Rotate270: return "270";
+        default:                        return "0";
+        }
+    }
+
+    // Angle a sprite drawn in desktop orientation needs to line up with the captured image, clockwise in radians.
+    double ImageRotationRadians(OutputRotation rotation) noexcept;
+
+    struct Point2D
+    {
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    // x' = xx * x + xy * y + tx, y' = yx * x + yy * y + ty.
+    struct Affine2D
+    {
+        double xx = 1.0, xy = 0.0, tx = 0.0;
+        double yx = 0.0, yy = 1.0, ty = 0.0;
+
+        static Affine2D Translation(double x, double y) noexcept { return { 1.0, 0.0, x, 0.0, 1.0, y }; }
+        static Affine2D Scale(double x, double y) noexcept { return { x, 0.0, 0.0, 0.0, y, 0.0 }; }
+
+        Point2D Apply(Point2D p) const noexcept { return { xx * p.x + xy * p.y + tx, yx * p.x + yy * p.y + ty }; }
+
+        // This transform followed by next.
+        Affine2D Then(const Affine2D& next) const noexcept;
+
+        // Returns false for a degenerate transform.
+        bool Invert(Affine2D& inverse) const noexcept;
+    };
+
+    // Half-open: right and bottom are outside, as in DXGI_OUTPUT_DESC.
+    struct DesktopRect
+    {
+        int32_t left = 0;
+        int32_t top = 0;
+        int32_t right = 0;
+        int32_t bottom = 0;
+
+        int32_t Width() const noexcept { return right - left; }
+        int32_t Height() const noexcept { return bottom - top; }
+        bool Contains(double x, double y) const noexcept { return x >= left && x < right && y >= top && y < bottom; }
+    };
+
+    // Part of the viewer, in viewer pixels.
+    struct ViewerRect
+    {
+        double left = 0.0;
+        double top = 0.0;
+        double width = 0.0;
+        double height = 0.0;
+    };
+
+    // Image pixels to viewer pixels for an image scaled to fit rect, keeping its aspect ratio, centred.
+    Affine2D FitImage(double imageWidth, double imageHeight, const ViewerRect& rect) noexcept;
+
+    // Cell index of the most square grid of count cells covering a width x height viewer, row by row.
+    ViewerRect TileRect(size_t index, size_t count, double width, double height) noexcept;
+
+    struct DesktopOutput
+    {
+        uint64_t        id = 0;             // Caller's handle for the output, e.g. its HMONITOR.
+        std::string     name;
+        DesktopRect     bounds;
+        OutputRotation  rotation = OutputRotation::Identity;
+        uint32_t        imageWidth = 0;     // Size of the captured image, in scanout orientation.
+        uint32_t        imageHeight = 0;
+        Affine2D        desktopToImage;
+        Affine2D        desktopToViewer;
+    };
+
+    class DesktopLayout
+    {
+    public:
+        static constexpr int NoOutput = -1;
+
+        void Clear() noexcept;
+
+        // Add an output; returns its index. Overlapping outputs are allowed and the first one added wins.
+        int AddOutput(uint64_t id, const std::string& name, const DesktopRect& bounds, OutputRotation rotation);
+
+        // Where the viewer draws captured images: image pixels to viewer pixels. Applied to every output.
+        void SetImageToViewer(const Affine2D& imageToViewer) noexcept;
+
+        // The same for one output only, when each output's image is drawn in its own place.
+        void SetImageToViewer(size_t index, const Affine2D& imageToViewer) noexcept;
+
+        // The output containing a desktop point, or NoOutput. hint is checked first, so passing the
+        // output found last time makes the common case a single comparison.
+        int FindOutput(Point2D point, int hint = NoOutput) const noexcept;
+        int FindOutputById(uint64_t id) const noexcept;
+
+        size_t OutputCount() const noexcept { return m_outputs.size(); }
+        const DesktopOutput& Output(size_t index) const noexcept { return m_outputs[index]; }
+        const DesktopRect& VirtualBounds() const noexcept { return m_virtualBounds; }
+
+        // One line per output, e.g. "0: \\.\DISPLAY1 at (0, 0) 1920x1080, rotated 0".
+        std::string Describe() const;
+
+    private:
+        std::vector<DesktopOutput>  m_outputs;
+        std::vector<DesktopRect>    m_bounds;       // Copy of each output's bounds, packed for FindOutput.
+        DesktopRect                 m_virtualBounds;
+        Affine2D                    m_imageToViewer;
+    };
+}
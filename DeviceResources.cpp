@@ -453,7 +453,7 @@ void DeviceResources::HandleDeviceLost()
 void DeviceResources::Present()
 {
     HRESULT hr = E_FAIL;
-    if (m_options & c_AllowTearing)
+    if ((m_options & c_AllowTearing) && !m_vsync)
     {
         // Recommended to always use tearing if supported when using a sync interval of 0.
         hr = m_swapChain->Present(0, DXGI_PRESENT_ALLOW_TEARING);
@@ -46,6 +46,9 @@ namespace DX
         void Present();
         void UpdateColorSpace();
 
+        // Wait for vblank on present even when tearing is allowed. Takes effect on the next Present.
+        void SetVsync(bool vsync) noexcept { m_vsync = vsync; }
+
         // Device Accessors.
         RECT GetOutputSize() const noexcept { return m_outputSize; }
 
@@ -117,6 +120,7 @@ namespace DX
 
         // DeviceResources options (see flags above)
         unsigned int                                    m_options;
+        bool                                            m_vsync = false;
 
         // The IDeviceNotify can be held directly as it owns the DeviceResources.
         IDeviceNotify*                                  m_deviceNotify;
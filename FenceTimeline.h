@@ -0,0 +1,112 @@
+//
+// FenceTimeline.h - Tracks signal values on a monotonic GPU fence for frames in flight
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace DX
+{
+    struct FenceTimelineStats
+    {
+        uint64_t signals = 0;
+        uint64_t waits = 0;                 // Calls to WaitFor that had to block.
+        uint64_t timeouts = 0;
+        double totalWaitSeconds = 0.0;
+        double maxWaitSeconds = 0.0;
+        size_t maxInFlight = 0;
+
+        double AverageWaitSeconds() const noexcept
+        {
+            return waits == 0 ? 0.0 : totalWaitSeconds / static_cast<double>(waits);
+        }
+    };
+
+    // Hands out increasing signal values and lets consumers wait for exactly the value they need.
+    // Values must reach the fence in the order they were handed out.
+    //
+    // TFence must provide:
+    //     uint64_t GetCompletedValue();
+    //     bool WaitForValue(uint64_t value, uint32_t timeoutMs);
+    template<typename TFence>
+    class FenceTimeline
+    {
+    public:
+        static constexpr uint32_t InfiniteTimeout = 0xFFFFFFFF;
+
+        explicit FenceTimeline(TFence fence, uint64_t lastSignaled = 0) :
+            m_fence(std::move(fence)),
+            m_lastSignaled(lastSignaled)
+        {
+        }
+
+        // Reserve the next value for a GPU signal and record it as in flight. Values the GPU has
+        // already reached are dropped first, so frames that are never waited on don't pile up.
+        uint64_t Signal()
+        {
+            Retire();
+            const uint64_t value = ++m_lastSignaled;
+            m_inFlight.push_back(value);
+            m_stats.signals++;
+            m_stats.maxInFlight = std::max(m_stats.maxInFlight, m_inFlight.size());
+            return value;
+        }
+
+        bool IsComplete(uint64_t value)
+        {
+            return m_fence.GetCompletedValue() >= value;
+        }
+
+        // Block until value has been signalled. Values already complete return without touching the OS.
+        bool WaitFor(uint64_t value, uint32_t timeoutMs = InfiniteTimeout)
+        {
+            if (value == 0 || IsComplete(value))
+            {
+                Retire();
+                return true;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            const bool signaled = m_fence.WaitForValue(value, timeoutMs);
+            const double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            m_stats.waits++;
+            m_stats.totalWaitSeconds += waited;
+            m_stats.maxWaitSeconds = std::max(m_stats.maxWaitSeconds, waited);
+            if (!signaled)
+                m_stats.timeouts++;
+
+            Retire();
+            return signaled;
+        }
+
+        // Drop every in-flight value the GPU has reached.
+        void Retire()
+        {
+            const uint64_t completed = m_fence.GetCompletedValue();
+            while (!m_inFlight.empty() && m_inFlight.front() <= completed)
+            {
+                m_inFlight.pop_front();
+            }
+        }
+
+        void ResetStats() noexcept { m_stats = FenceTimelineStats{}; }
+
+        size_t InFlight() const noexcept { return m_inFlight.size(); }
+        uint64_t LastSignaled() const noexcept { return m_lastSignaled; }
+        const FenceTimelineStats& GetStats() const noexcept { return m_stats; }
+        TFence& GetFence() noexcept { return m_fence; }
+
+    private:
+        TFence                  m_fence;
+        uint64_t                m_lastSignaled;
+        std::deque<uint64_t>    m_inFlight;
+        FenceTimelineStats      m_stats;
+    };
+}
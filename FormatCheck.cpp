@@ -0,0 +1,547 @@
+//
+// FormatCheck.cpp - Convert frames between the internal pixel formats, and check the per-format kernels
+//
+
+#include "ToolMain.h"
+#include "ColorConvert.h"
+#include "FrameConvert.h"
+#include "FrameInterpolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr PixelFormat c_Formats[] = { PixelFormat::Rgba8, PixelFormat::Rgb10a2, PixelFormat::Rgba16f, PixelFormat::Nv12 };
+
+    // Frame-sized transfers between capture and present per source frame: capture writes a slot,
+    // interpolation reads two and writes one, and the presenter reads the real and the interpolated frame.
+    constexpr uint32_t c_RingPasses = 6;
+
+    // Motion between the two synthetic frames, in pixels.
+    constexpr int c_MotionX = 6;
+    constexpr int c_MotionY = 2;
+
+    // Smooth, textured rgba8, as the benchmarks use, with a bright square to reach the shoulder.
+    Image SyntheticFrame(uint32_t width, uint32_t height, int offsetX, int offsetY)
+    {
+        Image frame(width, height, 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = frame.View().Row(y);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const int sx = int(x) + offsetX;
+                const int sy = int(y) + offsetY;
+                const uint32_t hash = uint32_t(sx / 8) * 73856093u ^ uint32_t(sy / 8) * 19349663u;
+                const bool bright = (sx / 64 + sy / 64) % 5 == 0;
+                row[x * 4 + 0] = bright ? 0xFF : uint8_t((sx * 3 + (hash & 63)) & 0xFF);
+                row[x * 4 + 1] = bright ? 0xF8 : uint8_t((sy * 2 + ((hash >> 6) & 63)) & 0xFF);
+                row[x * 4 + 2] = bright ? 0xF0 : uint8_t(((sx + sy) + ((hash >> 12) & 63)) & 0xFF);
+                row[x * 4 + 3] = 0xFF;
+            }
+        }
+        return frame;
+    }
+
+    struct Difference
+    {
+        double mean = 0.0;
+        uint32_t max = 0;
+    };
+
+    // Over the colour channels of two rgba8 images.
+    Difference CompareRgba8(ConstImageView a, ConstImageView b)
+    {
+        Difference difference;
+        uint64_t sum = 0;
+        for (uint32_t y = 0; y < a.height; y++)
+        {
+            for (uint32_t x = 0; x < a.width; x++)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    const uint32_t d = uint32_t(std::abs(int(a.Row(y)[x * 4 + c]) - int(b.Row(y)[x * 4 + c])));
+                    sum += d;
+                    difference.max = std::max(difference.max, d);
+                }
+            }
+        }
+        difference.mean = double(sum) / (3.0 * a.width * a.height);
+        return difference;
+    }
+
+    // rgba8 to the format and back, as capture and the readback path do.
+    Difference RoundTrip(ConstImageView rgba, PixelFormat format, const Srgb8Encoder& encoder)
+    {
+        if (format == PixelFormat::Nv12)
+        {
+            Image converted(rgba.width, PixelFormatRows(format, rgba.height), 1);
+            Image back(rgba.width, rgba.height, 4);
+            ConvertRgba8ToNv12(rgba, converted.View());
+            ConvertNv12ToRgba8(converted.View(), back.View());
+            return CompareRgba8(rgba, back.View());
+        }
+        return VisitPixelFormat(format, [&](auto pixel) {
+            using TPixel = decltype(pixel);
+            Image converted(rgba.width, rgba.height, TPixel::Bytes);
+            Image back(rgba.width, rgba.height, 4);
+            ConvertFromRgba8<TPixel>(rgba, converted.View(), encoder.SdrWhiteNits());
+            ConvertToRgba8<TPixel>(converted.View(), back.View(), encoder);
+            return CompareRgba8(rgba, back.View());
+        });
+    }
+
+    // Interpolate between the synthetic frames in the format, converted back to rgba8.
+    Image InterpolateIn(PixelFormat format, ConstImageView previous, ConstImageView current, const Srgb8Encoder& encoder)
+    {
+        CpuInterpolatorSettings settings;
+        settings.format = format;
+        if (format == PixelFormat::Nv12)
+        {
+            const uint32_t rows = PixelFormatRows(format, previous.height);
+            Image frames[2] = { Image(previous.width, rows, 1), Image(current.width, rows, 1) };
+            ConvertRgba8ToNv12(previous, frames[0].View());
+            ConvertRgba8ToNv12(current, frames[1].View());
+
+            CpuFrameInterpolator interpolator(settings);
+            Image output(previous.width, rows, 1);
+            interpolator.Process(frames[0].View(), 0.0, output.View(), nullptr);
+            interpolator.Process(frames[1].View(), 1.0, output.View(), nullptr);
+
+            Image rgba(previous.width, previous.height, 4);
+            ConvertNv12ToRgba8(output.View(), rgba.View());
+            return rgba;
+        }
+        return VisitPixelFormat(format, [&](auto pixel) {
+            using TPixel = decltype(pixel);
+            Image frames[2] = { Image(previous.width, previous.height, TPixel::Bytes), Image(current.width, current.height, TPixel::Bytes) };
+            ConvertFromRgba8<TPixel>(previous, frames[0].View(), encoder.SdrWhiteNits());
+            ConvertFromRgba8<TPixel>(current, frames[1].View(), encoder.SdrWhiteNits());
+
+            CpuFrameInterpolator interpolator(settings);
+            Image output(previous.width, previous.height, TPixel::Bytes);
+            interpolator.Process(frames[0].View(), 0.0, output.View(), nullptr);
+            interpolator.Process(frames[1].View(), 1.0, output.View(), nullptr);
+
+            Image rgba(previous.width, previous.height, 4);
+            ConvertToRgba8<TPixel>(output.View(), rgba.View(), encoder);
+            return rgba;
+        });
+    }
+
+    // Every half that isn't NaN survives a trip through float.
+    uint64_t CheckHalves()
+    {
+        uint64_t failures = 0;
+        for (uint32_t h = 0; h < 65536; h++)
+        {
+            if ((h & 0x7c00) == 0x7c00 && (h & 0x3ff) != 0)
+                continue;
+            failures += FloatToHalf(HalfToFloat(uint16_t(h))) == h ? 0 : 1;
+        }
+        return failures;
+    }
+
+    // The capture conversion on small known images: B and R swap with alpha made opaque, and each scale
+    // lands where bilinear filtering between pixel centres puts it.
+    uint64_t CheckCaptureConvert()
+    {
+        auto bgra = [](uint32_t width, uint32_t height, std::initializer_list<uint8_t> bytes) {
+            Image image(width, height, 4);
+            auto byte = bytes.begin();
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width * 4; x++)
+                    image.View().Row(y)[x] = *byte++;
+            }
+            return image;
+        };
+        auto row = [](const Image& image, uint32_t y) {
+            const uint8_t* bytes = image.View().Row(y);
+            return std::vector<uint8_t>(bytes, bytes + size_t(image.View().width) * 4);
+        };
+
+        uint64_t failures = 0;
+
+        // Same size: a straight swizzle.
+        const Image swizzle = bgra(3, 2, { 10, 20, 30, 0, 40, 50, 60, 128, 70, 80, 90, 255, 1, 2, 3, 4, 255, 0, 128, 7, 0, 255, 0, 0 });
+        Image swizzled(3, 2, 4);
+        ConvertBGRAToRGBA<Rgba8Pixel>(swizzle.View(), swizzled.View());
+        failures += row(swizzled, 0) == std::vector<uint8_t>{ 30, 20, 10, 255, 60, 50, 40, 255, 90, 80, 70, 255 } ? 0 : 1;
+        failures += row(swizzled, 1) == std::vector<uint8_t>{ 3, 2, 1, 255, 128, 0, 255, 255, 0, 255, 0, 255 } ? 0 : 1;
+
+        // Half size: every output pixel sits between four source pixels and averages them.
+        Image quad(4, 4, 4);
+        for (uint32_t y = 0; y < 4; y++)
+        {
+            for (uint32_t x = 0; x < 4; x++)
+            {
+                uint8_t* pixel = quad.View().Row(y) + x * 4;
+                pixel[0] = uint8_t(x * 40 + y * 10);
+                pixel[1] = uint8_t(200 - x * 20 - y * 7);
+                pixel[2] = uint8_t(y * 60 + (x & 1) * 3);
+                pixel[3] = 0;
+            }
+        }
+        Image half(2, 2, 4);
+        ConvertBGRAToRGBA<Rgba8Pixel>(quad.View(), half.View());
+        for (uint32_t y = 0; y < 2; y++)
+        {
+            for (uint32_t x = 0; x < 2; x++)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    int sum = 0;
+                    for (uint32_t j = 0; j < 2; j++)
+                    {
+                        for (uint32_t i = 0; i < 2; i++)
+                            sum += quad.View().Row(y * 2 + j)[(x * 2 + i) * 4 + 2 - c];
+                    }
+                    failures += half.View().Row(y)[x * 4 + c] == std::lround(sum / 4.0) ? 0 : 1;
+                }
+                failures += half.View().Row(y)[x * 4 + 3] == 255 ? 0 : 1;
+            }
+        }
+
+        // Double size: a quarter and three quarters of the way between centres, clamped at the edges.
+        const Image pair = bgra(2, 1, { 10, 200, 0, 9, 10, 0, 100, 9 });
+        Image doubled(4, 1, 4);
+        ConvertBGRAToRGBA<Rgba8Pixel>(pair.View(), doubled.View());
+        failures += row(doubled, 0) == std::vector<uint8_t>{ 0, 200, 10, 255, 25, 150, 10, 255, 75, 50, 10, 255, 100, 0, 10, 255 } ? 0 : 1;
+
+        // Two thirds: a scale that doesn't divide, sampled at 0.25 and 1.75.
+        const Image three = bgra(3, 1, { 0, 0, 0, 0, 0, 0, 40, 0, 0, 0, 80, 0 });
+        Image twoThirds(2, 1, 4);
+        ConvertBGRAToRGBA<Rgba8Pixel>(three.View(), twoThirds.View());
+        failures += row(twoThirds, 0) == std::vector<uint8_t>{ 10, 0, 0, 255, 70, 0, 0, 255 } ? 0 : 1;
+
+        // The wider formats encode the swizzled codes as converting the rgba8 result does.
+        for (PixelFormat format : { PixelFormat::Rgb10a2, PixelFormat::Rgba16f })
+        {
+            failures += VisitPixelFormat(format, [&](auto pixel) {
+                using TPixel = decltype(pixel);
+                const float sdrWhiteNits = 203.0f;
+                Image converted(3, 2, TPixel::Bytes), expected(3, 2, TPixel::Bytes);
+                ConvertBGRAToRGBA<TPixel>(swizzle.View(), converted.View(), sdrWhiteNits);
+                ConvertFromRgba8<TPixel>(swizzled.View(), expected.View(), sdrWhiteNits);
+                uint64_t mismatches = 0;
+                for (uint32_t y = 0; y < 2; y++)
+                    mismatches += std::memcmp(converted.View().Row(y), expected.View().Row(y), 3 * TPixel::Bytes) == 0 ? 0 : 1;
+                return mismatches;
+            });
+        }
+        return failures;
+    }
+
+    // Each transfer function inverts its encoding, to within a code of 10-bit PQ.
+    uint64_t CheckTransfers(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const float v = unit(random);
+            failures += std::abs(Transfer::LinearToSrgb(Transfer::SrgbToLinear(v)) - v) < 1e-4f ? 0 : 1;
+            failures += std::abs(Transfer::LinearToPq(Transfer::PqToLinear(v)) - v) < 1e-3f ? 0 : 1;
+            failures += Transfer::SoftClip(v * 4.0f) <= 1.0f && Transfer::SoftClip(v * 4.0f) >= std::min(v * 4.0f, Transfer::SoftClipKnee) ? 0 : 1;
+
+            const float rgb[3] = { unit(random) * 4.0f, unit(random) * 4.0f, unit(random) * 4.0f };
+            float encoded[3], decoded[3];
+            Transfer::Encode(TransferFunction::Pq, rgb, encoded, 200.0f);
+            Transfer::Decode(TransferFunction::Pq, encoded, decoded, 200.0f);
+            for (int c = 0; c < 3; c++)
+                failures += std::abs(decoded[c] - rgb[c]) <= 1e-3f * std::max(rgb[c], 1.0f) ? 0 : 1;
+        }
+        return failures;
+    }
+
+    // Packed 10-bit averaging rounds each field up, as (a + b + 1) / 2 does.
+    uint64_t CheckPackedAverage(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t a = random(), b = random();
+            const uint32_t average = Rgb10a2Pixel::AveragePacked(a, b);
+            const uint32_t shifts[] = { 0, 10, 20, 30 };
+            const uint32_t masks[] = { 0x3ff, 0x3ff, 0x3ff, 0x3 };
+            for (int f = 0; f < 4; f++)
+            {
+                const uint32_t expected = (((a >> shifts[f]) & masks[f]) + ((b >> shifts[f]) & masks[f]) + 1) >> 1;
+                failures += ((average >> shifts[f]) & masks[f]) == expected ? 0 : 1;
+            }
+        }
+        return failures;
+    }
+
+    // Random pixels of the format; half floats stay finite but cover subnormals and negatives.
+    template<typename TPixel>
+    Image RandomPixels(std::mt19937& random, uint32_t width, uint32_t height)
+    {
+        Image image(width, height, TPixel::Bytes);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row = image.View().Row(y);
+            for (uint32_t i = 0; i < width * TPixel::Bytes; i += 2)
+            {
+                uint16_t value = uint16_t(random());
+                if constexpr (TPixel::Format == PixelFormat::Rgba16f)
+                {
+                    if ((value & 0x7c00) == 0x7c00)
+                        value &= 0xbfff;
+                }
+                std::memcpy(row + i, &value, sizeof(value));
+            }
+        }
+        return image;
+    }
+
+    CpuInterpolatorSettings KernelSettings()
+    {
+        CpuInterpolatorSettings settings;
+        settings.blockSize = 8;
+        settings.searchRange = 4;
+        return settings;
+    }
+
+    // Random vectors, kept small enough that both ends of each block stay in the frame as motion search
+    // keeps them.
+    std::vector<MotionVector> RandomField(std::mt19937& random, const CpuInterpolatorSettings& settings, uint32_t width, uint32_t height)
+    {
+        const uint32_t blocksX = (width + settings.blockSize - 1) / settings.blockSize;
+        const uint32_t blocksY = (height + settings.blockSize - 1) / settings.blockSize;
+        std::vector<MotionVector> field(size_t(blocksX) * blocksY);
+        for (uint32_t by = 0; by < blocksY; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                const int x = int(bx * settings.blockSize), y = int(by * settings.blockSize);
+                const int rangeX = std::min({ settings.searchRange, x, int(width) - x - int(std::min(settings.blockSize, width - x)) });
+                const int rangeY = std::min({ settings.searchRange, y, int(height) - y - int(std::min(settings.blockSize, height - y)) });
+                field[size_t(by) * blocksX + bx] = { int16_t(std::uniform_int_distribution<int>(-rangeX, rangeX)(random)),
+                    int16_t(std::uniform_int_distribution<int>(-rangeY, rangeY)(random)), 0 };
+            }
+        }
+        return field;
+    }
+
+    // The SIMD kernels give exactly what the scalar ones do, for every format.
+    template<typename TPixel>
+    uint64_t CheckKernels(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t width = std::uniform_int_distribution<uint32_t>(1, 131)(random);
+            const uint32_t height = std::uniform_int_distribution<uint32_t>(1, 67)(random);
+            const Image a = RandomPixels<TPixel>(random, width, height);
+            const Image b = RandomPixels<TPixel>(random, width, height);
+
+            Image lumaScalar(width, height, 1), lumaSimd(width, height, 1);
+            Kernels::ComputeLuma<TPixel>(a.View(), lumaScalar.View(), SimdTier::Scalar);
+            Kernels::ComputeLuma<TPixel>(a.View(), lumaSimd.View(), BestSimdTier());
+            for (uint32_t y = 0; y < height; y++)
+                failures += std::memcmp(lumaScalar.View().Row(y), lumaSimd.View().Row(y), width) == 0 ? 0 : 1;
+
+            CpuInterpolatorSettings settings = KernelSettings();
+            const uint32_t blocksY = (height + settings.blockSize - 1) / settings.blockSize;
+            const std::vector<MotionVector> field = RandomField(random, settings, width, height);
+
+            Image composedScalar(width, height, TPixel::Bytes), composedSimd(width, height, TPixel::Bytes);
+            settings.tier = SimdTier::Scalar;
+            Kernels::ComposeMidpoint<TPixel>(a.View(), b.View(), field, settings, composedScalar.View(), 0, blocksY);
+            settings.tier = BestSimdTier();
+            Kernels::ComposeMidpoint<TPixel>(a.View(), b.View(), field, settings, composedSimd.View(), 0, blocksY);
+            for (uint32_t y = 0; y < height; y++)
+                failures += std::memcmp(composedScalar.View().Row(y), composedSimd.View().Row(y), size_t(width) * TPixel::Bytes) == 0 ? 0 : 1;
+        }
+        return failures;
+    }
+
+    bool SameRows(ConstImageView a, ConstImageView b, size_t bytes)
+    {
+        for (uint32_t y = 0; y < a.height; y++)
+        {
+            if (std::memcmp(a.Row(y), b.Row(y), bytes) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // nv12 conversion is ColorConvert.h's I420 with the chroma interleaved, and its SIMD paths and
+    // planar composition match the scalar ones exactly.
+    uint64_t CheckNv12(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const uint32_t width = 2 * std::uniform_int_distribution<uint32_t>(1, 66)(random);
+            const uint32_t height = 2 * std::uniform_int_distribution<uint32_t>(1, 34)(random);
+            const uint32_t rows = PixelFormatRows(PixelFormat::Nv12, height);
+            const Image rgba = RandomPixels<Rgba8Pixel>(random, width, height);
+
+            Image scalar(width, rows, 1), simd(width, rows, 1);
+            ConvertRgba8ToNv12(rgba.View(), scalar.View(), SimdTier::Scalar);
+            ConvertRgba8ToNv12(rgba.View(), simd.View(), BestSimdTier());
+            failures += SameRows(scalar.View(), simd.View(), width) ? 0 : 1;
+
+            I420Image yuv;
+            ConvertRGBAToI420(rgba.View(), yuv);
+            const ConstNv12Planes planes = SplitNv12<const uint8_t>(scalar.View());
+            failures += SameRows(planes.luma, yuv.y.View(), width) ? 0 : 1;
+            for (uint32_t y = 0; y < planes.chroma.height; y++)
+            {
+                for (uint32_t x = 0; x < planes.chroma.width; x++)
+                {
+                    failures += planes.chroma.Row(y)[x * 2] == yuv.u.View().Row(y)[x] ? 0 : 1;
+                    failures += planes.chroma.Row(y)[x * 2 + 1] == yuv.v.View().Row(y)[x] ? 0 : 1;
+                }
+            }
+
+            // Random planes, not just converted ones, so the clamps are reached.
+            const Image nv12 = RandomPixels<Rgba8Pixel>(random, width / 4 + 1, rows);
+            const ConstImageView nv12View = { nv12.Data(), width, rows, nv12.Pitch() };
+            Image backScalar(width, height, 4), backSimd(width, height, 4), backI420(width, height, 4);
+            ConvertNv12ToRgba8(nv12View, backScalar.View(), SimdTier::Scalar);
+            ConvertNv12ToRgba8(nv12View, backSimd.View(), BestSimdTier());
+            failures += SameRows(backScalar.View(), backSimd.View(), size_t(width) * 4) ? 0 : 1;
+            const ConstNv12Planes random12 = SplitNv12(nv12View);
+            for (uint32_t y = 0; y < random12.chroma.height; y++)
+            {
+                std::memcpy(yuv.y.View().Row(y * 2), random12.luma.Row(y * 2), width);
+                std::memcpy(yuv.y.View().Row(y * 2 + 1), random12.luma.Row(y * 2 + 1), width);
+                for (uint32_t x = 0; x < random12.chroma.width; x++)
+                {
+                    yuv.u.View().Row(y)[x] = random12.chroma.Row(y)[x * 2];
+                    yuv.v.View().Row(y)[x] = random12.chroma.Row(y)[x * 2 + 1];
+                }
+            }
+            ConvertI420ToRGBA(yuv, backI420.View());
+            failures += SameRows(backScalar.View(), backI420.View(), size_t(width) * 4) ? 0 : 1;
+
+            CpuInterpolatorSettings settings = KernelSettings();
+            const uint32_t blocksY = (height + settings.blockSize - 1) / settings.blockSize;
+            const std::vector<MotionVector> field = RandomField(random, settings, width, height);
+            Image composedScalar(width, rows, 1), composedSimd(width, rows, 1);
+            settings.tier = SimdTier::Scalar;
+            Kernels::ComposeMidpointNv12(scalar.View(), nv12View, field, settings, composedScalar.View(), 0, blocksY);
+            settings.tier = BestSimdTier();
+            Kernels::ComposeMidpointNv12(scalar.View(), nv12View, field, settings, composedSimd.View(), 0, blocksY);
+            failures += SameRows(composedScalar.View(), composedSimd.View(), width) ? 0 : 1;
+        }
+        return failures;
+    }
+
+    // Every rgba8 code comes back within one below the shoulder, and no brighter above it.
+    uint64_t CheckRoundTrips(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        const uint32_t knee = uint32_t(Transfer::LinearToSrgb(Transfer::SoftClipKnee) * 255.0f);
+        std::uniform_real_distribution<float> white(80.0f, 1000.0f);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const Srgb8Encoder encoder(white(random));
+            Image codes(256, 1, 4);
+            for (uint32_t c = 0; c < 256; c++)
+            {
+                uint8_t* p = codes.View().Row(0) + c * 4;
+                p[0] = p[1] = p[2] = uint8_t(c);
+                p[3] = 0xFF;
+            }
+            for (PixelFormat format : c_Formats)
+            {
+                if (PixelFormatPlanar(format))
+                    continue;
+                VisitPixelFormat(format, [&](auto pixel) {
+                    using TPixel = decltype(pixel);
+                    Image converted(256, 1, TPixel::Bytes), back(256, 1, 4);
+                    ConvertFromRgba8<TPixel>(codes.View(), converted.View(), encoder.SdrWhiteNits());
+                    ConvertToRgba8<TPixel>(converted.View(), back.View(), encoder);
+                    for (uint32_t c = 0; c < 256; c++)
+                    {
+                        const int code = back.View().Row(0)[c * 4];
+                        failures += c <= knee ? (std::abs(code - int(c)) <= 1 ? 0 : 1) : (code <= int(c) + 1 ? 0 : 1);
+                        failures += back.View().Row(0)[c * 4 + 3] == 0xFF ? 0 : 1;
+                    }
+                });
+            }
+        }
+        return failures;
+    }
+}
+
+int DX::FormatCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+
+    // --check N: conversions, the capture swizzle and scale, transfer functions, and the SIMD kernels of every format against the
+    // scalar ones. Blending in linear or PQ light differs from blending sRGB codes, so the interpolated
+    // frame in each format only has to be about as close to the true midpoint as the rgba8 one, give or
+    // take what the format loses on a round trip.
+    if (args.Has("check"))
+    {
+        const uint32_t count = std::max(1u, args.GetUInt("check", 200));
+        uint64_t failures = CheckHalves();
+        failures += CheckCaptureConvert();
+        failures += CheckTransfers(random, count * 50);
+        failures += CheckPackedAverage(random, count * 50);
+        failures += CheckKernels<Rgba8Pixel>(random, count);
+        failures += CheckKernels<Rgb10a2Pixel>(random, count);
+        failures += CheckKernels<Rgba16fPixel>(random, count);
+        failures += CheckNv12(random, count);
+        failures += CheckRoundTrips(random, std::max(1u, count / 20));
+
+        const Srgb8Encoder encoder(200.0f);
+        const Image previous = SyntheticFrame(256, 144, 0, 0);
+        const Image current = SyntheticFrame(256, 144, -c_MotionX, -c_MotionY);
+        const Image truth = SyntheticFrame(256, 144, -c_MotionX / 2, -c_MotionY / 2);
+        const double rgba8Error = CompareRgba8(truth.View(), InterpolateIn(PixelFormat::Rgba8, previous.View(), current.View(), encoder).View()).mean;
+        for (PixelFormat format : c_Formats)
+        {
+            const Difference difference = CompareRgba8(truth.View(), InterpolateIn(format, previous.View(), current.View(), encoder).View());
+            failures += difference.mean <= rgba8Error + RoundTrip(truth.View(), format, encoder).mean + 1.0 ? 0 : 1;
+        }
+
+        printf("formats: %u rounds, %llu failures\n", count, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Pixel formats failed their checks");
+        return 0;
+    }
+
+    uint32_t width = 0, height = 0;
+    if (!args.GetSize("size", width, height))
+    {
+        width = 1920;
+        height = 1080;
+    }
+    const float sdrWhite = float(args.GetNumber("sdr-white", 200.0));
+    if (!(sdrWhite >= 80.0f && sdrWhite <= 1000.0f))
+        throw std::runtime_error("--sdr-white must be 80 to 1000 nits");
+
+    const Srgb8Encoder encoder(sdrWhite);
+    const Image previous = SyntheticFrame(width, height, 0, 0);
+    const Image current = SyntheticFrame(width, height, -c_MotionX, -c_MotionY);
+    const Image truth = SyntheticFrame(width, height, -c_MotionX / 2, -c_MotionY / 2);
+    printf("formats: %ux%u frames, SDR white at %.0f nits; %u frame transfers per source frame between capture and present\n",
+        width, height, sdrWhite, c_RingPasses);
+    const double rgba8Bytes = double(PixelFormatFrameBytes(PixelFormat::Rgba8, width, height));
+    for (PixelFormat format : c_Formats)
+    {
+        const Difference trip = RoundTrip(truth.View(), format, encoder);
+        const Difference interpolated = CompareRgba8(truth.View(), InterpolateIn(format, previous.View(), current.View(), encoder).View());
+        const double bytes = double(PixelFormatFrameBytes(format, width, height));
+        printf("  %-8s %-6s %6.2f MB/frame %6.1f MB/source frame (%+4.0f%% vs rgba8)  round trip %.3f mean, %u max  interpolated vs midpoint %.3f mean, %u max\n",
+            PixelFormatName(format), TransferFunctionName(PixelFormatTransfer(format)), bytes / (1 << 20), bytes * c_RingPasses / (1 << 20),
+            100.0 * (bytes / rgba8Bytes - 1.0), trip.mean, trip.max, interpolated.mean, interpolated.max);
+    }
+    return 0;
+}
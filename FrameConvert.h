@@ -0,0 +1,192 @@
+//
+// FrameConvert.h - CPU reference for the capture conversion pass (CaptureConvert_CS.hlsl)
+//
+
+#pragma once
+
+#include "Image.h"
+#include "PixelFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace DX
+{
+    // Swizzle a BGRA desktop image to RGBA pixels of a format while resampling it to the destination size.
+    // Matches the GPU pass: pixel-centre mapping, bilinear filtering of the sRGB codes, clamped edges and
+    // opaque alpha, then the format's transfer at sdrWhiteNits for the wider formats.
+    template<typename TPixel>
+    void ConvertBGRAToRGBA(ConstImageView src, ImageView dst, float sdrWhiteNits = Transfer::ScRgbWhiteNits)
+    {
+        if (src.width == 0 || src.height == 0)
+            return;
+
+        const float scaleX = float(src.width) / float(dst.width);
+        const float scaleY = float(src.height) / float(dst.height);
+        const int maxX = int(src.width) - 1;
+        const int maxY = int(src.height) - 1;
+
+        for (uint32_t y = 0; y < dst.height; y++)
+        {
+            const float v = std::max((float(y) + 0.5f) * scaleY - 0.5f, 0.f);
+            const int y0 = std::min(int(v), maxY);
+            const int y1 = std::min(y0 + 1, maxY);
+            const float fy = v - float(y0);
+
+            const uint8_t* row0 = src.Row(uint32_t(y0));
+            const uint8_t* row1 = src.Row(uint32_t(y1));
+            uint8_t* out = dst.Row(y);
+
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                const float u = std::max((float(x) + 0.5f) * scaleX - 0.5f, 0.f);
+                const int x0 = std::min(int(u), maxX);
+                const int x1 = std::min(x0 + 1, maxX);
+                const float fx = u - float(x0);
+
+                float rgb[3];
+                for (int c = 0; c < 3; c++)
+                {
+                    // BGRA source channel 2 - c lands in RGBA channel c.
+                    const int s = 2 - c;
+                    const float top = row0[x0 * 4 + s] + (row0[x1 * 4 + s] - row0[x0 * 4 + s]) * fx;
+                    const float bottom = row1[x0 * 4 + s] + (row1[x1 * 4 + s] - row1[x0 * 4 + s]) * fx;
+                    rgb[c] = top + (bottom - top) * fy;
+                }
+
+                if constexpr (TPixel::Format == PixelFormat::Rgba8)
+                {
+                    (void)sdrWhiteNits;
+                    for (int c = 0; c < 3; c++)
+                        out[x * 4 + c] = static_cast<uint8_t>(std::lround(rgb[c]));
+                    out[x * 4 + 3] = 255;
+                }
+                else
+                {
+                    float linear[3], encoded[3];
+                    for (int c = 0; c < 3; c++)
+                        linear[c] = Transfer::SrgbToLinear(rgb[c] / 255.0f) * sdrWhiteNits / Transfer::ScRgbWhiteNits;
+                    Transfer::Encode(PixelFormatTransfer(TPixel::Format), linear, encoded, sdrWhiteNits);
+                    const float channels[4] = { encoded[0] * TPixel::ChannelMax, encoded[1] * TPixel::ChannelMax, encoded[2] * TPixel::ChannelMax, TPixel::AlphaMax };
+                    TPixel::Pack(channels, out + x * TPixel::Bytes);
+                }
+            }
+        }
+    }
+
+    // The 8-bit sRGB code of an scRGB value, looked up by the value as a half float: the last step into
+    // rgba8 for every other format. Built for one SDR white.
+    class Srgb8Encoder
+    {
+    public:
+        explicit Srgb8Encoder(float sdrWhiteNits) : m_sdrWhiteNits(sdrWhiteNits), m_table(65536)
+        {
+            for (uint32_t i = 0; i < m_table.size(); i++)
+            {
+                const float value = HalfToFloat(uint16_t(i));
+                const float code = value > 0.0f ? Transfer::LinearToSrgb(Transfer::SoftClip(value * Transfer::ScRgbWhiteNits / sdrWhiteNits)) : 0.0f;
+                m_table[i] = static_cast<uint8_t>(std::lround(code * 255.0f));
+            }
+        }
+
+        float SdrWhiteNits() const noexcept { return m_sdrWhiteNits; }
+        uint8_t FromHalf(uint16_t half) const noexcept { return m_table[half]; }
+        uint8_t operator()(float scRgb) const noexcept { return m_table[FloatToHalf(scRgb)]; }
+
+    private:
+        float                   m_sdrWhiteNits;
+        std::vector<uint8_t>    m_table;
+    };
+
+    // Pixels of a format to rgba8, as the present pass draws them on an SDR swap chain. Used where frames
+    // leave the viewer as 8-bit: recording and the shared output.
+    template<typename TPixel>
+    void ConvertToRgba8(ConstImageView src, ImageView dst, const Srgb8Encoder& encoder)
+    {
+        const uint32_t width = std::min(src.width, dst.width);
+        const uint32_t height = std::min(src.height, dst.height);
+        if constexpr (TPixel::Format == PixelFormat::Rgba8)
+        {
+            (void)encoder;
+            CopyImage(src, dst, TPixel::Bytes);
+        }
+        else if constexpr (TPixel::Format == PixelFormat::Rgb10a2)
+        {
+            const std::array<float, 1024>& pqLinear = Detail::PqLinearTable();
+            for (uint32_t y = 0; y < height; y++)
+            {
+                const uint8_t* in = src.Row(y);
+                uint8_t* out = dst.Row(y);
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const uint32_t v = Rgb10a2Pixel::Load(in + x * 4);
+                    const float wide[3] = { pqLinear[v & 0x3ff], pqLinear[(v >> 10) & 0x3ff], pqLinear[(v >> 20) & 0x3ff] };
+                    float linear[3];
+                    Transfer::Bt2020ToBt709(wide, linear);
+                    for (int c = 0; c < 3; c++)
+                        out[x * 4 + c] = encoder(linear[c]);
+                    out[x * 4 + 3] = static_cast<uint8_t>((v >> 30) * 85);
+                }
+            }
+        }
+        else
+        {
+            for (uint32_t y = 0; y < height; y++)
+            {
+                const uint16_t* in = reinterpret_cast<const uint16_t*>(src.Row(y));
+                uint8_t* out = dst.Row(y);
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    for (int c = 0; c < 3; c++)
+                        out[x * 4 + c] = encoder.FromHalf(in[x * 4 + c]);
+                    out[x * 4 + 3] = static_cast<uint8_t>(std::lround(std::clamp(HalfToFloat(in[x * 4 + 3]), 0.0f, 1.0f) * 255.0f));
+                }
+            }
+        }
+    }
+
+    // rgba8 pixels of an SDR desktop to a format, as the capture pass converts them; the reference the
+    // checks hold the other formats' kernels to.
+    template<typename TPixel>
+    void ConvertFromRgba8(ConstImageView src, ImageView dst, float sdrWhiteNits)
+    {
+        const uint32_t width = std::min(src.width, dst.width);
+        const uint32_t height = std::min(src.height, dst.height);
+        if constexpr (TPixel::Format == PixelFormat::Rgba8)
+        {
+            (void)sdrWhiteNits;
+            CopyImage(src, dst, TPixel::Bytes);
+            return;
+        }
+
+        // Every code decodes the same way, so decode each once.
+        std::array<float, 256> linear;
+        for (uint32_t i = 0; i < linear.size(); i++)
+            linear[i] = Transfer::SrgbToLinear(float(i) / 255.0f) * sdrWhiteNits / Transfer::ScRgbWhiteNits;
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* in = src.Row(y);
+            uint8_t* out = dst.Row(y);
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float rgb[3] = { linear[in[x * 4]], linear[in[x * 4 + 1]], linear[in[x * 4 + 2]] };
+                float encoded[3];
+                Transfer::Encode(PixelFormatTransfer(TPixel::Format), rgb, encoded, sdrWhiteNits);
+                if constexpr (TPixel::Format == PixelFormat::Rgb10a2)
+                {
+                    uint32_t value = 3u << 30;
+                    for (int c = 0; c < 3; c++)
+                        value |= uint32_t(std::lround(std::clamp(encoded[c], 0.0f, 1.0f) * 1023.0f)) << (10 * c);
+                    std::memcpy(out + x * 4, &value, sizeof(value));
+                }
+                else
+                {
+                    const uint16_t halves[4] = { FloatToHalf(encoded[0]), FloatToHalf(encoded[1]), FloatToHalf(encoded[2]), FloatToHalf(in[x * 4 + 3] / 255.0f) };
+                    std::memcpy(out + x * 8, halves, sizeof(halves));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,252 @@
+//
+// FrameIO.cpp - File-based frame sources and sinks (Y4M and raw RGBA) for the offline tools
+//
+
+#include "FrameIO.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    struct FileCloser
+    {
+        void operator()(FILE* file) const noexcept
+        {
+            if (file != nullptr && file != stdout && file != stdin)
+                fclose(file);
+        }
+    };
+
+    using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+    FilePtr OpenFile(const std::string& path, const char* mode)
+    {
+        if (path == "-")
+            return FilePtr(std::strchr(mode, 'r') ? stdin : stdout);
+
+        FILE* file = nullptr;
+#ifdef _WIN32
+        fopen_s(&file, path.c_str(), mode);
+#else
+        file = fopen(path.c_str(), mode);
+#endif
+        if (file == nullptr)
+            throw std::runtime_error("Cannot open " + path);
+
+        // Large buffers keep the tools from being bound by small reads and writes.
+        setvbuf(file, nullptr, _IOFBF, 4 << 20);
+        return FilePtr(file);
+    }
+
+    bool ReadLine(FILE* file, std::string& line)
+    {
+        line.clear();
+        for (int c = fgetc(file); c != EOF; c = fgetc(file))
+        {
+            if (c == '\n')
+                return true;
+            line.push_back(static_cast<char>(c));
+        }
+        return !line.empty();
+    }
+
+    bool ReadPlane(FILE* file, Image& plane)
+    {
+        for (uint32_t y = 0; y < plane.Height(); y++)
+        {
+            if (fread(plane.View().Row(y), 1, plane.Width(), file) != plane.Width())
+                return false;
+        }
+        return true;
+    }
+
+    bool WritePlane(FILE* file, const Image& plane)
+    {
+        for (uint32_t y = 0; y < plane.Height(); y++)
+        {
+            if (fwrite(plane.View().Row(y), 1, plane.Width(), file) != plane.Width())
+                return false;
+        }
+        return true;
+    }
+
+    class Y4MFrameSource final : public IFrameSource
+    {
+    public:
+        explicit Y4MFrameSource(const std::string& path) :
+            m_file(OpenFile(path, "rb"))
+        {
+            std::string header;
+            if (!ReadLine(m_file.get(), header) || header.rfind("YUV4MPEG2", 0) != 0)
+                throw std::runtime_error(path + " is not a Y4M file");
+
+            // Parse space-separated tagged parameters.
+            size_t pos = 0;
+            while ((pos = header.find(' ', pos)) != std::string::npos)
+            {
+                const char tag = header[++pos];
+                const std::string value = header.substr(pos + 1, header.find(' ', pos) - pos - 1);
+                switch (tag)
+                {
+                case 'W': m_format.width = static_cast<uint32_t>(std::stoul(value)); break;
+                case 'H': m_format.height = static_cast<uint32_t>(std::stoul(value)); break;
+                case 'F':
+                    m_format.rateNumerator = static_cast<uint32_t>(std::stoul(value));
+                    m_format.rateDenominator = static_cast<uint32_t>(std::stoul(value.substr(value.find(':') + 1)));
+                    break;
+                case 'C':
+                    if (value.rfind("420", 0) != 0)
+                        throw std::runtime_error(path + ": only 4:2:0 Y4M is supported");
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            if (m_format.width == 0 || m_format.height == 0)
+                throw std::runtime_error(path + ": missing frame size");
+            m_yuv.Resize(m_format.width, m_format.height);
+        }
+
+        const FrameFormat& Format() const noexcept override { return m_format; }
+
+        bool Read(ImageView rgba) override
+        {
+            std::string frameHeader;
+            if (!ReadLine(m_file.get(), frameHeader) || frameHeader.rfind("FRAME", 0) != 0)
+                return false;
+            if (!ReadPlane(m_file.get(), m_yuv.y) || !ReadPlane(m_file.get(), m_yuv.u) || !ReadPlane(m_file.get(), m_yuv.v))
+                return false;
+
+            ConvertI420ToRGBA(m_yuv, rgba);
+            return true;
+        }
+
+    private:
+        FilePtr         m_file;
+        FrameFormat     m_format;
+        I420Image       m_yuv;
+    };
+
+    class RawFrameSource final : public IFrameSource
+    {
+    public:
+        RawFrameSource(const std::string& path, const FrameFormat& format) :
+            m_file(OpenFile(path, "rb")),
+            m_format(format)
+        {
+            if (m_format.width == 0 || m_format.height == 0)
+                throw std::runtime_error(path + ": raw input needs a frame size");
+        }
+
+        const FrameFormat& Format() const noexcept override { return m_format; }
+
+        bool Read(ImageView rgba) override
+        {
+            const size_t rowBytes = size_t(m_format.width) * 4;
+            for (uint32_t y = 0; y < m_format.height; y++)
+            {
+                if (fread(rgba.Row(y), 1, rowBytes, m_file.get()) != rowBytes)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        FilePtr         m_file;
+        FrameFormat     m_format;
+    };
+
+    class Y4MFrameSink final : public IFrameSink
+    {
+    public:
+        Y4MFrameSink(const std::string& path, const FrameFormat& format) :
+            m_file(OpenFile(path, "wb"))
+        {
+            const std::string header = Y4MStreamHeader(format);
+            m_bytes += fwrite(header.data(), 1, header.size(), m_file.get());
+        }
+
+        bool Write(ConstImageView rgba) override
+        {
+            ConvertRGBAToI420(rgba, m_yuv);
+            static const char frameHeader[] = "FRAME\n";
+            if (fwrite(frameHeader, 1, sizeof(frameHeader) - 1, m_file.get()) != sizeof(frameHeader) - 1)
+                return false;
+            if (!WritePlane(m_file.get(), m_yuv.y) || !WritePlane(m_file.get(), m_yuv.u) || !WritePlane(m_file.get(), m_yuv.v))
+                return false;
+
+            m_bytes += sizeof(frameHeader) - 1 + size_t(m_yuv.y.Width()) * m_yuv.y.Height()
+                + 2 * size_t(m_yuv.u.Width()) * m_yuv.u.Height();
+            return true;
+        }
+
+        uint64_t BytesWritten() const noexcept override { return m_bytes; }
+
+    private:
+        FilePtr         m_file;
+        I420Image       m_yuv;
+        uint64_t        m_bytes = 0;
+    };
+
+    class RawFrameSink final : public IFrameSink
+    {
+    public:
+        explicit RawFrameSink(const std::string& path) :
+            m_file(OpenFile(path, "wb"))
+        {
+        }
+
+        bool Write(ConstImageView rgba) override
+        {
+            const size_t rowBytes = size_t(rgba.width) * 4;
+            for (uint32_t y = 0; y < rgba.height; y++)
+            {
+                if (fwrite(rgba.Row(y), 1, rowBytes, m_file.get()) != rowBytes)
+                    return false;
+            }
+            m_bytes += rowBytes * rgba.height;
+            return true;
+        }
+
+        uint64_t BytesWritten() const noexcept override { return m_bytes; }
+
+    private:
+        FilePtr         m_file;
+        uint64_t        m_bytes = 0;
+    };
+}
+
+std::unique_ptr<IFrameSource> DX::OpenFrameSource(const std::string& path, FrameFileFormat fileFormat, const FrameFormat& rawFormat)
+{
+    if (fileFormat == FrameFileFormat::Y4M)
+        return std::make_unique<Y4MFrameSource>(path);
+    return std::make_unique<RawFrameSource>(path, rawFormat);
+}
+
+std::unique_ptr<IFrameSink> DX::CreateFrameSink(const std::string& path, FrameFileFormat fileFormat, const FrameFormat& format)
+{
+    if (fileFormat == FrameFileFormat::Y4M)
+        return std::make_unique<Y4MFrameSink>(path, format);
+    return std::make_unique<RawFrameSink>(path);
+}
+
+FrameFileFormat DX::FrameFileFormatFromPath(const std::string& path)
+{
+    const size_t dot = path.find_last_of('.');
+    if (dot != std::string::npos && path.compare(dot, std::string::npos, ".y4m") == 0)
+        return FrameFileFormat::Y4M;
+    return FrameFileFormat::RawRGBA;
+}
+
+std::string DX::Y4MStreamHeader(const FrameFormat& format)
+{
+    char header[128] = {};
+    snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C420jpeg\n",
+        format.width, format.height, format.rateNumerator, format.rateDenominator);
+    return header;
+}
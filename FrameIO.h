@@ -0,0 +1,63 @@
+//
+// FrameIO.h - File-based frame sources and sinks (Y4M and raw RGBA) for the offline tools
+//
+
+#pragma once
+
+#include "ColorConvert.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace DX
+{
+    enum class FrameFileFormat
+    {
+        Y4M,
+        RawRGBA,
+    };
+
+    struct FrameFormat
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t rateNumerator = 60;
+        uint32_t rateDenominator = 1;
+
+        double FramesPerSecond() const noexcept { return rateDenominator == 0 ? 0.0 : double(rateNumerator) / rateDenominator; }
+    };
+
+    // Delivers RGBA frames from a file in presentation order.
+    class IFrameSource
+    {
+    public:
+        virtual ~IFrameSource() = default;
+        virtual const FrameFormat& Format() const noexcept = 0;
+
+        // Read the next frame into rgba, which must match Format(). Returns false at end of stream.
+        virtual bool Read(ImageView rgba) = 0;
+    };
+
+    // Consumes RGBA frames in presentation order.
+    class IFrameSink
+    {
+    public:
+        virtual ~IFrameSink() = default;
+        virtual bool Write(ConstImageView rgba) = 0;
+        virtual uint64_t BytesWritten() const noexcept = 0;
+    };
+
+    // Open path for reading. Raw files carry no header, so their format must be supplied.
+    // Throws std::runtime_error if the file can't be opened or parsed.
+    std::unique_ptr<IFrameSource> OpenFrameSource(const std::string& path, FrameFileFormat fileFormat, const FrameFormat& rawFormat = {});
+
+    // Create path for writing frames of the given format. "-" writes to stdout.
+    std::unique_ptr<IFrameSink> CreateFrameSink(const std::string& path, FrameFileFormat fileFormat, const FrameFormat& format);
+
+    // Choose a file format from the path's extension (.y4m, anything else is raw).
+    FrameFileFormat FrameFileFormatFromPath(const std::string& path);
+
+    // "YUV4MPEG2 W.. H.. F..:.. Ip A1:1 C420jpeg\n", the stream header of the 4:2:0 files we write.
+    std::string Y4MStreamHeader(const FrameFormat& format);
+}
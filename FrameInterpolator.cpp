@@ -0,0 +1,530 @@
+//
+// FrameInterpolator.cpp - CPU backend for the frame interpolation contract
+//
+
+#include "FrameInterpolator.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace DX;
+
+namespace
+{
+    constexpr int c_CoarseStep = 4;
+    constexpr int c_MaxRefineSteps = 8;
+
+    struct Block
+    {
+        int x, y;
+        uint32_t width, height;
+    };
+
+    inline Block BlockAt(uint32_t bx, uint32_t by, uint32_t blockSize, uint32_t width, uint32_t height) noexcept
+    {
+        const uint32_t x = bx * blockSize;
+        const uint32_t y = by * blockSize;
+        return { int(x), int(y), std::min(blockSize, width - x), std::min(blockSize, height - y) };
+    }
+
+    inline uint32_t BlocksAcross(uint32_t size, uint32_t blockSize) noexcept
+    {
+        return (size + blockSize - 1) / blockSize;
+    }
+
+    // previous(p - v) and current(p + v) must both stay inside the frame.
+    inline bool InBounds(const Block& block, int vx, int vy, uint32_t width, uint32_t height) noexcept
+    {
+        const int ax = std::abs(vx);
+        const int ay = std::abs(vy);
+        return block.x - ax >= 0 && block.y - ay >= 0
+            && block.x + int(block.width) + ax <= int(width) && block.y + int(block.height) + ay <= int(height);
+    }
+
+    // The part of a row each format does with SIMD; returns the pixels (or bytes) done, and the scalar
+    // traits finish the rest. Formats without a SIMD path do none.
+    template<typename TPixel>
+    uint32_t LumaRowSimd(const uint8_t*, uint8_t*, uint32_t, SimdTier) noexcept { return 0; }
+
+    template<typename TPixel>
+    uint32_t AverageRowSimd(const uint8_t*, const uint8_t*, uint8_t*, uint32_t, SimdTier) noexcept { return 0; }
+
+#if DX_HAS_SSE2
+    template<>
+    uint32_t LumaRowSimd<Rgba8Pixel>(const uint8_t* in, uint8_t* out, uint32_t width, SimdTier tier) noexcept
+    {
+        uint32_t x = 0;
+        if (tier != SimdTier::SSE2)
+            return x;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(54, 183, 19, 0, 54, 183, 19, 0);
+        const __m128i round = _mm_set1_epi32(128);
+        for (; x + 4 <= width; x += 4)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4));
+            const __m128 lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights));
+            const __m128 hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights));
+
+            // Each pixel produced (54r + 183g, 19b); add the halves.
+            const __m128i rg = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128i b = _mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+            const __m128i sum = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(rg, b), round), 8);
+            const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(sum, sum), zero));
+            std::memcpy(out + x, &packed, sizeof(packed));
+        }
+        return x;
+    }
+
+    template<>
+    uint32_t LumaRowSimd<Rgb10a2Pixel>(const uint8_t* in, uint8_t* out, uint32_t width, SimdTier tier) noexcept
+    {
+        uint32_t x = 0;
+        if (tier != SimdTier::SSE2)
+            return x;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i field = _mm_set1_epi32(0x3ff);
+        const __m128i rgWeights = _mm_setr_epi16(67, 174, 67, 174, 67, 174, 67, 174);
+        const __m128i bWeights = _mm_setr_epi16(15, 0, 15, 0, 15, 0, 15, 0);
+        const __m128i round = _mm_set1_epi32(512);
+        for (; x + 4 <= width; x += 4)
+        {
+            // R and G side by side in each 32-bit lane, B alone, so one multiply-add weighs each pair.
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4));
+            const __m128i rg = _mm_or_si128(_mm_and_si128(pixels, field), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(pixels, 10), field), 16));
+            const __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 20), field);
+            const __m128i sum = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rg, rgWeights), _mm_madd_epi16(b, bWeights)), round), 10);
+            const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(sum, sum), zero));
+            std::memcpy(out + x, &packed, sizeof(packed));
+        }
+        return x;
+    }
+
+    // Four pixels at a time, transposed to planes for the weights; the table is still read per pixel.
+    template<>
+    uint32_t LumaRowSimd<Rgba16fPixel>(const uint8_t* in, uint8_t* out, uint32_t width, SimdTier tier) noexcept
+    {
+        const std::array<uint8_t, 65536>& pqLuma = Detail::PqLumaTable();
+        uint32_t x = 0;
+        if (tier == SimdTier::SSE2)
+        {
+            const __m128 wr = _mm_set1_ps(0.2126f);
+            const __m128 wg = _mm_set1_ps(0.7152f);
+            const __m128 wb = _mm_set1_ps(0.0722f);
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + size_t(x) * 8));
+                const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + size_t(x) * 8 + 16));
+                __m128 r = HalvesToFloats(lo);
+                __m128 g = HalvesToFloats(_mm_srli_si128(lo, 8));
+                __m128 b = HalvesToFloats(hi);
+                __m128 a = HalvesToFloats(_mm_srli_si128(hi, 8));
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+                const __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, wr), _mm_mul_ps(g, wg)), _mm_mul_ps(b, wb));
+
+                alignas(16) int32_t halves[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(halves), FloatsToHalves(y));
+                for (int i = 0; i < 4; i++)
+                    out[x + i] = pqLuma[uint16_t(halves[i])];
+            }
+        }
+        for (; x < width; x++)
+            out[x] = Rgba16fPixel::Luma(in + size_t(x) * Rgba16fPixel::Bytes, pqLuma);
+        return width;
+    }
+
+    template<>
+    uint32_t AverageRowSimd<Rgba8Pixel>(const uint8_t* a, const uint8_t* b, uint8_t* out, uint32_t bytes, SimdTier tier) noexcept
+    {
+        uint32_t i = 0;
+        if (tier != SimdTier::SSE2)
+            return i;
+        for (; i + 16 <= bytes; i += 16)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_avg_epu8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+        }
+        return i;
+    }
+
+    template<>
+    uint32_t AverageRowSimd<Rgb10a2Pixel>(const uint8_t* a, const uint8_t* b, uint8_t* out, uint32_t bytes, SimdTier tier) noexcept
+    {
+        uint32_t i = 0;
+        if (tier != SimdTier::SSE2)
+            return i;
+        const __m128i keep = _mm_set1_epi32(static_cast<int>(~Rgb10a2Pixel::FieldCarries));
+        for (; i + 16 <= bytes; i += 16)
+        {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                _mm_sub_epi32(_mm_or_si128(x, y), _mm_and_si128(_mm_srli_epi32(_mm_xor_si128(x, y), 1), keep)));
+        }
+        return i;
+    }
+
+    // Two pixels at a time, averaged in float and rounded back like the scalar path.
+    template<>
+    uint32_t AverageRowSimd<Rgba16fPixel>(const uint8_t* a, const uint8_t* b, uint8_t* out, uint32_t bytes, SimdTier tier) noexcept
+    {
+        uint32_t i = 0;
+        if (tier != SimdTier::SSE2)
+            return i;
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 16 <= bytes; i += 16)
+        {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            const __m128 lo = _mm_mul_ps(_mm_add_ps(HalvesToFloats(x), HalvesToFloats(y)), half);
+            const __m128 hi = _mm_mul_ps(_mm_add_ps(HalvesToFloats(_mm_srli_si128(x, 8)), HalvesToFloats(_mm_srli_si128(y, 8))), half);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(FloatsToHalves(lo), FloatsToHalves(hi)));
+        }
+        return i;
+    }
+#else
+    // Without SIMD, half-float luma still looks its table up once per row rather than once per pixel.
+    template<>
+    uint32_t LumaRowSimd<Rgba16fPixel>(const uint8_t* in, uint8_t* out, uint32_t width, SimdTier) noexcept
+    {
+        const std::array<uint8_t, 65536>& pqLuma = Detail::PqLumaTable();
+        for (uint32_t x = 0; x < width; x++)
+            out[x] = Rgba16fPixel::Luma(in + size_t(x) * Rgba16fPixel::Bytes, pqLuma);
+        return width;
+    }
+#endif
+
+    // The rounded mean of count rows of bytes, count being 2, 4 or 8.
+    void AverageTaps(const uint8_t* const* taps, uint32_t count, uint8_t* out, uint32_t bytes, SimdTier tier) noexcept
+    {
+        const uint32_t shift = count == 8 ? 3 : count == 4 ? 2 : 1;
+        uint32_t i = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(short(count / 2));
+            const __m128i shiftBy = _mm_cvtsi32_si128(int(shift));
+            for (; i + 16 <= bytes; i += 16)
+            {
+                __m128i lo = round, hi = round;
+                for (uint32_t t = 0; t < count; t++)
+                {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[t] + i));
+                    lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                    hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(_mm_srl_epi16(lo, shiftBy), _mm_srl_epi16(hi, shiftBy)));
+            }
+        }
+#endif
+        for (; i < bytes; i++)
+        {
+            uint32_t sum = count / 2;
+            for (uint32_t t = 0; t < count; t++)
+                sum += taps[t][i];
+            out[i] = static_cast<uint8_t>(sum >> shift);
+        }
+        (void)tier;
+    }
+}
+
+template<typename TPixel>
+void Kernels::ComputeLuma(ConstImageView pixels, ImageView luma, SimdTier tier)
+{
+    for (uint32_t y = 0; y < pixels.height; y++)
+    {
+        const uint8_t* in = pixels.Row(y);
+        uint8_t* out = luma.Row(y);
+        for (uint32_t x = LumaRowSimd<TPixel>(in, out, pixels.width, tier); x < pixels.width; x++)
+            out[x] = TPixel::Luma(in + size_t(x) * TPixel::Bytes);
+    }
+}
+
+uint32_t Kernels::BlockSAD(const uint8_t* a, size_t pitchA, const uint8_t* b, size_t pitchB,
+                           uint32_t width, uint32_t height, SimdTier tier)
+{
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < height; y++, a += pitchA, b += pitchB)
+    {
+        uint32_t x = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+        {
+            __m128i acc = _mm_setzero_si128();
+            for (; x + 16 <= width; x += 16)
+            {
+                acc = _mm_add_epi64(acc, _mm_sad_epu8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x))));
+            }
+            sum += static_cast<uint32_t>(_mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+        }
+#endif
+        for (; x < width; x++)
+            sum += static_cast<uint32_t>(std::abs(int(a[x]) - int(b[x])));
+    }
+    (void)tier;
+    return sum;
+}
+
+void Kernels::EstimateMotion(ConstImageView previousLuma, ConstImageView currentLuma, std::vector<MotionVector>& field,
+                             const CpuInterpolatorSettings& settings, uint32_t firstRow, uint32_t lastRow)
+{
+    const uint32_t blockSize = settings.blockSize;
+    const uint32_t blocksX = BlocksAcross(currentLuma.width, blockSize);
+    const int range = settings.searchRange;
+
+    for (uint32_t by = firstRow; by < lastRow; by++)
+    {
+        for (uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            const Block block = BlockAt(bx, by, blockSize, currentLuma.width, currentLuma.height);
+
+            // Penalise long vectors a little so flat and static areas stay put.
+            const uint32_t lambda = std::max(1u, block.width * block.height / 16);
+            auto cost = [&](int vx, int vy) -> uint32_t {
+                if (!InBounds(block, vx, vy, currentLuma.width, currentLuma.height))
+                    return UINT32_MAX;
+                const uint8_t* a = previousLuma.Row(uint32_t(block.y - vy)) + (block.x - vx);
+                const uint8_t* b = currentLuma.Row(uint32_t(block.y + vy)) + (block.x + vx);
+                return BlockSAD(a, previousLuma.pitch, b, currentLuma.pitch, block.width, block.height, settings.tier)
+                    + lambda * uint32_t(std::abs(vx) + std::abs(vy));
+            };
+
+            MotionVector best{ 0, 0, cost(0, 0) };
+            auto consider = [&](int vx, int vy) {
+                if (std::abs(vx) > range || std::abs(vy) > range)
+                    return;
+                const uint32_t c = cost(vx, vy);
+                if (c < best.cost)
+                    best = { int16_t(vx), int16_t(vy), c };
+            };
+
+            // Seed from the previous field and the block to the left.
+            MotionVector& slot = field[size_t(by) * blocksX + bx];
+            consider(slot.x, slot.y);
+            if (bx > 0)
+                consider(field[size_t(by) * blocksX + bx - 1].x, field[size_t(by) * blocksX + bx - 1].y);
+
+            // Fall back to a coarse grid when the seeds don't explain the block.
+            if (best.cost > 2 * block.width * block.height)
+            {
+                for (int vy = -range; vy <= range; vy += c_CoarseStep)
+                    for (int vx = -range; vx <= range; vx += c_CoarseStep)
+                        consider(vx, vy);
+            }
+
+            // Small diamond refinement around the winner.
+            for (int step = 0; step < c_MaxRefineSteps; step++)
+            {
+                const MotionVector center = best;
+                consider(center.x + 1, center.y);
+                consider(center.x - 1, center.y);
+                consider(center.x, center.y + 1);
+                consider(center.x, center.y - 1);
+                if (best.x == center.x && best.y == center.y)
+                    break;
+            }
+
+            slot = best;
+        }
+    }
+}
+
+template<typename TPixel>
+void Kernels::ComposeMidpoint(ConstImageView previous, ConstImageView current, const std::vector<MotionVector>& field,
+                              const CpuInterpolatorSettings& settings, ImageView output, uint32_t firstRow, uint32_t lastRow)
+{
+    const uint32_t blockSize = settings.blockSize;
+    const uint32_t blocksX = BlocksAcross(output.width, blockSize);
+
+    for (uint32_t by = firstRow; by < lastRow; by++)
+    {
+        for (uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            const Block block = BlockAt(bx, by, blockSize, output.width, output.height);
+            const MotionVector& v = field[size_t(by) * blocksX + bx];
+            const uint32_t bytes = block.width * TPixel::Bytes;
+
+            for (uint32_t row = 0; row < block.height; row++)
+            {
+                const uint8_t* a = previous.Row(uint32_t(block.y + int(row) - v.y)) + size_t(block.x - v.x) * TPixel::Bytes;
+                const uint8_t* b = current.Row(uint32_t(block.y + int(row) + v.y)) + size_t(block.x + v.x) * TPixel::Bytes;
+                uint8_t* out = output.Row(uint32_t(block.y) + row) + size_t(block.x) * TPixel::Bytes;
+
+                for (uint32_t i = AverageRowSimd<TPixel>(a, b, out, bytes, settings.tier); i < bytes; i += TPixel::Bytes)
+                    TPixel::Average(a + i, b + i, out + i);
+            }
+        }
+    }
+}
+
+// Block offsets are multiples of the even block size, so each block's chroma starts on a pair. Chroma
+// moves by v / 2 samples; along an odd axis each frame's sample lies between two neighbours, which are
+// averaged, so a block reads one, two or four pairs from each frame. They lie within the ceiling of
+// |v| / 2 samples, which stays in bounds wherever v does.
+void Kernels::ComposeMidpointNv12(ConstImageView previous, ConstImageView current, const std::vector<MotionVector>& field,
+                                  const CpuInterpolatorSettings& settings, ImageView output, uint32_t firstRow, uint32_t lastRow)
+{
+    const ConstNv12Planes a = SplitNv12(previous);
+    const ConstNv12Planes b = SplitNv12(current);
+    const Nv12Planes out = SplitNv12(output);
+    const uint32_t blockSize = settings.blockSize;
+    const uint32_t blocksX = BlocksAcross(out.luma.width, blockSize);
+
+    for (uint32_t by = firstRow; by < lastRow; by++)
+    {
+        for (uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            const Block block = BlockAt(bx, by, blockSize, out.luma.width, out.luma.height);
+            const MotionVector& v = field[size_t(by) * blocksX + bx];
+            for (uint32_t row = 0; row < block.height; row++)
+            {
+                const uint8_t* taps[2] = { a.luma.Row(uint32_t(block.y + int(row) - v.y)) + (block.x - v.x),
+                                           b.luma.Row(uint32_t(block.y + int(row) + v.y)) + (block.x + v.x) };
+                uint8_t* luma = out.luma.Row(uint32_t(block.y) + row) + block.x;
+                for (uint32_t i = AverageRowSimd<Rgba8Pixel>(taps[0], taps[1], luma, block.width, settings.tier); i < block.width; i++)
+                    luma[i] = static_cast<uint8_t>((taps[0][i] + taps[1][i] + 1) >> 1);
+            }
+
+            // Offsets in half chroma samples: -v for the previous frame and v for the current one. The taps
+            // of the first row step down a row at a time.
+            const uint8_t* taps[8];
+            size_t pitches[8];
+            uint32_t count = 0;
+            auto sample = [&](ConstImageView plane, int hx, int hy) {
+                for (int dy = hy >> 1; dy <= (hy + 1) >> 1; dy++)
+                {
+                    for (int dx = hx >> 1; dx <= (hx + 1) >> 1; dx++)
+                    {
+                        taps[count] = plane.Row(uint32_t(block.y / 2 + dy)) + block.x + 2 * dx;
+                        pitches[count++] = plane.pitch;
+                    }
+                }
+            };
+            sample(a.chroma, -v.x, -v.y);
+            sample(b.chroma, v.x, v.y);
+            for (uint32_t row = 0; row < block.height / 2; row++)
+            {
+                uint8_t* chroma = out.chroma.Row(uint32_t(block.y / 2) + row) + block.x;
+                if (count == 2)
+                {
+                    for (uint32_t i = AverageRowSimd<Rgba8Pixel>(taps[0], taps[1], chroma, block.width, settings.tier); i < block.width; i++)
+                        chroma[i] = static_cast<uint8_t>((taps[0][i] + taps[1][i] + 1) >> 1);
+                }
+                else
+                {
+                    AverageTaps(taps, count, chroma, block.width, settings.tier);
+                }
+                for (uint32_t t = 0; t < count; t++)
+                    taps[t] += pitches[t];
+            }
+        }
+    }
+}
+
+template void Kernels::ComputeLuma<Rgba8Pixel>(ConstImageView, ImageView, SimdTier);
+template void Kernels::ComputeLuma<Rgb10a2Pixel>(ConstImageView, ImageView, SimdTier);
+template void Kernels::ComputeLuma<Rgba16fPixel>(ConstImageView, ImageView, SimdTier);
+template void Kernels::ComposeMidpoint<Rgba8Pixel>(ConstImageView, ConstImageView, const std::vector<MotionVector>&,
+                                                   const CpuInterpolatorSettings&, ImageView, uint32_t, uint32_t);
+template void Kernels::ComposeMidpoint<Rgb10a2Pixel>(ConstImageView, ConstImageView, const std::vector<MotionVector>&,
+                                                     const CpuInterpolatorSettings&, ImageView, uint32_t, uint32_t);
+template void Kernels::ComposeMidpoint<Rgba16fPixel>(ConstImageView, ConstImageView, const std::vector<MotionVector>&,
+                                                     const CpuInterpolatorSettings&, ImageView, uint32_t, uint32_t);
+
+template<typename TWork>
+void CpuFrameInterpolator::ParallelRows(uint32_t rows, const TWork& work)
+{
+    // Single-threaded interpolators never start the shared pool.
+    if (m_settings.threads <= 1)
+    {
+        work(0u, rows);
+        return;
+    }
+    WorkerPool::Shared().ParallelFor(rows, m_settings.threads, work);
+}
+
+// The format is looked at once per frame; everything below runs the loops built for it.
+bool CpuFrameInterpolator::Process(ConstImageView frame, double timestamp, ImageView output, bool* repeated)
+{
+    (void)timestamp;
+    if (m_settings.format == PixelFormat::Nv12)
+        return ProcessNv12(frame, output, repeated);
+    return VisitPixelFormat(m_settings.format, [&](auto pixel) {
+        return ProcessFormat<decltype(pixel)>(frame, output, repeated);
+    });
+}
+
+template<typename TPixel>
+bool CpuFrameInterpolator::ProcessFormat(ConstImageView frame, ImageView output, bool* repeated)
+{
+    const bool resized = frame.width != m_previous.Width() || frame.height != m_previous.Height();
+    if (!m_hasPrevious || resized)
+    {
+        // Nothing to interpolate against yet: repeat the frame, like NvOFFRUC does on its first call.
+        m_previous.Resize(frame.width, frame.height, TPixel::Bytes);
+        m_previousLuma.Resize(frame.width, frame.height, 1);
+        m_currentLuma.Resize(frame.width, frame.height, 1);
+        CopyImage(frame, m_previous.View(), TPixel::Bytes);
+        Kernels::ComputeLuma<TPixel>(frame, m_previousLuma.View(), m_settings.tier);
+        CopyImage(frame, output, TPixel::Bytes);
+        m_field.assign(size_t(BlocksAcross(frame.width, m_settings.blockSize)) * BlocksAcross(frame.height, m_settings.blockSize), MotionVector{});
+        m_hasPrevious = true;
+        if (repeated != nullptr)
+            *repeated = true;
+        return true;
+    }
+
+    Kernels::ComputeLuma<TPixel>(frame, m_currentLuma.View(), m_settings.tier);
+
+    const uint32_t blockRows = BlocksAcross(frame.height, m_settings.blockSize);
+    ParallelRows(blockRows, [&](uint32_t first, uint32_t last) {
+        Kernels::EstimateMotion(m_previousLuma.View(), m_currentLuma.View(), m_field, m_settings, first, last);
+    });
+    ParallelRows(blockRows, [&](uint32_t first, uint32_t last) {
+        Kernels::ComposeMidpoint<TPixel>(m_previous.View(), frame, m_field, m_settings, output, first, last);
+    });
+
+    // This frame becomes the previous one for the next call.
+    CopyImage(frame, m_previous.View(), TPixel::Bytes);
+    std::swap(m_previousLuma, m_currentLuma);
+
+    if (repeated != nullptr)
+        *repeated = false;
+    return true;
+}
+
+// nv12 carries its own luma, so motion is estimated on the frames' luma planes and nothing is derived.
+bool CpuFrameInterpolator::ProcessNv12(ConstImageView frame, ImageView output, bool* repeated)
+{
+    const ConstNv12Planes planes = SplitNv12(frame);
+    const bool resized = frame.width != m_previous.Width() || frame.height != m_previous.Height();
+    if (!m_hasPrevious || resized)
+    {
+        m_previous.Resize(frame.width, frame.height, 1);
+        CopyImage(frame, m_previous.View(), 1);
+        CopyImage(frame, output, 1);
+        m_field.assign(size_t(BlocksAcross(planes.luma.width, m_settings.blockSize)) * BlocksAcross(planes.luma.height, m_settings.blockSize), MotionVector{});
+        m_hasPrevious = true;
+        if (repeated != nullptr)
+            *repeated = true;
+        return true;
+    }
+
+    const ConstImageView previousLuma = SplitNv12(m_previous.View()).luma;
+    const uint32_t blockRows = BlocksAcross(planes.luma.height, m_settings.blockSize);
+    ParallelRows(blockRows, [&](uint32_t first, uint32_t last) {
+        Kernels::EstimateMotion(previousLuma, planes.luma, m_field, m_settings, first, last);
+    });
+    ParallelRows(blockRows, [&](uint32_t first, uint32_t last) {
+        Kernels::ComposeMidpointNv12(m_previous.View(), frame, m_field, m_settings, output, first, last);
+    });
+
+    CopyImage(frame, m_previous.View(), 1);
+    if (repeated != nullptr)
+        *repeated = false;
+    return true;
+}
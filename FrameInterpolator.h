@@ -0,0 +1,100 @@
+//
+// FrameInterpolator.h - The interpolation contract used by InterpolateFrame, plus a CPU backend
+//
+
+#pragma once
+
+#include "Image.h"
+#include "Nv12Convert.h"
+#include "PixelFormat.h"
+#include "Simd.h"
+
+#include <vector>
+
+namespace DX
+{
+    // Mirrors NvOFFRUCProcess: each call takes the newest frame and produces the frame halfway
+    // between it and the previous call's frame. The first call has nothing to blend with and
+    // reports a repeat.
+    class IFrameInterpolator
+    {
+    public:
+        virtual ~IFrameInterpolator() = default;
+        virtual const char* Name() const noexcept = 0;
+        virtual bool Process(ConstImageView frame, double timestamp, ImageView output, bool* repeated) = 0;
+        virtual void Reset() = 0;
+    };
+
+    struct MotionVector
+    {
+        int16_t x = 0;
+        int16_t y = 0;
+        uint32_t cost = 0;
+    };
+
+    struct CpuInterpolatorSettings
+    {
+        uint32_t blockSize = 16;        // Motion field granularity in pixels.
+        int searchRange = 16;           // Maximum half-vector in pixels, so motion up to 2x this is found.
+        uint32_t threads = 1;           // Chunks each pass is split into; they run on WorkerPool::Shared().
+        SimdTier tier = BestSimdTier();
+        PixelFormat format = PixelFormat::Rgba8;    // Of the frames passed to Process.
+    };
+
+    // Per-pixel kernels, exposed for the benchmark suite. Those that touch pixels take the format's
+    // traits from PixelFormat.h and are built for each format.
+    namespace Kernels
+    {
+        // 8-bit luma from pixels of the format: BT.709 weights over rgba8's sRGB codes; see the traits
+        // for the others.
+        template<typename TPixel = Rgba8Pixel>
+        void ComputeLuma(ConstImageView pixels, ImageView luma, SimdTier tier);
+
+        // Sum of absolute differences over a width x height block.
+        uint32_t BlockSAD(const uint8_t* a, size_t pitchA, const uint8_t* b, size_t pitchB,
+                          uint32_t width, uint32_t height, SimdTier tier);
+
+        // Symmetric block matching: for each block, the half-vector v where previous(p - v) best matches current(p + v).
+        // Rows in [firstRow, lastRow) are estimated; temporal seeds come from field's existing contents.
+        void EstimateMotion(ConstImageView previousLuma, ConstImageView currentLuma, std::vector<MotionVector>& field,
+                            const CpuInterpolatorSettings& settings, uint32_t firstRow, uint32_t lastRow);
+
+        // Average previous(p - v) and current(p + v) per block into output rows [firstRow, lastRow) of blocks.
+        template<typename TPixel = Rgba8Pixel>
+        void ComposeMidpoint(ConstImageView previous, ConstImageView current, const std::vector<MotionVector>& field,
+                             const CpuInterpolatorSettings& settings, ImageView output, uint32_t firstRow, uint32_t lastRow);
+
+        // ComposeMidpoint for nv12 frames: luma as above, chroma moved by half of each vector.
+        void ComposeMidpointNv12(ConstImageView previous, ConstImageView current, const std::vector<MotionVector>& field,
+                                 const CpuInterpolatorSettings& settings, ImageView output, uint32_t firstRow, uint32_t lastRow);
+    }
+
+    // Block-matching motion-compensated interpolation on the CPU.
+    class CpuFrameInterpolator final : public IFrameInterpolator
+    {
+    public:
+        explicit CpuFrameInterpolator(const CpuInterpolatorSettings& settings = {}) : m_settings(settings) {}
+
+        const char* Name() const noexcept override { return "cpu"; }
+        bool Process(ConstImageView frame, double timestamp, ImageView output, bool* repeated) override;
+        void Reset() override { m_hasPrevious = false; m_field.clear(); }
+
+        const CpuInterpolatorSettings& Settings() const noexcept { return m_settings; }
+        const std::vector<MotionVector>& Field() const noexcept { return m_field; }
+
+    private:
+        template<typename TWork>
+        void ParallelRows(uint32_t rows, const TWork& work);
+
+        template<typename TPixel>
+        bool ProcessFormat(ConstImageView frame, ImageView output, bool* repeated);
+        bool ProcessNv12(ConstImageView frame, ImageView output, bool* repeated);
+
+        CpuInterpolatorSettings     m_settings;
+        Image                       m_previous;
+        Image                       m_previousLuma;
+        Image                       m_currentLuma;
+        std::vector<MotionVector>   m_field;
+        bool                        m_hasPrevious = false;
+    };
+}
@@ -0,0 +1,247 @@
+//
+// FrameRecorder.cpp - Streams RGBA frames to Y4M or raw files from a writer thread
+//
+
+#include "FrameRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Sector and page sizes both divide this, so block writes never straddle a page.
+    constexpr size_t c_BlockAlignment = 4096;
+
+    constexpr char c_Y4MFrameHeader[] = "FRAME\n";
+    constexpr size_t c_Y4MFrameHeaderSize = sizeof(c_Y4MFrameHeader) - 1;
+
+    class FileRecordSink final : public RecordSink
+    {
+    public:
+        FileRecordSink(const std::string& path, size_t blockSize) :
+            m_blockSize((std::max<size_t>(blockSize, c_BlockAlignment) + c_BlockAlignment - 1) & ~(c_BlockAlignment - 1)),
+            m_block(static_cast<uint8_t*>(::operator new(m_blockSize, std::align_val_t(c_BlockAlignment))))
+        {
+#ifdef _WIN32
+            fopen_s(&m_file, path.c_str(), "wb");
+#else
+            m_file = fopen(path.c_str(), "wb");
+#endif
+            if (m_file == nullptr)
+                throw std::runtime_error("Cannot open " + path);
+
+            // Blocks are already large; a second copy through stdio would only cost bandwidth.
+            setvbuf(m_file, nullptr, _IONBF, 0);
+        }
+
+        ~FileRecordSink() override { Close(); }
+
+        bool Write(const uint8_t* data, size_t bytes) override
+        {
+            while (bytes > 0)
+            {
+                const size_t copied = std::min(bytes, m_blockSize - m_used);
+                std::memcpy(m_block.get() + m_used, data, copied);
+                m_used += copied;
+                data += copied;
+                bytes -= copied;
+                if (m_used == m_blockSize && !WriteBlock())
+                    return false;
+            }
+            return true;
+        }
+
+        bool Close() override
+        {
+            if (m_file == nullptr)
+                return true;
+            const bool written = m_used == 0 || WriteBlock();
+            const bool closed = fclose(m_file) == 0;
+            m_file = nullptr;
+            return written && closed;
+        }
+
+    private:
+        bool WriteBlock()
+        {
+            const bool written = m_file != nullptr && fwrite(m_block.get(), 1, m_used, m_file) == m_used;
+            m_used = 0;
+            return written;
+        }
+
+        struct AlignedDelete
+        {
+            void operator()(uint8_t* p) const noexcept { ::operator delete(p, std::align_val_t(c_BlockAlignment)); }
+        };
+
+        size_t                                  m_blockSize;
+        std::unique_ptr<uint8_t, AlignedDelete> m_block;
+        size_t                                  m_used = 0;
+        FILE*                                   m_file = nullptr;
+    };
+
+    bool WritePlane(RecordSink& sink, const Image& plane)
+    {
+        const size_t rowBytes = size_t(plane.Width()) * plane.BytesPerPixel();
+        for (uint32_t y = 0; y < plane.Height(); y++)
+        {
+            if (!sink.Write(plane.View().Row(y), rowBytes))
+                return false;
+        }
+        return true;
+    }
+}
+
+std::unique_ptr<RecordSink> DX::CreateFileRecordSink(const std::string& path, size_t blockSize)
+{
+    return std::make_unique<FileRecordSink>(path, blockSize);
+}
+
+bool MemoryRecordSink::Write(const uint8_t* data, size_t bytes)
+{
+    m_bytes += bytes;
+    while (bytes > 0 && !m_buffer.empty())
+    {
+        const size_t copied = std::min(bytes, m_buffer.size() - m_offset);
+        std::memcpy(m_buffer.data() + m_offset, data, copied);
+        m_offset = (m_offset + copied) % m_buffer.size();
+        data += copied;
+        bytes -= copied;
+    }
+    return true;
+}
+
+FrameRecorder::FrameRecorder(std::unique_ptr<RecordSink> sink, FrameFileFormat fileFormat, const FrameFormat& format, size_t queueDepth) :
+    m_sink(std::move(sink)),
+    m_fileFormat(fileFormat),
+    m_format(format),
+    m_buffers(std::max<size_t>(queueDepth, 1))
+{
+    if (m_format.width == 0 || m_format.height == 0)
+        throw std::invalid_argument("Recording needs a frame size");
+
+    for (size_t i = 0; i < m_buffers.size(); i++)
+    {
+        m_buffers[i].Resize(m_format.width, m_format.height, 4);
+        m_free.push_back(i);
+    }
+
+    // The header goes out before any frame so a recording that is cut short is still playable.
+    if (m_fileFormat == FrameFileFormat::Y4M)
+    {
+        const std::string header = Y4MStreamHeader(m_format);
+        m_stats.failed = !m_sink->Write(reinterpret_cast<const uint8_t*>(header.data()), header.size());
+        m_stats.bytesWritten = header.size();
+    }
+
+    m_writer = std::thread([this] { WriterLoop(); });
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    Stop();
+}
+
+bool FrameRecorder::Submit(ConstImageView rgba)
+{
+    size_t buffer = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.submittedFrames++;
+        if (m_free.empty() || m_stopping || m_stats.failed)
+        {
+            m_stats.droppedFrames++;
+            return false;
+        }
+        buffer = m_free.back();
+        m_free.pop_back();
+    }
+
+    // The copy is the only per-frame cost on the caller's thread.
+    CopyImage(rgba, m_buffers[buffer].View(), 4);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued.push_back(buffer);
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+bool FrameRecorder::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    if (m_writer.joinable())
+        m_writer.join();
+
+    if (m_sink)
+    {
+        const bool closed = m_sink->Close();
+        m_sink.reset();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.failed = m_stats.failed || !closed;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_stats.failed;
+}
+
+FrameRecorderStats FrameRecorder::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void FrameRecorder::WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_stopping || !m_queued.empty(); });
+        if (m_queued.empty())
+            return;
+
+        const size_t buffer = m_queued.front();
+        m_queued.pop_front();
+        const bool skip = m_stats.failed;
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        const bool written = skip || WriteFrame(m_buffers[buffer]);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        lock.lock();
+        m_free.push_back(buffer);
+        m_stats.writerBusySeconds += seconds;
+        if (skip || !written)
+        {
+            m_stats.failed = true;
+            m_stats.droppedFrames++;
+            continue;
+        }
+        m_stats.writtenFrames++;
+        m_stats.bytesWritten += m_fileFormat == FrameFileFormat::Y4M
+            ? c_Y4MFrameHeaderSize + size_t(m_yuv.y.Width()) * m_yuv.y.Height() + 2 * size_t(m_yuv.u.Width()) * m_yuv.u.Height()
+            : size_t(m_format.width) * 4 * m_format.height;
+    }
+}
+
+bool FrameRecorder::WriteFrame(const Image& rgba)
+{
+    if (m_fileFormat == FrameFileFormat::RawRGBA)
+        return WritePlane(*m_sink, rgba);
+
+    ConvertRGBAToI420(rgba.View(), m_yuv);
+    return m_sink->Write(reinterpret_cast<const uint8_t*>(c_Y4MFrameHeader), c_Y4MFrameHeaderSize)
+        && WritePlane(*m_sink, m_yuv.y) && WritePlane(*m_sink, m_yuv.u) && WritePlane(*m_sink, m_yuv.v);
+}
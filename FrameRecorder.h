@@ -0,0 +1,103 @@
+//
+// FrameRecorder.h - Streams RGBA frames to Y4M or raw files from a writer thread
+//
+// The render thread hands each frame to Submit, which copies it into one of a fixed set of buffers
+// and returns; conversion and I/O happen on the writer thread. When every buffer is still queued
+// the frame is dropped and counted instead of blocking the caller.
+//
+
+#pragma once
+
+#include "FrameIO.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    // Byte destination for a recording. Only the writer thread calls it.
+    class RecordSink
+    {
+    public:
+        virtual ~RecordSink() = default;
+        virtual bool Write(const uint8_t* data, size_t bytes) = 0;
+
+        // Write anything still buffered and release the destination.
+        virtual bool Close() { return true; }
+    };
+
+    // Gathers the stream into a page-aligned block and writes it to the file a whole block at a time,
+    // bypassing stdio's buffer; only the final write is short. Throws std::runtime_error if path can't be created.
+    std::unique_ptr<RecordSink> CreateFileRecordSink(const std::string& path, size_t blockSize = 4 << 20);
+
+    // Copies the stream into a fixed amount of RAM, wrapping around. Costs everything a file does except the disk.
+    class MemoryRecordSink final : public RecordSink
+    {
+    public:
+        explicit MemoryRecordSink(size_t capacity = 64 << 20) : m_buffer(capacity) {}
+
+        bool Write(const uint8_t* data, size_t bytes) override;
+
+        uint64_t BytesWritten() const noexcept { return m_bytes; }
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        size_t m_offset = 0;
+        uint64_t m_bytes = 0;
+    };
+
+    struct FrameRecorderStats
+    {
+        uint64_t submittedFrames = 0;
+        uint64_t droppedFrames = 0;     // Submitted while every buffer was queued.
+        uint64_t writtenFrames = 0;
+        uint64_t bytesWritten = 0;
+        double writerBusySeconds = 0;   // Converting and writing, excluding waits for work.
+        bool failed = false;            // A write failed; later frames are dropped.
+    };
+
+    class FrameRecorder
+    {
+    public:
+        // queueDepth frames can wait for the writer before Submit starts dropping.
+        FrameRecorder(std::unique_ptr<RecordSink> sink, FrameFileFormat fileFormat, const FrameFormat& format, size_t queueDepth = 8);
+        ~FrameRecorder();
+
+        FrameRecorder(FrameRecorder const&) = delete;
+        FrameRecorder& operator= (FrameRecorder const&) = delete;
+
+        // Copy a frame of Format()'s size for the writer. Returns false if it was dropped.
+        bool Submit(ConstImageView rgba);
+
+        // Write every queued frame, close the sink and join the writer. Returns false if anything failed.
+        bool Stop();
+
+        const FrameFormat& Format() const noexcept { return m_format; }
+        FrameRecorderStats Stats() const;
+
+    private:
+        void WriterLoop();
+        bool WriteFrame(const Image& rgba);
+
+        std::unique_ptr<RecordSink>     m_sink;
+        FrameFileFormat                 m_fileFormat;
+        FrameFormat                     m_format;
+        I420Image                       m_yuv;              // Writer thread only.
+
+        std::vector<Image>              m_buffers;
+        std::vector<size_t>             m_free;
+        std::deque<size_t>              m_queued;
+        mutable std::mutex              m_mutex;
+        std::condition_variable         m_wake;
+        bool                            m_stopping = false;
+        FrameRecorderStats              m_stats;
+        std::thread                     m_writer;
+    };
+}
@@ -0,0 +1,149 @@
+//
+// FrameShare.cpp - A ring of output frames in shared memory, with a publisher and a lock-free consumer
+//
+
+#include "FrameShare.h"
+
+#include <new>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr size_t c_PageSize = 4096;
+
+    size_t RoundToPage(size_t bytes) { return (bytes + c_PageSize - 1) & ~(c_PageSize - 1); }
+
+    static_assert(sizeof(SharedFrameHeader) <= c_PageSize, "SharedFrameHeader must fit its page");
+
+    size_t SlotTableOffset() { return c_PageSize; }
+}
+
+FramePublisher::FramePublisher(const std::string& name, const SharedFrameFormat& format)
+{
+    if (format.width == 0 || format.height == 0 || format.slotCount < 2)
+        throw std::invalid_argument("Shared frame ring needs a frame size and at least two slots");
+
+    const size_t pitch = size_t(format.width) * 4;
+    const size_t slotStride = RoundToPage(pitch * format.height);
+    const size_t pixelOffset = SlotTableOffset() + RoundToPage(sizeof(SharedFrameSlot) * format.slotCount);
+    if (!m_memory.Create(name, pixelOffset + slotStride * format.slotCount))
+        throw std::runtime_error("Cannot create shared memory " + name);
+
+    // The mapping starts zeroed, so every sequence is already even and no frame is published.
+    m_header = new (m_memory.Data()) SharedFrameHeader{};
+    m_header->version = c_SharedFrameVersion;
+    m_header->width = format.width;
+    m_header->height = format.height;
+    m_header->pitch = static_cast<uint32_t>(pitch);
+    m_header->slotCount = format.slotCount;
+    m_header->slotStride = slotStride;
+    m_header->pixelOffset = pixelOffset;
+    m_header->tickFrequency = format.tickFrequency;
+    m_header->rateNumerator = format.rateNumerator;
+    m_header->rateDenominator = format.rateDenominator;
+    m_slots = new (m_memory.Data() + SlotTableOffset()) SharedFrameSlot[format.slotCount]{};
+
+    // Consumers check the magic first, so they never see a half-written header.
+    m_header->magic.store(c_SharedFrameMagic, std::memory_order_release);
+}
+
+FramePublisher::~FramePublisher()
+{
+    if (m_header != nullptr)
+        m_header->closed.store(1, std::memory_order_release);
+}
+
+uint64_t FramePublisher::Publish(ConstImageView rgba, bool interpolated, uint64_t sourceTicks)
+{
+    const uint64_t frame = ++m_frame;
+    const uint32_t index = static_cast<uint32_t>(frame % m_header->slotCount);
+    SharedFrameSlot& slot = m_slots[index];
+
+    // Seqlock write: odd, pixels and metadata, then even again.
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const ImageView pixels = { m_memory.Data() + m_header->pixelOffset + index * m_header->slotStride, m_header->width, m_header->height, m_header->pitch };
+    CopyImage(rgba, pixels, 4);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.sourceTicks.store(sourceTicks, std::memory_order_relaxed);
+    slot.interpolated.store(interpolated ? 1 : 0, std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    m_header->latestFrame.store(frame, std::memory_order_release);
+    return frame;
+}
+
+bool FrameConsumer::Open(const std::string& name)
+{
+    Close();
+    m_lastFrame = 0;
+    m_skipped = 0;
+    m_torn = 0;
+    if (!m_memory.Open(name) || m_memory.Size() < c_PageSize)
+        return false;
+
+    auto* header = reinterpret_cast<SharedFrameHeader*>(m_memory.Data());
+    const bool compatible = header->magic.load(std::memory_order_acquire) == c_SharedFrameMagic && header->version == c_SharedFrameVersion
+        && header->slotCount >= 2 && header->pitch >= header->width * 4
+        && header->slotStride >= size_t(header->pitch) * header->height
+        && header->pixelOffset >= SlotTableOffset() + sizeof(SharedFrameSlot) * header->slotCount
+        && header->pixelOffset + header->slotStride * header->slotCount <= m_memory.Size();
+    if (!compatible)
+    {
+        m_memory.Close();
+        return false;
+    }
+
+    m_header = header;
+    m_slots = reinterpret_cast<SharedFrameSlot*>(m_memory.Data() + SlotTableOffset());
+    return true;
+}
+
+bool FrameConsumer::AcquireLatest(SharedFrame& frame)
+{
+    const uint64_t latest = m_header->latestFrame.load(std::memory_order_acquire);
+    if (latest == 0 || latest <= m_lastFrame)
+        return false;
+
+    const uint32_t index = static_cast<uint32_t>(latest % m_header->slotCount);
+    const SharedFrameSlot& slot = m_slots[index];
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence & 1)
+        return false;
+
+    // The slot may already hold a newer frame than latest said; that is fine as long as it is stable.
+    frame.frame = slot.frame.load(std::memory_order_relaxed);
+    frame.sourceTicks = slot.sourceTicks.load(std::memory_order_relaxed);
+    frame.interpolated = slot.interpolated.load(std::memory_order_relaxed) != 0;
+    frame.slot = index;
+    frame.sequence = sequence;
+    frame.view = { m_memory.Data() + m_header->pixelOffset + index * m_header->slotStride, m_header->width, m_header->height, m_header->pitch };
+    if (frame.frame <= m_lastFrame || !IsValid(frame))
+        return false;
+
+    if (m_lastFrame != 0)
+        m_skipped += frame.frame - m_lastFrame - 1;
+    m_lastFrame = frame.frame;
+    return true;
+}
+
+bool FrameConsumer::IsValid(const SharedFrame& frame) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_slots[frame.slot].sequence.load(std::memory_order_relaxed) == frame.sequence)
+        return true;
+    m_torn++;
+    return false;
+}
+
+bool FrameConsumer::CopyLatest(ImageView dst, SharedFrame& frame)
+{
+    if (!AcquireLatest(frame))
+        return false;
+    CopyImage(frame.view, dst, 4);
+    return IsValid(frame);
+}
@@ -0,0 +1,137 @@
+//
+// FrameShare.h - A ring of output frames in shared memory, with a publisher and a lock-free consumer
+//
+// Layout of the mapping:
+//     SharedFrameHeader                         one page
+//     SharedFrameSlot[slotCount]                64 bytes each, padded to a page
+//     pixels[slotCount]                         slotStride bytes each, page aligned
+//
+// Frame n goes to slot n % slotCount. Each slot carries a sequence number that is odd while the
+// publisher writes it, so a consumer reads pixels in place and then checks the sequence is
+// unchanged; if it changed, the frame was overwritten under it and whatever was read is discarded.
+// Neither side ever waits for the other.
+//
+
+#pragma once
+
+#include "Image.h"
+#include "SharedMemory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DX
+{
+    constexpr uint32_t c_SharedFrameMagic = 0x52564648;     // "HFVR"
+    constexpr uint32_t c_SharedFrameVersion = 1;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared frame sequences need address-free atomics");
+
+    struct SharedFrameHeader
+    {
+        std::atomic<uint32_t>   magic;              // Written last, once the rest of the header is valid.
+        uint32_t                version;
+        uint32_t                width;
+        uint32_t                height;
+        uint32_t                pitch;              // Bytes per RGBA row.
+        uint32_t                slotCount;
+        uint64_t                slotStride;         // Bytes between slots' pixels.
+        uint64_t                pixelOffset;        // Offset of slot 0's pixels.
+        uint64_t                tickFrequency;      // Units of SharedFrameSlot::sourceTicks per second.
+        uint32_t                rateNumerator;
+        uint32_t                rateDenominator;
+        std::atomic<uint64_t>   latestFrame;        // Newest published frame, 0 before the first.
+        std::atomic<uint32_t>   closed;             // Set when the publisher goes away.
+    };
+
+    struct alignas(64) SharedFrameSlot
+    {
+        std::atomic<uint64_t>   sequence;           // Odd while the slot is being written.
+        std::atomic<uint64_t>   frame;
+        std::atomic<uint64_t>   sourceTicks;        // Capture time of the desktop frame this was built from.
+        std::atomic<uint32_t>   interpolated;       // 1 for interpolated frames, 0 for real ones.
+    };
+    static_assert(sizeof(SharedFrameSlot) == 64, "SharedFrameSlot should stay one cache line");
+
+    struct SharedFrameFormat
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t slotCount = 4;
+        uint32_t rateNumerator = 60;
+        uint32_t rateDenominator = 1;
+        uint64_t tickFrequency = 1000000000;
+    };
+
+    // Single writer of a named ring. The mapping is removed when the publisher is destroyed.
+    class FramePublisher
+    {
+    public:
+        // Throws std::runtime_error if the mapping can't be created.
+        FramePublisher(const std::string& name, const SharedFrameFormat& format);
+        ~FramePublisher();
+
+        FramePublisher(FramePublisher const&) = delete;
+        FramePublisher& operator= (FramePublisher const&) = delete;
+
+        // Copy an RGBA frame of the ring's size into the next slot. Returns its frame number.
+        uint64_t Publish(ConstImageView rgba, bool interpolated, uint64_t sourceTicks);
+
+        const std::string& Name() const noexcept { return m_memory.Name(); }
+        uint64_t PublishedFrames() const noexcept { return m_frame; }
+
+    private:
+        SharedMemory        m_memory;
+        SharedFrameHeader*  m_header = nullptr;
+        SharedFrameSlot*    m_slots = nullptr;
+        uint64_t            m_frame = 0;
+    };
+
+    // One frame as seen by a consumer. view points into the shared mapping, not a copy.
+    struct SharedFrame
+    {
+        ConstImageView  view;
+        uint64_t        frame = 0;
+        uint64_t        sourceTicks = 0;
+        bool            interpolated = false;
+        uint32_t        slot = 0;
+        uint64_t        sequence = 0;
+    };
+
+    class FrameConsumer
+    {
+    public:
+        // Map a ring published under name. Returns false if it doesn't exist or isn't a compatible ring.
+        bool Open(const std::string& name);
+        void Close() noexcept { m_memory.Close(); m_header = nullptr; m_slots = nullptr; }
+
+        bool IsOpen() const noexcept { return m_header != nullptr; }
+        const SharedFrameHeader& Header() const noexcept { return *m_header; }
+        bool IsPublisherClosed() const noexcept { return m_header->closed.load(std::memory_order_acquire) != 0; }
+
+        // Newest frame after the last one acquired, read in place. Returns false if there is none yet,
+        // or if its slot is being written right now.
+        bool AcquireLatest(SharedFrame& frame);
+
+        // True if the frame's pixels were not overwritten since AcquireLatest. Call once, after reading them.
+        bool IsValid(const SharedFrame& frame) noexcept;
+
+        // AcquireLatest, copied into dst (of the ring's size) and validated. Returns false if nothing new
+        // arrived or the copy was torn.
+        bool CopyLatest(ImageView dst, SharedFrame& frame);
+
+        // Frames published between two acquired ones that this consumer never saw.
+        uint64_t SkippedFrames() const noexcept { return m_skipped; }
+        uint64_t TornFrames() const noexcept { return m_torn; }
+
+    private:
+        SharedMemory        m_memory;
+        SharedFrameHeader*  m_header = nullptr;
+        SharedFrameSlot*    m_slots = nullptr;
+        uint64_t            m_lastFrame = 0;
+        uint64_t            m_skipped = 0;
+        uint64_t            m_torn = 0;
+    };
+}
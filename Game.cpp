@@ -5,25 +5,118 @@
 #include "pch.h"
 #include "Game.h"
 
+#include <psapi.h>
+
+// Compiled by FXC into the intermediate directory.
+#include "PresentConvert_PS.inc"
+#include "PresentNv12_PS.inc"
+
 extern void ExitGame() noexcept;
 
 using namespace DirectX;
 
 using Microsoft::WRL::ComPtr;
 
-//Function to output float to Debug Console
-void fts(float f) {
-    std::stringstream ss;
-    ss << f;
-    std::string str = ss.str();
-    OutputDebugStringA(str.c_str());
-    OutputDebugStringA(" ms\n");
+// Pointer samples kept per latency recording; about 18 minutes at 240 Hz.
+constexpr size_t c_MaxPointerTraceSamples = size_t(1) << 18;
+
+// Build "<prefix>-YYYYMMDD-HHMMSS.<extension>" from the local time.
+std::string TimestampedFileName(const char* prefix, const char* extension) {
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+    char name[96] = {};
+    sprintf_s(name, "%s-%04u%02u%02u-%02u%02u%02u.%s", prefix, time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, extension);
+    return name;
+}
+
+// Upload an RGBA image as an immutable texture and return a view of it.
+ComPtr<ID3D11ShaderResourceView> CreateImmutableTexture(ID3D11Device* device, DX::ConstImageView image) {
+    CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, image.width, image.height, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+    D3D11_SUBRESOURCE_DATA data = { image.data, static_cast<UINT>(image.pitch), 0 };
+    ComPtr<ID3D11Texture2D> texture;
+    ComPtr<ID3D11ShaderResourceView> view;
+    if (SUCCEEDED(device->CreateTexture2D(&desc, &data, texture.GetAddressOf())))
+        device->CreateShaderResourceView(texture.Get(), nullptr, view.GetAddressOf());
+    return view;
+}
+
+// The SDR white level Windows shows SDR content at on the output with this GDI name, in nits.
+float QuerySdrWhiteNits(const WCHAR* gdiDeviceName) {
+    UINT32 pathCount = 0, modeCount = 0;
+    if (GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount) != ERROR_SUCCESS) return DX::Transfer::ScRgbWhiteNits;
+    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
+    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
+    if (QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(), nullptr) != ERROR_SUCCESS) return DX::Transfer::ScRgbWhiteNits;
+
+    for (UINT32 i = 0; i < pathCount; i++) {
+        DISPLAYCONFIG_SOURCE_DEVICE_NAME source = {};
+        source.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SOURCE_NAME;
+        source.header.size = sizeof(source);
+        source.header.adapterId = paths[i].sourceInfo.adapterId;
+        source.header.id = paths[i].sourceInfo.id;
+        if (DisplayConfigGetDeviceInfo(&source.header) != ERROR_SUCCESS || wcscmp(source.viewGdiDeviceName, gdiDeviceName) != 0) continue;
+
+        // Reported in thousandths of scRGB white.
+        DISPLAYCONFIG_SDR_WHITE_LEVEL white = {};
+        white.header.type = DISPLAYCONFIG_DEVICE_INFO_GET_SDR_WHITE_LEVEL;
+        white.header.size = sizeof(white);
+        white.header.adapterId = paths[i].targetInfo.adapterId;
+        white.header.id = paths[i].targetInfo.id;
+        if (DisplayConfigGetDeviceInfo(&white.header) == ERROR_SUCCESS && white.SDRWhiteLevel != 0)
+            return float(white.SDRWhiteLevel) * DX::Transfer::ScRgbWhiteNits / 1000.f;
+    }
+    return DX::Transfer::ScRgbWhiteNits;
+}
+
+// The transfer function frames have to be in for the swap chain's color space.
+DX::TransferFunction SwapChainTransfer(DXGI_COLOR_SPACE_TYPE colorSpace) {
+    if (colorSpace == DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020) return DX::TransferFunction::Pq;
+    if (colorSpace == DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709) return DX::TransferFunction::Linear;
+    return DX::TransferFunction::Srgb;
+}
+
+// The ring's size along one axis of a crop downscaled by resFactor; nv12 rings need even sizes.
+int RingSize(int cropSize, double factor, DX::PixelFormat format) {
+    const int step = int(DX::PixelFormatSizeStep(format));
+    return std::max(step, int(cropSize / factor) / step * step);
+}
+
+// NvOFFRUC takes ARGB and NV12 surfaces; rings in other formats are interpolated on the CPU.
+bool FrucTakes(DX::PixelFormat format) {
+    return format == DX::PixelFormat::Rgba8 || format == DX::PixelFormat::Nv12;
 }
 
+// nv12 frames are drawn and captured through views of their planes. The chroma view is attached to the
+// luma one, which is the frame's SRV, so whatever holds the frame can present it.
+// {6B0D2E4C-93A1-4F5B-8C27-1E4D9A7F3B60}
+const GUID ChromaViewGuid = { 0x6b0d2e4c, 0x93a1, 0x4f5b, { 0x8c, 0x27, 0x1e, 0x4d, 0x9a, 0x7f, 0x3b, 0x60 } };
+
+// The chroma view attached to an nv12 frame's luma view, kept alive by it.
+ID3D11ShaderResourceView* ChromaView(ID3D11ShaderResourceView* luma) {
+    ID3D11ShaderResourceView* chroma = nullptr;
+    UINT size = sizeof(chroma);
+    if (FAILED(luma->GetPrivateData(ChromaViewGuid, &size, &chroma))) return nullptr;
+    chroma->Release();
+    return chroma;
+}
+
+// Constants of PresentConvert_PS and PresentNv12_PS.
+struct PresentConvertConstants {
+    uint32_t sourceTransfer;
+    uint32_t destinationTransfer;
+    float sdrWhiteNits;
+    uint32_t padding;
+};
+
 Game::Game() noexcept(false)
 {
-    m_deviceResources = std::make_unique<DX::DeviceResources>();
+    // Tearing is allowed so vsync can be switched off while running. The 10-bit back buffer holds sRGB on SDR
+    // displays and HDR10 on HDR ones, as UpdateColorSpace picks, and DrawFromSRV converts to whichever it is.
+    m_deviceResources = std::make_unique<DX::DeviceResources>(DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_D32_FLOAT, 2, D3D_FEATURE_LEVEL_10_0,
+        DX::DeviceResources::c_FlipPresent | DX::DeviceResources::c_AllowTearing | DX::DeviceResources::c_EnableHDR);
     m_deviceResources->RegisterDeviceNotify(this);
+    m_metrics.Register(DX::MetricsRegistry::Default());
+    m_startSeconds = DX::HudSeconds();
 }
 
 // Initialize the Direct3D resources required to run.
@@ -41,7 +134,196 @@ void Game::Initialize(HWND window, int width, int height)
     
     // Set timer equal to framerate.
     m_timer.SetFixedTimeStep(true);
+
+    // Latency timestamps are QPC ticks.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_latency = DX::LatencyTracker(static_cast<uint64_t>(frequency.QuadPart));
+
+    // So are pointer samples.
+    m_cursorPredictor = DX::CursorPredictor(static_cast<uint64_t>(frequency.QuadPart), cursorPrediction);
+}
+
+// Pace to frameRate, or to twice the first output's refresh rate. The vblank clock starts from the
+// pacing interval until the display reports in.
+void Game::SetFrameRate()
+{
+    fps = frameRate > 0 ? frameRate : m_captures[0]->refreshRate * 2.f;
+    frametime = 1.0 / fps;
     m_timer.SetTargetElapsedSeconds(frametime);
+    m_hud.SetTargetFrameTime(1000.0 * frametime);
+    m_metrics.targetFps->Set(fps);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_vblankClock = DX::VblankClock(static_cast<uint64_t>(frametime * double(frequency.QuadPart)));
+}
+
+// Read the settings file (--config, or hfv.ini in the working directory) and the command line, which
+// wins. Called before Initialize; settings that don't parse are logged and keep their defaults.
+void Game::LoadSettings(const std::vector<std::string>& arguments)
+{
+    m_arguments = arguments;
+    std::string path = "hfv.ini";
+    for (size_t i = 1; i < arguments.size(); i++) {
+        if (arguments[i] == "--config" && i + 1 < arguments.size()) path = arguments[i + 1];
+        else if (arguments[i].rfind("--config=", 0) == 0) path = arguments[i].substr(9);
+    }
+    m_settingsFile = DX::SettingsFile(path);
+
+    std::vector<std::string> errors;
+    m_settings = ReadSettings(errors);
+    for (const std::string& error : errors) DX_LOG_WARNING("Settings: %s", error);
+    UseSettings(m_settings, nullptr);
+    DX_LOG_INFO("Settings: %s%s", path, m_settingsFile.Exists() ? "" : " not found; using defaults and the command line");
+}
+
+// Defaults, then the settings file if there is one, then the command line.
+DX::ViewerSettings Game::ReadSettings(std::vector<std::string>& errors) const
+{
+    DX::ViewerSettings settings;
+    std::string text;
+    if (m_settingsFile.Exists()) {
+        if (m_settingsFile.Read(text)) DX::ParseSettingsIni(text, m_settingsFile.Path(), settings, errors);
+        else errors.push_back("could not read " + m_settingsFile.Path());
+    }
+    DX::ParseSettingsArguments(m_arguments, { "config" }, settings, errors);
+    return settings;
+}
+
+// Copy settings into the members that use them: every one, or only those the plan lists as changed.
+void Game::UseSettings(const DX::ViewerSettings& settings, const DX::SettingsPlan* plan)
+{
+    auto changed = [plan](const char* key) {
+        return plan == nullptr || std::find(plan->keys.begin(), plan->keys.end(), key) != plan->keys.end();
+    };
+    if (changed("monitorIndices")) monitorIndices.assign(settings.monitorIndices.begin(), settings.monitorIndices.end());
+    if (changed("tileOutputs")) tileOutputs = settings.tileOutputs;
+    if (changed("useRegion")) useRegion = settings.useRegion;
+    if (changed("roiRect")) roiRect = settings.roiRect;
+    if (changed("roiWindowTitle")) roiWindowTitle = settings.roiWindowTitle;
+    if (changed("resFactor")) resFactor = settings.resFactor;
+    if (changed("captureRingDepth")) captureRingDepth = static_cast<int>(settings.captureRingDepth);
+    if (changed("scaleFilter")) scaleFilter = settings.scaleFilter;
+    if (changed("internalFormat")) internalFormat = settings.internalFormat;
+    if (changed("sdrWhiteNits")) sdrWhiteNits = settings.sdrWhiteNits;
+    if (changed("interpolationBudget")) interpolationBudget = settings.interpolationBudget;
+    if (changed("frameRate")) frameRate = settings.frameRate;
+    if (changed("vsync")) m_deviceResources->SetVsync(settings.vsync);
+    if (changed("showCursor")) showCursor = settings.showCursor;
+    if (changed("cursorPrediction")) cursorPrediction = settings.cursorPrediction;
+    if (changed("cursorVblanks")) cursorVblanks = static_cast<int>(settings.cursorVblanks);
+    if (changed("showHud")) showHud = settings.showHud;
+    if (changed("metricsPort")) metricsPort = static_cast<uint16_t>(settings.metricsPort);
+    if (changed("sharedOutputName")) sharedOutputName = settings.sharedOutputName;
+    if (changed("readbackRingDepth")) readbackRingDepth = static_cast<int>(settings.readbackRingDepth);
+    if (changed("readbackLatency")) readbackLatency = static_cast<int>(settings.readbackLatency);
+    if (changed("logLevel")) DX::SetLogMinLevel(settings.logLevel);
+}
+
+// Apply the settings file once it has stopped changing for half a second, so an editor's save isn't
+// read halfway. A file with errors changes nothing until it is fixed.
+void Game::CheckSettingsFile()
+{
+    const double now = DX::HudSeconds();
+    if (now - m_settingsPollSeconds < 0.25) return;
+    m_settingsPollSeconds = now;
+    if (m_settingsFile.Changed()) m_settingsChangedSeconds = now;
+    if (m_settingsChangedSeconds < 0 || now - m_settingsChangedSeconds < 0.5) return;
+    m_settingsChangedSeconds = -1.0;
+
+    std::vector<std::string> errors;
+    const DX::ViewerSettings settings = ReadSettings(errors);
+    if (!errors.empty()) {
+        for (const std::string& error : errors) DX_LOG_ERROR("Settings: %s", error);
+        DX_LOG_WARNING("Settings: keeping the current settings until %s is fixed", m_settingsFile.Path());
+        return;
+    }
+    const DX::SettingsPlan plan = DX::PlanSettingsChange(m_settings, settings);
+    if (!plan.Empty()) ApplySettings(settings, plan);
+}
+
+// Use changed settings, rebuilding only what depends on them.
+void Game::ApplySettings(const DX::ViewerSettings& settings, const DX::SettingsPlan& plan)
+{
+    DX_TRACE_SPAN("ApplySettings");
+    const std::vector<UINT> previousIndices = monitorIndices;
+    m_settings = settings;
+    UseSettings(settings, &plan);
+
+    // Nothing may still be reading what is about to be released.
+    if (plan.Has(DX::SettingsChangeCaptures) || plan.Has(DX::SettingsChangeInterpolators)) {
+        WaitForGpu();
+    }
+    if (plan.Has(DX::SettingsChangeCaptures)) {
+        ReleaseCaptures();
+        try {
+            CreateCaptures();
+        }
+        catch (const std::exception& e) {
+            DX_LOG_ERROR("Settings: %s; capturing the previous outputs", e.what());
+            monitorIndices = previousIndices;
+            ReleaseCaptures();
+            try {
+                CreateCaptures();
+            }
+            catch (const std::exception& retry) {
+                DX_LOG_ERROR("Settings: %s; retrying the previous outputs as they recover", retry.what());
+                CreateRecoveringCaptures();
+            }
+        }
+    }
+    if (plan.Has(DX::SettingsChangeInterpolators)) {
+        captureRingDepth = std::clamp(captureRingDepth, 3, static_cast<int>(std::size(m_captures[0]->registered.pArrResource)) - 1);
+        for (auto& capture : m_captures) ResizeCapture(*capture);
+    }
+    if (plan.Has(DX::SettingsChangeScalers)) {
+        for (auto& capture : m_captures) {
+            capture->scaler.Resize(m_deviceResources->GetD3DDevice(), capture->region.Width(), capture->region.Height(), capture->width, capture->height, scaleFilter);
+        }
+    }
+    if (plan.Has(DX::SettingsChangeRegions)) {
+        // Look the window up again by its new title; the crops follow on the next frame.
+        m_roiWindow = NULL;
+        m_roiWindowSearchSeconds = -1.0;
+    }
+    if (plan.Has(DX::SettingsChangeCaptures) || plan.Has(DX::SettingsChangeInterpolators) || plan.Has(DX::SettingsChangeLayout)) {
+        OutputCapture& active = *m_captures[m_activeCapture];
+        desktop_width = active.width;
+        desktop_height = active.height;
+        PlaceOutputs();
+        if ((m_recorder || m_framePublisher) && (desktop_width != m_readbackWidth || desktop_height != m_readbackHeight))
+            DX_LOG_WARNING("Settings: recording and shared output stay %dx%d; frames of this size are skipped", m_readbackWidth, m_readbackHeight);
+    }
+    if (plan.Has(DX::SettingsChangePacing) && !plan.Has(DX::SettingsChangeCaptures)) {
+        SetFrameRate();
+    }
+    if (plan.Has(DX::SettingsChangeCursor)) {
+        m_cursorPredictor.SetPrediction(cursorPrediction);
+        m_cursorPredictor.Reset();
+    }
+    if (plan.Has(DX::SettingsChangeMetricsServer) && m_metricsServer) {
+        ToggleMetricsServer();
+        ToggleMetricsServer();
+    }
+    if (plan.Has(DX::SettingsChangeSharedOutput) && m_framePublisher) {
+        ToggleFramePublisher();
+        ToggleFramePublisher();
+    }
+    if (plan.Has(DX::SettingsChangeInterpolators) && internalFormat != m_readbackFormat && !m_readbackTextures.empty()) {
+        DX_LOG_WARNING("Settings: recording and shared output stay %s; frames in %s are skipped", DX::PixelFormatName(m_readbackFormat), DX::PixelFormatName(internalFormat));
+    }
+    if (plan.Has(DX::SettingsChangeReadback) && !m_readbackTextures.empty()) {
+        DX_LOG_INFO("Settings: the readback ring is in use; its new depth and latency apply when recording or the shared output next starts");
+    }
+
+    std::string keys, changes;
+    for (const std::string& key : plan.keys) keys += (keys.empty() ? "" : ", ") + key;
+    for (uint32_t change = DX::SettingsChangeCaptures; change <= DX::SettingsChangeValue; change <<= 1) {
+        if (plan.Has(static_cast<DX::SettingsChange>(change)))
+            changes += std::string(changes.empty() ? "" : ", ") + DX::SettingsChangeName(static_cast<DX::SettingsChange>(change));
+    }
+    DX_LOG_INFO("Settings: changed %s (%s)", keys, changes);
 }
 
 #pragma region Frame Update
@@ -52,6 +334,13 @@ void Game::Tick()
     {
             
     });
+
+    // Between a real frame and the next interpolated one, nothing is in flight on the rings.
+    if (drawInterpolated) {
+        FinishDeferredLoad(false);
+        RecoverCaptures();
+        CheckSettingsFile();
+    }
     Render();
 }
 
@@ -66,65 +355,197 @@ void Game::Render()
     
     if (drawInterpolated) {
         
-        // Get new frame and interpolate.
+        // Get new frame and interpolate. The active output paces the loop; the others are polled, hidden
+        // ones even with a full ring so the newest frames are there the moment they are shown.
+        UpdateRegions();
+        OutputCapture& paced = *m_captures[m_activeCapture];
         auto start = std::chrono::high_resolution_clock::now();
-        while (!GetFrame()) {}
-        InterpolateFrame();
+        {
+            DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Capture);
+            while (!paced.ring.HasReady() && !paced.recovery.Recovering()) { GetFrame(paced); }
+            for (auto& capture : m_captures) {
+                if (capture.get() != &paced && (!capture->visible || capture->ring.HasFree())) GetFrame(*capture, 0);
+            }
+        }
+        {
+            DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Interpolate);
+            const double interpolateStart = DX::HudSeconds();
+            InterpolateOutputs();
+            m_metrics.interpolateSeconds->Observe(DX::HudSeconds() - interpolateStart);
+        }
 		auto end = std::chrono::high_resolution_clock::now();
         
         
         sleepDuration += end - start; totalcount++;
 
+        // Wait only for the interpolated frames that are about to be shown, each on its output's own fence,
+        // so no output waits for another's capture or interpolation. The time from the later of its
+        // submission and the previous completion is taken as what each one cost the GPU.
+        {
+            DX_TRACE_SPAN("WaitInterpolated");
+            DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Wait);
+            double completed = 0;
+            for (size_t index : m_interpolatePlan) {
+                OutputCapture& capture = *m_captures[index];
+                capture.fenceTimeline->WaitFor(capture.interpolatedFenceValue);
+                const double now = DX::HudSeconds();
+                m_scheduler.Report(index, { now - std::max(completed, capture.submittedSeconds), capture.submitCpuSeconds });
+                completed = now;
+            }
+        }
+
         Clear();
 
-        // Create SRV from interpolated texture.
-        D3D11_TEXTURE2D_DESC textureDesc;
-        m_pInterpolateTexture2D[0]->GetDesc(&textureDesc);
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = textureDesc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-        if (m_texture != nullptr)m_texture->Release();
-        auto hr=device->CreateShaderResourceView(m_pInterpolateTexture2D[0], &srvDesc, &m_texture);
+        // Show the interpolated texture.
+        m_texture = paced.shown;
         
         // Show the new frame.
-        DrawFromSRV();
-        m_deviceResources->Present();
+        PresentFrame(DX::LatencyFrameKind::Interpolated, paced.shownSourceTicks);
 
         drawInterpolated = false;
     }
     else {
         
 #ifdef _DEBUG
-        fts(1000 * sleepDuration.count()/totalcount);
+        DX_LOG_DEBUG("Average capture and interpolation: %.3f ms", 1000 * sleepDuration.count() / totalcount);
+        if (totalcount % 120 == 0) { ReportFenceStats(); ReportSchedulerStats(); }
 #endif
+
+        // Let capture run ahead of interpolation while a slot is free.
+        {
+            DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Capture);
+            for (size_t i = 0; i < m_captures.size(); i++) {
+                if (!m_captures[i]->visible || m_captures[i]->ring.HasFree()) GetFrame(*m_captures[i], i == m_activeCapture ? 1 : 0);
+            }
+        }
         
 		// Sleep for the average duration.
-        if(totalcount!=0) std::this_thread::sleep_for(sleepDuration/totalcount);
+        if (totalcount != 0) {
+            DX_TRACE_SPAN("Sleep");
+            DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Sleep);
+            std::this_thread::sleep_for(sleepDuration/totalcount);
+        }
 
         Clear();
 
-		// Create SRV from last frame.
-        D3D11_TEXTURE2D_DESC textureDesc;
-        lastFrame->GetDesc(&textureDesc);
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = textureDesc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-		if (m_texture != nullptr)m_texture->Release();
-        auto hr = device->CreateShaderResourceView(lastFrame, &srvDesc, &m_texture);
+		// Show each output's previous ring slot directly; nothing else reads it after this. An output
+        // without one keeps showing what it showed last.
+        for (auto& capture : m_captures) {
+            if (capture->presentSlot != DX::CaptureRing::InvalidSlot) {
+                capture->shown = capture->renderSRV[capture->presentSlot];
+                capture->shownSourceTicks = capture->slotSourceTicks[capture->presentSlot];
+            }
+            else if (capture->shown == nullptr) {
+                capture->shown = capture->interpolateSRV;
+            }
+        }
+        OutputCapture& active = *m_captures[m_activeCapture];
+        m_texture = active.shown;
 
         // Show the new frame.
-        DrawFromSRV();
-        m_deviceResources->Present();
+        PresentFrame(DX::LatencyFrameKind::Real, active.presentSlot != DX::CaptureRing::InvalidSlot ? active.shownSourceTicks : 0);
+
+        for (auto& capture : m_captures) {
+            if (capture->presentSlot != DX::CaptureRing::InvalidSlot) {
+                capture->ring.Retire(capture->presentSlot);
+                capture->presentSlot = DX::CaptureRing::InvalidSlot;
+            }
+        }
 
         drawInterpolated = true;
     }
 
 }
 
+// Draw the current texture and overlay, present, and update the HUD and latency counters.
+// sourceTicks is the capture time of the newest desktop frame the shown image was built from.
+void Game::PresentFrame(DX::LatencyFrameKind kind, uint64_t sourceTicks)
+{
+    if (showCursor && m_pointerVisible) LatchCursor();
+    DrawFromSRV();
+    if (m_recorder || m_framePublisher) ReadbackFrame(kind, sourceTicks);
+    {
+        DX_TRACE_SPAN("Present");
+        DX::HudStageTimer hudTimer(m_hud, DX::HudStage::Present);
+        m_deviceResources->Present();
+    }
+
+    // Each ring counts drops since it was last reset; the counter only ever grows.
+    uint64_t dropped = 0;
+    for (auto& capture : m_captures) {
+        const uint64_t ringDropped = capture->ring.GetDroppedFrames();
+        if (ringDropped > capture->reportedDroppedFrames) m_metrics.droppedFrames->Increment(ringDropped - capture->reportedDroppedFrames);
+        capture->reportedDroppedFrames = ringDropped;
+        dropped += ringDropped;
+    }
+
+    const double now = DX::HudSeconds();
+    m_hud.OnPresent(now);
+    m_hud.SetDroppedFrames(dropped);
+    m_hud.Update(now);
+
+    (kind == DX::LatencyFrameKind::Interpolated ? m_metrics.interpolatedFrames : m_metrics.realFrames)->Increment();
+    if (m_lastPresentSeconds > 0) m_metrics.frameSeconds->Observe(now - m_lastPresentSeconds);
+    m_lastPresentSeconds = now;
+
+    // Startup: the first frame of any kind, and the first that really was interpolated.
+    if (m_firstFrameSeconds < 0 && m_texture != nullptr) {
+        m_firstFrameSeconds = now - m_startSeconds;
+        m_metrics.firstFrameSeconds->Set(m_firstFrameSeconds);
+        DX_LOG_INFO("Startup: first frame after %.0f ms", 1000.0 * m_firstFrameSeconds);
+    }
+    if (m_firstInterpolatedSeconds < 0 && kind == DX::LatencyFrameKind::Interpolated && m_texture == m_captures[m_activeCapture]->interpolateSRV) {
+        m_firstInterpolatedSeconds = now - m_startSeconds;
+        m_metrics.firstInterpolatedSeconds->Set(m_firstInterpolatedSeconds);
+        DX_LOG_INFO("Startup: first interpolated frame after %.0f ms", 1000.0 * m_firstInterpolatedSeconds);
+    }
+
+    // Present statistics keep the cursor's vblank clock in phase. Only available for flip model or fullscreen swap chains.
+    auto swapChain = m_deviceResources->GetSwapChain();
+    DXGI_FRAME_STATISTICS stats = {};
+    const bool hasStats = SUCCEEDED(swapChain->GetFrameStatistics(&stats));
+    if (hasStats) m_vblankClock.OnVblank(stats.SyncRefreshCount, static_cast<uint64_t>(stats.SyncQPCTime.QuadPart));
+
+    // Latency mode: stamp the Present just issued, then resolve whichever one the display last reported.
+    if (m_latency.IsRecording()) {
+        LARGE_INTEGER presentTime;
+        QueryPerformanceCounter(&presentTime);
+        UINT presentCount = 0;
+        if (SUCCEEDED(swapChain->GetLastPresentCount(&presentCount)))
+            m_latency.OnPresent(kind, sourceTicks, static_cast<uint64_t>(presentTime.QuadPart), presentCount);
+        if (hasStats)
+            m_latency.OnDisplayed(stats.PresentCount, static_cast<uint64_t>(stats.SyncQPCTime.QuadPart));
+    }
+}
+
+// Sample the pointer once more right before drawing, and place the cursor where the predictor expects it
+// when this frame reaches the screen. The desktop image never contains the pointer, so interpolated
+// frames are free of it and the cursor is only ever drawn here.
+void Game::LatchCursor()
+{
+    DX_TRACE_SPAN("LatchCursor");
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    // The hotspot on the virtual desktop, in physical pixels whatever the DPI.
+    POINT cursorPos;
+    if (GetPhysicalCursorPos(&cursorPos))
+        AddPointerSample({ static_cast<uint64_t>(now.QuadPart), double(cursorPos.x), double(cursorPos.y) });
+
+    const uint64_t target = m_vblankClock.NextAfter(static_cast<uint64_t>(now.QuadPart)) + uint64_t(std::max(cursorVblanks - 1, 0)) * m_vblankClock.Period();
+    const DX::Point2D origin = OutputOrigin(m_pointerOutput);
+    m_cursorHotspot.x = origin.x + m_pointerPosition.x + m_cursorTextures.hotspotX;
+    m_cursorHotspot.y = origin.y + m_pointerPosition.y + m_cursorTextures.hotspotY;
+    m_cursorPredictor.Predict(target, m_cursorHotspot.x, m_cursorHotspot.y);
+}
+
+// Feed the predictor, and the trace written with the latency CSV.
+void Game::AddPointerSample(const DX::PointerSample& sample)
+{
+    m_cursorPredictor.AddSample(sample);
+    if (m_latency.IsRecording() && m_pointerTrace.size() < c_MaxPointerTraceSamples) m_pointerTrace.push_back(sample);
+}
+
 // Helper method to clear the back buffers.
 void Game::Clear()
 {
@@ -142,12 +563,39 @@ void Game::Clear()
     context->RSSetViewports(1, &viewport);
 }
 
-bool Game::GetFrame()
+bool Game::GetFrame(OutputCapture& capture, UINT timeoutMs)
 {
+    DX_TRACE_SPAN("GetFrame");
+
+    // A failing output is left alone until RecoverCaptures has rebuilt what it needs.
+    if (capture.recovery.Recovering()) return false;
+
     // Acquire next frame.
     DXGI_OUTDUPL_FRAME_INFO frameInfo;
-    auto hr = pDeskDupl->AcquireNextFrame(1, &frameInfo, &desktopResource);
-    if (hr == DXGI_ERROR_WAIT_TIMEOUT || hr != S_OK) return false;
+    auto hr = capture.duplication->AcquireNextFrame(timeoutMs, &frameInfo, &desktopResource);
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) { m_metrics.captureTimeouts->Increment(); return false; }
+    if (hr != S_OK) {
+        m_metrics.captureErrors->Increment();
+        const DX::CaptureFault fault = DX::ClassifyCaptureResult(hr);
+        const DX::RecoveryLayer layer = capture.recovery.OnFault(fault, DX::HudSeconds());
+        DX_LOG_WARNING("Capture: output %u failed with %s (0x%08x); rebuilding its %s", capture.outputIndex,
+            DX::CaptureFaultName(fault), static_cast<unsigned>(hr), DX::RecoveryLayerName(layer));
+        return false;
+    }
+    UpdatePointer(capture, frameInfo);
+
+    // Claim a ring slot, recycling the oldest unused capture if the ring is full.
+    const int slot = capture.ring.BeginCapture();
+    if (slot == DX::CaptureRing::InvalidSlot) {
+        desktopResource->Release();
+        capture.duplication->ReleaseFrame();
+        return false;
+    }
+
+    // Stamp the slot with when the desktop frame was presented; pointer-only updates carry no time.
+    LARGE_INTEGER sourceTime = frameInfo.LastPresentTime;
+    if (sourceTime.QuadPart == 0) QueryPerformanceCounter(&sourceTime);
+    capture.slotSourceTicks[slot] = static_cast<uint64_t>(sourceTime.QuadPart);
 
     auto device = m_deviceResources->GetD3DDevice();
     auto context = m_deviceResources->GetD3DDeviceContext();
@@ -162,88 +610,194 @@ bool Game::GetFrame()
     srvDesc.Texture2D.MipLevels = 1;
     srvDesc.Texture2D.MostDetailedMip = 0;
     device->CreateShaderResourceView(desktopTextureBGR, &srvDesc, &m_textureDesktop);
-    postProcess->SetSourceTexture(m_textureDesktop);
-    postProcess->SetEffect(BasicPostProcess::Copy);
-
-    // Initialize temporary render target.
-    ID3D11RenderTargetView* tmpRTV = nullptr;
-    D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc;
-    renderTargetViewDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    renderTargetViewDesc.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
-    renderTargetViewDesc.Texture2D.MipSlice = 0;
-    device->CreateRenderTargetView(renderTargetTexture, &renderTargetViewDesc, &tmpRTV);
-
-	// Render to temporary render target (scope added for mutex if used).
-    {
-        // Set to temporary render target view and viewport.
-        D3D11_VIEWPORT tmpViewport = { 0.0f, 0.0f, static_cast<float>(desktop_width), static_cast<float>(desktop_height), 0.f, 1.f };
-        context->OMSetRenderTargets(1, &tmpRTV, nullptr);
-		context->RSSetViewports(1, &tmpViewport);
-        
-		// Render to temporary render target.
-        postProcess->Process(context);
-        
-		// Reset render target view and viewport.
-        auto renderTarget = m_deviceResources->GetRenderTargetView();
-        auto depthStencil = m_deviceResources->GetDepthStencilView();
-        auto const viewport = m_deviceResources->GetScreenViewport();
-        context->OMSetRenderTargets(1, &renderTarget, depthStencil);
-        context->RSSetViewports(1, &viewport);
-    }
 
-    // Update render index.
-    lastRenderIndex = currRenderIndex;
-	currRenderIndex = (currRenderIndex + 1) % 2;
+    // Convert, downscale and write straight into the ring slot, reading only the region's crop. An HDR
+    // desktop arrives as scRGB and is encoded to the ring's format on the way.
+    const DX::DesktopRect& crop = capture.region.Crop();
+    capture.scaler.SetSourceRegion(crop.left, crop.top, capture.captureWidth, capture.captureHeight);
+    capture.scaler.SetTransfer(DX::DesktopTransfer(textureDesc.Format), capture.format, SdrWhiteNits(capture));
+    capture.scaler.Process(context, m_textureDesktop, capture.renderUAV[slot], capture.renderChromaUAV[slot]);
 
-    // Copy to render texture for NvOFFRUC.
-    {
-        context->CopySubresourceRegion(m_pRenderTexture2D[currRenderIndex], 0, 0, 0, 0, renderTargetTexture, 0, nullptr);
-    }
+    // Signal once the conversion lands. Only the immediate context signals the capture fence, so nothing
+    // waits here for any other output's work.
+    const uint64_t captureFenceValue = m_captureTimeline->Signal();
+    m_pDeviceContext4->Signal(m_pCaptureFence, captureFenceValue);
+    capture.ring.EndCapture(slot, captureFenceValue);
+    m_hud.OnSourceFrame();
+    m_metrics.sourceFrames->Increment();
 
 	// Release resources.
-    tmpRTV->Release();
+    m_textureDesktop->Release();
+    m_textureDesktop = nullptr;
     desktopTextureBGR->Release();
-    pDeskDupl->ReleaseFrame();
+    desktopResource->Release();
+    capture.duplication->ReleaseFrame();
 
     return true;
 }
 
+// Take the pointer shape when it changed, then the position, from the duplication frame metadata.
+void Game::UpdatePointer(OutputCapture& capture, const DXGI_OUTDUPL_FRAME_INFO& frameInfo)
+{
+    // No update time means only the desktop image changed.
+    if (frameInfo.LastMouseUpdateTime.QuadPart == 0) return;
+    if (frameInfo.PointerShapeBufferSize != 0) UpdatePointerShape(capture, frameInfo.PointerShapeBufferSize);
+
+    // Every output reports the pointer leaving it; only the one it was last on may hide it.
+    const bool visible = frameInfo.PointerPosition.Visible != FALSE;
+    if (!visible && capture.layoutIndex != m_pointerOutput) return;
+
+    // Position is the shape's top-left on the output; the predictor follows the hotspot on the virtual desktop,
+    // which stays put when the shape changes.
+    m_pointerVisible = visible;
+    m_pointerOutput = capture.layoutIndex;
+    m_pointerPosition = frameInfo.PointerPosition.Position;
+    const DX::Point2D origin = OutputOrigin(m_pointerOutput);
+    m_cursorHotspot.x = origin.x + m_pointerPosition.x + m_cursorTextures.hotspotX;
+    m_cursorHotspot.y = origin.y + m_pointerPosition.y + m_cursorTextures.hotspotY;
+    if (m_pointerVisible) AddPointerSample({ static_cast<uint64_t>(frameInfo.LastMouseUpdateTime.QuadPart), m_cursorHotspot.x, m_cursorHotspot.y });
+}
+
+// Fetch the new pointer shape, decoding and uploading it unless it is already cached.
+void Game::UpdatePointerShape(OutputCapture& capture, UINT bufferSize)
+{
+    DX_TRACE_SPAN("UpdatePointerShape");
+    m_pointerShapeBuffer.resize(bufferSize);
+    UINT shapeSize = 0;
+    DXGI_OUTDUPL_POINTER_SHAPE_INFO shapeInfo = {};
+    auto hr = capture.duplication->GetFramePointerShape(static_cast<UINT>(m_pointerShapeBuffer.size()), m_pointerShapeBuffer.data(), &shapeSize, &shapeInfo);
+    if (FAILED(hr)) {
+        DX_LOG_WARNING("Cursor: GetFramePointerShape failed (0x%08X)", static_cast<unsigned>(hr));
+        return;
+    }
+
+    DX::CursorShapeInfo info;
+    info.type = static_cast<DX::CursorShapeType>(shapeInfo.Type);
+    info.width = shapeInfo.Width;
+    info.height = shapeInfo.Height;
+    info.pitch = shapeInfo.Pitch;
+    info.hotspotX = shapeInfo.HotSpot.x;
+    info.hotspotY = shapeInfo.HotSpot.y;
+
+    // Shapes repeat constantly (arrow, I-beam, arrow); only new ones are decoded and uploaded.
+    const uint64_t hash = DX::HashCursorShape(m_pointerShapeBuffer.data(), shapeSize, info);
+    if (auto cached = m_cursorCache.Find(hash)) {
+        m_cursorTextures = *cached;
+        return;
+    }
+    if (!DX::DecodeCursorShape(m_pointerShapeBuffer.data(), shapeSize, info, m_decodedCursor)) {
+        DX_LOG_WARNING("Cursor: could not decode a %ux%u shape of type %u", info.width, info.height, shapeInfo.Type);
+        return;
+    }
+
+    auto device = m_deviceResources->GetD3DDevice();
+    D3D11CursorTextures textures;
+    textures.color = CreateImmutableTexture(device, m_decodedCursor.color.View());
+    if (m_decodedCursor.hasXor) textures.xorMask = CreateImmutableTexture(device, m_decodedCursor.xorMask.View());
+    if (!textures.color) return;
+    textures.hotspotX = m_decodedCursor.hotspotX;
+    textures.hotspotY = m_decodedCursor.hotspotY;
+    m_cursorTextures = m_cursorCache.Insert(hash, std::move(textures));
+    DX_LOG_DEBUG("Cursor: uploaded %ux%u shape of type %u, %zu cached", m_decodedCursor.Width(), m_decodedCursor.Height(), shapeInfo.Type, m_cursorCache.Size());
+}
+
 void Game::DrawFromSRV() {
-    m_spriteBatch->Begin();
+    DX_TRACE_SPAN("DrawFromSRV");
 
-    // Draw main texture.
-    auto tmp = m_texture;
-    m_spriteBatch->Draw(tmp, m_screenPos, nullptr, Colors::White, 0.f, DirectX::SimpleMath::Vector2::Zero, m_scaleFactor);
+    // Draw every visible output where PlaceOutputs put it. Frames in another transfer function than the swap
+    // chain's are converted as they are drawn, each output at its own SDR white, and nv12 frames always are,
+    // from their luma view with the chroma view beside it; the cursor and HUD are sRGB, converted the same way.
+    auto context = m_deviceResources->GetD3DDeviceContext();
+    const DX::TransferFunction swapChainTransfer = SwapChainTransfer(m_deviceResources->GetColorSpace());
+    auto converted = [&](const OutputCapture& capture) {
+        return DX::PixelFormatPlanar(capture.format) || DX::PixelFormatTransfer(capture.format) != swapChainTransfer;
+    };
+    for (auto& capture : m_captures) {
+        if (!capture->visible || capture->shown == nullptr || !converted(*capture)) continue;
+        const PresentConvertConstants constants = { uint32_t(DX::PixelFormatTransfer(capture->format)), uint32_t(swapChainTransfer), SdrWhiteNits(*capture), 0 };
+        context->UpdateSubresource(m_presentConvertConstants.Get(), 0, nullptr, &constants, 0, 0);
+        ID3D11ShaderResourceView* chroma = DX::PixelFormatPlanar(capture->format) ? ChromaView(capture->shown) : nullptr;
+        m_spriteBatch->Begin(SpriteSortMode_Deferred, nullptr, nullptr, nullptr, nullptr, [this, context, chroma]() {
+            ID3D11Buffer* buffer = m_presentConvertConstants.Get();
+            context->PSSetShader(chroma ? m_presentNv12PS.Get() : m_presentConvertPS.Get(), nullptr, 0);
+            context->PSSetConstantBuffers(0, 1, &buffer);
+            if (chroma) context->PSSetShaderResources(1, 1, &chroma);
+        });
+        m_spriteBatch->Draw(capture->shown, capture->screenPos, nullptr, Colors::White, 0.f, DirectX::SimpleMath::Vector2::Zero, capture->scaleFactor);
+        m_spriteBatch->End();
+        if (chroma) {
+            ID3D11ShaderResourceView* nullSRV = nullptr;
+            context->PSSetShaderResources(1, 1, &nullSRV);
+        }
+    }
 
-    // Get current cursor position.
-    POINT cursorPos;
-    DirectX::SimpleMath::Vector2 m_mousePosition;
-    DirectX::SimpleMath::Vector2 m_scaleFactor2;
-    GetCursorPos(&cursorPos);
-    
-	// Only draw cursor if it is inside the screen.
-    if (cursorPos.x < 0 && isOnTheLeft) {
-        
-        //// Reset sleep duration if cursor is moving.
-        //if (cursorPos.x != lastCursorPos.x || cursorPos.y != lastCursorPos.y) {
-        //    sleepDuration = std::chrono::duration<double>(0);
-        //    totalcount = 0;
-        //}
-        
-        // Scale cursor.
-        m_mousePosition.x = ((float)cursorPos.x/resFactor + (float)desktop_width) * (float)m_scaleFactor.x;
-        m_mousePosition.y = (float)cursorPos.y * (float)m_scaleFactor.y / resFactor;
-        
-        // Add screen offset position.
-        m_mousePosition.x += m_screenPos.x;
-        m_mousePosition.y += m_screenPos.y;
-        m_scaleFactor2.x = m_scaleFactor.x / resFactor;
-        m_scaleFactor2.y = m_scaleFactor.y / resFactor;
-        m_spriteBatch->Draw(m_textureCursor.Get(), m_mousePosition, nullptr, Colors::White, 0.f, m_origin, m_scaleFactor2);
-    }    
+    m_spriteBatch->Begin();
+    for (auto& capture : m_captures) {
+        if (capture->visible && capture->shown != nullptr && !converted(*capture))
+            m_spriteBatch->Draw(capture->shown, capture->screenPos, nullptr, Colors::White, 0.f, DirectX::SimpleMath::Vector2::Zero, capture->scaleFactor);
+    }
     m_spriteBatch->End();
 
-    lastCursorPos = cursorPos;
+    // Draw the cursor only while its hotspot is in the crop of a visible output, mapped and turned like that output's
+    // image. The shape is drawn around its hotspot, at the scale the output is shown at.
+    const int cursorOutput = m_desktopLayout.FindOutput(m_cursorHotspot, m_pointerOutput);
+    const OutputCapture* cursorCapture = nullptr;
+    for (auto& capture : m_captures) {
+        if (capture->visible && cursorOutput != DX::DesktopLayout::NoOutput && capture->layoutIndex == cursorOutput) {
+            const DX::Point2D image = m_desktopLayout.Output(cursorOutput).desktopToImage.Apply(m_cursorHotspot);
+            if (capture->region.Crop().Contains(image.x, image.y)) cursorCapture = capture.get();
+        }
+    }
+    const bool drawCursor = showCursor && m_pointerVisible && cursorCapture != nullptr;
+    DirectX::SimpleMath::Vector2 cursorPosition, cursorOrigin, cursorScale;
+    float cursorRotation = 0.f;
+    if (drawCursor) {
+        const DX::DesktopOutput& output = m_desktopLayout.Output(cursorOutput);
+        const DX::Point2D viewer = output.desktopToViewer.Apply(m_cursorHotspot);
+        cursorPosition = { float(viewer.x), float(viewer.y) };
+        cursorOrigin = { float(m_cursorTextures.hotspotX), float(m_cursorTextures.hotspotY) };
+        cursorScale = { cursorCapture->scaleFactor.x * float(cursorCapture->width) / float(cursorCapture->region.Width()),
+            cursorCapture->scaleFactor.y * float(cursorCapture->height) / float(cursorCapture->region.Height()) };
+        cursorRotation = float(DX::ImageRotationRadians(output.rotation));
+
+        // default.png stands in until the first shape arrives, once the startup worker has loaded it.
+        auto cursor = m_cursorTextures.color ? m_cursorTextures.color.Get() : m_textureCursor.Get();
+        if (cursor) {
+            m_spriteBatch->Begin(SpriteSortMode_Deferred, nullptr, nullptr, nullptr, nullptr, ConvertFromSrgb(swapChainTransfer, SdrWhiteNits(*cursorCapture)));
+            m_spriteBatch->Draw(cursor, cursorPosition, nullptr, Colors::White, cursorRotation, cursorOrigin, cursorScale);
+            m_spriteBatch->End();
+        }
+    }
+
+    // Pixels that XOR the screen, such as the I-beam's, need their own blend. They invert the swap chain's
+    // own code values, so the mask is drawn unconverted.
+    if (drawCursor && m_cursorTextures.xorMask) {
+        m_spriteBatch->Begin(SpriteSortMode_Deferred, m_cursorXorBlend.Get());
+        m_spriteBatch->Draw(m_cursorTextures.xorMask.Get(), cursorPosition, nullptr, Colors::White, cursorRotation, cursorOrigin, cursorScale);
+        m_spriteBatch->End();
+    }
+
+    // Performance overlay in the top-left corner, at the active output's SDR white.
+    if (showHud) {
+        const float white = m_captures.empty() ? DX::Transfer::ScRgbWhiteNits : SdrWhiteNits(*m_captures[m_activeCapture]);
+        m_hudRenderer.Draw(m_spriteBatch.get(), m_hud, DirectX::XMFLOAT2(8.f, 8.f), 2.f, ConvertFromSrgb(swapChainTransfer, white));
+    }
+
+    lastCursorPos = m_pointerPosition;
+}
+
+// SpriteBatch setup that draws sRGB quads, the cursor and HUD, in the swap chain's transfer function at the given
+// SDR white; nullptr when the swap chain is sRGB and they are drawn as they are. The batch must end before the next call.
+std::function<void()> Game::ConvertFromSrgb(DX::TransferFunction swapChainTransfer, float sdrWhiteNits) {
+    if (swapChainTransfer == DX::TransferFunction::Srgb) return nullptr;
+    auto context = m_deviceResources->GetD3DDeviceContext();
+    const PresentConvertConstants constants = { uint32_t(DX::TransferFunction::Srgb), uint32_t(swapChainTransfer), sdrWhiteNits, 0 };
+    context->UpdateSubresource(m_presentConvertConstants.Get(), 0, nullptr, &constants, 0, 0);
+    return [this, context]() {
+        ID3D11Buffer* buffer = m_presentConvertConstants.Get();
+        context->PSSetShader(m_presentConvertPS.Get(), nullptr, 0);
+        context->PSSetConstantBuffers(0, 1, &buffer);
+    };
 }
 
 #pragma region Message Handlers
@@ -279,6 +833,8 @@ void Game::OnWindowMoved()
 void Game::OnDisplayChange()
 {
     m_deviceResources->UpdateColorSpace();
+    BuildDesktopLayout();
+    PlaceOutputs();
 }
 
 void Game::OnWindowSizeChanged(int width, int height)
@@ -307,83 +863,42 @@ void Game::CreateDeviceDependentResources()
     auto device = m_deviceResources->GetD3DDevice();
     auto context = m_deviceResources->GetD3DDeviceContext();
  
-    // Create sprite batch for drawing.
+    // Create sprite batch for drawing, and the pixel shaders it converts frames in wider formats and nv12 with.
     m_spriteBatch = std::make_unique<SpriteBatch>(context);
-    
-    // Initialize cursor texture.
-    ComPtr<ID3D11Resource> resource;
-    DX::ThrowIfFailed(
-        CreateWICTextureFromFile(device, L"default.png",
-            resource.GetAddressOf(),
-            m_textureCursor.ReleaseAndGetAddressOf()));
-    
-    ComPtr<ID3D11Texture2D> cursor;
-    DX::ThrowIfFailed(resource.As(&cursor));
-    
-    CD3D11_TEXTURE2D_DESC cursorDesc;                               
-    cursor->GetDesc(&cursorDesc);
-    
-    m_origin.x = 0;
-    m_origin.y = 0;
-
-    // Initialize desktop duplication.
-    CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory);
-    factory->EnumAdapters1(0, &adapter);
-    adapter->EnumOutputs(monitorIndex, &pOutput);
-    pOutput->QueryInterface(__uuidof(IDXGIOutput1), (void**)&pOutput1);
-    pOutput1->DuplicateOutput(device, &pDeskDupl);
-    
-    // Get width and height for rendering.
-    DXGI_OUTDUPL_DESC outputDesc = { 0 };                           
-    pDeskDupl->GetDesc(&outputDesc);
-    desktop_width = outputDesc.ModeDesc.Width/resFactor;
-    desktop_height = outputDesc.ModeDesc.Height/resFactor;
-    
-    // Set the framerate to double the source.
-    DXGI_RATIONAL refreshRate = outputDesc.ModeDesc.RefreshRate;
-    fps = refreshRate.Numerator / (double)refreshRate.Denominator * 2.f;
-    frametime = 1.0 / fps;
+    DX::ThrowIfFailed(device->CreatePixelShader(g_PresentConvert_PS, sizeof(g_PresentConvert_PS), nullptr, m_presentConvertPS.ReleaseAndGetAddressOf()));
+    DX::ThrowIfFailed(device->CreatePixelShader(g_PresentNv12_PS, sizeof(g_PresentNv12_PS), nullptr, m_presentNv12PS.ReleaseAndGetAddressOf()));
+    CD3D11_BUFFER_DESC constantsDesc(sizeof(PresentConvertConstants), D3D11_BIND_CONSTANT_BUFFER);
+    DX::ThrowIfFailed(device->CreateBuffer(&constantsDesc, nullptr, m_presentConvertConstants.ReleaseAndGetAddressOf()));
 
-    // Initialize NvOFFRUC.
+    // src * (1 - dst) + dst * (1 - src): inverts under white, leaves the screen alone under black.
+    CD3D11_BLEND_DESC xorBlend(D3D11_DEFAULT);
+    xorBlend.RenderTarget[0].BlendEnable = TRUE;
+    xorBlend.RenderTarget[0].SrcBlend = D3D11_BLEND_INV_DEST_COLOR;
+    xorBlend.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_COLOR;
+    xorBlend.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+    xorBlend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+    DX::ThrowIfFailed(device->CreateBlendState(&xorBlend, m_cursorXorBlend.ReleaseAndGetAddressOf()));
 
-    // Load NvOFFRUC dll.
-    HMODULE hDLL=LoadLibrary("NvOFFRUC.dll");
-    if (hDLL == nullptr) {
-        throw;
-    }
-    NvOFFRUCCreate = (PtrToFuncNvOFFRUCCreate)GetProcAddress(hDLL,CreateProcName);
-    NvOFFRUCRegisterResource = (PtrToFuncNvOFFRUCRegisterResource)GetProcAddress(hDLL,RegisterResourceProcName);
-    NvOFFRUCUnregisterResource =(PtrToFuncNvOFFRUCUnregisterResource)GetProcAddress(hDLL,UnregisterResourceProcName);
-    NvOFFRUCProcess = (PtrToFuncNvOFFRUCProcess)GetProcAddress(hDLL,ProcessProcName);
-    NvOFFRUCDestroy = (PtrToFuncNvOFFRUCDestroy)GetProcAddress(hDLL,DestroyProcName);
+    m_hudRenderer.CreateDeviceResources(device);
     
-	// Create NvOFFRUC instance.
-    NvOFFRUC_CREATE_PARAM createParams = { 0 };
-    createParams.pDevice = device;
-    createParams.uiHeight = desktop_height;
-    createParams.uiWidth = desktop_width;
-    createParams.eResourceType = DirectX11Resource;
-    createParams.eSurfaceFormat = ARGBSurface;
-    createParams.eCUDAResourceType = CudaResourceCuDevicePtr;
-    auto status = NvOFFRUCCreate(&createParams,&hFRUC);
+    m_origin.x = 0;
+    m_origin.y = 0;
 
-	// Create textures for NvOFFRUC.
-    CreateTextureBuffer();
-    
-    // Create fence for NvOFFRUC.
+    // Create the capture fence; each output creates its own for its interpolations.
     device->QueryInterface<ID3D11Device5>(&m_pDevice5);
     context->QueryInterface<ID3D11DeviceContext4>(&m_pDeviceContext4);
-    m_pDevice5->CreateFence(0, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(&m_pFence));
-    m_hFenceEvent = CreateEvent(nullptr,FALSE,FALSE,nullptr);
-    
-	// Register resource to NvOFFRUC.
-    GetResource(regOutParam.pArrResource);
-    regOutParam.uiCount = 3;
-    regOutParam.pD3D11FenceObj = m_pFence;
-    status = NvOFFRUCRegisterResource(hFRUC,&regOutParam);
+    m_pDevice5->CreateFence(0, D3D11_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pCaptureFence));
+    m_hCaptureFenceEvent = CreateEvent(nullptr,FALSE,FALSE,nullptr);
+    m_captureTimeline = std::make_unique<D3D11FenceTimeline>(D3D11FenceAdapter{ m_pCaptureFence, m_hCaptureFenceEvent });
+    // Nothing is kept idle until the rings exist; TrimTexturePool then sizes the budget to them.
+    m_texturePool = std::make_unique<D3D11TexturePool>(D3D11TextureAllocator{ device }, 0);
 
-    // Initialize PostProcess for downscaling and conversion.
-    postProcess = std::make_unique<BasicPostProcess>(device);
+    // Initialize desktop duplication, one session and ring per listed output. Their frames pass through
+    // until the worker has loaded NvOFFRUC and the cursor below.
+    m_backend = InterpolatorBackend::PassThrough;
+    CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory);
+    factory->EnumAdapters1(0, &adapter);
+    CreateCaptures();
 
     // Initialize lastCursorPos to avoid possible errors.
     GetCursorPos(&lastCursorPos);
@@ -398,154 +913,1374 @@ void Game::CreateDeviceDependentResources()
 	ID3D11Multithread* pMultiThread = nullptr;
 	device->QueryInterface(__uuidof(ID3D11Multithread), (void**)&pMultiThread);
 	pMultiThread->SetMultithreadProtected(TRUE);
+
+    // The worker creates NvOFFRUC instances on the device, so only once it is protected.
+    StartDeferredLoad();
 }
 
-// Allocate all memory resources that change on a window SizeChanged event.
-void Game::CreateWindowSizeDependentResources()
+// Duplicate each output in monitorIndices, and create its scaler and interpolator at its region's size.
+void Game::CreateCaptures()
 {
-    // Get the new scale factors.
-    RECT size = m_deviceResources->GetOutputSize();
-    m_screenPos.x = -1.0f;
-    m_screenPos.y = -1.0f;
-    int width = size.right - size.left;
-    int height = size.bottom - size.top;
-    m_scaleFactor.x = float(width) / float(desktop_width);
-    m_scaleFactor.y = float(height) / float(desktop_height);
-    
-	// Preserve aspect ratio of desktop.
-    if (m_scaleFactor.y > m_scaleFactor.x) {
-        m_scaleFactor.y = m_scaleFactor.x;
-        m_screenPos.y = (float(height) - float(desktop_height) * m_scaleFactor.y) / 2.0f;
+    auto device = m_deviceResources->GetD3DDevice();
+    for (UINT index : monitorIndices) {
+        auto capture = std::make_unique<OutputCapture>();
+        capture->outputIndex = index;
+        if (FAILED(adapter->EnumOutputs(index, &capture->output))) {
+            DX_LOG_WARNING("Capture: adapter 0 has no output %u", index);
+            continue;
+        }
+        capture->output->QueryInterface(__uuidof(IDXGIOutput1), (void**)&capture->output1);
+        const HRESULT hr = DuplicateCapture(*capture);
+
+        // Get width and height for rendering.
+        DXGI_OUTDUPL_DESC outputDesc = { 0 };
+        if (SUCCEEDED(hr)) {
+            capture->duplication->GetDesc(&outputDesc);
+        }
+        else {
+            // The secure desktop or too many sessions only pass with time: start recovering, at the mode
+            // the desktop reports until duplication tells otherwise.
+            const DX::CaptureFault fault = DX::ClassifyCaptureResult(hr);
+            if (DX::RecoveryLayerFor(fault) != DX::RecoveryLayer::Duplication) {
+                DX_LOG_WARNING("Capture: could not duplicate output %u (%s)", index, DX::CaptureFaultName(fault));
+                capture->output1->Release();
+                capture->output->Release();
+                continue;
+            }
+            DX_LOG_WARNING("Capture: output %u can't be duplicated yet (%s); retrying", index, DX::CaptureFaultName(fault));
+            capture->duplication = nullptr;
+            capture->recovery.OnFault(fault, DX::HudSeconds());
+            DXGI_OUTPUT_DESC desc = {};
+            capture->output->GetDesc(&desc);
+            const bool sideways = desc.Rotation == DXGI_MODE_ROTATION_ROTATE90 || desc.Rotation == DXGI_MODE_ROTATION_ROTATE270;
+            const UINT width = UINT(desc.DesktopCoordinates.right - desc.DesktopCoordinates.left);
+            const UINT height = UINT(desc.DesktopCoordinates.bottom - desc.DesktopCoordinates.top);
+            outputDesc.ModeDesc.Width = sideways ? height : width;
+            outputDesc.ModeDesc.Height = sideways ? width : height;
+            outputDesc.ModeDesc.RefreshRate = { 60, 1 };
+            outputDesc.Rotation = desc.Rotation;
+        }
+        SetCaptureMode(*capture, outputDesc);
+        m_captures.push_back(std::move(capture));
     }
-    else if (m_scaleFactor.x > m_scaleFactor.y) {
-        m_scaleFactor.x = m_scaleFactor.y;
-        m_screenPos.x = (float(width) - float(desktop_width) * m_scaleFactor.x) / 2.0f;
+    if (m_captures.empty()) {
+        throw std::runtime_error("No output to capture");
     }
-}
+    m_activeCapture = std::min(m_activeCapture, m_captures.size() - 1);
+    BuildDesktopLayout();
 
-void Game::OnDeviceLost()
-{
+    // Start at the region of interest, so the interpolators are created at its size.
+    for (auto& capture : m_captures) {
+        capture->region.Update(WantedRegion(*capture));
+        capture->width = RingSize(capture->region.Width(), resFactor, internalFormat);
+        capture->height = RingSize(capture->region.Height(), resFactor, internalFormat);
+    }
     
-	// Release all resources.
+    // The ring holds the interpolator's previous frame, the frame being presented and at least one capture,
+    // and must fit in what NvOFFRUC can register next to the interpolation target.
+    captureRingDepth = std::clamp(captureRingDepth, 3, static_cast<int>(std::size(m_captures[0]->registered.pArrResource)) - 1);
 
-    // Release desktop duplication resources.
-    factory->Release();
-    adapter->Release();
-    pOutput->Release();
-    pOutput1->Release();
-    pDeskDupl->Release();
-    
-	// Release NvOFFRUC resources.
-    m_pFence->Release();
-    m_pDevice5->Release();
-    m_pDeviceContext4->Release();
-    
-	// Unregister textures from NvOFFRUC.
-    NvOFFRUC_UNREGISTER_RESOURCE_PARAM stUnregisterResourceParam = { 0 };
-    memcpy(stUnregisterResourceParam.pArrResource,regOutParam.pArrResource,regOutParam.uiCount * sizeof(IUnknown*));
-    stUnregisterResourceParam.uiCount = regOutParam.uiCount;
-    auto status = NvOFFRUCUnregisterResource(hFRUC,&stUnregisterResourceParam);
-    
-	// Destroy NvOFFRUC instance.
-    NvOFFRUCDestroy(hFRUC);
+    // The window starts at the active output's size.
+    OutputCapture& active = *m_captures[m_activeCapture];
+    desktop_width = active.width;
+    desktop_height = active.height;
     
-    // Release texture buffers.
-    renderTargetTexture->Release();
-    lastFrame->Release();
-    for (int i = 0; i < 1; i++) {
-        m_pInterpolateTexture2D[i]->Release();
-    }
-    for (int i = 0; i < 2; i++) {
-        m_pRenderTexture2D[i]->Release();
+    // Pace to the outputs.
+    SetFrameRate();
+
+    for (auto& capture : m_captures) {
+        // Initialize compute passes for downscaling and conversion.
+        capture->scaler.CreateDeviceResources(device);
+        CreateInterpolator(*capture);
     }
-    m_texture->Release();
-    m_textureDesktop->Release();
+    TrimTexturePool();
+
+    // Every output starts with an equal share; its costs are learnt as it is interpolated.
+    m_scheduler = DX::CaptureScheduler(m_captures.size());
+    m_interpolatePlan.clear();
 }
 
-void Game::OnDeviceRestored()
+// Stand in for each output of monitorIndices with one recovering as if it had been unplugged, when not
+// even the outputs that were captured before can be captured again. RecoverCaptures rebuilds each one,
+// ring and interpolator included, once its output can be duplicated; until then it shows nothing.
+void Game::CreateRecoveringCaptures()
 {
-    CreateDeviceDependentResources();
-
-    CreateWindowSizeDependentResources();
+    ReleaseCaptures();
+    auto device = m_deviceResources->GetD3DDevice();
+    for (UINT index : monitorIndices) {
+        auto capture = std::make_unique<OutputCapture>();
+        capture->outputIndex = index;
+        capture->width = 0;                 // No ring yet, so the rebuild creates one at the output's size.
+        capture->height = 0;
+        capture->recovery.OnFault(DX::CaptureFault::OutputGone, DX::HudSeconds());
+        capture->scaler.CreateDeviceResources(device);
+        m_captures.push_back(std::move(capture));
+    }
+    m_activeCapture = std::min(m_activeCapture, m_captures.size() - 1);
+    BuildDesktopLayout();
+    m_scheduler = DX::CaptureScheduler(m_captures.size());
+    m_interpolatePlan.clear();
 }
-#pragma endregion
 
-// Interpolation loop.
-void Game::InterpolateFrame()
-{    
-    // Copy the last texture to the render texture.
-    {
-        auto context = m_deviceResources->GetD3DDeviceContext();
-        context->CopySubresourceRegion(lastFrame, 0, 0, 0, 0, m_pRenderTexture2D[lastRenderIndex], 0, nullptr);
+// Release every output's interpolator, scaler and duplication session.
+void Game::ReleaseCaptures()
+{
+    for (auto& capture : m_captures) {
+        ReleaseInterpolator(*capture);
+        capture->scaler.ReleaseResources();
+        if (capture->output) capture->output->Release();
+        if (capture->output1) capture->output1->Release();
+        if (capture->duplication) capture->duplication->Release();
     }
-
-    // Parameter for input.
-    bool repeated;
-    NvOFFRUC_PROCESS_IN_PARAMS stInParams = { 0 };
-    stInParams.stFrameDataInput.pFrame = m_pRenderTexture2D[currRenderIndex];
-    stInParams.stFrameDataInput.nTimeStamp = m_dLastRenderTime + m_constdRenderInterval;
-    m_dLastRenderTime = m_dLastRenderTime + m_constdRenderInterval;
-    stInParams.stFrameDataInput.nCuSurfacePitch = desktop_width * 4;
-    stInParams.uSyncWait.FenceWaitValue.uiFenceValueToWaitOn = m_uiFenceValue;
-    
-	// Parameter for output.
-    NvOFFRUC_PROCESS_OUT_PARAMS stOutParams = { 0 };
-    stOutParams.stFrameDataOutput.pFrame = m_pInterpolateTexture2D[0];
-    stOutParams.stFrameDataOutput.nTimeStamp = m_dLastRenderTime + (0.f - float(m_constdRenderInterval)) * 0.5;
-    stOutParams.stFrameDataOutput.bHasFrameRepetitionOccurred = &repeated;
-    stOutParams.stFrameDataOutput.nCuSurfacePitch = desktop_width * 4;
-    stOutParams.uSyncSignal.FenceSignalValue.uiFenceValueToSignalOn = ++m_uiFenceValue;
-    
-	// Call NvOFFRUC to interpolate.
-    auto status = NvOFFRUCProcess(hFRUC,&stInParams,&stOutParams);
+    m_captures.clear();
+    m_interpolatePlan.clear();
+    m_texture = nullptr;
 }
 
-// Initialize all textures.
-void Game::CreateTextureBuffer()
+// Duplicate the output, in its HDR format if it has one: DuplicateOutput1 hands over scRGB frames of an
+// HDR desktop where DuplicateOutput only has them tone-mapped to BGRA. It needs Windows 10 1703 and a
+// per-monitor DPI aware process, so the older call is made when it fails.
+HRESULT Game::DuplicateCapture(OutputCapture& capture)
 {
     auto device = m_deviceResources->GetD3DDevice();
-    
-    // Initialize texture description.
-    D3D11_TEXTURE2D_DESC desc = { 0 };
-    ZeroMemory(&desc, sizeof(desc));
-    desc.Width = desktop_width;
-    desc.Height = desktop_height;
-    desc.MipLevels = 1;
-    desc.ArraySize = 1;
-    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    desc.SampleDesc.Count = 1;
-    desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
-    desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
-    
-	// Create texture for NvOFFRUC.
-    for (int i = 0; i < 2; i++) {
-       device->CreateTexture2D(&desc, NULL, &m_pRenderTexture2D[i]);
+    IDXGIOutput5* output5 = nullptr;
+    if (SUCCEEDED(capture.output->QueryInterface(__uuidof(IDXGIOutput5), (void**)&output5))) {
+        const DXGI_FORMAT formats[] = { DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM };
+        const HRESULT hr = output5->DuplicateOutput1(device, 0, static_cast<UINT>(std::size(formats)), formats, &capture.duplication);
+        output5->Release();
+        if (SUCCEEDED(hr)) return hr;
+        capture.duplication = nullptr;
     }
-    for (int i = 0; i < 1; i++) {
-        device->CreateTexture2D(&desc, NULL, &m_pInterpolateTexture2D[i]);
-    }
-    
-    // Create texture for duplication and rendering.
-    device->CreateTexture2D(&desc, NULL, &lastFrame);
-    device->CreateTexture2D(&desc, NULL, &renderTargetTexture);
+    return capture.output1->DuplicateOutput(device, &capture.duplication);
 }
 
-// Code from NvOFFRUCSample to get resources.
-void Game::GetResource(void** ppTexture)
+// Take the output's mode as duplication reports it: its image size, rotation and refresh rate, and the
+// SDR white level Windows has for it.
+void Game::SetCaptureMode(OutputCapture& capture, const DXGI_OUTDUPL_DESC& desc)
 {
-    for (uint32_t i = 0; i < 1; i++)
-    {
-        if (m_pInterpolateTexture2D[i])
-        {
-            ppTexture[i] = m_pInterpolateTexture2D[i];
-        }
-    }
-    ppTexture = ppTexture + 1;
-    for (uint32_t i = 0; i < 2; i++)
+    capture.captureWidth = desc.ModeDesc.Width;
+    capture.captureHeight = desc.ModeDesc.Height;
+    capture.rotation = desc.Rotation;
+    capture.region.Reset(desc.ModeDesc.Width, desc.ModeDesc.Height);
+    if (desc.ModeDesc.RefreshRate.Denominator != 0 && desc.ModeDesc.RefreshRate.Numerator != 0)
+        capture.refreshRate = desc.ModeDesc.RefreshRate.Numerator / (double)desc.ModeDesc.RefreshRate.Denominator;
+    DXGI_OUTPUT_DESC outputDesc = {};
+    if (capture.output && SUCCEEDED(capture.output->GetDesc(&outputDesc))) capture.sdrWhiteNits = QuerySdrWhiteNits(outputDesc.DeviceName);
+}
+
+// Where SDR white sits in the output's HDR frames: sdrWhiteNits when set, otherwise the output's level in Windows.
+float Game::SdrWhiteNits(const OutputCapture& capture) const
+{
+    return sdrWhiteNits > 0 ? float(sdrWhiteNits) : capture.sdrWhiteNits;
+}
+
+// Rebuild what each failing output needs once it is due: its session, or the output and, if its size
+// changed, its ring and interpolator. The other outputs keep capturing, and a failing one keeps showing
+// its last good frame. Only a removed device takes everything down.
+void Game::RecoverCaptures()
+{
+    const double now = DX::HudSeconds();
+    bool placed = false;
+    for (auto& capture : m_captures) {
+        // A frame held over a rebuild is let go once the output shows a new one.
+        if (capture->heldFrame && capture->shown != capture->heldFrame.Get()) capture->heldFrame.Reset();
+
+        const DX::RecoveryLayer layer = capture->recovery.Due(now);
+        if (layer == DX::RecoveryLayer::None) continue;
+        if (layer == DX::RecoveryLayer::Device) {
+            DX_LOG_ERROR("Capture: output %u lost the device; re-creating every resource", capture->outputIndex);
+            m_deviceResources->HandleDeviceLost();
+            return;
+        }
+
+        DX_TRACE_SPAN("RecoverCapture");
+        const DX::CaptureFault result = layer == DX::RecoveryLayer::Duplication ? RecreateDuplication(*capture) : RecreateOutput(*capture);
+        capture->recovery.OnRebuilt(result, now);
+        if (capture->recovery.Recovering()) {
+            DX_LOG_DEBUG("Capture: rebuilding the %s of output %u failed with %s; next the %s", DX::RecoveryLayerName(layer), capture->outputIndex,
+                DX::CaptureFaultName(result), DX::RecoveryLayerName(capture->recovery.Pending()));
+            continue;
+        }
+        m_metrics.captureRecoveries->Increment();
+        placed = placed || layer == DX::RecoveryLayer::Output;
+        DX_LOG_INFO("Capture: output %u recovered after %.0f ms by rebuilding its %s", capture->outputIndex,
+            1000.0 * capture->recovery.LastRecoverySeconds(), DX::RecoveryLayerName(layer));
+    }
+    if (placed) PlaceOutputs();
+}
+
+// Re-create only the output's duplication session. One that comes back at another mode needs the output
+// rebuilt at its new size.
+DX::CaptureFault Game::RecreateDuplication(OutputCapture& capture)
+{
+    if (capture.duplication) capture.duplication->Release();
+    capture.duplication = nullptr;
+    const HRESULT hr = DuplicateCapture(capture);
+    if (FAILED(hr)) {
+        capture.duplication = nullptr;
+        return DX::ClassifyCaptureResult(hr);
+    }
+
+    DXGI_OUTDUPL_DESC desc = {};
+    capture.duplication->GetDesc(&desc);
+    if (int(desc.ModeDesc.Width) != capture.captureWidth || int(desc.ModeDesc.Height) != capture.captureHeight || desc.Rotation != capture.rotation)
+        return DX::CaptureFault::ModeChanged;
+    return DX::CaptureFault::None;
+}
+
+// Find the output again by its index and duplicate it at whatever mode it has now. The ring and
+// interpolator are only re-created if the crop changed size, and the last frame stays on screen until
+// the new ring has one.
+DX::CaptureFault Game::RecreateOutput(OutputCapture& capture)
+{
+    if (capture.duplication) capture.duplication->Release();
+    if (capture.output1) capture.output1->Release();
+    if (capture.output) capture.output->Release();
+    capture.duplication = nullptr;
+    capture.output1 = nullptr;
+    capture.output = nullptr;
+
+    // An output that was plugged in again only shows up in a new factory.
+    if (!factory->IsCurrent()) {
+        adapter->Release();
+        factory->Release();
+        CreateDXGIFactory1(__uuidof(IDXGIFactory1), (void**)&factory);
+        factory->EnumAdapters1(0, &adapter);
+    }
+    if (FAILED(adapter->EnumOutputs(capture.outputIndex, &capture.output))) {
+        capture.output = nullptr;
+        return DX::CaptureFault::OutputGone;
+    }
+    capture.output->QueryInterface(__uuidof(IDXGIOutput1), (void**)&capture.output1);
+    const HRESULT hr = DuplicateCapture(capture);
+    if (FAILED(hr)) {
+        capture.duplication = nullptr;
+        return DX::ClassifyCaptureResult(hr);
+    }
+
+    DXGI_OUTDUPL_DESC desc = {};
+    capture.duplication->GetDesc(&desc);
+    const double refreshRate = capture.refreshRate;
+    SetCaptureMode(capture, desc);
+    BuildDesktopLayout();
+    capture.region.Update(WantedRegion(capture));
+    if (RingSize(capture.region.Width(), resFactor, internalFormat) != capture.width || RingSize(capture.region.Height(), resFactor, internalFormat) != capture.height) {
+        capture.heldFrame = capture.shown;
+        ResizeCapture(capture);
+        capture.shown = capture.heldFrame.Get();
+    }
+    if (capture.refreshRate != refreshRate && &capture == m_captures[0].get()) SetFrameRate();
+    DX_LOG_INFO("Capture: output %u is now %dx%d at %.2f Hz", capture.outputIndex, capture.captureWidth, capture.captureHeight, capture.refreshRate);
+    return DX::CaptureFault::None;
+}
+
+// Allocate all memory resources that change on a window SizeChanged event.
+void Game::CreateWindowSizeDependentResources()
+{
+    PlaceOutputs();
+}
+
+// Lay the visible outputs out in the window: the active one alone, keeping its aspect ratio, or every
+// output in a grid of tiles. Each output's desktop-to-viewer mapping follows its own tile.
+void Game::PlaceOutputs()
+{
+    RECT size = m_deviceResources->GetOutputSize();
+    const double width = double(size.right - size.left);
+    const double height = double(size.bottom - size.top);
+
+    for (size_t i = 0; i < m_captures.size(); i++) {
+        OutputCapture& capture = *m_captures[i];
+        capture.visible = tileOutputs || i == m_activeCapture;
+        if (!capture.visible) continue;
+
+        // The region's crop of the captured pixels is downscaled to the output's texture, which is drawn at
+        // screenPos and scaleFactor.
+        const DX::ViewerRect tile = tileOutputs ? DX::TileRect(i, m_captures.size(), width, height) : DX::ViewerRect{ 0.0, 0.0, width, height };
+        const DX::Affine2D imageToViewer = DX::FitImage(capture.width, capture.height, tile);
+        capture.scaleFactor = { float(imageToViewer.xx), float(imageToViewer.yy) };
+        capture.screenPos = { float(imageToViewer.tx), float(imageToViewer.ty) };
+        if (capture.layoutIndex != DX::DesktopLayout::NoOutput)
+            m_desktopLayout.SetImageToViewer(capture.layoutIndex, DX::Affine2D::Translation(-capture.region.Crop().left, -capture.region.Crop().top)
+                .Then(DX::Affine2D::Scale(double(capture.width) / capture.region.Width(), double(capture.height) / capture.region.Height()))
+                .Then(imageToViewer));
+    }
+}
+
+void Game::OnDeviceLost()
+{
+    
+	// Release all resources.
+
+    // Release desktop duplication resources, and each output's NvOFFRUC instance and fence.
+    ReleaseCaptures();
+    factory->Release();
+    adapter->Release();
+    
+	// Release NvOFFRUC resources.
+    m_captureTimeline.reset();
+    CloseHandle(m_hCaptureFenceEvent);
+    m_hCaptureFenceEvent = NULL;
+    m_pCaptureFence->Release();
+    m_pDevice5->Release();
+    m_pDeviceContext4->Release();
+    
+    // Release the pool that owned the texture buffers.
+    m_texturePool.reset();
+    m_hudRenderer.ReleaseResources();
+    m_cursorCache.Clear();
+    m_cursorTextures = {};
+    m_cursorXorBlend.Reset();
+    m_presentConvertPS.Reset();
+    m_presentNv12PS.Reset();
+    m_presentConvertConstants.Reset();
+
+    // Whatever was read back so far stays in the file; consumers see the publisher close.
+    if (m_recorder) StopRecording();
+    if (m_framePublisher) ToggleFramePublisher();
+}
+
+void Game::OnDeviceRestored()
+{
+    CreateDeviceDependentResources();
+
+    CreateWindowSizeDependentResources();
+}
+#pragma endregion
+
+// Interpolate the visible outputs the scheduler picks for this round, within the share of the round
+// interpolationBudget allows, and pass the others' new frames through as they are.
+void Game::InterpolateOutputs()
+{
+    if (m_backend == InterpolatorBackend::PassThrough) {
+        m_interpolatePlan.clear();
+        for (auto& capture : m_captures) {
+            if (capture->visible) SkipInterpolation(*capture);
+        }
+        return;
+    }
+
+    const double budgetSeconds = 2.0 * frametime * interpolationBudget;
+    for (size_t i = 0; i < m_captures.size(); i++) {
+        m_scheduler.SetWork(i, m_captures[i]->visible && m_captures[i]->ring.HasReady());
+    }
+    m_interpolatePlan = m_scheduler.Plan({ budgetSeconds, budgetSeconds });
+
+    for (size_t index : m_interpolatePlan) {
+        OutputCapture& capture = *m_captures[index];
+        capture.submittedSeconds = DX::HudSeconds();
+        InterpolateFrame(capture);
+        capture.submitCpuSeconds = DX::HudSeconds() - capture.submittedSeconds;
+    }
+    for (size_t i = 0; i < m_captures.size(); i++) {
+        if (m_captures[i]->visible && std::find(m_interpolatePlan.begin(), m_interpolatePlan.end(), i) == m_interpolatePlan.end())
+            SkipInterpolation(*m_captures[i]);
+    }
+}
+
+// Interpolation loop.
+void Game::InterpolateFrame(OutputCapture& capture)
+{    
+    DX_TRACE_SPAN("InterpolateFrame");
+
+    // Without an interpolator for its size and format, the output's frames pass through.
+    if (capture.fruc == nullptr && !capture.cpuInterpolator) {
+        SkipInterpolation(capture);
+        return;
+    }
+
+    // Take the oldest captured frame.
+    const int slot = capture.ring.AcquireForInterpolation();
+    if (slot == DX::CaptureRing::InvalidSlot) return;
+
+    bool repeated = false;
+    if (capture.cpuInterpolator) InterpolateOnCpu(capture, slot, &repeated);
+    else if (!InterpolateWithFruc(capture, slot, &repeated)) {
+        PassThroughSlot(capture, slot);
+        return;
+    }
+    capture.failedInterpolations = 0;
+    m_hud.OnInterpolated(repeated);
+    if (repeated) m_metrics.repeatedFrames->Increment();
+    capture.interpolatedSourceTicks = capture.slotSourceTicks[slot];
+    capture.shown = capture.interpolateSRV;
+    capture.shownSourceTicks = capture.interpolatedSourceTicks;
+
+    // The previous frame is shown next and retired once it has been presented.
+    capture.ring.EndInterpolation(slot, capture.interpolatedFenceValue);
+    if (capture.presentSlot != DX::CaptureRing::InvalidSlot) capture.ring.Retire(capture.presentSlot);
+    capture.presentSlot = capture.previousSlot;
+    capture.previousSlot = slot;
+}
+
+// Submit the slot to the output's NvOFFRUC instance, which signals the output's fence once the frame is
+// ready. Returns false, with the fence value signalled anyway, if NvOFFRUC refused the frame.
+bool Game::InterpolateWithFruc(OutputCapture& capture, int slot, bool* repeated)
+{
+    // Parameter for input.
+    NvOFFRUC_PROCESS_IN_PARAMS stInParams = { 0 };
+    stInParams.stFrameDataInput.pFrame = capture.renderTextures[slot];
+    stInParams.stFrameDataInput.nTimeStamp = capture.lastRenderTime + m_constdRenderInterval;
+    capture.lastRenderTime = capture.lastRenderTime + m_constdRenderInterval;
+    stInParams.stFrameDataInput.nCuSurfacePitch = capture.width * DX::PixelFormatBytes(capture.format);
+
+    // NvOFFRUC waits and signals on the output's fence only, so the slot's capture is handed over on it: the
+    // immediate context signals the next value once the slot's conversion has landed, and NvOFFRUC waits for
+    // just that. The output's previous interpolation lands first so the fence only moves forwards; the
+    // presenter has normally waited for it already.
+    D3D11FenceTimeline& timeline = *capture.fenceTimeline;
+    timeline.WaitFor(capture.interpolatedFenceValue);
+    const uint64_t capturedValue = timeline.Signal();
+    m_pDeviceContext4->Signal(capture.fence, capturedValue);
+    m_pDeviceContext4->Flush();     // NvOFFRUC waits from another queue, so the signal can't sit in the context's buffer.
+    stInParams.uSyncWait.FenceWaitValue.uiFenceValueToWaitOn = capturedValue;
+    
+	// Parameter for output.
+    NvOFFRUC_PROCESS_OUT_PARAMS stOutParams = { 0 };
+    stOutParams.stFrameDataOutput.pFrame = capture.interpolateTexture;
+    stOutParams.stFrameDataOutput.nTimeStamp = capture.lastRenderTime + (0.f - float(m_constdRenderInterval)) * 0.5;
+    stOutParams.stFrameDataOutput.bHasFrameRepetitionOccurred = repeated;
+    stOutParams.stFrameDataOutput.nCuSurfacePitch = capture.width * DX::PixelFormatBytes(capture.format);
+    capture.interpolatedFenceValue = timeline.Signal();
+    stOutParams.uSyncSignal.FenceSignalValue.uiFenceValueToSignalOn = capture.interpolatedFenceValue;
+    
+	// Call NvOFFRUC to interpolate.
+    const auto status = NvOFFRUCProcess(capture.fruc,&stInParams,&stOutParams);
+    if (status != NvOFFRUC_SUCCESS) {
+        // The value is already handed out; signal it behind the handover so nothing waiting on it hangs.
+        m_pDeviceContext4->Signal(capture.fence, capture.interpolatedFenceValue);
+        if (capture.failedInterpolations++ == 0)
+            DX_LOG_WARNING("Interpolation: NvOFFRUCProcess failed on output %u (status %d); showing its frames as captured", capture.outputIndex, static_cast<int>(status));
+        return false;
+    }
+    return true;
+}
+
+// Move a frame the scheduler had no budget for through the ring as if it had been interpolated, so the
+// output keeps up; it shows its previous frame in place of an interpolated one.
+void Game::SkipInterpolation(OutputCapture& capture)
+{
+    const int slot = capture.ring.AcquireForInterpolation();
+    if (slot == DX::CaptureRing::InvalidSlot) return;
+    PassThroughSlot(capture, slot);
+}
+
+// Move a slot taken for interpolation on to be presented as it was captured.
+void Game::PassThroughSlot(OutputCapture& capture, int slot)
+{
+    capture.ring.EndInterpolation(slot, capture.ring.GetFenceValue(slot));
+    if (capture.presentSlot != DX::CaptureRing::InvalidSlot) capture.ring.Retire(capture.presentSlot);
+    capture.presentSlot = capture.previousSlot;
+    capture.previousSlot = slot;
+    if (capture.presentSlot != DX::CaptureRing::InvalidSlot) {
+        capture.shown = capture.renderSRV[capture.presentSlot];
+        capture.shownSourceTicks = capture.slotSourceTicks[capture.presentSlot];
+    }
+}
+
+// Create the output's ring at its current size, and the interpolator of the current backend for it.
+void Game::CreateInterpolator(OutputCapture& capture)
+{
+	// Create textures and the fence for NvOFFRUC.
+    CreateTextureBuffer(capture);
+    CreateOutputFence(capture);
+    capture.interpolatedFenceValue = 0;
+    capture.lastRenderTime = 0;
+
+    if (m_backend == InterpolatorBackend::NvOFFRUC && FrucTakes(capture.format)) CreateFruc(capture);
+    else if (m_backend != InterpolatorBackend::PassThrough) CreateCpuInterpolator(capture);
+}
+
+// Release the output's interpolator and hand its textures back to the pool. A load still running on
+// the worker may be registering them, so it is waited for.
+void Game::ReleaseInterpolator(OutputCapture& capture)
+{
+    FinishDeferredLoad(true);
+    ReleaseFruc(capture);
+    ReleaseCpuInterpolator(capture);
+    ReleaseOutputFence(capture);
+
+    // Release texture buffers.
+    ReleaseTextureBuffer(capture);
+}
+
+// The output's fence starts again from zero with each interpolator, as its NvOFFRUC instance does.
+void Game::CreateOutputFence(OutputCapture& capture)
+{
+    DX::ThrowIfFailed(m_pDevice5->CreateFence(0, D3D11_FENCE_FLAG_SHARED, IID_PPV_ARGS(&capture.fence)));
+    capture.fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    capture.fenceTimeline = std::make_unique<D3D11FenceTimeline>(D3D11FenceAdapter{ capture.fence, capture.fenceEvent });
+}
+
+void Game::ReleaseOutputFence(OutputCapture& capture)
+{
+    capture.fenceTimeline.reset();
+    if (capture.fenceEvent != NULL) CloseHandle(capture.fenceEvent);
+    capture.fenceEvent = NULL;
+    if (capture.fence != nullptr) capture.fence->Release();
+    capture.fence = nullptr;
+}
+
+// Block until the GPU is done with every capture and interpolation submitted so far, before what they use
+// is released. The capture fence's signals may still be buffered in the immediate context, so it is flushed.
+void Game::WaitForGpu()
+{
+    m_deviceResources->GetD3DDeviceContext()->Flush();
+    m_captureTimeline->WaitFor(m_captureTimeline->LastSignaled());
+    for (auto& capture : m_captures) {
+        if (capture->fenceTimeline) capture->fenceTimeline->WaitFor(capture->fenceTimeline->LastSignaled());
+    }
+}
+
+// Create the output's NvOFFRUC instance at its ring's size and register the ring with it, which must be
+// rgba8 or nv12. Runs on the worker during startup. Returns false if NvOFFRUC refuses either.
+bool Game::CreateFruc(OutputCapture& capture)
+{
+	// Create NvOFFRUC instance.
+    NvOFFRUC_CREATE_PARAM createParams = { 0 };
+    createParams.pDevice = m_deviceResources->GetD3DDevice();
+    createParams.uiHeight = capture.height;
+    createParams.uiWidth = capture.width;
+    createParams.eResourceType = DirectX11Resource;
+    createParams.eSurfaceFormat = capture.format == DX::PixelFormat::Nv12 ? NV12Surface : ARGBSurface;
+    createParams.eCUDAResourceType = CudaResourceCuDevicePtr;
+    auto status = NvOFFRUCCreate(&createParams,&capture.fruc);
+    if (status != NvOFFRUC_SUCCESS) {
+        capture.fruc = {};
+        return false;
+    }
+
+	// Register resource to NvOFFRUC.
+    NvOFFRUC_REGISTER_RESOURCE_PARAM registered = { 0 };
+    GetResource(capture, registered.pArrResource);
+    registered.uiCount = static_cast<uint32_t>(1 + capture.renderTextures.size());
+    registered.pD3D11FenceObj = capture.fence;
+    status = NvOFFRUCRegisterResource(capture.fruc,&registered);
+    if (status != NvOFFRUC_SUCCESS) {
+        NvOFFRUCDestroy(capture.fruc);
+        capture.fruc = {};
+        return false;
+    }
+    capture.registered = registered;
+    return true;
+}
+
+// Unregister the output's textures from its NvOFFRUC instance and destroy it.
+void Game::ReleaseFruc(OutputCapture& capture)
+{
+    if (capture.fruc == nullptr) return;
+
+	// Unregister textures from NvOFFRUC.
+    NvOFFRUC_UNREGISTER_RESOURCE_PARAM stUnregisterResourceParam = { 0 };
+    memcpy(stUnregisterResourceParam.pArrResource,capture.registered.pArrResource,capture.registered.uiCount * sizeof(IUnknown*));
+    stUnregisterResourceParam.uiCount = capture.registered.uiCount;
+    auto status = NvOFFRUCUnregisterResource(capture.fruc,&stUnregisterResourceParam);
+    
+	// Destroy NvOFFRUC instance.
+    NvOFFRUCDestroy(capture.fruc);
+    capture.fruc = {};
+    capture.registered = { 0 };
+}
+
+// The CPU interpolator reads each frame back through a staging texture and uploads its result.
+void Game::CreateCpuInterpolator(OutputCapture& capture)
+{
+    // Outputs are interpolated one after another on the render thread, so each splits its rows over
+    // every thread of the pool they share.
+    DX::CpuInterpolatorSettings settings;
+    settings.threads = DX::WorkerPool::Shared().Concurrency();
+    settings.format = capture.format;
+    capture.cpuInterpolator = std::make_unique<DX::CpuFrameInterpolator>(settings);
+    capture.cpuOutput.Resize(capture.width, DX::PixelFormatRows(capture.format, capture.height), DX::PixelFormatBytes(capture.format));
+
+    CD3D11_TEXTURE2D_DESC desc(static_cast<DXGI_FORMAT>(DX::PixelFormatDxgi(capture.format)), capture.width, capture.height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+    if (FAILED(m_deviceResources->GetD3DDevice()->CreateTexture2D(&desc, nullptr, &capture.cpuStaging))) {
+        DX_LOG_ERROR("Interpolator: could not create a %dx%d staging texture; output %u passes frames through", capture.width, capture.height, capture.outputIndex);
+        capture.cpuInterpolator.reset();
+    }
+}
+
+void Game::ReleaseCpuInterpolator(OutputCapture& capture)
+{
+    if (capture.cpuStaging != nullptr) capture.cpuStaging->Release();
+    capture.cpuStaging = nullptr;
+    capture.cpuInterpolator.reset();
+}
+
+// Interpolate on the CPU: read the slot back, blend it with the previous frame and upload the result.
+// Reading back waits for the GPU, so this is much slower than NvOFFRUC and only a fallback.
+void Game::InterpolateOnCpu(OutputCapture& capture, int slot, bool* repeated)
+{
+    DX_TRACE_SPAN("InterpolateOnCpu");
+    auto context = m_deviceResources->GetD3DDeviceContext();
+    context->CopyResource(capture.cpuStaging, capture.renderTextures[slot]);
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    if (SUCCEEDED(context->Map(capture.cpuStaging, 0, D3D11_MAP_READ, 0, &mapped))) {
+        // nv12 maps as its luma rows with the chroma rows below, as the interpolator takes it.
+        const DX::ConstImageView frame = { static_cast<const uint8_t*>(mapped.pData), uint32_t(capture.width),
+            DX::PixelFormatRows(capture.format, uint32_t(capture.height)), size_t(mapped.RowPitch) };
+        capture.lastRenderTime = capture.lastRenderTime + m_constdRenderInterval;
+        capture.cpuInterpolator->Process(frame, capture.lastRenderTime, capture.cpuOutput.View(), repeated);
+        context->Unmap(capture.cpuStaging, 0);
+        context->UpdateSubresource(capture.interpolateTexture, 0, nullptr, capture.cpuOutput.Data(), static_cast<UINT>(capture.cpuOutput.Pitch()), 0);
+    }
+    capture.interpolatedFenceValue = capture.fenceTimeline->Signal();
+    m_pDeviceContext4->Signal(capture.fence, capture.interpolatedFenceValue);
+}
+
+// Load NvOFFRUC.dll and create every output's instance, and load default.png, on a worker so the first
+// frames pass through without waiting for them. Only the returned load is touched by the render thread.
+void Game::StartDeferredLoad()
+{
+    std::vector<OutputCapture*> captures;
+    for (auto& capture : m_captures) captures.push_back(capture.get());
+
+    m_deferredLoad = std::async(std::launch::async, [this, captures]() {
+        DX::SetTraceThreadName("Startup");
+        DX_TRACE_SPAN("DeferredLoad");
+        const double start = DX::HudSeconds();
+        DeferredLoad load;
+
+        // WIC needs COM on this thread too.
+        if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            if (FAILED(CreateWICTextureFromFile(m_deviceResources->GetD3DDevice(), L"default.png", nullptr, load.cursor.GetAddressOf())))
+                DX_LOG_WARNING("Startup: could not load default.png; the cursor shows once Desktop Duplication reports its shape");
+            CoUninitialize();
+        }
+
+        // Load NvOFFRUC dll.
+        HMODULE hDLL = LoadLibrary("NvOFFRUC.dll");
+        if (hDLL == nullptr) {
+            load.error = "NvOFFRUC.dll could not be loaded";
+            load.seconds = DX::HudSeconds() - start;
+            return load;
+        }
+        NvOFFRUCCreate = (PtrToFuncNvOFFRUCCreate)GetProcAddress(hDLL,CreateProcName);
+        NvOFFRUCRegisterResource = (PtrToFuncNvOFFRUCRegisterResource)GetProcAddress(hDLL,RegisterResourceProcName);
+        NvOFFRUCUnregisterResource =(PtrToFuncNvOFFRUCUnregisterResource)GetProcAddress(hDLL,UnregisterResourceProcName);
+        NvOFFRUCProcess = (PtrToFuncNvOFFRUCProcess)GetProcAddress(hDLL,ProcessProcName);
+        NvOFFRUCDestroy = (PtrToFuncNvOFFRUCDestroy)GetProcAddress(hDLL,DestroyProcName);
+        if (!NvOFFRUCCreate || !NvOFFRUCRegisterResource || !NvOFFRUCUnregisterResource || !NvOFFRUCProcess || !NvOFFRUCDestroy) {
+            load.error = "NvOFFRUC.dll is missing entry points";
+            load.seconds = DX::HudSeconds() - start;
+            return load;
+        }
+
+        // All or nothing, so every output interpolates the same way; outputs in formats NvOFFRUC can't
+        // take are left to the CPU.
+        load.interpolatorReady = true;
+        for (OutputCapture* capture : captures) {
+            if (!FrucTakes(capture->format)) continue;
+            if (!CreateFruc(*capture)) {
+                load.error = "NvOFFRUC could not be created for output " + std::to_string(capture->outputIndex);
+                load.interpolatorReady = false;
+                break;
+            }
+        }
+        if (!load.interpolatorReady) {
+            for (OutputCapture* capture : captures) ReleaseFruc(*capture);
+        }
+        load.seconds = DX::HudSeconds() - start;
+        return load;
+    });
+}
+
+// Switch to the backend the worker settled on once it is done; with wait set, block until it is.
+// Returns true while there is nothing left to wait for.
+bool Game::FinishDeferredLoad(bool wait)
+{
+    if (!m_deferredLoad.valid()) return true;
+    if (!wait && m_deferredLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+
+    DeferredLoad load = m_deferredLoad.get();
+    if (load.cursor) m_textureCursor = load.cursor;
+    if (load.interpolatorReady) {
+        m_backend = InterpolatorBackend::NvOFFRUC;
+        DX_LOG_INFO("Startup: NvOFFRUC ready after %.0f ms on the worker", 1000.0 * load.seconds);
+        for (auto& capture : m_captures) {
+            if (capture->fruc != nullptr) continue;
+            DX_LOG_INFO("Startup: NvOFFRUC takes only rgba8 and nv12; output %u interpolates %s on the CPU", capture->outputIndex, DX::PixelFormatName(capture->format));
+            CreateCpuInterpolator(*capture);
+        }
+    }
+    else {
+        m_backend = InterpolatorBackend::Cpu;
+        DX_LOG_ERROR("Startup: %s; interpolating on the CPU instead, which is much slower", load.error);
+        for (auto& capture : m_captures) CreateCpuInterpolator(*capture);
+    }
+    for (auto& capture : m_captures) capture->lastRenderTime = 0;
+    return true;
+}
+
+// The region of interest on an output, in its image pixels: the tracked window's bounds or roiRect.
+// Empty for the whole output.
+DX::DesktopRect Game::WantedRegion(const OutputCapture& capture)
+{
+    if (!useRegion || capture.layoutIndex == DX::DesktopLayout::NoOutput) return {};
+
+    DX::DesktopRect desktop = roiRect;
+    if (!roiWindowTitle.empty()) {
+        // Look the window up again at most once a second while it is missing.
+        const double now = DX::HudSeconds();
+        if (!IsWindow(m_roiWindow) && now - m_roiWindowSearchSeconds >= 1.0) {
+            m_roiWindowSearchSeconds = now;
+            m_roiWindow = FindWindowA(nullptr, roiWindowTitle.c_str());
+            if (m_roiWindow != NULL) DX_LOG_INFO("Region: tracking window \"%s\"", roiWindowTitle);
+        }
+        RECT bounds;
+        if (!IsWindow(m_roiWindow) || IsIconic(m_roiWindow) || !GetWindowRect(m_roiWindow, &bounds)) return {};
+        desktop = { bounds.left, bounds.top, bounds.right, bounds.bottom };
+    }
+    return DX::DesktopToImageRect(m_desktopLayout.Output(capture.layoutIndex), desktop);
+}
+
+// Follow each output's region of interest. A crop that only moved changes a constant; one that changed
+// size class re-creates that output's interpolator and ring.
+void Game::UpdateRegions()
+{
+    bool moved = false;
+    for (auto& capture : m_captures) {
+        const DX::DesktopRect before = capture->region.Crop();
+        if (capture->region.Update(WantedRegion(*capture))) {
+            ResizeCapture(*capture);
+            moved = true;
+        }
+        const DX::DesktopRect& after = capture->region.Crop();
+        moved = moved || after.left != before.left || after.top != before.top;
+    }
+    if (moved) PlaceOutputs();
+}
+
+// Re-create the output's interpolator and ring at its crop's new size, once the GPU is done with the old ones.
+void Game::ResizeCapture(OutputCapture& capture)
+{
+    DX_TRACE_SPAN("ResizeCapture");
+    WaitForGpu();
+    ReleaseInterpolator(capture);
+    capture.width = RingSize(capture.region.Width(), resFactor, internalFormat);
+    capture.height = RingSize(capture.region.Height(), resFactor, internalFormat);
+    CreateInterpolator(capture);
+    TrimTexturePool();
+
+    const DX::DesktopRect& crop = capture.region.Crop();
+    DX_LOG_INFO("Region: output %u captures %dx%d at (%d, %d), interpolated at %dx%d", capture.outputIndex,
+        crop.Width(), crop.Height(), crop.left, crop.top, capture.width, capture.height);
+    if (&capture == m_captures[m_activeCapture].get()) {
+        desktop_width = capture.width;
+        desktop_height = capture.height;
+        if ((m_recorder || m_framePublisher) && (desktop_width != m_readbackWidth || desktop_height != m_readbackHeight))
+            DX_LOG_WARNING("Region: recording and shared output stay %dx%d; frames of this size are skipped", m_readbackWidth, m_readbackHeight);
+    }
+}
+
+// Switch between the region of interest and whole outputs.
+void Game::ToggleRegion()
+{
+    useRegion = !useRegion;
+    DX_LOG_INFO("Region: %s", useRegion ? "capturing the region of interest" : "capturing whole outputs");
+}
+
+// Initialize all textures.
+void Game::CreateTextureBuffer(OutputCapture& capture)
+{
+    // Hand any previous textures back so compatible ones are reused.
+    ReleaseTextureBuffer(capture);
+
+    capture.format = internalFormat;
+    const DX::TextureKey key = RingTextureKey(capture);
+
+	// Create texture for NvOFFRUC.
+    capture.renderTextures.resize(captureRingDepth);
+    for (auto& texture : capture.renderTextures) {
+        texture = m_texturePool->Acquire(key);
+    }
+    capture.ring.Reset(capture.renderTextures.size());
+    capture.reportedDroppedFrames = 0;
+    capture.slotSourceTicks.assign(capture.renderTextures.size(), 0);
+    capture.previousSlot = DX::CaptureRing::InvalidSlot;
+    capture.presentSlot = DX::CaptureRing::InvalidSlot;
+    capture.interpolateTexture = m_texturePool->Acquire(key);
+
+    // Create views once so neither capture nor present builds them per frame. nv12 has no view of the
+    // whole frame: its planes are viewed as R8 luma and R8G8 chroma at half size.
+    auto device = m_deviceResources->GetD3DDevice();
+    const bool planar = DX::PixelFormatPlanar(capture.format);
+    auto createSRV = [&](ID3D11Texture2D* texture, ID3D11ShaderResourceView** view) {
+        if (!planar) {
+            device->CreateShaderResourceView(texture, nullptr, view);
+            return;
+        }
+        CD3D11_SHADER_RESOURCE_VIEW_DESC lumaDesc(D3D11_SRV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8_UNORM);
+        CD3D11_SHADER_RESOURCE_VIEW_DESC chromaDesc(D3D11_SRV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8_UNORM);
+        ComPtr<ID3D11ShaderResourceView> chroma;
+        device->CreateShaderResourceView(texture, &lumaDesc, view);
+        device->CreateShaderResourceView(texture, &chromaDesc, chroma.GetAddressOf());
+        if (*view != nullptr && chroma) (*view)->SetPrivateDataInterface(ChromaViewGuid, chroma.Get());
+    };
+    capture.renderSRV.assign(capture.renderTextures.size(), nullptr);
+    capture.renderUAV.assign(capture.renderTextures.size(), nullptr);
+    capture.renderChromaUAV.assign(capture.renderTextures.size(), nullptr);
+    for (size_t i = 0; i < capture.renderTextures.size(); i++) {
+        createSRV(capture.renderTextures[i], &capture.renderSRV[i]);
+        if (planar) {
+            CD3D11_UNORDERED_ACCESS_VIEW_DESC lumaDesc(D3D11_UAV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8_UNORM);
+            CD3D11_UNORDERED_ACCESS_VIEW_DESC chromaDesc(D3D11_UAV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8_UNORM);
+            device->CreateUnorderedAccessView(capture.renderTextures[i], &lumaDesc, &capture.renderUAV[i]);
+            device->CreateUnorderedAccessView(capture.renderTextures[i], &chromaDesc, &capture.renderChromaUAV[i]);
+        }
+        else {
+            device->CreateUnorderedAccessView(capture.renderTextures[i], nullptr, &capture.renderUAV[i]);
+        }
+    }
+    createSRV(capture.interpolateTexture, &capture.interpolateSRV);
+    capture.shown = nullptr;
+
+    // Weight tables and intermediates for the capture scaler.
+    capture.scaler.Resize(device, capture.region.Width(), capture.region.Height(), capture.width, capture.height, scaleFilter);
+}
+
+// Describe the textures of the output's ring and interpolation target.
+DX::TextureKey Game::RingTextureKey(const OutputCapture& capture) const
+{
+    DX::TextureKey key;
+    key.width = capture.width;
+    key.height = capture.height;
+    key.format = static_cast<DXGI_FORMAT>(DX::PixelFormatDxgi(capture.format));
+    key.miscFlags = D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_NTHANDLE;
+    key.bindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+    return key;
+}
+
+// Return all textures to the pool.
+void Game::ReleaseTextureBuffer(OutputCapture& capture)
+{
+    if (!m_texturePool)
+        return;
+
+    auto release = [&](ID3D11Texture2D*& texture) {
+        if (texture != nullptr) m_texturePool->Release(texture);
+        texture = nullptr;
+    };
+    for (auto& texture : capture.renderTextures) release(texture);
+    release(capture.interpolateTexture);
+
+    auto releaseView = [](auto*& view) {
+        if (view != nullptr) view->Release();
+        view = nullptr;
+    };
+    for (auto& view : capture.renderSRV) releaseView(view);
+    for (auto& view : capture.renderUAV) releaseView(view);
+    for (auto& view : capture.renderChromaUAV) releaseView(view);
+    releaseView(capture.interpolateSRV);
+    capture.shown = nullptr;
+}
+
+// Once rings have been rebuilt, keep at most one ring's worth per output idle, so going back to the
+// previous size or format reuses its textures while older sizes are released first. Rings handed back
+// during the next rebuild may take the idle set to two rings per output before it is trimmed again.
+void Game::TrimTexturePool()
+{
+    uint64_t ringBytes = 0;
+    for (auto& capture : m_captures) {
+        if (capture->interpolateTexture == nullptr) continue;
+        ringBytes += (capture->renderTextures.size() + 1) * m_texturePool->GetAllocator().SizeInBytes(RingTextureKey(*capture));
+    }
+    m_texturePool->SetIdleBudget(2 * ringBytes);
+    m_texturePool->Trim(ringBytes);
+    m_metrics.texturePoolBytes->Set(static_cast<double>(m_texturePool->GetStats().residentBytes));
+
+#ifdef _DEBUG
+    ReportTexturePoolStats();
+#endif
+}
+
+// Switch to the next downscaling filter without touching the ring.
+void Game::CycleScaleFilter()
+{
+    scaleFilter = static_cast<DX::ScaleFilter>((static_cast<int>(scaleFilter) + 1) % static_cast<int>(DX::ScaleFilter::Count));
+    for (auto& capture : m_captures) {
+        capture->scaler.Resize(m_deviceResources->GetD3DDevice(), capture->region.Width(), capture->region.Height(), capture->width, capture->height, scaleFilter);
+    }
+
+    DX_LOG_INFO("Scale filter: %s", DX::ScaleFilterName(scaleFilter));
+}
+
+// Start recording trace spans, or stop and write them to the working directory.
+void Game::ToggleTrace()
+{
+    if (!DX::IsTraceEnabled()) {
+        DX::ClearTrace();
+        DX::SetTraceThreadName("Render");
+        DX::SetTraceEnabled(true);
+        DX_LOG_INFO("Trace started");
+        return;
+    }
+    DX::SetTraceEnabled(false);
+
+    const std::string path = TimestampedFileName("trace", "json");
+    size_t events = 0;
+    if (DX::WriteChromeTrace(path, &events))
+        DX_LOG_INFO("Trace: wrote %zu events to %s", events, path);
+    else
+        DX_LOG_ERROR("Trace: could not write %s", path);
+}
+
+// Start recording capture-to-photon latency, or stop and write the per-frame CSV and a summary.
+void Game::ToggleLatencyRecording()
+{
+    if (!m_latency.IsRecording()) {
+        m_latency.Start();
+        m_pointerTrace.clear();
+        DX_LOG_INFO("Latency recording started");
+        return;
+    }
+    m_latency.Stop();
+
+    const std::string path = TimestampedFileName("latency", "csv");
+    if (m_latency.WriteCsv(path))
+        DX_LOG_INFO("Latency: wrote %zu frames to %s", m_latency.Records().size(), path);
+    else
+        DX_LOG_ERROR("Latency: could not write %s", path);
+
+    // The pointer samples the cursor predictor saw, for replaying through cursorsim.
+    if (!m_pointerTrace.empty()) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        const std::string tracePath = TimestampedFileName("cursor", "csv");
+        if (DX::WritePointerTrace(tracePath, m_pointerTrace, static_cast<uint64_t>(frequency.QuadPart)))
+            DX_LOG_INFO("Latency: wrote %zu pointer samples to %s", m_pointerTrace.size(), tracePath);
+        else
+            DX_LOG_ERROR("Latency: could not write %s", tracePath);
+        m_pointerTrace.clear();
+    }
+
+    // One record per summary line; the whole summary would not fit in one.
+    std::istringstream summary(m_latency.Summary());
+    for (std::string line; std::getline(summary, line);)
+        DX_LOG_INFO("Latency: %s", line);
+}
+
+// Show or hide the cursor. Samples from before it was hidden say nothing about where it is going now.
+void Game::ToggleCursor()
+{
+    showCursor = !showCursor;
+    m_cursorPredictor.Reset();
+    DX_LOG_INFO("Cursor: %s", showCursor ? "shown" : "hidden");
+}
+
+// Rebuild the virtual desktop from every output on every adapter, and find the captured ones among them.
+void Game::BuildDesktopLayout()
+{
+    m_desktopLayout.Clear();
+    m_pointerOutput = DX::DesktopLayout::NoOutput;
+
+    // A fresh factory: the one duplication was created from keeps the adapter list it started with.
+    ComPtr<IDXGIFactory1> layoutFactory;
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(layoutFactory.GetAddressOf())))) return;
+    ComPtr<IDXGIAdapter1> layoutAdapter;
+    for (UINT adapterIndex = 0; SUCCEEDED(layoutFactory->EnumAdapters1(adapterIndex, layoutAdapter.ReleaseAndGetAddressOf())); ++adapterIndex) {
+        ComPtr<IDXGIOutput> output;
+        for (UINT outputIndex = 0; SUCCEEDED(layoutAdapter->EnumOutputs(outputIndex, output.ReleaseAndGetAddressOf())); ++outputIndex) {
+            DXGI_OUTPUT_DESC desc;
+            if (FAILED(output->GetDesc(&desc)) || !desc.AttachedToDesktop) continue;
+
+            std::string name;
+            for (const WCHAR* c = desc.DeviceName; *c != 0; ++c) name.push_back(static_cast<char>(*c));
+            const auto& r = desc.DesktopCoordinates;
+            const auto rotation = desc.Rotation <= DXGI_MODE_ROTATION_IDENTITY
+                ? DX::OutputRotation::Identity : static_cast<DX::OutputRotation>(desc.Rotation - DXGI_MODE_ROTATION_IDENTITY);
+            m_desktopLayout.AddOutput(reinterpret_cast<uintptr_t>(desc.Monitor), name, { r.left, r.top, r.right, r.bottom }, rotation);
+        }
+    }
+
+    // One record per output; the whole description would not fit in one.
+    std::istringstream outputs(m_desktopLayout.Describe());
+    for (std::string line; std::getline(outputs, line);)
+        DX_LOG_INFO("Desktop: %s", line);
+
+    for (auto& capture : m_captures) {
+        DXGI_OUTPUT_DESC captured = {};
+        capture->layoutIndex = DX::DesktopLayout::NoOutput;
+        if (capture->output && SUCCEEDED(capture->output->GetDesc(&captured)))
+            capture->layoutIndex = m_desktopLayout.FindOutputById(reinterpret_cast<uintptr_t>(captured.Monitor));
+        if (capture->layoutIndex == DX::DesktopLayout::NoOutput)
+            DX_LOG_WARNING("Desktop: captured output %u is not on the desktop; the cursor will not be drawn on it", capture->outputIndex);
+        else
+            DX_LOG_INFO("Desktop: capturing output %d", capture->layoutIndex);
+    }
+}
+
+// Top-left of an output on the virtual desktop, which duplication's pointer positions are relative to.
+DX::Point2D Game::OutputOrigin(int layoutIndex) const
+{
+    if (layoutIndex == DX::DesktopLayout::NoOutput) return {};
+    const DX::DesktopRect& bounds = m_desktopLayout.Output(layoutIndex).bounds;
+    return { double(bounds.left), double(bounds.top) };
+}
+
+// Show one output alone, or make it the one paced to and recorded when tiled. Its session and ring
+// kept running while it was hidden, so nothing is recreated.
+void Game::SelectOutput(size_t index)
+{
+    if (index >= m_captures.size() || index == m_activeCapture) return;
+
+    m_activeCapture = index;
+    OutputCapture& active = *m_captures[m_activeCapture];
+    desktop_width = active.width;
+    desktop_height = active.height;
+    PlaceOutputs();
+    DX_LOG_INFO("Output: showing output %u (%dx%d)", active.outputIndex, active.width, active.height);
+    if ((m_recorder || m_framePublisher) && (desktop_width != m_readbackWidth || desktop_height != m_readbackHeight))
+        DX_LOG_WARNING("Output: recording and shared output stay %dx%d; frames of this output are skipped", m_readbackWidth, m_readbackHeight);
+}
+
+// Switch between the active output alone and every output in a grid.
+void Game::ToggleTiling()
+{
+    tileOutputs = !tileOutputs;
+    PlaceOutputs();
+    DX_LOG_INFO("Output: %s", tileOutputs ? "tiling every output" : "showing the active output");
+}
+
+// Switch between drawing the newest pointer sample and the two predictors.
+void Game::CycleCursorPrediction()
+{
+    cursorPrediction = static_cast<DX::CursorPrediction>((static_cast<int>(cursorPrediction) + 1) % static_cast<int>(DX::CursorPrediction::Count));
+    m_cursorPredictor.SetPrediction(cursorPrediction);
+    DX_LOG_INFO("Cursor prediction: %s", DX::CursorPredictionName(cursorPrediction));
+}
+
+// Serve the metrics on 127.0.0.1:metricsPort/metrics, or stop serving.
+void Game::ToggleMetricsServer()
+{
+    if (m_metricsServer) {
+        m_metricsServer.reset();
+        DX_LOG_INFO("Metrics endpoint stopped");
+        return;
+    }
+
+    m_metricsServer = std::make_unique<DX::MetricsServer>();
+    if (m_metricsServer->Start(DX::MetricsRegistry::Default(), metricsPort)) {
+        DX_LOG_INFO("Metrics: serving http://127.0.0.1:%u/metrics", m_metricsServer->Port());
+    }
+    else {
+        DX_LOG_ERROR("Metrics: could not listen on 127.0.0.1:%u", metricsPort);
+        m_metricsServer.reset();
+    }
+}
+
+// Write the current metrics to the working directory for a textfile collector.
+void Game::WriteMetricsSnapshot()
+{
+    const std::string path = TimestampedFileName("metrics", "prom");
+    if (DX::MetricsRegistry::Default().WriteFile(path))
+        DX_LOG_INFO("Metrics: wrote %s", path);
+    else
+        DX_LOG_ERROR("Metrics: could not write %s", path);
+}
+
+// Start recording every presented frame to the working directory, or finish the file.
+void Game::ToggleRecording()
+{
+    if (m_recorder) {
+        StopRecording();
+        return;
+    }
+    if (!CreateReadbackTextures()) return;
+
+    DX::FrameFormat format;
+    format.width = desktop_width;
+    format.height = desktop_height;
+    format.rateNumerator = static_cast<uint32_t>(fps);
+
+    m_recordingPath = TimestampedFileName("recording", "y4m");
+    try {
+        m_recorder = std::make_unique<DX::FrameRecorder>(DX::CreateFileRecordSink(m_recordingPath), DX::FrameFileFormat::Y4M, format);
+    }
+    catch (const std::exception& e) {
+        DX_LOG_ERROR("Recording: %s", e.what());
+        ReleaseReadbackTextures();
+        return;
+    }
+    DX_LOG_INFO("Recording to %s", m_recordingPath);
+}
+
+// Publish every presented frame to the shared-memory ring named sharedOutputName, or stop publishing.
+void Game::ToggleFramePublisher()
+{
+    if (m_framePublisher) {
+        DrainReadback(UINT64_MAX, true);
+        DX_LOG_INFO("Shared output: published %llu frames to %s", static_cast<unsigned long long>(m_framePublisher->PublishedFrames()), sharedOutputName);
+        m_framePublisher.reset();
+        ReleaseReadbackTextures();
+        return;
+    }
+    if (!CreateReadbackTextures()) return;
+
+    // Consumers convert sourceTicks with the QPC frequency.
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    DX::SharedFrameFormat format;
+    format.width = desktop_width;
+    format.height = desktop_height;
+    format.rateNumerator = static_cast<uint32_t>(fps);
+    format.tickFrequency = static_cast<uint64_t>(frequency.QuadPart);
+
+    try {
+        m_framePublisher = std::make_unique<DX::FramePublisher>(sharedOutputName, format);
+    }
+    catch (const std::exception& e) {
+        DX_LOG_ERROR("Shared output: %s", e.what());
+        ReleaseReadbackTextures();
+        return;
+    }
+    DX_LOG_INFO("Shared output: publishing %dx%d frames as %s", desktop_width, desktop_height, sharedOutputName);
+}
+
+// Staging textures the presented textures are copied into; Map reads them a few frames later.
+// The recorder and the frame publisher share them, so they are created for whichever starts first.
+bool Game::CreateReadbackTextures()
+{
+    if (!m_readbackTextures.empty()) return true;
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = desktop_width;
+    desc.Height = desktop_height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = static_cast<DXGI_FORMAT>(DX::PixelFormatDxgi(internalFormat));
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    auto device = m_deviceResources->GetD3DDevice();
+    m_readbackWidth = desktop_width;
+    m_readbackHeight = desktop_height;
+    m_readbackFormat = internalFormat;
+    m_readbackTextures.assign(readbackRingDepth, nullptr);
+    for (auto& texture : m_readbackTextures) {
+        if (FAILED(device->CreateTexture2D(&desc, nullptr, &texture))) {
+            DX_LOG_ERROR("Readback: could not create %dx%d staging textures", desktop_width, desktop_height);
+            ReleaseReadbackTextures();
+            return false;
+        }
+    }
+    m_readbackRing.Reset(m_readbackTextures.size(), readbackLatency);
+    m_readbackInfo.assign(m_readbackTextures.size(), ReadbackFrameInfo{});
+    m_readbackFrame = 0;
+    return true;
+}
+
+// Release the staging textures once neither the recorder nor the publisher needs them.
+void Game::ReleaseReadbackTextures()
+{
+    if (m_recorder || m_framePublisher) return;
+
+    for (auto& texture : m_readbackTextures) {
+        if (texture != nullptr) texture->Release();
+    }
+    m_readbackTextures.clear();
+}
+
+// Copy the texture about to be presented and hand copies that have aged enough to their readers.
+void Game::ReadbackFrame(DX::LatencyFrameKind kind, uint64_t sourceTicks)
+{
+    DX_TRACE_SPAN("Readback");
+    DrainReadback(m_readbackFrame, false);
+
+    // An output of another size or format than the recording is skipped until one that matches is shown
+    // again, and so is one that was just re-created and has nothing to show yet.
+    if (desktop_width != m_readbackWidth || desktop_height != m_readbackHeight || m_texture == nullptr) return;
+    if (m_captures[m_activeCapture]->format != m_readbackFormat) return;
+
+    // A full ring means the GPU is far behind; that frame is skipped.
+    const int slot = m_readbackRing.BeginCopy(m_readbackFrame++);
+    if (slot == DX::ReadbackRing::InvalidSlot) return;
+
+    ComPtr<ID3D11Resource> source;
+    m_texture->GetResource(&source);
+    m_deviceResources->GetD3DDeviceContext()->CopyResource(m_readbackTextures[slot], source.Get());
+    m_readbackInfo[slot] = { kind == DX::LatencyFrameKind::Interpolated, sourceTicks };
+}
+
+// Map copies at least readbackLatency frames old. Unless wait is set, a copy the GPU hasn't finished
+// is left for the next frame instead of stalling the render thread.
+void Game::DrainReadback(uint64_t frame, bool wait)
+{
+    auto context = m_deviceResources->GetD3DDeviceContext();
+    for (int slot = m_readbackRing.NextToMap(frame); slot != DX::ReadbackRing::InvalidSlot; slot = m_readbackRing.NextToMap(frame)) {
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        const HRESULT hr = context->Map(m_readbackTextures[slot], 0, D3D11_MAP_READ, wait ? 0 : D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+        if (hr == DXGI_ERROR_WAS_STILL_DRAWING) return;
+
+        if (SUCCEEDED(hr)) {
+            DX::ConstImageView view = { static_cast<const uint8_t*>(mapped.pData), static_cast<uint32_t>(m_readbackWidth),
+                DX::PixelFormatRows(m_readbackFormat, static_cast<uint32_t>(m_readbackHeight)), mapped.RowPitch };
+
+            // Readers take rgba8, encoded as an SDR swap chain would show the frame.
+            if (DX::PixelFormatPlanar(m_readbackFormat)) {
+                m_readbackImage.Resize(view.width, static_cast<uint32_t>(m_readbackHeight), 4);
+                DX::ConvertNv12ToRgba8(view, m_readbackImage.View());
+                view = m_readbackImage.View();
+            }
+            else if (m_readbackFormat != DX::PixelFormat::Rgba8) {
+                const float white = SdrWhiteNits(*m_captures[m_activeCapture]);
+                if (!m_readbackEncoder || m_readbackEncoder->SdrWhiteNits() != white) m_readbackEncoder = std::make_unique<DX::Srgb8Encoder>(white);
+                m_readbackImage.Resize(view.width, view.height, 4);
+                DX::VisitPixelFormat(m_readbackFormat, [&](auto pixel) {
+                    DX::ConvertToRgba8<decltype(pixel)>(view, m_readbackImage.View(), *m_readbackEncoder);
+                });
+                view = m_readbackImage.View();
+            }
+            if (m_recorder) m_recorder->Submit(view);
+            if (m_framePublisher) m_framePublisher->Publish(view, m_readbackInfo[slot].interpolated, m_readbackInfo[slot].sourceTicks);
+            context->Unmap(m_readbackTextures[slot], 0);
+        }
+        else {
+            DX_LOG_WARNING("Readback: could not map frame %llu (0x%08X)", static_cast<unsigned long long>(m_readbackRing.GetFrame(slot)), static_cast<unsigned>(hr));
+        }
+        m_readbackRing.EndMap(slot);
+    }
+}
+
+// Read back the copies still in flight, finish the file and release the staging textures if unused.
+void Game::StopRecording()
+{
+    DrainReadback(UINT64_MAX, true);
+    const bool written = m_recorder->Stop();
+    const DX::FrameRecorderStats stats = m_recorder->Stats();
+    m_recorder.reset();
+    ReleaseReadbackTextures();
+
+    if (written)
+        DX_LOG_INFO("Recording: wrote %llu frames (%.1f MB) to %s", static_cast<unsigned long long>(stats.writtenFrames), double(stats.bytesWritten) / (1 << 20), m_recordingPath);
+    else
+        DX_LOG_ERROR("Recording: writing %s failed after %llu frames", m_recordingPath, static_cast<unsigned long long>(stats.writtenFrames));
+    DX_LOG_INFO("Recording: %llu frames dropped by the writer queue, %llu by the readback ring",
+        static_cast<unsigned long long>(stats.droppedFrames), static_cast<unsigned long long>(m_readbackRing.GetDroppedFrames()));
+}
+
+// Log pool hit rate and resident memory.
+void Game::ReportTexturePoolStats()
+{
+    auto const& stats = m_texturePool->GetStats();
+    DX_LOG_DEBUG("Texture pool: %.1f%% hit rate (%llu hits, %llu misses), %zu textures, %.1f MB resident",
+        stats.HitRate() * 100.0,
+        static_cast<unsigned long long>(stats.hits),
+        static_cast<unsigned long long>(stats.misses),
+        stats.residentCount,
+        stats.residentBytes / (1024.0 * 1024.0));
+}
+
+// Log in-flight depth and presenter wait times, for each output's fence.
+void Game::ReportFenceStats()
+{
+    for (auto& capture : m_captures) {
+        if (!capture->fenceTimeline) continue;
+        auto const& stats = capture->fenceTimeline->GetStats();
+        DX_LOG_DEBUG("Fence: output %u %zu in flight (max %zu), %llu waits, %.3f ms avg, %.3f ms max, %llu timeouts",
+            capture->outputIndex,
+            capture->fenceTimeline->InFlight(),
+            stats.maxInFlight,
+            static_cast<unsigned long long>(stats.waits),
+            stats.AverageWaitSeconds() * 1000.0,
+            stats.maxWaitSeconds * 1000.0,
+            static_cast<unsigned long long>(stats.timeouts));
+    }
+}
+
+// Log how often each output was interpolated and the longest it waited for a turn.
+void Game::ReportSchedulerStats()
+{
+    for (size_t i = 0; i < m_captures.size(); i++) {
+        auto const& stats = m_scheduler.Stats(i);
+        auto const& estimate = m_scheduler.Estimate(i);
+        DX_LOG_DEBUG("Scheduler: output %u interpolated %llu of %llu rounds, max wait %u, %.3f ms GPU, %.3f ms CPU",
+            m_captures[i]->outputIndex,
+            static_cast<unsigned long long>(stats.served),
+            static_cast<unsigned long long>(stats.rounds),
+            stats.maxWait,
+            estimate.gpuSeconds * 1000.0,
+            estimate.cpuSeconds * 1000.0);
+    }
+}
+
+void ViewerMetrics::Register(DX::MetricsRegistry& registry)
+{
+    // Prometheus convention: base units, counters end in _total.
+    const auto frameBuckets = DX::ExponentialBuckets(0.001, 1.5, 12);
+    sourceFrames = &registry.AddCounter("hfv_source_frames_total", "Desktop frames captured.");
+    captureTimeouts = &registry.AddCounter("hfv_capture_timeouts_total", "AcquireNextFrame calls that timed out without a new frame.");
+    captureErrors = &registry.AddCounter("hfv_capture_errors_total", "AcquireNextFrame calls that failed.");
+    captureRecoveries = &registry.AddCounter("hfv_capture_recoveries_total", "Outputs that captured again after duplication failed.");
+    realFrames = &registry.AddCounter("hfv_frames_presented_total", "Frames presented.", "kind=\"real\"");
+    interpolatedFrames = &registry.AddCounter("hfv_frames_presented_total", "Frames presented.", "kind=\"interpolated\"");
+    droppedFrames = &registry.AddCounter("hfv_dropped_frames_total", "Captured frames recycled before they were interpolated.");
+    repeatedFrames = &registry.AddCounter("hfv_repeated_frames_total", "Interpolated frames NvOFFRUC replaced with a repeat.");
+    interpolateSeconds = &registry.AddHistogram("hfv_interpolate_seconds", "CPU time to submit one interpolation.", frameBuckets);
+    frameSeconds = &registry.AddHistogram("hfv_frame_interval_seconds", "Time between consecutive presents.", frameBuckets);
+    texturePoolBytes = &registry.AddGauge("hfv_texture_pool_resident_bytes", "Bytes held by pooled textures.");
+    targetFps = &registry.AddGauge("hfv_target_fps", "Output frame rate the viewer paces to.");
+    firstFrameSeconds = &registry.AddGauge("hfv_startup_first_frame_seconds", "Time from start to the first presented frame.");
+    firstInterpolatedSeconds = &registry.AddGauge("hfv_startup_first_interpolated_seconds", "Time from start to the first presented interpolated frame.");
+
+    // Process memory is sampled when scraped rather than every frame.
+    static std::once_flag memoryCollector;
+    std::call_once(memoryCollector, [&registry] {
+        DX::Gauge& workingSet = registry.AddGauge("hfv_process_working_set_bytes", "Resident memory of the viewer process.");
+        DX::Gauge& privateBytes = registry.AddGauge("hfv_process_private_bytes", "Committed private memory of the viewer process.");
+        registry.AddCollector([&workingSet, &privateBytes] {
+            PROCESS_MEMORY_COUNTERS_EX counters = {};
+            if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))) {
+                workingSet.Set(static_cast<double>(counters.WorkingSetSize));
+                privateBytes.Set(static_cast<double>(counters.PrivateUsage));
+            }
+        });
+    });
+}
+
+bool D3D11FenceAdapter::WaitForValue(uint64_t value, uint32_t timeoutMs)
+{
+    if (FAILED(fence->SetEventOnCompletion(value, event)))
+        return false;
+    return WaitForSingleObject(event, timeoutMs) == WAIT_OBJECT_0;
+}
+
+ID3D11Texture2D* D3D11TextureAllocator::Create(const DX::TextureKey& key)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = key.width;
+    desc.Height = key.height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = static_cast<DXGI_FORMAT>(key.format);
+    desc.SampleDesc.Count = 1;
+    desc.BindFlags = key.bindFlags;
+    desc.MiscFlags = key.miscFlags;
+
+    ID3D11Texture2D* texture = nullptr;
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &texture)))
+        return nullptr;
+    return texture;
+}
+
+uint64_t D3D11TextureAllocator::SizeInBytes(const DX::TextureKey& key) const
+{
+    return uint64_t(key.width) * key.height * BitsPerPixel(static_cast<DXGI_FORMAT>(key.format)) / 8;
+}
+
+// Code from NvOFFRUCSample to get resources.
+void Game::GetResource(OutputCapture& capture, void** ppTexture)
+{
+    if (capture.interpolateTexture)
     {
-        if (m_pRenderTexture2D[i])
+        ppTexture[0] = capture.interpolateTexture;
+    }
+    ppTexture = ppTexture + 1;
+    for (uint32_t i = 0; i < capture.renderTextures.size(); i++)
+    {
+        if (capture.renderTextures[i])
         {
-            ppTexture[i] = m_pRenderTexture2D[i];
+            ppTexture[i] = capture.renderTextures[i];
         }
     }
-}
\ No newline at end of file
+}
@@ -19,9 +19,180 @@
 #include <chrono>
 #include <sstream>
 #include "PostProcess.h"
+#include "TexturePool.h"
+#include "CaptureRing.h"
+#include "FenceTimeline.h"
+#include "CaptureScaler.h"
+#include "Trace.h"
+#include "Logger.h"
+#include "HudRenderer.h"
+#include "LatencyTracker.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+#include "FrameRecorder.h"
+#include "ReadbackRing.h"
+#include "FrameShare.h"
+#include "CursorShape.h"
+#include "CursorCache.h"
+#include "CursorPredictor.h"
+#include "DesktopLayout.h"
+#include "CaptureScheduler.h"
+#include "CaptureRegion.h"
+#include "CaptureRecovery.h"
+#include "Settings.h"
+#include "FrameInterpolator.h"
+#include "WorkerPool.h"
+#include "FrameConvert.h"
+#include <future>
 #include <queue>
 #include <thread>
 
+// Creates pooled textures on a D3D11 device.
+struct D3D11TextureAllocator
+{
+    ID3D11Device* device = nullptr;
+
+    ID3D11Texture2D* Create(const DX::TextureKey& key);
+    void Destroy(ID3D11Texture2D* texture) { texture->Release(); }
+    uint64_t SizeInBytes(const DX::TextureKey& key) const;
+};
+
+using D3D11TexturePool = DX::TexturePool<ID3D11Texture2D, D3D11TextureAllocator>;
+
+// Lets the CPU query and wait on a D3D11 fence.
+struct D3D11FenceAdapter
+{
+    ID3D11Fence* fence = nullptr;
+    HANDLE event = NULL;
+
+    uint64_t GetCompletedValue() { return fence->GetCompletedValue(); }
+    bool WaitForValue(uint64_t value, uint32_t timeoutMs);
+};
+
+using D3D11FenceTimeline = DX::FenceTimeline<D3D11FenceAdapter>;
+
+// Fleet metrics, registered once in MetricsRegistry::Default() and updated from the render loop.
+struct ViewerMetrics
+{
+    DX::Counter* sourceFrames = nullptr;
+    DX::Counter* captureTimeouts = nullptr;
+    DX::Counter* captureErrors = nullptr;
+    DX::Counter* captureRecoveries = nullptr;
+    DX::Counter* realFrames = nullptr;
+    DX::Counter* interpolatedFrames = nullptr;
+    DX::Counter* droppedFrames = nullptr;
+    DX::Counter* repeatedFrames = nullptr;
+    DX::Histogram* interpolateSeconds = nullptr;
+    DX::Histogram* frameSeconds = nullptr;
+    DX::Gauge* texturePoolBytes = nullptr;
+    DX::Gauge* targetFps = nullptr;
+    DX::Gauge* firstFrameSeconds = nullptr;
+    DX::Gauge* firstInterpolatedSeconds = nullptr;
+
+    void Register(DX::MetricsRegistry& registry);
+};
+
+// What a staging texture holds, passed on to shared-output consumers.
+struct ReadbackFrameInfo
+{
+    bool interpolated = false;
+    uint64_t sourceTicks = 0;
+};
+
+// Uploaded textures for one pointer shape. xorMask is null for shapes that never XOR the screen.
+struct D3D11CursorTextures
+{
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> color;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> xorMask;
+    int32_t hotspotX = 0;
+    int32_t hotspotY = 0;
+};
+
+// What interpolates the outputs. Frames pass through until NvOFFRUC has loaded; the CPU takes over if it can't.
+enum class InterpolatorBackend
+{
+    PassThrough,
+    NvOFFRUC,
+    Cpu,
+};
+
+// What the startup worker loaded, handed to the render thread once it is done.
+struct DeferredLoad
+{
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cursor;
+    bool interpolatorReady = false;                                        // Every output has its NvOFFRUC instance.
+    std::string error;
+    double seconds = 0;
+};
+
+// One duplicated output: its session, capture ring, NvOFFRUC instance and the textures they share.
+struct OutputCapture
+{
+    UINT outputIndex = 0;                                                  // On adapter 0, as in monitorIndices.
+    int layoutIndex = DX::DesktopLayout::NoOutput;                         // In the desktop layout, for the cursor.
+
+    // Desktop Duplication
+    IDXGIOutput* output = nullptr;                                         //Released
+    IDXGIOutput1* output1 = nullptr;                                       //Released
+    IDXGIOutputDuplication* duplication = nullptr;                         //Released
+    int width = 1280, height = 720;                                        // The region's crop, downscaled by resFactor.
+    int captureWidth = 1280, captureHeight = 720;
+    DXGI_MODE_ROTATION rotation = DXGI_MODE_ROTATION_IDENTITY;
+    double refreshRate = 60;
+    float sdrWhiteNits = 80.f;                                             // The output's SDR white level in Windows.
+    DX::CaptureRegion region;                                              // Part of the output that is converted and interpolated.
+    DX::CaptureScaler scaler;
+
+    // What to rebuild after duplication failed. While recovering, the output isn't captured and keeps
+    // showing its last good frame, held here if its ring had to be re-created.
+    DX::CaptureRecovery recovery;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> heldFrame;
+
+    // Capture ring shared by GetFrame, InterpolateFrame and the presenter, and each slot's capture time (QPC).
+    DX::CaptureRing ring;
+    std::vector<uint64_t> slotSourceTicks;
+    int previousSlot = DX::CaptureRing::InvalidSlot;
+    int presentSlot = DX::CaptureRing::InvalidSlot;
+    uint64_t reportedDroppedFrames = 0;
+
+    // This output's own fence, registered with its NvOFFRUC instance. Only this output's submissions signal
+    // it: each captured slot handed over to NvOFFRUC, and each interpolated frame, NvOFFRUC's or the CPU path's.
+    ID3D11Fence* fence = nullptr;                                          //Released
+    HANDLE fenceEvent = NULL;
+    std::unique_ptr<D3D11FenceTimeline> fenceTimeline;
+
+    // NvOFFRUC instance, sized for this output.
+    NvOFFRUCHandle fruc = {};
+    NvOFFRUC_REGISTER_RESOURCE_PARAM registered = { 0 };
+    DX::PixelFormat format = DX::PixelFormat::Rgba8;                       // Of the ring and the interpolation target.
+    std::vector<ID3D11Texture2D*> renderTextures;                          //Pooled
+    ID3D11Texture2D* interpolateTexture = nullptr;                         //Pooled
+    std::vector<ID3D11ShaderResourceView*> renderSRV;                      //Released
+    std::vector<ID3D11UnorderedAccessView*> renderUAV;                     //Released; the luma plane's for nv12
+    std::vector<ID3D11UnorderedAccessView*> renderChromaUAV;               //Released; null unless nv12
+    ID3D11ShaderResourceView* interpolateSRV = nullptr;                    //Released
+    double lastRenderTime = 0;
+    uint64_t interpolatedFenceValue = 0;                                   // On this output's fence.
+    uint32_t failedInterpolations = 0;                                     // NvOFFRUCProcess failures in a row; the first is logged.
+    uint64_t interpolatedSourceTicks = 0;
+
+    // CPU interpolator used when NvOFFRUC is unavailable or can't take the internal format, and the staging texture it reads frames back through.
+    std::unique_ptr<DX::CpuFrameInterpolator> cpuInterpolator;
+    ID3D11Texture2D* cpuStaging = nullptr;                                 //Released
+    DX::Image cpuOutput;
+
+    // When the last interpolation was submitted and how long submitting took, reported to the scheduler.
+    double submittedSeconds = 0;
+    double submitCpuSeconds = 0;
+
+    // What the presenter draws for this output and where.
+    ID3D11ShaderResourceView* shown = nullptr;                             //Cached view, not owned
+    uint64_t shownSourceTicks = 0;
+    DirectX::SimpleMath::Vector2 screenPos;
+    DirectX::SimpleMath::Vector2 scaleFactor;
+    bool visible = false;
+};
+
 // A basic game implementation that creates a D3D11 device and
 // provides a game loop.
 class Game final : public DX::IDeviceNotify
@@ -38,6 +209,7 @@ public:
     Game& operator= (Game const&) = delete;
 
     // Initialization and management
+    void LoadSettings(const std::vector<std::string>& arguments);
     void Initialize(HWND window, int width, int height);
 
     // Basic game loop
@@ -60,37 +232,98 @@ public:
     void GetDefaultSize( int& width, int& height ) const noexcept;
 
     // Drawing Stuff
-    ID3D11ShaderResourceView* m_texture = nullptr;                         //Released
-    ID3D11ShaderResourceView* m_textureDesktop = nullptr;                  //Released
+    ID3D11ShaderResourceView* m_texture = nullptr;                         //Cached view, not owned
+    ID3D11ShaderResourceView* m_textureDesktop = nullptr;                  //Released per frame
     
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_textureCursor;
     
     std::unique_ptr<DirectX::SpriteBatch> m_spriteBatch;
-    std::unique_ptr<DirectX::DX11::BasicPostProcess> postProcess;
-    std::unique_ptr<DirectX::DX11::BasicPostProcess> postProcess2;
+
+    // Converts frames from the internal format's transfer function to the swap chain's as they are drawn.
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_presentConvertPS;
+    Microsoft::WRL::ComPtr<ID3D11PixelShader> m_presentNv12PS;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_presentConvertConstants;
+
+    // Performance overlay.
+    DX::HudModel m_hud;
+    DX::HudRenderer m_hudRenderer;
+    bool showHud = false;
     
     DirectX::SimpleMath::Vector2 m_origin;          
-    DirectX::SimpleMath::Vector2 m_scaleFactor;     
-    DirectX::SimpleMath::Vector2 m_screenPos;    
     
     POINT lastCursorPos;
 
+    // Pointer from the duplication metadata, relative to the captured output. Shapes are decoded once and cached by hash.
+    DX::CursorCache<D3D11CursorTextures> m_cursorCache;
+    D3D11CursorTextures m_cursorTextures;                                  // Current shape; empty until one is reported.
+    DX::DecodedCursor m_decodedCursor;
+    std::vector<uint8_t> m_pointerShapeBuffer;
+    POINT m_pointerPosition = {};
+    bool m_pointerVisible = false;
+    int m_pointerOutput = DX::DesktopLayout::NoOutput;                     // Layout index of the output that last reported the pointer.
+    Microsoft::WRL::ComPtr<ID3D11BlendState> m_cursorXorBlend;
+
+    // Late-latched cursor: sampled again at present time and extrapolated to the vblank that shows the frame.
+    DX::CursorPredictor m_cursorPredictor;
+    DX::VblankClock m_vblankClock;
+    DX::Point2D m_cursorHotspot;                                           // Where the hotspot will be, on the virtual desktop.
+
+    // Every output on the virtual desktop, rebuilt on display changes.
+    DX::DesktopLayout m_desktopLayout;
+    std::vector<DX::PointerSample> m_pointerTrace;                         // Hotspot samples, kept while latency is recorded.
+
     // Desktop Duplication Stuff
     IDXGIFactory1* factory = nullptr;                                      //Released
     IDXGIAdapter1* adapter = nullptr;                                      //Released
-    IDXGIOutput* pOutput = nullptr;                                        //Released
-    IDXGIOutput1* pOutput1 = nullptr;                                      //Released
-    IDXGIOutputDuplication* pDeskDupl = nullptr;                           //Released
     IDXGIResource* desktopResource = nullptr;                              //Released
     ID3D11Texture2D* desktopTextureBGR = nullptr;                          //Released
-    ID3D11Texture2D* lastFrame = nullptr;                                  //Released
-    ID3D11Texture2D* renderTargetTexture = nullptr;                        //Released  
+
+    // Every captured output, and the one shown alone or paced to when tiled. Each keeps its session
+    // and ring while another is shown, so switching is instant.
+    std::vector<std::unique_ptr<OutputCapture>> m_captures;
+    size_t m_activeCapture = 0;
+    DX::CaptureScheduler m_scheduler;
+    std::vector<size_t> m_interpolatePlan;
     
+    // Settings from the settings file and the command line. The file is watched and what changed in it
+    // applied while running; keys pressed since keep their effect until the file changes that setting.
+    DX::ViewerSettings m_settings;
+    DX::SettingsFile m_settingsFile;
+    std::vector<std::string> m_arguments;
+    double m_settingsPollSeconds = 0;
+    double m_settingsChangedSeconds = -1.0;                                // When the file last changed, until it is applied.
+
+    // Window whose bounds are the region of interest, found by roiWindowTitle.
+    HWND m_roiWindow = NULL;
+    double m_roiWindowSearchSeconds = -1.0;
+
+    // Size of the active output's texture, which the window, recorder and shared output follow.
     int desktop_width = 1280, desktop_height = 720;
 
     // Function for Rendering
-    bool GetFrame();
+    bool GetFrame(OutputCapture& capture, UINT timeoutMs = 1);
+    void RecoverCaptures();
+    DX::CaptureFault RecreateDuplication(OutputCapture& capture);
+    DX::CaptureFault RecreateOutput(OutputCapture& capture);
+    HRESULT DuplicateCapture(OutputCapture& capture);
+    void SetCaptureMode(OutputCapture& capture, const DXGI_OUTDUPL_DESC& desc);
+    float SdrWhiteNits(const OutputCapture& capture) const;
+    void UpdatePointer(OutputCapture& capture, const DXGI_OUTDUPL_FRAME_INFO& frameInfo);
+    void UpdatePointerShape(OutputCapture& capture, UINT bufferSize);
     void DrawFromSRV();
+    std::function<void()> ConvertFromSrgb(DX::TransferFunction swapChainTransfer, float sdrWhiteNits);
+    void CycleScaleFilter();
+    void ToggleTrace();
+    void ToggleLatencyRecording();
+    void ToggleMetricsServer();
+    void WriteMetricsSnapshot();
+    void ToggleRecording();
+    void ToggleFramePublisher();
+    void ToggleCursor();
+    void CycleCursorPrediction();
+    void SelectOutput(size_t index);
+    void ToggleTiling();
+    void ToggleRegion();
 
     // NVOF Stuff
     PtrToFuncNvOFFRUCCreate NvOFFRUCCreate;
@@ -98,34 +331,96 @@ public:
     PtrToFuncNvOFFRUCUnregisterResource NvOFFRUCUnregisterResource;
     PtrToFuncNvOFFRUCProcess NvOFFRUCProcess;
     PtrToFuncNvOFFRUCDestroy NvOFFRUCDestroy;
-    NvOFFRUCHandle hFRUC;
-    NvOFFRUC_REGISTER_RESOURCE_PARAM regOutParam = { 0 };
 
     // NvOFFRUC Functions
-    void InterpolateFrame();
-    void CreateTextureBuffer();
-    void GetResource(void** ppTexture);
+    void InterpolateOutputs();
+    void CreateInterpolator(OutputCapture& capture);
+    void ReleaseInterpolator(OutputCapture& capture);
+    bool CreateFruc(OutputCapture& capture);
+    void ReleaseFruc(OutputCapture& capture);
+    void CreateCpuInterpolator(OutputCapture& capture);
+    void ReleaseCpuInterpolator(OutputCapture& capture);
+    bool InterpolateWithFruc(OutputCapture& capture, int slot, bool* repeated);
+    void InterpolateOnCpu(OutputCapture& capture, int slot, bool* repeated);
+    void StartDeferredLoad();
+    bool FinishDeferredLoad(bool wait);
+    void InterpolateFrame(OutputCapture& capture);
+    void SkipInterpolation(OutputCapture& capture);
+    void PassThroughSlot(OutputCapture& capture, int slot);
+    void CreateTextureBuffer(OutputCapture& capture);
+    void ReleaseTextureBuffer(OutputCapture& capture);
+    DX::TextureKey RingTextureKey(const OutputCapture& capture) const;
+    void TrimTexturePool();
+    void ReportTexturePoolStats();
+    void ReportFenceStats();
+    void CreateOutputFence(OutputCapture& capture);
+    void ReleaseOutputFence(OutputCapture& capture);
+    void WaitForGpu();
+    void ReportSchedulerStats();
+    void GetResource(OutputCapture& capture, void** ppTexture);
 
-    // NvOFFRUC Objects
-    ID3D11Fence* m_pFence = nullptr;                                       //Released
+    // Fence the immediate context signals as each capture conversion lands. Nothing else signals it, so its
+    // values land in order; each output's interpolations signal the output's own fence.
+    ID3D11Fence* m_pCaptureFence = nullptr;                                //Released
     ID3D11Device5* m_pDevice5 = nullptr;                                   //Released
-    ID3D11Texture2D* m_pRenderTexture2D[2];                                //Released
-    ID3D11Texture2D* m_pInterpolateTexture2D[1];                           //Released
     ID3D11DeviceContext4* m_pDeviceContext4 = nullptr;                     //Released
-    HANDLE m_hFenceEvent = NULL;
+    HANDLE m_hCaptureFenceEvent = NULL;
+    std::unique_ptr<D3D11FenceTimeline> m_captureTimeline;
+
+    // NvOFFRUC loads on a worker while the first frames pass through.
+    InterpolatorBackend m_backend = InterpolatorBackend::PassThrough;
+    std::future<DeferredLoad> m_deferredLoad;
+    double m_startSeconds = 0;
+    double m_firstFrameSeconds = -1.0;                                     // After start, once shown.
+    double m_firstInterpolatedSeconds = -1.0;
+
+    // Texture pool backing every output's NvOFFRUC ring and interpolation target.
+    std::unique_ptr<D3D11TexturePool> m_texturePool;
 
     // NvOFFRUC Variables
     const double m_constdRenderInterval = 1;
-    double m_dLastRenderTime=0;
-    int m_uiFenceValue = 0;
-    int currRenderIndex = 1;
-    int lastRenderIndex = 0;
     bool drawInterpolated = true;
+    int captureRingDepth = 3;
+    DX::LatencyTracker m_latency;
+
+    // Metrics endpoint, started on request.
+    ViewerMetrics m_metrics;
+    std::unique_ptr<DX::MetricsServer> m_metricsServer;
+    double m_lastPresentSeconds = 0;
+
+    // Recorder and shared-memory publisher of presented frames, read back through staging textures
+    // a few frames after each copy.
+    std::unique_ptr<DX::FrameRecorder> m_recorder;
+    std::string m_recordingPath;
+    std::unique_ptr<DX::FramePublisher> m_framePublisher;
+    DX::ReadbackRing m_readbackRing;
+    std::vector<ID3D11Texture2D*> m_readbackTextures;                      //Released
+    std::vector<ReadbackFrameInfo> m_readbackInfo;
+    uint64_t m_readbackFrame = 0;
+    int m_readbackWidth = 0, m_readbackHeight = 0;
+    DX::PixelFormat m_readbackFormat = DX::PixelFormat::Rgba8;            // Of the staging textures; readers get rgba8.
+    DX::Image m_readbackImage;
+    std::unique_ptr<DX::Srgb8Encoder> m_readbackEncoder;
+    int readbackRingDepth = 4;
+    int readbackLatency = 3;
 
     // Important Variables
-    bool isOnTheLeft = true;
-    int monitorIndex = 1;
+    bool showCursor = true;
+    std::vector<UINT> monitorIndices = { 1 };                             // Outputs of adapter 0 to capture; the first is shown first.
+    bool tileOutputs = false;
+    DX::DesktopRect roiRect;                                               // Region of interest on the virtual desktop; empty for whole outputs.
+    std::string roiWindowTitle;                                            // Follow this window's bounds instead, when set.
+    bool useRegion = true;
+    double frameRate = 0;                                                  // Output frame rate; 0 for twice the first output's refresh rate.
+    double interpolationBudget = 0.75;                                     // Share of each source frame all outputs' interpolation may take, on the GPU and the render thread.
     double resFactor = 2;
+    DX::ScaleFilter scaleFilter = DX::ScaleFilter::Bilinear;
+    DX::PixelFormat internalFormat = DX::PixelFormat::Rgba8;              // Of the rings, the interpolators and what they hand the presenter.
+    double sdrWhiteNits = 0;                                               // 0 for each output's level in Windows.
+    uint16_t metricsPort = DX::MetricsServer::DefaultPort;
+    std::string sharedOutputName = "hfv-output";
+    DX::CursorPrediction cursorPrediction = DX::CursorPrediction::Kalman;
+    int cursorVblanks = 1;
 
     // Timing Objects
     std::chrono::duration<double> sleepDuration = std::chrono::duration<double>(0);
@@ -135,6 +430,28 @@ public:
 private:
 
     void Render();
+    void PresentFrame(DX::LatencyFrameKind kind, uint64_t sourceTicks);
+    void LatchCursor();
+    void AddPointerSample(const DX::PointerSample& sample);
+    void BuildDesktopLayout();
+    void PlaceOutputs();
+    DX::DesktopRect WantedRegion(const OutputCapture& capture);
+    void UpdateRegions();
+    void ResizeCapture(OutputCapture& capture);
+    void CreateCaptures();
+    void CreateRecoveringCaptures();
+    void ReleaseCaptures();
+    void SetFrameRate();
+    DX::ViewerSettings ReadSettings(std::vector<std::string>& errors) const;
+    void UseSettings(const DX::ViewerSettings& settings, const DX::SettingsPlan* plan);
+    void CheckSettingsFile();
+    void ApplySettings(const DX::ViewerSettings& settings, const DX::SettingsPlan& plan);
+    DX::Point2D OutputOrigin(int layoutIndex) const;
+    void ReadbackFrame(DX::LatencyFrameKind kind, uint64_t sourceTicks);
+    bool CreateReadbackTextures();
+    void ReleaseReadbackTextures();
+    void DrainReadback(uint64_t frame, bool wait);
+    void StopRecording();
 
     void Clear();
 
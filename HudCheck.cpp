@@ -0,0 +1,232 @@
+//
+// HudCheck.cpp - Feed the performance overlay's model simulated frames, and check its numbers
+//
+
+#include "ToolMain.h"
+#include "HudModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    bool Near(double a, double b, double tolerance = 1e-4)
+    {
+        return std::abs(a - b) <= tolerance;
+    }
+
+    bool HasLine(const HudModel& hud, const char* text)
+    {
+        for (size_t i = 0; i < hud.LineCount(); i++)
+        {
+            if (std::strcmp(hud.Line(i), text) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // The ring graph keeps the newest HistoryLength frame times, oldest first.
+    uint64_t CheckHistory(std::mt19937& random)
+    {
+        uint64_t failures = 0;
+        HudModel::History history;
+        failures += history.Size() == 0 && history.Max() == 0.0f ? 0 : 1;
+
+        std::uniform_real_distribution<float> sample(1.0f, 40.0f);
+        std::vector<float> pushed;
+        for (size_t i = 0; i < HudModel::HistoryLength * 2 + 17; i++)
+        {
+            pushed.push_back(sample(random));
+            history.Push(pushed.back());
+
+            const size_t kept = std::min(pushed.size(), HudModel::HistoryLength);
+            failures += history.Size() == kept ? 0 : 1;
+            const size_t first = pushed.size() - kept;
+            failures += history[0] == pushed[first] && history[kept - 1] == pushed.back() ? 0 : 1;
+            failures += history.Max() == *std::max_element(pushed.begin() + ptrdiff_t(first), pushed.end()) ? 0 : 1;
+        }
+
+        history.Clear();
+        failures += history.Size() == 0 ? 0 : 1;
+        return failures;
+    }
+
+    // Known timings: each present's interval lands in the graph, rates count frames over the refresh
+    // window, stage times are smoothed towards their samples, and the counters reach the text.
+    uint64_t CheckKnownRun()
+    {
+        uint64_t failures = 0;
+        HudModel hud;
+        double now = 100.0;
+
+        // The first Update only opens the window; the first present has no interval.
+        failures += !hud.Update(now) && hud.SourceFps() == 0.0 ? 0 : 1;
+        hud.OnPresent(now);
+        failures += hud.FrameTimes().Size() == 0 ? 0 : 1;
+
+        // 0.3 s at 120 Hz output from a 60 fps source, with every other output frame interpolated
+        // and one in four of those repeated.
+        const double intervals[] = { 8.0, 9.0, 7.5, 8.5 };
+        uint32_t outputs = 0, sources = 0, repeats = 0;
+        for (uint32_t frame = 0; frame < 36; frame++)
+        {
+            now += intervals[frame % 4] / 1000.0;
+            hud.OnPresent(now);
+            outputs++;
+            if (frame % 2 == 0)
+            {
+                hud.OnSourceFrame();
+                sources++;
+            }
+            else
+            {
+                hud.OnInterpolated(frame % 8 == 1);
+                repeats += frame % 8 == 1 ? 1 : 0;
+            }
+        }
+        failures += hud.FrameTimes().Size() == 36 ? 0 : 1;
+        for (size_t i = 0; i < hud.FrameTimes().Size(); i++)
+            failures += Near(hud.FrameTimes()[i], intervals[i % 4], 1e-3) ? 0 : 1;
+        failures += Near(hud.FrameTimes().Max(), 9.0, 1e-3) ? 0 : 1;
+
+        // Not yet a quarter second into the window: nothing is recomputed.
+        failures += !hud.Update(100.2) && hud.OutputFps() == 0.0 ? 0 : 1;
+        failures += hud.Update(now) ? 0 : 1;
+        const double elapsed = now - 100.0;
+        failures += Near(hud.OutputFps(), (outputs + 1) / elapsed) && Near(hud.SourceFps(), sources / elapsed) ? 0 : 1;
+
+        // Each sample moves the smoothed stage time a tenth of the way.
+        for (int i = 0; i < 10; i++)
+            hud.AddStageSample(HudStage::Interpolate, 4.0);
+        hud.AddStageSample(HudStage::Capture, 2.0);
+        failures += Near(hud.StageMilliseconds(HudStage::Interpolate), 4.0 * (1.0 - std::pow(0.9, 10))) ? 0 : 1;
+        failures += Near(hud.StageMilliseconds(HudStage::Capture), 0.2) && hud.StageMilliseconds(HudStage::Wait) == 0.0 ? 0 : 1;
+
+        hud.SetDroppedFrames(7);
+        hud.SetTargetFrameTime(8.33);
+        failures += hud.DroppedFrames() == 7 && hud.RepeatedFrames() == repeats ? 0 : 1;
+
+        // The next window starts empty and the text follows.
+        failures += !hud.Update(now + 0.1) ? 0 : 1;
+        for (uint32_t i = 0; i < 15; i++)
+            hud.OnSourceFrame();
+        failures += hud.Update(now + 0.5) && Near(hud.SourceFps(), 30.0) && hud.OutputFps() == 0.0 ? 0 : 1;
+        char dropped[HudModel::LineLength];
+        snprintf(dropped, sizeof(dropped), "dropped 7  repeated %u", repeats);
+        failures += HasLine(hud, dropped) && HasLine(hud, "source   30.0 fps") && HasLine(hud, "interp     2.61 ms") ? 0 : 1;
+        failures += HasLine(hud, "frame max  9.00 ms  target  8.33") ? 0 : 1;
+        failures += hud.LineCount() == 2 + size_t(HudStage::Count) + 2 ? 0 : 1;
+
+        hud.Reset();
+        failures += hud.FrameTimes().Size() == 0 && hud.RepeatedFrames() == 0 && hud.LineCount() == 0 ? 0 : 1;
+        return failures;
+    }
+
+    struct Run
+    {
+        uint64_t failures = 0;
+        HudModel hud;
+        uint64_t repeated = 0;
+        uint64_t dropped = 0;
+    };
+
+    // A source at sourceFps shown at refreshHz with jittered present times, checking every refresh
+    // against the frames counted in its window.
+    void Simulate(Run& run, std::mt19937& random, double sourceFps, double refreshHz, double seconds, double jitter)
+    {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        HudModel& hud = run.hud;
+        double now = 1.0;
+        double nextSource = now;
+        double windowStart = now;
+        double lastPresent = 0.0;
+        uint64_t sources = 0, outputs = 0;
+        hud.Update(now);
+        hud.SetTargetFrameTime(1000.0 / refreshHz);
+
+        while (now < 1.0 + seconds)
+        {
+            const double interval = (1.0 + (unit(random) - 0.5) * jitter) / refreshHz;
+            now += interval;
+            hud.OnPresent(now);
+            outputs++;
+            if (lastPresent > 0.0)
+                run.failures += Near(hud.FrameTimes()[hud.FrameTimes().Size() - 1], interval * 1000.0, 1e-2) ? 0 : 1;
+            lastPresent = now;
+
+            if (now >= nextSource)
+            {
+                hud.OnSourceFrame();
+                sources++;
+                nextSource += 1.0 / sourceFps;
+            }
+            else
+            {
+                const bool repeated = unit(random) < 0.1;
+                hud.OnInterpolated(repeated);
+                run.repeated += repeated ? 1 : 0;
+            }
+            if (unit(random) < 0.01)
+                hud.SetDroppedFrames(++run.dropped);
+            hud.AddStageSample(HudStage::Present, unit(random));
+
+            const bool refreshed = hud.Update(now);
+            run.failures += refreshed == (now - windowStart >= HudModel::RefreshInterval) ? 0 : 1;
+            if (refreshed)
+            {
+                run.failures += Near(hud.SourceFps(), sources / (now - windowStart)) && Near(hud.OutputFps(), outputs / (now - windowStart)) ? 0 : 1;
+                sources = 0;
+                outputs = 0;
+                windowStart = now;
+            }
+            run.failures += hud.RepeatedFrames() == run.repeated && hud.DroppedFrames() == run.dropped ? 0 : 1;
+            run.failures += hud.StageMilliseconds(HudStage::Present) >= 0.0 && hud.StageMilliseconds(HudStage::Present) <= 1.0 ? 0 : 1;
+        }
+    }
+}
+
+int DX::HudCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+
+    // --check N: the graph ring and a run with known timings, then N simulated runs at random rates.
+    if (args.Has("check"))
+    {
+        const uint32_t count = std::max(1u, args.GetUInt("check", 100));
+        uint64_t failures = CheckHistory(random) + CheckKnownRun();
+        std::uniform_real_distribution<double> sourceFps(20.0, 144.0);
+        std::uniform_real_distribution<double> refreshHz(60.0, 240.0);
+        std::uniform_real_distribution<double> jitter(0.0, 0.5);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Run run;
+            Simulate(run, random, sourceFps(random), refreshHz(random), 3.0, jitter(random));
+            failures += run.failures;
+        }
+
+        printf("hud: %u rounds, %llu failures\n", count, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("HUD model failed its checks");
+        return 0;
+    }
+
+    const double sourceFps = args.GetNumber("source-fps", 60.0);
+    const double refreshHz = args.GetNumber("refresh", 120.0);
+    const double seconds = args.GetNumber("seconds", 2.0);
+    if (!(sourceFps > 0.0 && refreshHz > 0.0 && seconds > 0.0))
+        throw std::runtime_error("--source-fps, --refresh and --seconds must be positive");
+
+    Run run;
+    Simulate(run, random, sourceFps, refreshHz, seconds, args.GetNumber("jitter", 0.2));
+    for (size_t i = 0; i < run.hud.LineCount(); i++)
+        printf("hud: %s\n", run.hud.Line(i));
+    return 0;
+}
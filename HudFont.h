@@ -0,0 +1,99 @@
+//
+// HudFont.h - Built-in 5x7 bitmap font for the overlay, so no font asset has to ship
+//
+
+#pragma once
+
+#include "Image.h"
+
+namespace DX
+{
+    // Printable ASCII laid out 16 glyphs per row, each in a 6x8 cell (one texel of spacing).
+    struct HudFont
+    {
+        static constexpr char FirstChar = ' ';
+        static constexpr char LastChar = '~';
+        static constexpr uint32_t GlyphWidth = 5;
+        static constexpr uint32_t GlyphHeight = 7;
+        static constexpr uint32_t CellWidth = 6;
+        static constexpr uint32_t CellHeight = 8;
+        static constexpr uint32_t Columns = 16;
+        static constexpr uint32_t Rows = (LastChar - FirstChar + Columns) / Columns;
+        static constexpr uint32_t AtlasWidth = Columns * CellWidth;
+        static constexpr uint32_t AtlasHeight = Rows * CellHeight;
+
+        // One byte per column, bit 0 at the top.
+        static const uint8_t* Glyph(char c) noexcept
+        {
+            static const uint8_t glyphs[][GlyphWidth] =
+            {
+                { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },
+                { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },
+                { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },
+                { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },
+                { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },
+                { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+                { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },
+                { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },
+                { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },
+                { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A },
+                { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },
+                { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },
+                { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },
+                { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F },
+                { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },
+                { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },
+                { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },
+                { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },
+                { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },
+                { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },
+                { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+                { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },
+                { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },
+                { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x08, 0x04, 0x08, 0x10, 0x08 },
+            };
+            static_assert(sizeof(glyphs) / sizeof(glyphs[0]) == LastChar - FirstChar + 1, "One glyph per printable character");
+
+            if (c < FirstChar || c > LastChar)
+                c = '?';
+            return glyphs[c - FirstChar];
+        }
+
+        // Top-left texel of c's cell in the atlas.
+        static void CellOrigin(char c, uint32_t& x, uint32_t& y) noexcept
+        {
+            if (c < FirstChar || c > LastChar)
+                c = '?';
+            const uint32_t index = static_cast<uint32_t>(c - FirstChar);
+            x = (index % Columns) * CellWidth;
+            y = (index / Columns) * CellHeight;
+        }
+
+        // White glyphs with premultiplied alpha, ready for SpriteBatch's default blend state.
+        static void BuildAtlas(Image& atlas)
+        {
+            atlas.Resize(AtlasWidth, AtlasHeight, 4);
+            ImageView view = atlas.View();
+            for (uint32_t y = 0; y < AtlasHeight; y++)
+                std::memset(view.Row(y), 0, size_t(AtlasWidth) * 4);
+
+            for (char c = FirstChar; c <= LastChar; c++)
+            {
+                uint32_t originX, originY;
+                CellOrigin(c, originX, originY);
+                const uint8_t* columns = Glyph(c);
+                for (uint32_t x = 0; x < GlyphWidth; x++)
+                {
+                    for (uint32_t y = 0; y < GlyphHeight; y++)
+                    {
+                        if (columns[x] & (1u << y))
+                            std::memset(view.Row(originY + y) + (originX + x) * 4, 0xFF, 4);
+                    }
+                }
+
+                if (c == LastChar)
+                    break;
+            }
+        }
+    };
+}
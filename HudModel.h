@@ -0,0 +1,199 @@
+//
+// HudModel.h - Numbers and text behind the performance overlay, independent of rendering
+//
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace DX
+{
+    enum class HudStage
+    {
+        Capture,
+        Interpolate,
+        Wait,
+        Present,
+        Sleep,
+        Count,
+    };
+
+    inline const char* HudStageName(HudStage stage) noexcept
+    {
+        switch (stage)
+        {
+        case HudStage::Capture:     return "capture";
+        case HudStage::Interpolate: return "interp";
+        case HudStage::Wait:        return "wait";
+        case HudStage::Present:     return "present";
+        default:                    return "sleep";
+        }
+    }
+
+    // Seconds on the steady clock, the time base HudModel expects.
+    inline double HudSeconds() noexcept
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Fixed capacity ring of samples; pushing overwrites the oldest and never allocates.
+    template<size_t Capacity>
+    class FrameTimeHistory
+    {
+    public:
+        static constexpr size_t capacity = Capacity;
+
+        void Push(float value) noexcept
+        {
+            m_values[m_next] = value;
+            m_next = (m_next + 1) % Capacity;
+            if (m_count < Capacity)
+                m_count++;
+        }
+
+        void Clear() noexcept { m_next = 0; m_count = 0; }
+        size_t Size() const noexcept { return m_count; }
+
+        // Index 0 is the oldest sample.
+        float operator[](size_t i) const noexcept { return m_values[(m_next + Capacity - m_count + i) % Capacity]; }
+
+        float Max() const noexcept
+        {
+            float result = 0.0f;
+            for (size_t i = 0; i < m_count; i++)
+                result = (*this)[i] > result ? (*this)[i] : result;
+            return result;
+        }
+
+    private:
+        std::array<float, Capacity> m_values = {};
+        size_t                      m_next = 0;
+        size_t                      m_count = 0;
+    };
+
+    // Collects counters from the render loop and turns them into rates and overlay text.
+    // Time is passed in explicitly so the model runs the same headless as in the viewer.
+    class HudModel
+    {
+    public:
+        static constexpr size_t HistoryLength = 240;
+        static constexpr size_t MaxLines = 9;
+        static constexpr size_t LineLength = 48;
+        static constexpr double RefreshInterval = 0.25;
+
+        using History = FrameTimeHistory<HistoryLength>;
+
+        void OnSourceFrame() noexcept { m_sourceFrames++; }
+        void OnInterpolated(bool repeated) noexcept { m_repeatedFrames += repeated ? 1 : 0; }
+        void SetDroppedFrames(uint64_t dropped) noexcept { m_droppedFrames = dropped; }
+        void SetTargetFrameTime(double milliseconds) noexcept { m_targetFrameTime = milliseconds; }
+
+        // Smoothed so the numbers stay readable at 120 updates a second.
+        void AddStageSample(HudStage stage, double milliseconds) noexcept
+        {
+            double& value = m_stageMilliseconds[static_cast<size_t>(stage)];
+            value += (milliseconds - value) * c_Smoothing;
+        }
+
+        // Count an output frame and record the time since the previous one.
+        void OnPresent(double now) noexcept
+        {
+            if (m_lastPresent > 0.0)
+                m_history.Push(static_cast<float>((now - m_lastPresent) * 1000.0));
+            m_lastPresent = now;
+            m_outputFrames++;
+        }
+
+        // Recompute rates and text at most every RefreshInterval. Returns true when they changed.
+        bool Update(double now) noexcept
+        {
+            if (m_windowStart == 0.0)
+            {
+                m_windowStart = now;
+                m_sourceFrames = 0;
+                m_outputFrames = 0;
+                return false;
+            }
+
+            const double elapsed = now - m_windowStart;
+            if (elapsed < RefreshInterval)
+                return false;
+
+            m_sourceFps = m_sourceFrames / elapsed;
+            m_outputFps = m_outputFrames / elapsed;
+            m_sourceFrames = 0;
+            m_outputFrames = 0;
+            m_windowStart = now;
+            FormatLines();
+            return true;
+        }
+
+        void Reset() noexcept { *this = HudModel(); }
+
+        double SourceFps() const noexcept { return m_sourceFps; }
+        double OutputFps() const noexcept { return m_outputFps; }
+        double StageMilliseconds(HudStage stage) const noexcept { return m_stageMilliseconds[static_cast<size_t>(stage)]; }
+        uint64_t DroppedFrames() const noexcept { return m_droppedFrames; }
+        uint64_t RepeatedFrames() const noexcept { return m_repeatedFrames; }
+        double TargetFrameTime() const noexcept { return m_targetFrameTime; }
+        const History& FrameTimes() const noexcept { return m_history; }
+
+        size_t LineCount() const noexcept { return m_lineCount; }
+        const char* Line(size_t i) const noexcept { return m_lines[i]; }
+
+    private:
+        static constexpr double c_Smoothing = 0.1;
+
+        template<typename... TArgs>
+        void AddLine(const char* format, TArgs... args) noexcept
+        {
+            if (m_lineCount < MaxLines)
+                snprintf(m_lines[m_lineCount++], LineLength, format, args...);
+        }
+
+        void FormatLines() noexcept
+        {
+            m_lineCount = 0;
+            AddLine("source %6.1f fps", m_sourceFps);
+            AddLine("output %6.1f fps", m_outputFps);
+            for (size_t stage = 0; stage < static_cast<size_t>(HudStage::Count); stage++)
+                AddLine("%-8s %6.2f ms", HudStageName(static_cast<HudStage>(stage)), m_stageMilliseconds[stage]);
+            AddLine("dropped %llu  repeated %llu", static_cast<unsigned long long>(m_droppedFrames), static_cast<unsigned long long>(m_repeatedFrames));
+            AddLine("frame max %5.2f ms  target %5.2f", m_history.Max(), m_targetFrameTime);
+        }
+
+        History     m_history;
+        double      m_stageMilliseconds[static_cast<size_t>(HudStage::Count)] = {};
+        double      m_targetFrameTime = 0.0;
+        double      m_lastPresent = 0.0;
+        double      m_windowStart = 0.0;
+        double      m_sourceFps = 0.0;
+        double      m_outputFps = 0.0;
+        uint64_t    m_sourceFrames = 0;
+        uint64_t    m_outputFrames = 0;
+        uint64_t    m_droppedFrames = 0;
+        uint64_t    m_repeatedFrames = 0;
+        char        m_lines[MaxLines][LineLength] = {};
+        size_t      m_lineCount = 0;
+    };
+
+    // Adds the lifetime of a scope to one HUD stage.
+    class HudStageTimer
+    {
+    public:
+        HudStageTimer(HudModel& model, HudStage stage) noexcept : m_model(model), m_stage(stage), m_start(HudSeconds()) {}
+        ~HudStageTimer() { m_model.AddStageSample(m_stage, (HudSeconds() - m_start) * 1000.0); }
+
+        HudStageTimer(const HudStageTimer&) = delete;
+        HudStageTimer& operator=(const HudStageTimer&) = delete;
+
+    private:
+        HudModel&   m_model;
+        HudStage    m_stage;
+        double      m_start;
+    };
+}
@@ -0,0 +1,118 @@
+//
+// HudRenderer.cpp - Draws a HudModel through the viewer's SpriteBatch
+//
+
+#include "pch.h"
+#include "HudRenderer.h"
+#include "HudFont.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+using namespace DirectX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr float c_Padding = 4.0f;
+    constexpr float c_GraphRows = 24.0f;       // Graph height in font texels.
+
+    const XMVECTORF32 c_PanelColor = { { { 0.0f, 0.0f, 0.0f, 0.6f } } };
+    const XMVECTORF32 c_BarColor = { { { 0.2f, 0.8f, 0.3f, 1.0f } } };
+    const XMVECTORF32 c_SlowBarColor = { { { 0.9f, 0.2f, 0.2f, 1.0f } } };
+    const XMVECTORF32 c_TargetColor = { { { 0.9f, 0.9f, 0.9f, 1.0f } } };
+
+    void CreateTextureSRV(ID3D11Device* device, const void* pixels, UINT width, UINT height, UINT pitch, ID3D11ShaderResourceView** view)
+    {
+        CD3D11_TEXTURE2D_DESC desc(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+        D3D11_SUBRESOURCE_DATA initData = { pixels, pitch, 0 };
+        ComPtr<ID3D11Texture2D> texture;
+        ThrowIfFailed(device->CreateTexture2D(&desc, &initData, texture.GetAddressOf()));
+        ThrowIfFailed(device->CreateShaderResourceView(texture.Get(), nullptr, view));
+    }
+}
+
+void HudRenderer::CreateDeviceResources(ID3D11Device* device)
+{
+    Image atlas;
+    HudFont::BuildAtlas(atlas);
+    CreateTextureSRV(device, atlas.Data(), atlas.Width(), atlas.Height(), static_cast<UINT>(atlas.Pitch()), m_fontSRV.ReleaseAndGetAddressOf());
+
+    const uint32_t white = 0xFFFFFFFF;
+    CreateTextureSRV(device, &white, 1, 1, sizeof(white), m_whiteSRV.ReleaseAndGetAddressOf());
+
+    CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+    ThrowIfFailed(device->CreateSamplerState(&samplerDesc, m_pointSampler.ReleaseAndGetAddressOf()));
+}
+
+void HudRenderer::ReleaseResources() noexcept
+{
+    m_fontSRV.Reset();
+    m_whiteSRV.Reset();
+    m_pointSampler.Reset();
+}
+
+void HudRenderer::Draw(SpriteBatch* spriteBatch, const HudModel& model, XMFLOAT2 position, float scale, std::function<void()> setCustomShaders) const
+{
+    if (!m_fontSRV)
+        return;
+
+    size_t columns = 0;
+    for (size_t line = 0; line < model.LineCount(); line++)
+        columns = std::max(columns, std::strlen(model.Line(line)));
+
+    // One bar per history entry, one font texel wide.
+    const float lineHeight = HudFont::CellHeight * scale;
+    const float textHeight = model.LineCount() * lineHeight;
+    const float barWidth = scale;
+    const float graphWidth = HudModel::History::capacity * barWidth;
+    const float graphHeight = c_GraphRows * scale;
+    const float panelWidth = std::max(graphWidth, columns * HudFont::CellWidth * scale) + 2 * c_Padding;
+    const float panelHeight = textHeight + graphHeight + 3 * c_Padding;
+
+    spriteBatch->Begin(SpriteSortMode_Deferred, nullptr, m_pointSampler.Get(), nullptr, nullptr, setCustomShaders);
+    DrawRect(spriteBatch, position.x, position.y, panelWidth, panelHeight, c_PanelColor);
+
+    for (size_t line = 0; line < model.LineCount(); line++)
+        DrawString(spriteBatch, model.Line(line), { position.x + c_Padding, position.y + c_Padding + line * lineHeight }, scale);
+
+    // Scaled so the target frame time sits at half height or lower; slow frames turn red.
+    const auto& frameTimes = model.FrameTimes();
+    const float target = static_cast<float>(model.TargetFrameTime());
+    const float range = std::max(2.0f * target, frameTimes.Max());
+    const float graphBottom = position.y + 2 * c_Padding + textHeight + graphHeight;
+    if (range > 0.0f)
+    {
+        for (size_t i = 0; i < frameTimes.Size(); i++)
+        {
+            const float height = std::min(frameTimes[i] / range, 1.0f) * graphHeight;
+            const bool slow = target > 0.0f && frameTimes[i] > target * 1.5f;
+            DrawRect(spriteBatch, position.x + c_Padding + i * barWidth, graphBottom - height, barWidth, height, slow ? c_SlowBarColor : c_BarColor);
+        }
+        if (target > 0.0f)
+            DrawRect(spriteBatch, position.x + c_Padding, graphBottom - target / range * graphHeight, graphWidth, 1.0f, c_TargetColor);
+    }
+    spriteBatch->End();
+}
+
+void HudRenderer::DrawString(SpriteBatch* spriteBatch, const char* text, XMFLOAT2 position, float scale) const
+{
+    for (; *text != '\0'; text++, position.x += HudFont::CellWidth * scale)
+    {
+        if (*text == ' ')
+            continue;
+
+        uint32_t x, y;
+        HudFont::CellOrigin(*text, x, y);
+        const RECT source = { LONG(x), LONG(y), LONG(x + HudFont::CellWidth), LONG(y + HudFont::CellHeight) };
+        spriteBatch->Draw(m_fontSRV.Get(), position, &source, Colors::White, 0.f, XMFLOAT2(0, 0), scale);
+    }
+}
+
+void HudRenderer::DrawRect(SpriteBatch* spriteBatch, float x, float y, float width, float height, FXMVECTOR color) const
+{
+    spriteBatch->Draw(m_whiteSRV.Get(), XMFLOAT2(x, y), nullptr, color, 0.f, XMFLOAT2(0, 0), XMFLOAT2(width, height));
+}
@@ -0,0 +1,34 @@
+//
+// HudRenderer.h - Draws a HudModel through the viewer's SpriteBatch
+//
+
+#pragma once
+
+#include "HudModel.h"
+
+#include <SpriteBatch.h>
+
+#include <functional>
+
+namespace DX
+{
+    // Text from the built-in bitmap font and a frame-time bar graph, all as SpriteBatch quads.
+    // Draw runs its own Begin/End with point sampling so the font stays crisp when scaled, passing
+    // setCustomShaders on to Begin so the caller can convert the quads to the swap chain's colors.
+    class HudRenderer
+    {
+    public:
+        void CreateDeviceResources(ID3D11Device* device);
+        void Draw(DirectX::SpriteBatch* spriteBatch, const HudModel& model, DirectX::XMFLOAT2 position, float scale = 2.0f,
+            std::function<void()> setCustomShaders = nullptr) const;
+        void ReleaseResources() noexcept;
+
+    private:
+        void DrawString(DirectX::SpriteBatch* spriteBatch, const char* text, DirectX::XMFLOAT2 position, float scale) const;
+        void DrawRect(DirectX::SpriteBatch* spriteBatch, float x, float y, float width, float height, DirectX::FXMVECTOR color) const;
+
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_fontSRV;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_whiteSRV;
+        Microsoft::WRL::ComPtr<ID3D11SamplerState>          m_pointSampler;
+    };
+}
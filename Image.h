@@ -0,0 +1,97 @@
+//
+// Image.h - CPU-side pixel buffers shared by the reference kernels
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace DX
+{
+    // Non-owning view of a 2D pixel buffer. Pitch is in bytes.
+    template<typename T>
+    struct BasicImageView
+    {
+        T* data = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        size_t pitch = 0;
+
+        using Byte = std::conditional_t<std::is_const_v<T>, const uint8_t, uint8_t>;
+
+        T* Row(uint32_t y) const noexcept
+        {
+            return reinterpret_cast<T*>(reinterpret_cast<Byte*>(data) + y * pitch);
+        }
+
+        // Writable views convert to read-only ones.
+        template<typename U = T, typename = std::enable_if_t<!std::is_const_v<U>>>
+        operator BasicImageView<const U>() const noexcept { return { data, width, height, pitch }; }
+    };
+
+    using ImageView = BasicImageView<uint8_t>;
+    using ConstImageView = BasicImageView<const uint8_t>;
+
+    // Copy the overlapping rows of two views with the same pixel size.
+    inline void CopyImage(ConstImageView src, ImageView dst, uint32_t bytesPerPixel)
+    {
+        const uint32_t width = src.width < dst.width ? src.width : dst.width;
+        const uint32_t height = src.height < dst.height ? src.height : dst.height;
+        for (uint32_t y = 0; y < height; y++)
+            std::memcpy(dst.Row(y), src.Row(y), size_t(width) * bytesPerPixel);
+    }
+
+    // Owning, 64-byte aligned pixel buffer with rows padded to 64 bytes.
+    class Image
+    {
+    public:
+        static constexpr size_t Alignment = 64;
+
+        Image() = default;
+        Image(uint32_t width, uint32_t height, uint32_t bytesPerPixel) { Resize(width, height, bytesPerPixel); }
+
+        void Resize(uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+        {
+            const size_t pitch = (size_t(width) * bytesPerPixel + Alignment - 1) & ~(Alignment - 1);
+            if (pitch * height > m_capacity)
+            {
+                m_data.reset(static_cast<uint8_t*>(::operator new(pitch * height, std::align_val_t(Alignment))));
+                m_capacity = pitch * height;
+            }
+            m_width = width;
+            m_height = height;
+            m_bytesPerPixel = bytesPerPixel;
+            m_pitch = pitch;
+        }
+
+        ImageView View() noexcept { return { m_data.get(), m_width, m_height, m_pitch }; }
+        ConstImageView View() const noexcept { return { m_data.get(), m_width, m_height, m_pitch }; }
+
+        uint8_t* Data() noexcept { return m_data.get(); }
+        const uint8_t* Data() const noexcept { return m_data.get(); }
+        uint32_t Width() const noexcept { return m_width; }
+        uint32_t Height() const noexcept { return m_height; }
+        uint32_t BytesPerPixel() const noexcept { return m_bytesPerPixel; }
+        size_t Pitch() const noexcept { return m_pitch; }
+        size_t SizeInBytes() const noexcept { return m_pitch * m_height; }
+
+    private:
+        struct AlignedDelete
+        {
+            void operator()(uint8_t* p) const noexcept { ::operator delete(p, std::align_val_t(Alignment)); }
+        };
+
+        std::unique_ptr<uint8_t, AlignedDelete> m_data;
+        size_t m_capacity = 0;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        uint32_t m_bytesPerPixel = 0;
+        size_t m_pitch = 0;
+    };
+}
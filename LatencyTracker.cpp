@@ -0,0 +1,158 @@
+//
+// LatencyTracker.cpp - Capture-to-photon latency bookkeeping for real and interpolated frames
+//
+
+#include "LatencyTracker.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace DX;
+
+void LatencyHistogram::Add(double milliseconds) noexcept
+{
+    milliseconds = std::max(0.0, milliseconds);
+    const size_t bucket = std::min(BucketCount - 1, static_cast<size_t>(milliseconds / BucketMilliseconds));
+    m_buckets[bucket]++;
+    m_min = m_count == 0 ? milliseconds : std::min(m_min, milliseconds);
+    m_max = std::max(m_max, milliseconds);
+    m_sum += milliseconds;
+    m_count++;
+}
+
+void LatencyHistogram::Clear() noexcept
+{
+    *this = LatencyHistogram();
+}
+
+double LatencyHistogram::Percentile(double p) const noexcept
+{
+    if (m_count == 0)
+        return 0.0;
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * double(m_count) + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BucketCount; bucket++)
+    {
+        seen += m_buckets[bucket];
+        if (seen >= rank)
+            return std::min(m_max, (bucket + 1) * BucketMilliseconds);
+    }
+    return m_max;
+}
+
+void LatencyTracker::Start(size_t maxRecords)
+{
+    m_records.clear();
+    m_records.reserve(maxRecords);
+    m_maxRecords = maxRecords;
+    m_pendingCount = 0;
+    for (auto& kind : m_histograms)
+    {
+        for (auto& histogram : kind)
+            histogram.Clear();
+    }
+    m_recording = true;
+}
+
+void LatencyTracker::OnPresent(LatencyFrameKind kind, uint64_t sourceTicks, uint64_t presentTicks, uint32_t presentId) noexcept
+{
+    if (!m_recording || sourceTicks == 0 || presentTicks < sourceTicks)
+        return;
+
+    m_histograms[static_cast<size_t>(kind)][static_cast<size_t>(LatencyPoint::Present)].Add(TicksToMilliseconds(presentTicks - sourceTicks));
+
+    size_t record = c_NoRecord;
+    if (m_records.size() < m_maxRecords)
+    {
+        record = m_records.size();
+        m_records.push_back({ kind, presentId, sourceTicks, presentTicks, 0 });
+    }
+
+    // The oldest waiting frame gives way if statistics never arrive.
+    if (m_pendingCount == PendingCapacity)
+    {
+        std::move(m_pending.begin() + 1, m_pending.end(), m_pending.begin());
+        m_pendingCount--;
+    }
+    m_pending[m_pendingCount++] = { presentId, kind, sourceTicks, record };
+}
+
+void LatencyTracker::OnDisplayed(uint32_t presentId, uint64_t vblankTicks) noexcept
+{
+    if (!m_recording)
+        return;
+
+    // Present ids wrap at 32 bits, so compare by signed distance.
+    size_t kept = 0;
+    for (size_t i = 0; i < m_pendingCount; i++)
+    {
+        const Pending& pending = m_pending[i];
+        const int32_t distance = static_cast<int32_t>(pending.presentId - presentId);
+        if (distance > 0)
+        {
+            m_pending[kept++] = pending;
+            continue;
+        }
+
+        if (distance == 0 && vblankTicks >= pending.sourceTicks)
+        {
+            m_histograms[static_cast<size_t>(pending.kind)][static_cast<size_t>(LatencyPoint::Display)].Add(TicksToMilliseconds(vblankTicks - pending.sourceTicks));
+            if (pending.record != c_NoRecord)
+                m_records[pending.record].displayTicks = vblankTicks;
+        }
+    }
+    m_pendingCount = kept;
+}
+
+bool LatencyTracker::WriteCsv(const std::string& path) const
+{
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, path.c_str(), "wb");
+#else
+    file = fopen(path.c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+
+    fprintf(file, "frame,kind,present_id,present_ms,display_ms\n");
+    for (size_t i = 0; i < m_records.size(); i++)
+    {
+        const LatencyRecord& record = m_records[i];
+        fprintf(file, "%zu,%s,%u,%.3f,", i, LatencyFrameKindName(record.kind), record.presentId,
+            TicksToMilliseconds(record.presentTicks - record.sourceTicks));
+        if (record.displayTicks != 0)
+            fprintf(file, "%.3f\n", TicksToMilliseconds(record.displayTicks - record.sourceTicks));
+        else
+            fprintf(file, "\n");
+    }
+
+    const bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+std::string LatencyTracker::Summary() const
+{
+    static const char* const pointNames[] = { "present", "display" };
+
+    std::string summary;
+    char line[192];
+    for (size_t kind = 0; kind < static_cast<size_t>(LatencyFrameKind::Count); kind++)
+    {
+        for (size_t point = 0; point < static_cast<size_t>(LatencyPoint::Count); point++)
+        {
+            const LatencyHistogram& histogram = m_histograms[kind][point];
+            if (histogram.Count() == 0)
+                continue;
+
+            snprintf(line, sizeof(line), "%-12s to %-7s %6llu frames  mean %6.2f  p50 %6.2f  p90 %6.2f  p99 %6.2f  max %6.2f ms\n",
+                LatencyFrameKindName(static_cast<LatencyFrameKind>(kind)), pointNames[point],
+                static_cast<unsigned long long>(histogram.Count()), histogram.Mean(),
+                histogram.Percentile(0.5), histogram.Percentile(0.9), histogram.Percentile(0.99), histogram.Max());
+            summary += line;
+        }
+    }
+    return summary;
+}
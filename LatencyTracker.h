@@ -0,0 +1,128 @@
+//
+// LatencyTracker.h - Capture-to-photon latency bookkeeping for real and interpolated frames
+//
+// Timestamps are raw ticks of one clock (QPC in the viewer, simulated time in the pacing tool).
+// Each shown frame carries the source timestamp of the newest captured frame it was built from.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    enum class LatencyFrameKind
+    {
+        Real,
+        Interpolated,
+        Count,
+    };
+
+    inline const char* LatencyFrameKindName(LatencyFrameKind kind) noexcept
+    {
+        return kind == LatencyFrameKind::Interpolated ? "interpolated" : "real";
+    }
+
+    // Where latency is measured to: the Present call returning, or the vblank that scanned the frame out.
+    enum class LatencyPoint
+    {
+        Present,
+        Display,
+        Count,
+    };
+
+    // Fixed 0.1 ms buckets up to MaxMilliseconds; larger values land in the last bucket.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr double BucketMilliseconds = 0.1;
+        static constexpr double MaxMilliseconds = 250.0;
+        static constexpr size_t BucketCount = static_cast<size_t>(MaxMilliseconds / BucketMilliseconds) + 1;
+
+        void Add(double milliseconds) noexcept;
+        void Clear() noexcept;
+
+        uint64_t Count() const noexcept { return m_count; }
+        double Mean() const noexcept { return m_count == 0 ? 0.0 : m_sum / double(m_count); }
+        double Min() const noexcept { return m_count == 0 ? 0.0 : m_min; }
+        double Max() const noexcept { return m_max; }
+
+        // Upper edge of the bucket holding the p-th fraction of samples, p in [0, 1].
+        double Percentile(double p) const noexcept;
+
+    private:
+        std::array<uint32_t, BucketCount>   m_buckets = {};
+        uint64_t                            m_count = 0;
+        double                              m_sum = 0.0;
+        double                              m_min = 0.0;
+        double                              m_max = 0.0;
+    };
+
+    struct LatencyRecord
+    {
+        LatencyFrameKind    kind = LatencyFrameKind::Real;
+        uint32_t            presentId = 0;
+        uint64_t            sourceTicks = 0;
+        uint64_t            presentTicks = 0;
+        uint64_t            displayTicks = 0;       // 0 until present statistics report the frame.
+    };
+
+    class LatencyTracker
+    {
+    public:
+        // Vblank times arrive a frame or two after the Present that queued them.
+        static constexpr size_t PendingCapacity = 16;
+
+        explicit LatencyTracker(uint64_t ticksPerSecond = 1000000000) : m_ticksPerSecond(ticksPerSecond) {}
+
+        // Start a recording with room for maxRecords per-frame rows. Histograms keep counting past that.
+        void Start(size_t maxRecords = size_t(1) << 16);
+        void Stop() noexcept { m_recording = false; }
+        bool IsRecording() const noexcept { return m_recording; }
+
+        // A frame built from a capture stamped sourceTicks was presented. presentId increases per Present.
+        void OnPresent(LatencyFrameKind kind, uint64_t sourceTicks, uint64_t presentTicks, uint32_t presentId) noexcept;
+
+        // Present statistics: the Present numbered presentId reached the screen at vblankTicks.
+        // Earlier frames still waiting are dropped; their vblank is no longer reported.
+        void OnDisplayed(uint32_t presentId, uint64_t vblankTicks) noexcept;
+
+        const LatencyHistogram& Histogram(LatencyFrameKind kind, LatencyPoint point) const noexcept
+        {
+            return m_histograms[static_cast<size_t>(kind)][static_cast<size_t>(point)];
+        }
+
+        const std::vector<LatencyRecord>& Records() const noexcept { return m_records; }
+        double TicksToMilliseconds(uint64_t ticks) const noexcept { return 1000.0 * double(ticks) / double(m_ticksPerSecond); }
+
+        // One row per presented frame: kind, present and display latency in milliseconds.
+        bool WriteCsv(const std::string& path) const;
+
+        // Count, mean and p50/p90/p99/max per frame kind and measurement point, one line each.
+        std::string Summary() const;
+
+    private:
+        struct Pending
+        {
+            uint32_t            presentId;
+            LatencyFrameKind    kind;
+            uint64_t            sourceTicks;
+            size_t              record;
+        };
+
+        static constexpr size_t c_NoRecord = SIZE_MAX;
+
+        uint64_t                                m_ticksPerSecond;
+        bool                                    m_recording = false;
+        std::vector<LatencyRecord>              m_records;
+        size_t                                  m_maxRecords = 0;
+        std::array<Pending, PendingCapacity>    m_pending = {};
+        size_t                                  m_pendingCount = 0;
+
+        LatencyHistogram m_histograms[static_cast<size_t>(LatencyFrameKind::Count)][static_cast<size_t>(LatencyPoint::Count)];
+    };
+}
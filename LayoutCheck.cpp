@@ -0,0 +1,240 @@
+//
+// LayoutCheck.cpp - Map desktop points through a DesktopLayout, and check the mapping on random layouts
+//
+
+#include "ToolMain.h"
+#include "DesktopLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_Tolerance = 1e-6;
+
+    // "X,Y,WxH[,ROT]" outputs separated by ';', e.g. the original setup "0,0,1920x1080;-1920,0,1920x1080".
+    void ParseOutputs(const std::string& spec, DesktopLayout& layout)
+    {
+        size_t start = 0;
+        while (start < spec.size())
+        {
+            const size_t end = std::min(spec.find(';', start), spec.size());
+            const std::string item = spec.substr(start, end - start);
+            char* cursor = nullptr;
+            DesktopRect bounds;
+            bounds.left = static_cast<int32_t>(std::strtol(item.c_str(), &cursor, 10));
+            bounds.top = static_cast<int32_t>(std::strtol(cursor + (*cursor == ',' ? 1 : 0), &cursor, 10));
+            const long width = std::strtol(cursor + (*cursor == ',' ? 1 : 0), &cursor, 10);
+            const long height = std::strtol(cursor + (*cursor == 'x' ? 1 : 0), &cursor, 10);
+            const long degrees = *cursor == ',' ? std::strtol(cursor + 1, &cursor, 10) : 0;
+            if (width <= 0 || height <= 0 || degrees % 90 != 0)
+                throw std::runtime_error("Bad output " + item + ", expected X,Y,WxH[,0|90|180|270]");
+            bounds.right = bounds.left + static_cast<int32_t>(width);
+            bounds.bottom = bounds.top + static_cast<int32_t>(height);
+            layout.AddOutput(layout.OutputCount(), "output" + std::to_string(layout.OutputCount()), bounds,
+                static_cast<OutputRotation>((degrees / 90) % 4));
+            start = end + 1;
+        }
+    }
+
+    int BruteForceFind(const DesktopLayout& layout, Point2D point)
+    {
+        for (size_t i = 0; i < layout.OutputCount(); i++)
+        {
+            if (layout.Output(i).bounds.Contains(point.x, point.y))
+                return static_cast<int>(i);
+        }
+        return DesktopLayout::NoOutput;
+    }
+
+    bool Near(Point2D a, double x, double y)
+    {
+        return std::fabs(a.x - x) < c_Tolerance && std::fabs(a.y - y) < c_Tolerance;
+    }
+
+    // Every mapping property for one layout; returns the number of failures.
+    uint64_t CheckLayout(const DesktopLayout& layout, std::mt19937& random, uint64_t& points)
+    {
+        uint64_t failures = 0;
+        const DesktopRect& all = layout.VirtualBounds();
+        std::uniform_real_distribution<double> x(all.left - 100.0, all.right + 100.0);
+        std::uniform_real_distribution<double> y(all.top - 100.0, all.bottom + 100.0);
+        std::uniform_int_distribution<int> hint(-1, static_cast<int>(layout.OutputCount()));
+
+        // Lookup matches a plain scan, with any hint, including exactly on output edges.
+        for (int i = 0; i < 2000; i++)
+        {
+            Point2D point = { x(random), y(random) };
+            if (i % 4 == 0)
+            {
+                const DesktopRect& edges = layout.Output(static_cast<size_t>(i / 4) % layout.OutputCount()).bounds;
+                point = { double(i % 8 == 0 ? edges.right : edges.left), double(i % 3 == 0 ? edges.bottom : edges.top) };
+            }
+            failures += layout.FindOutput(point, hint(random)) != BruteForceFind(layout, point) ? 1 : 0;
+            points++;
+        }
+
+        for (size_t i = 0; i < layout.OutputCount(); i++)
+        {
+            const DesktopOutput& output = layout.Output(i);
+            const DesktopRect& b = output.bounds;
+            const double w = output.imageWidth;
+            const double h = output.imageHeight;
+
+            // The output's corners land on the image's corners, and turn the way the sprite rotation says.
+            const Point2D topLeft = output.desktopToImage.Apply({ double(b.left), double(b.top) });
+            const Point2D bottomRight = output.desktopToImage.Apply({ double(b.right), double(b.bottom) });
+            const bool cornersOk = std::fabs(topLeft.x + bottomRight.x - w) < c_Tolerance && std::fabs(topLeft.y + bottomRight.y - h) < c_Tolerance
+                && (Near(topLeft, 0, 0) || Near(topLeft, w, 0) || Near(topLeft, 0, h) || Near(topLeft, w, h));
+            const double angle = std::atan2(output.desktopToImage.yx, output.desktopToImage.xx);
+            const double expected = ImageRotationRadians(output.rotation);
+            const bool angleOk = std::fabs(std::remainder(angle - expected, 2.0 * 3.14159265358979323846)) < c_Tolerance;
+            const bool sizeOk = (output.rotation == OutputRotation::Rotate90 || output.rotation == OutputRotation::Rotate270)
+                ? (w == b.Height() && h == b.Width()) : (w == b.Width() && h == b.Height());
+            failures += cornersOk && angleOk && sizeOk ? 0 : 1;
+
+            // Points inside the output stay inside the image, and the viewer mapping inverts.
+            Affine2D inverse;
+            if (!output.desktopToViewer.Invert(inverse))
+            {
+                failures++;
+                continue;
+            }
+            std::uniform_real_distribution<double> u(b.left, b.right);
+            std::uniform_real_distribution<double> v(b.top, b.bottom);
+            for (int j = 0; j < 200; j++)
+            {
+                const Point2D point = { u(random), v(random) };
+                const Point2D image = output.desktopToImage.Apply(point);
+                const Point2D back = inverse.Apply(output.desktopToViewer.Apply(point));
+                const bool inside = image.x >= -c_Tolerance && image.x <= w + c_Tolerance && image.y >= -c_Tolerance && image.y <= h + c_Tolerance;
+                failures += inside && Near(back, point.x, point.y) ? 0 : 1;
+                points++;
+            }
+        }
+        return failures;
+    }
+
+    // Each output's image lands inside its own tile, and the tiles cover the viewer without overlapping.
+    uint64_t CheckTiles(const DesktopLayout& layout, double viewerWidth, double viewerHeight)
+    {
+        uint64_t failures = 0;
+        double area = 0.0;
+        for (size_t i = 0; i < layout.OutputCount(); i++)
+        {
+            const ViewerRect tile = TileRect(i, layout.OutputCount(), viewerWidth, viewerHeight);
+            area += tile.width * tile.height;
+            const DesktopOutput& output = layout.Output(i);
+            const Point2D corners[] = {
+                { double(output.bounds.left), double(output.bounds.top) },
+                { double(output.bounds.right), double(output.bounds.bottom) },
+            };
+            for (const Point2D& corner : corners)
+            {
+                const Point2D viewer = output.desktopToViewer.Apply(corner);
+                const bool inside = viewer.x >= tile.left - c_Tolerance && viewer.x <= tile.left + tile.width + c_Tolerance
+                    && viewer.y >= tile.top - c_Tolerance && viewer.y <= tile.top + tile.height + c_Tolerance;
+                failures += inside ? 0 : 1;
+            }
+            for (size_t j = 0; j < i; j++)
+            {
+                const ViewerRect other = TileRect(j, layout.OutputCount(), viewerWidth, viewerHeight);
+                const bool overlap = tile.left + c_Tolerance < other.left + other.width && other.left + c_Tolerance < tile.left + tile.width
+                    && tile.top + c_Tolerance < other.top + other.height && other.top + c_Tolerance < tile.top + tile.height;
+                failures += overlap ? 1 : 0;
+            }
+        }
+        failures += area <= viewerWidth * viewerHeight + c_Tolerance ? 0 : 1;
+        return failures;
+    }
+}
+
+int DX::LayoutCheckMain(const ToolArgs& args)
+{
+    uint32_t viewerWidth = 0, viewerHeight = 0;
+    if (!args.GetSize("viewer", viewerWidth, viewerHeight))
+    {
+        viewerWidth = 1280;
+        viewerHeight = 720;
+    }
+
+    // --check N: random layouts of one to six outputs, some touching, some overlapping, any rotation.
+    if (args.Has("check"))
+    {
+        const uint32_t layouts = std::max(1u, args.GetUInt("check", 1000));
+        std::mt19937 random(args.GetUInt("seed", 1));
+        std::uniform_int_distribution<int> count(1, 6), size(480, 3840), offset(-8000, 8000), rotation(0, 3), adjacent(0, 2);
+        uint64_t failures = 0, points = 0;
+        for (uint32_t i = 0; i < layouts; i++)
+        {
+            DesktopLayout layout;
+            const int outputs = count(random);
+            DesktopRect previous;
+            for (int j = 0; j < outputs; j++)
+            {
+                DesktopRect bounds;
+                const int placement = j == 0 ? 0 : adjacent(random);
+                bounds.left = placement == 1 ? previous.right : placement == 2 ? previous.left : offset(random);
+                bounds.top = placement == 2 ? previous.bottom : placement == 1 ? previous.top : offset(random);
+                bounds.right = bounds.left + size(random);
+                bounds.bottom = bounds.top + size(random);
+                layout.AddOutput(j, "output" + std::to_string(j), bounds, static_cast<OutputRotation>(rotation(random)));
+                previous = bounds;
+            }
+            // Half the layouts show the first output alone, the others tile every output.
+            const DesktopOutput& shown = layout.Output(0);
+            layout.SetImageToViewer(FitImage(shown.imageWidth, shown.imageHeight, { 0.0, 0.0, double(viewerWidth), double(viewerHeight) }));
+            const bool tiled = i % 2 == 1;
+            for (size_t j = 0; tiled && j < layout.OutputCount(); j++)
+            {
+                const DesktopOutput& output = layout.Output(j);
+                layout.SetImageToViewer(j, FitImage(output.imageWidth, output.imageHeight, TileRect(j, layout.OutputCount(), viewerWidth, viewerHeight)));
+            }
+            failures += CheckLayout(layout, random, points);
+            failures += tiled ? CheckTiles(layout, viewerWidth, viewerHeight) : 0;
+        }
+
+        printf("layout: %u random layouts, %llu points checked, %llu failures\n", layouts, static_cast<unsigned long long>(points),
+            static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Desktop layout mapping failed its checks");
+        return 0;
+    }
+
+    DesktopLayout layout;
+    ParseOutputs(args.Get("outputs", "0,0,1920x1080;-1920,0,1920x1080"), layout);
+    const uint32_t shownIndex = std::min<uint32_t>(args.GetUInt("output", 0), static_cast<uint32_t>(layout.OutputCount() - 1));
+    const DesktopOutput& shown = layout.Output(shownIndex);
+    layout.SetImageToViewer(FitImage(shown.imageWidth, shown.imageHeight, { 0.0, 0.0, double(viewerWidth), double(viewerHeight) }));
+    printf("%s", layout.Describe().c_str());
+
+    const std::string pointText = args.Get("point");
+    if (pointText.empty())
+        return 0;
+    char* cursor = nullptr;
+    Point2D point;
+    point.x = std::strtod(pointText.c_str(), &cursor);
+    point.y = std::strtod(cursor + (*cursor == ',' ? 1 : 0), nullptr);
+
+    const int found = layout.FindOutput(point);
+    if (found == DesktopLayout::NoOutput)
+    {
+        printf("layout: (%g, %g) is on no output\n", point.x, point.y);
+        return 0;
+    }
+    const DesktopOutput& output = layout.Output(found);
+    const Point2D image = output.desktopToImage.Apply(point);
+    const Point2D viewer = layout.Output(shownIndex).desktopToViewer.Apply(point);
+    printf("layout: (%g, %g) is on output %d at image (%.2f, %.2f)", point.x, point.y, found, image.x, image.y);
+    if (found == static_cast<int>(shownIndex))
+        printf(", viewer (%.2f, %.2f) in %ux%u\n", viewer.x, viewer.y, viewerWidth, viewerHeight);
+    else
+        printf(", not the shown output %u\n", shownIndex);
+    return 0;
+}
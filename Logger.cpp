@@ -0,0 +1,425 @@
+//
+// Logger.cpp - Non-blocking printf-style logging through a lock-free ring of binary records
+//
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+#include "Logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+#ifdef _DEBUG
+std::atomic<LogLevel> DX::g_logMinLevel{ LogLevel::Debug };
+#else
+std::atomic<LogLevel> DX::g_logMinLevel{ LogLevel::Info };
+#endif
+
+namespace
+{
+    static_assert((c_LogRingCapacity & (c_LogRingCapacity - 1)) == 0, "Log ring capacity must be a power of two");
+
+    // How long the writer sleeps when the ring is empty.
+    constexpr auto c_IdleWait = std::chrono::milliseconds(5);
+
+    // A bounded multi-producer queue slot: sequence == position means free for the producer claiming
+    // position, position + 1 means published for the consumer.
+    struct LogCell
+    {
+        LogRecord               record;
+        std::atomic<uint64_t>   sequence{ 0 };
+        uint64_t                position = 0;
+    };
+
+    struct LogState
+    {
+        std::unique_ptr<LogCell[]>                  cells{ new LogCell[c_LogRingCapacity] };
+        alignas(64) std::atomic<uint64_t>           tail{ 0 };
+        alignas(64) std::atomic<uint64_t>           dropped{ 0 };
+        std::atomic<uint16_t>                       nextThread{ 0 };
+        std::chrono::steady_clock::time_point       start = std::chrono::steady_clock::now();
+
+        // The consumer side: ring head, sinks and drop reporting, owned by whoever holds the mutex.
+        std::mutex                                  mutex;
+        uint64_t                                    head = 0;
+        uint64_t                                    reportedDropped = 0;
+        std::vector<std::unique_ptr<LogSink>>       sinks;
+
+        std::thread                                 writer;
+        std::condition_variable                     wake;
+        bool                                        running = false;
+
+        LogState()
+        {
+            for (size_t i = 0; i < c_LogRingCapacity; i++)
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // A writer still running at exit is stopped rather than left joinable.
+        ~LogState()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+            wake.notify_one();
+            if (writer.joinable())
+                writer.join();
+        }
+    };
+
+    LogState& State()
+    {
+        static LogState state;
+        return state;
+    }
+
+    thread_local uint16_t t_logThread = 0;
+
+    uint16_t ThreadIndex(LogState& state) noexcept
+    {
+        if (t_logThread == 0)
+            t_logThread = static_cast<uint16_t>(state.nextThread.fetch_add(1, std::memory_order_relaxed) + 1);
+        return t_logThread;
+    }
+
+    void WriteLine(LogState& state, LogLevel level, const std::string& line)
+    {
+        for (auto& sink : state.sinks)
+        {
+            if (level >= sink->minLevel)
+                sink->Write(level, line);
+        }
+    }
+
+    // Format and write every published record. Caller holds state.mutex.
+    size_t Drain(LogState& state)
+    {
+        size_t drained = 0;
+        for (;;)
+        {
+            LogCell& cell = state.cells[state.head & (c_LogRingCapacity - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != state.head + 1)
+                break;
+
+            WriteLine(state, cell.record.level, FormatLogRecord(cell.record));
+            cell.sequence.store(state.head + c_LogRingCapacity, std::memory_order_release);
+            state.head++;
+            drained++;
+        }
+
+        const uint64_t dropped = state.dropped.load(std::memory_order_relaxed);
+        if (dropped != state.reportedDropped)
+        {
+            LogRecord record = {};
+            record.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - state.start).count());
+            record.format = "Log: ring full, dropped %llu records";
+            record.level = LogLevel::Warning;
+            LogDetail::Pack(record, dropped - state.reportedDropped);
+            record.argCount = 1;
+            WriteLine(state, record.level, FormatLogRecord(record));
+            state.reportedDropped = dropped;
+        }
+        return drained;
+    }
+
+    void FlushSinks(LogState& state)
+    {
+        for (auto& sink : state.sinks)
+            sink->Flush();
+    }
+
+    void WriterLoop(LogState& state)
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        while (state.running)
+        {
+            if (Drain(state) != 0)
+                FlushSinks(state);
+            else
+                state.wake.wait_for(lock, c_IdleWait);
+        }
+    }
+
+    // Append one printf conversion of arg, reinterpreting the stored bits as the conversion expects.
+    void AppendConversion(std::string& out, std::string spec, char conversion, const LogRecord& record, size_t arg)
+    {
+        char buffer[128];
+        const uint64_t bits = record.args[arg];
+        const LogArgType type = record.types[arg];
+        double asDouble = 0.0;
+        std::memcpy(&asDouble, &bits, sizeof(asDouble));
+
+        switch (conversion)
+        {
+        case 'd': case 'i':
+            spec += "lld";
+            snprintf(buffer, sizeof(buffer), spec.c_str(), type == LogArgType::Double ? static_cast<long long>(asDouble) : static_cast<long long>(bits));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            spec += "ll";
+            spec += conversion;
+            snprintf(buffer, sizeof(buffer), spec.c_str(), type == LogArgType::Double ? static_cast<unsigned long long>(asDouble) : static_cast<unsigned long long>(bits));
+            break;
+        case 'c':
+            spec += 'c';
+            snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(bits));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec += conversion;
+            snprintf(buffer, sizeof(buffer), spec.c_str(), type == LogArgType::Double ? asDouble :
+                type == LogArgType::Signed ? static_cast<double>(static_cast<int64_t>(bits)) : static_cast<double>(bits));
+            break;
+        case 's':
+            spec += 's';
+            if (type != LogArgType::String)
+                snprintf(buffer, sizeof(buffer), "<not a string>");
+            else
+            {
+                // Strings may be longer than the scratch buffer.
+                std::string text(record.text + bits);
+                if (spec == "%s")
+                {
+                    out += text;
+                    return;
+                }
+                snprintf(buffer, sizeof(buffer), spec.c_str(), text.c_str());
+            }
+            break;
+        case 'p':
+            snprintf(buffer, sizeof(buffer), "%p", reinterpret_cast<void*>(static_cast<uintptr_t>(bits)));
+            break;
+        default:
+            snprintf(buffer, sizeof(buffer), "<bad conversion %c>", conversion);
+            break;
+        }
+        out += buffer;
+    }
+}
+
+const char* DX::LogLevelName(LogLevel level) noexcept
+{
+    switch (level)
+    {
+    case LogLevel::Debug:   return "DEBUG";
+    case LogLevel::Info:    return "INFO";
+    case LogLevel::Warning: return "WARN";
+    case LogLevel::Error:   return "ERROR";
+    }
+    return "?";
+}
+
+bool DX::LogLevelFromName(const char* name, LogLevel& level) noexcept
+{
+    static const struct { const char* name; LogLevel level; } levels[] =
+    {
+        { "debug", LogLevel::Debug },
+        { "info", LogLevel::Info },
+        { "warning", LogLevel::Warning },
+        { "error", LogLevel::Error },
+    };
+    for (auto const& entry : levels)
+    {
+        if (std::strcmp(name, entry.name) == 0)
+        {
+            level = entry.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+LogRecord* LogDetail::BeginRecord(LogLevel level, const char* format) noexcept
+{
+    LogState& state = State();
+    uint64_t position = state.tail.load(std::memory_order_relaxed);
+    LogCell* cell = nullptr;
+    for (;;)
+    {
+        cell = &state.cells[position & (c_LogRingCapacity - 1)];
+        const int64_t distance = static_cast<int64_t>(cell->sequence.load(std::memory_order_acquire) - position);
+        if (distance == 0)
+        {
+            if (state.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (distance < 0)
+        {
+            // The writer is a full lap behind.
+            state.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+            position = state.tail.load(std::memory_order_relaxed);
+    }
+
+    cell->position = position;
+    LogRecord& record = cell->record;
+    record.timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - state.start).count());
+    record.format = format;
+    record.level = level;
+    record.argCount = 0;
+    record.thread = ThreadIndex(state);
+    record.textUsed = 0;
+    return &record;
+}
+
+void LogDetail::CommitRecord(LogRecord* record) noexcept
+{
+    // The record is the first member of its cell.
+    LogCell* cell = reinterpret_cast<LogCell*>(record);
+    cell->sequence.store(cell->position + 1, std::memory_order_release);
+}
+
+std::string DX::FormatLogRecord(const LogRecord& record)
+{
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "%11.6f %-5s [t%u] ", double(record.timestamp) * 1e-9, LogLevelName(record.level), record.thread);
+
+    std::string out = prefix;
+    size_t arg = 0;
+    for (const char* cursor = record.format; *cursor != '\0'; cursor++)
+    {
+        if (*cursor != '%')
+        {
+            out += *cursor;
+            continue;
+        }
+        if (cursor[1] == '%')
+        {
+            out += '%';
+            cursor++;
+            continue;
+        }
+
+        // Keep flags, width and precision; drop length modifiers, since every argument was widened.
+        std::string spec = "%";
+        cursor++;
+        while (*cursor != '\0' && std::strchr("-+ #0123456789.", *cursor) != nullptr)
+            spec += *cursor++;
+        while (*cursor != '\0' && std::strchr("hlLzjt", *cursor) != nullptr)
+            cursor++;
+        if (*cursor == '\0')
+            break;
+
+        if (arg >= record.argCount)
+            out += "<missing>";
+        else
+            AppendConversion(out, spec, *cursor, record, arg++);
+    }
+    return out;
+}
+
+void StderrLogSink::Write(LogLevel, const std::string& line)
+{
+    fputs(line.c_str(), stderr);
+    fputc('\n', stderr);
+}
+
+void StderrLogSink::Flush()
+{
+    fflush(stderr);
+}
+
+FileLogSink::FileLogSink(const std::string& path, bool append)
+{
+#ifdef _WIN32
+    fopen_s(&m_file, path.c_str(), append ? "ab" : "wb");
+#else
+    m_file = fopen(path.c_str(), append ? "ab" : "wb");
+#endif
+}
+
+FileLogSink::~FileLogSink()
+{
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+void FileLogSink::Write(LogLevel, const std::string& line)
+{
+    if (m_file == nullptr)
+        return;
+    fputs(line.c_str(), m_file);
+    fputc('\n', m_file);
+}
+
+void FileLogSink::Flush()
+{
+    if (m_file != nullptr)
+        fflush(m_file);
+}
+
+#ifdef _WIN32
+void DebugOutputLogSink::Write(LogLevel, const std::string& line)
+{
+    OutputDebugStringA((line + "\n").c_str());
+}
+#endif
+
+void DX::AddLogSink(std::unique_ptr<LogSink> sink)
+{
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.sinks.push_back(std::move(sink));
+}
+
+void DX::RemoveLogSinks()
+{
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    FlushSinks(state);
+    state.sinks.clear();
+}
+
+void DX::StartLogThread()
+{
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.running)
+        return;
+    state.running = true;
+    state.writer = std::thread([&state] { WriterLoop(state); });
+}
+
+void DX::StopLogThread()
+{
+    LogState& state = State();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.running)
+            return;
+        state.running = false;
+    }
+    state.wake.notify_one();
+    state.writer.join();
+    FlushLog();
+}
+
+void DX::FlushLog()
+{
+    LogState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    Drain(state);
+    FlushSinks(state);
+}
+
+uint64_t DX::LogDroppedRecords() noexcept
+{
+    return State().dropped.load(std::memory_order_relaxed);
+}
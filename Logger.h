@@ -0,0 +1,227 @@
+//
+// Logger.h - Non-blocking printf-style logging through a lock-free ring of binary records
+//
+// DX_LOG_INFO("Fence: %zu in flight", n) copies the format pointer and arguments into a fixed-size
+// record and returns; formatting and sink I/O happen on the log thread. When the ring is full the
+// record is dropped and counted instead of blocking the caller. Formats must be string literals;
+// string arguments are copied, up to LogRecord::TextCapacity bytes in total per record.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+namespace DX
+{
+    enum class LogLevel : uint8_t
+    {
+        Debug,
+        Info,
+        Warning,
+        Error,
+    };
+
+    const char* LogLevelName(LogLevel level) noexcept;
+
+    // Parse "debug", "info", "warning" or "error". Returns false for anything else.
+    bool LogLevelFromName(const char* name, LogLevel& level) noexcept;
+
+    enum class LogArgType : uint8_t
+    {
+        Signed,
+        Unsigned,
+        Double,
+        Pointer,
+        String,         // Value is an offset into LogRecord::text.
+    };
+
+    // One log call, laid out to fill four cache lines.
+    struct LogRecord
+    {
+        static constexpr size_t MaxArgs = 8;
+        static constexpr size_t TextCapacity = 256 - 32 - MaxArgs * 8;
+
+        uint64_t        timestamp;          // Nanoseconds on the steady clock.
+        const char*     format;
+        LogLevel        level;
+        uint8_t         argCount;
+        uint16_t        thread;
+        LogArgType      types[MaxArgs];
+        uint16_t        textUsed;
+        uint64_t        args[MaxArgs];
+        char            text[TextCapacity];
+    };
+    static_assert(sizeof(LogRecord) == 256, "LogRecord should stay four cache lines");
+
+    // Receives formatted lines on the log thread, one call per record, without a trailing newline.
+    class LogSink
+    {
+    public:
+        virtual ~LogSink() = default;
+        virtual void Write(LogLevel level, const std::string& line) = 0;
+        virtual void Flush() {}
+
+        // Records below this level are not passed to the sink.
+        LogLevel minLevel = LogLevel::Debug;
+    };
+
+    class StderrLogSink final : public LogSink
+    {
+    public:
+        void Write(LogLevel level, const std::string& line) override;
+        void Flush() override;
+    };
+
+    class FileLogSink final : public LogSink
+    {
+    public:
+        // Appends when append is true, otherwise truncates. IsOpen() reports whether the file opened.
+        explicit FileLogSink(const std::string& path, bool append = true);
+        ~FileLogSink() override;
+
+        bool IsOpen() const noexcept { return m_file != nullptr; }
+        void Write(LogLevel level, const std::string& line) override;
+        void Flush() override;
+
+    private:
+        FILE* m_file = nullptr;
+    };
+
+#ifdef _WIN32
+    // The debugger's output window, where OutputDebugString used to go.
+    class DebugOutputLogSink final : public LogSink
+    {
+    public:
+        void Write(LogLevel level, const std::string& line) override;
+    };
+#endif
+
+    // Records below the minimum level are rejected before anything is copied.
+    extern std::atomic<LogLevel> g_logMinLevel;
+
+    inline bool IsLogEnabled(LogLevel level) noexcept { return level >= g_logMinLevel.load(std::memory_order_relaxed); }
+    inline void SetLogMinLevel(LogLevel level) noexcept { g_logMinLevel.store(level, std::memory_order_relaxed); }
+
+    // Sinks can be added at any time; they are written to and destroyed on the log thread's side.
+    void AddLogSink(std::unique_ptr<LogSink> sink);
+    void RemoveLogSinks();
+
+    // Start the background writer. Without it, records wait in the ring until FlushLog.
+    void StartLogThread();
+
+    // Drain the ring, flush every sink and stop the writer.
+    void StopLogThread();
+
+    // Format and write everything logged so far before returning.
+    void FlushLog();
+
+    // Records dropped because the ring was full.
+    uint64_t LogDroppedRecords() noexcept;
+
+    // Ring slots; a power of two.
+    constexpr size_t c_LogRingCapacity = 4096;
+
+    namespace LogDetail
+    {
+        // Claim a ring slot and fill its header. Returns nullptr and counts a drop if the ring is full.
+        LogRecord* BeginRecord(LogLevel level, const char* format) noexcept;
+        void CommitRecord(LogRecord* record) noexcept;
+
+        // Strings past the text capacity are truncated, and once it is full they become empty.
+        inline void AppendString(LogRecord& record, const char* text, size_t length) noexcept
+        {
+            size_t offset = record.textUsed;
+            if (offset >= LogRecord::TextCapacity)
+            {
+                // The last byte is always a terminator once the buffer is full.
+                offset = LogRecord::TextCapacity - 1;
+                length = 0;
+            }
+            const size_t copied = std::min(length, LogRecord::TextCapacity - 1 - offset);
+            std::memcpy(record.text + offset, text, copied);
+            record.text[offset + copied] = '\0';
+            record.textUsed = static_cast<uint16_t>(std::max<size_t>(record.textUsed, offset + copied + 1));
+            record.types[record.argCount] = LogArgType::String;
+            record.args[record.argCount] = offset;
+        }
+
+        inline void Pack(LogRecord& record, const char* text) noexcept
+        {
+            if (text == nullptr)
+                text = "(null)";
+            AppendString(record, text, std::strlen(text));
+        }
+
+        inline void Pack(LogRecord& record, const std::string& text) noexcept
+        {
+            AppendString(record, text.data(), text.size());
+        }
+
+        inline void Pack(LogRecord& record, char* text) noexcept { Pack(record, static_cast<const char*>(text)); }
+
+        template<typename T>
+        void Pack(LogRecord& record, T value) noexcept
+        {
+            static_assert(std::is_arithmetic_v<T> || std::is_pointer_v<T> || std::is_enum_v<T>, "Unsupported log argument");
+            uint64_t bits = 0;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                const double wide = value;
+                std::memcpy(&bits, &wide, sizeof(bits));
+                record.types[record.argCount] = LogArgType::Double;
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                bits = reinterpret_cast<uintptr_t>(value);
+                record.types[record.argCount] = LogArgType::Pointer;
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                bits = static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(value));
+                record.types[record.argCount] = LogArgType::Unsigned;
+            }
+            else if constexpr (std::is_signed_v<T>)
+            {
+                bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+                record.types[record.argCount] = LogArgType::Signed;
+            }
+            else
+            {
+                bits = static_cast<uint64_t>(value);
+                record.types[record.argCount] = LogArgType::Unsigned;
+            }
+            record.args[record.argCount] = bits;
+        }
+    }
+
+    // printf-style; the format is interpreted on the log thread, so only its pointer is recorded.
+    template<typename... TArgs>
+    void Log(LogLevel level, const char* format, const TArgs&... args) noexcept
+    {
+        static_assert(sizeof...(TArgs) <= LogRecord::MaxArgs, "Too many log arguments");
+        if (!IsLogEnabled(level))
+            return;
+
+        LogRecord* record = LogDetail::BeginRecord(level, format);
+        if (record == nullptr)
+            return;
+        ((LogDetail::Pack(*record, args), record->argCount++), ...);
+        LogDetail::CommitRecord(record);
+    }
+
+    // Render a record as "  12.345678 INFO  [t1] message". Exposed for the log thread and benchmarks.
+    std::string FormatLogRecord(const LogRecord& record);
+}
+
+#define DX_LOG_DEBUG(...) ::DX::Log(::DX::LogLevel::Debug, __VA_ARGS__)
+#define DX_LOG_INFO(...) ::DX::Log(::DX::LogLevel::Info, __VA_ARGS__)
+#define DX_LOG_WARNING(...) ::DX::Log(::DX::LogLevel::Warning, __VA_ARGS__)
+#define DX_LOG_ERROR(...) ::DX::Log(::DX::LogLevel::Error, __VA_ARGS__)
@@ -4,6 +4,11 @@
 
 #include "pch.h"
 #include "Game.h"
+#include "ToolMain.h"
+
+#include <shellapi.h>
+#include <string>
+#include <vector>
 
 using namespace DirectX;
 
@@ -23,6 +28,8 @@ LPCWSTR g_szAppName = L"CleanProject";
 
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 void ExitGame() noexcept;
+std::vector<std::string> CommandLineArguments();
+int RunToolFromCommandLine(std::vector<std::string>& arguments);
 
 // Indicates to hybrid graphics systems to prefer the discrete part by default
 extern "C"
@@ -40,11 +47,21 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     if (!XMVerifyCPUSupport())
         return 1;
 
+    // Headless tools (e.g. "CleanProject.exe transcode ...") run without creating a window.
+    std::vector<std::string> arguments = CommandLineArguments();
+    if (int toolResult = RunToolFromCommandLine(arguments); toolResult >= 0)
+        return toolResult;
+
+    // Log records are formatted and written to the debugger on a background thread.
+    DX::AddLogSink(std::make_unique<DX::DebugOutputLogSink>());
+    DX::StartLogThread();
+
     HRESULT hr = CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
     if (FAILED(hr))
         return 1;
 
     g_game = std::make_unique<Game>();
+    g_game->LoadSettings(arguments);
 
     // Register class and create window
     {
@@ -104,7 +121,18 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         }
     }
 
+    // Write out a trace, latency recording or frame recording that is still running, and stop publishing.
+    if (DX::IsTraceEnabled())
+        g_game->ToggleTrace();
+    if (g_game->m_latency.IsRecording())
+        g_game->ToggleLatencyRecording();
+    if (g_game->m_recorder)
+        g_game->ToggleRecording();
+    if (g_game->m_framePublisher)
+        g_game->ToggleFramePublisher();
+
     g_game.reset();
+    DX::StopLogThread();
 
     CoUninitialize();
 
@@ -283,8 +311,62 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             break;
         }
         if (wParam == VK_F3) {
-            g_game->isOnTheLeft = !g_game->isOnTheLeft;
+            if (GetKeyState(VK_SHIFT) & 0x8000) g_game->CycleCursorPrediction();
+            else g_game->ToggleCursor();
             
+            break;
+        }
+        if (wParam == VK_F4) {
+            g_game->ToggleTrace();
+
+            break;
+        }
+        if (wParam == VK_F5) {
+            g_game->CycleScaleFilter();
+
+            break;
+        }
+        if (wParam == VK_F6) {
+            g_game->showHud = !g_game->showHud;
+
+            break;
+        }
+        if (wParam == VK_F7) {
+            g_game->ToggleLatencyRecording();
+
+            break;
+        }
+        if (wParam == VK_F8) {
+            g_game->ToggleMetricsServer();
+
+            break;
+        }
+        if (wParam == VK_F9) {
+            g_game->WriteMetricsSnapshot();
+
+            break;
+        }
+        if (wParam == VK_F11) {
+            if (GetKeyState(VK_SHIFT) & 0x8000)
+                g_game->ToggleFramePublisher();
+            else
+                g_game->ToggleRecording();
+
+            break;
+        }
+        if (wParam >= '1' && wParam <= '9') {
+            g_game->SelectOutput(static_cast<size_t>(wParam - '1'));
+
+            break;
+        }
+        if (wParam == 'T') {
+            g_game->ToggleTiling();
+
+            break;
+        }
+        if (wParam == 'R') {
+            g_game->ToggleRegion();
+
             break;
         }
     }
@@ -297,3 +379,43 @@ void ExitGame() noexcept
 {
     PostQuitMessage(0);
 }
+
+// The command line as UTF-8 arguments, the executable first.
+std::vector<std::string> CommandLineArguments()
+{
+    std::vector<std::string> arguments;
+    int argc = 0;
+    LPWSTR* argvW = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argvW == nullptr)
+        return arguments;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const int size = WideCharToMultiByte(CP_UTF8, 0, argvW[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string argument(size > 0 ? size - 1 : 0, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, argvW[i], -1, argument.data(), size, nullptr, nullptr);
+        arguments.push_back(std::move(argument));
+    }
+    LocalFree(argvW);
+    return arguments;
+}
+
+// Run an offline tool if the first argument names one. Returns -1 otherwise.
+int RunToolFromCommandLine(std::vector<std::string>& arguments)
+{
+    if (arguments.size() < 2 || !DX::IsToolName(arguments[1].c_str()))
+        return -1;
+
+    // Tools report to the console that launched them.
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+        freopen_s(&stream, "CONOUT$", "w", stderr);
+    }
+
+    std::vector<char*> argv;
+    for (auto& argument : arguments)
+        argv.push_back(argument.data());
+    return DX::RunTool(static_cast<int>(argv.size()), argv.data());
+}
@@ -0,0 +1,337 @@
+//
+// Metrics.cpp - Counters, gauges and histograms exported in Prometheus text format
+//
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    std::atomic<size_t> g_nextShard{ 0 };
+    thread_local size_t t_shard = SIZE_MAX;
+
+    uint64_t DoubleToBits(double value) noexcept
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double BitsToDouble(uint64_t bits) noexcept
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Add to a double stored as bits. Shards are mostly written by one thread, so this rarely retries.
+    void AtomicAddDouble(std::atomic<uint64_t>& bits, double amount) noexcept
+    {
+        uint64_t expected = bits.load(std::memory_order_relaxed);
+        while (!bits.compare_exchange_weak(expected, DoubleToBits(BitsToDouble(expected) + amount), std::memory_order_relaxed))
+        {
+        }
+    }
+
+    bool IsValidMetricName(const std::string& name) noexcept
+    {
+        if (name.empty() || (name[0] >= '0' && name[0] <= '9'))
+            return false;
+        return std::all_of(name.begin(), name.end(), [](char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+        });
+    }
+
+    // Shortest of %.15g and %.17g that reads back exactly, so bucket bounds print as written.
+    void AppendValue(std::string& out, double value)
+    {
+        if (std::isnan(value))
+            out += "NaN";
+        else if (std::isinf(value))
+            out += value > 0 ? "+Inf" : "-Inf";
+        else
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.15g", value);
+            if (strtod(buffer, nullptr) != value)
+                snprintf(buffer, sizeof(buffer), "%.17g", value);
+            out += buffer;
+        }
+    }
+
+    void AppendValue(std::string& out, uint64_t value)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+        out += buffer;
+    }
+
+    // name{labels,extra} with the braces left out when both are empty.
+    void AppendSeries(std::string& out, const std::string& name, const char* suffix, const std::string& labels, const std::string& extra = {})
+    {
+        out += name;
+        out += suffix;
+        if (labels.empty() && extra.empty())
+            return;
+
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra.empty())
+            out += ',';
+        out += extra;
+        out += '}';
+    }
+
+    void AppendHelpText(std::string& out, const std::string& help)
+    {
+        for (char c : help)
+        {
+            if (c == '\\')
+                out += "\\\\";
+            else if (c == '\n')
+                out += "\\n";
+            else
+                out += c;
+        }
+    }
+}
+
+size_t DX::MetricShardIndex() noexcept
+{
+    if (t_shard == SIZE_MAX)
+        t_shard = g_nextShard.fetch_add(1, std::memory_order_relaxed) % c_MetricShards;
+    return t_shard;
+}
+
+uint64_t Counter::Value() const noexcept
+{
+    uint64_t total = 0;
+    for (auto const& shard : m_shards)
+        total += shard.value.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Gauge::Add(double amount) noexcept
+{
+    AtomicAddDouble(m_bits, amount);
+}
+
+Histogram::Histogram(std::vector<double> upperBounds) :
+    m_upperBounds(std::move(upperBounds))
+{
+    if (!std::is_sorted(m_upperBounds.begin(), m_upperBounds.end()))
+        throw std::invalid_argument("Histogram bounds must be ascending");
+
+    for (auto& shard : m_shards)
+    {
+        shard.buckets.reset(new std::atomic<uint64_t>[m_upperBounds.size() + 1]);
+        for (size_t i = 0; i <= m_upperBounds.size(); i++)
+            shard.buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::Observe(double value) noexcept
+{
+    // Bounds are few, so a linear scan beats a binary search.
+    size_t bucket = 0;
+    while (bucket < m_upperBounds.size() && value > m_upperBounds[bucket])
+        bucket++;
+
+    Shard& shard = m_shards[MetricShardIndex()];
+    shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    AtomicAddDouble(shard.sumBits, value);
+}
+
+void Histogram::Snapshot(std::vector<uint64_t>& buckets, double& sum) const
+{
+    buckets.assign(m_upperBounds.size() + 1, 0);
+    sum = 0.0;
+    for (auto const& shard : m_shards)
+    {
+        for (size_t i = 0; i < buckets.size(); i++)
+            buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        sum += BitsToDouble(shard.sumBits.load(std::memory_order_relaxed));
+    }
+}
+
+std::vector<double> DX::ExponentialBuckets(double start, double factor, size_t count)
+{
+    std::vector<double> bounds(count);
+    for (size_t i = 0; i < count; i++, start *= factor)
+        bounds[i] = start;
+    return bounds;
+}
+
+MetricsRegistry& MetricsRegistry::Default()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::Register(MetricType type, const std::string& name, const std::string& help, const std::string& labels)
+{
+    if (!IsValidMetricName(name))
+        throw std::invalid_argument("Invalid metric name " + name);
+
+    for (auto& entry : m_entries)
+    {
+        if (entry->name != name)
+            continue;
+        if (entry->type != type)
+            throw std::invalid_argument("Metric " + name + " is already registered with another type");
+        if (entry->labels == labels)
+            return *entry;
+    }
+
+    m_entries.push_back(std::make_unique<Entry>());
+    Entry& entry = *m_entries.back();
+    entry.type = type;
+    entry.name = name;
+    entry.help = help;
+    entry.labels = labels;
+    return entry;
+}
+
+Counter& MetricsRegistry::AddCounter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = Register(MetricType::Counter, name, help, labels);
+    if (!entry.counter)
+        entry.counter = std::make_unique<Counter>();
+    return *entry.counter;
+}
+
+Gauge& MetricsRegistry::AddGauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = Register(MetricType::Gauge, name, help, labels);
+    if (!entry.gauge)
+        entry.gauge = std::make_unique<Gauge>();
+    return *entry.gauge;
+}
+
+Histogram& MetricsRegistry::AddHistogram(const std::string& name, const std::string& help, std::vector<double> upperBounds, const std::string& labels)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = Register(MetricType::Histogram, name, help, labels);
+    if (!entry.histogram)
+        entry.histogram = std::make_unique<Histogram>(std::move(upperBounds));
+    return *entry.histogram;
+}
+
+void MetricsRegistry::AddCollector(std::function<void()> collect)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_collectors.push_back(std::move(collect));
+}
+
+std::string MetricsRegistry::WritePrometheus()
+{
+    static const char* const typeNames[] = { "counter", "gauge", "histogram" };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto const& collect : m_collectors)
+        collect();
+
+    // One HELP/TYPE block per name, with every labelled series of that name beneath it.
+    std::string out;
+    std::vector<uint64_t> buckets;
+    for (size_t first = 0; first < m_entries.size(); first++)
+    {
+        const Entry& family = *m_entries[first];
+        bool seen = false;
+        for (size_t i = 0; i < first && !seen; i++)
+            seen = m_entries[i]->name == family.name;
+        if (seen)
+            continue;
+
+        out += "# HELP " + family.name + ' ';
+        AppendHelpText(out, family.help);
+        out += "\n# TYPE " + family.name + ' ' + typeNames[static_cast<int>(family.type)] + '\n';
+
+        for (size_t i = first; i < m_entries.size(); i++)
+        {
+            const Entry& entry = *m_entries[i];
+            if (entry.name != family.name)
+                continue;
+
+            switch (entry.type)
+            {
+            case MetricType::Counter:
+                AppendSeries(out, entry.name, "", entry.labels);
+                out += ' ';
+                AppendValue(out, entry.counter->Value());
+                out += '\n';
+                break;
+
+            case MetricType::Gauge:
+                AppendSeries(out, entry.name, "", entry.labels);
+                out += ' ';
+                AppendValue(out, entry.gauge->Value());
+                out += '\n';
+                break;
+
+            case MetricType::Histogram:
+            {
+                double sum = 0.0;
+                entry.histogram->Snapshot(buckets, sum);
+                const auto& bounds = entry.histogram->UpperBounds();
+                uint64_t cumulative = 0;
+                for (size_t b = 0; b < buckets.size(); b++)
+                {
+                    cumulative += buckets[b];
+                    std::string le = "le=\"";
+                    AppendValue(le, b < bounds.size() ? bounds[b] : INFINITY);
+                    le += '"';
+                    AppendSeries(out, entry.name, "_bucket", entry.labels, le);
+                    out += ' ';
+                    AppendValue(out, cumulative);
+                    out += '\n';
+                }
+                AppendSeries(out, entry.name, "_sum", entry.labels);
+                out += ' ';
+                AppendValue(out, sum);
+                out += '\n';
+                AppendSeries(out, entry.name, "_count", entry.labels);
+                out += ' ';
+                AppendValue(out, cumulative);
+                out += '\n';
+                break;
+            }
+            }
+        }
+    }
+    return out;
+}
+
+bool MetricsRegistry::WriteFile(const std::string& path)
+{
+    const std::string text = WritePrometheus();
+    const std::string temporary = path + ".tmp";
+
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, temporary.c_str(), "wb");
+#else
+    file = fopen(temporary.c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+
+    const bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    const bool closed = fclose(file) == 0;
+    if (!written || !closed)
+        return false;
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
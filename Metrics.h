@@ -0,0 +1,138 @@
+//
+// Metrics.h - Counters, gauges and histograms exported in Prometheus text format
+//
+// Updates are relaxed atomics on a per-thread shard, so recording from the render loop costs a few
+// nanoseconds and never takes a lock. Registration and export lock the registry; register once at
+// startup and keep the returned reference.
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    // Threads are spread round-robin over this many cache lines per metric.
+    constexpr size_t c_MetricShards = 16;
+
+    // Shard of the calling thread, assigned on its first update.
+    size_t MetricShardIndex() noexcept;
+
+    class Counter
+    {
+    public:
+        void Increment(uint64_t amount = 1) noexcept
+        {
+            m_shards[MetricShardIndex()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        uint64_t Value() const noexcept;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::atomic<uint64_t> value{ 0 };
+        };
+
+        std::array<Shard, c_MetricShards> m_shards;
+    };
+
+    // Last write wins, so a gauge is one atomic rather than sharded.
+    class Gauge
+    {
+    public:
+        void Set(double value) noexcept { m_bits.store(ToBits(value), std::memory_order_relaxed); }
+        void Add(double amount) noexcept;
+        double Value() const noexcept { return FromBits(m_bits.load(std::memory_order_relaxed)); }
+
+    private:
+        static uint64_t ToBits(double value) noexcept { uint64_t bits; std::memcpy(&bits, &value, sizeof(bits)); return bits; }
+        static double FromBits(uint64_t bits) noexcept { double value; std::memcpy(&value, &bits, sizeof(value)); return value; }
+
+        alignas(64) std::atomic<uint64_t> m_bits{ 0 };
+    };
+
+    // Fixed upper bounds chosen at registration; values above the last bound land in +Inf.
+    class Histogram
+    {
+    public:
+        explicit Histogram(std::vector<double> upperBounds);
+
+        void Observe(double value) noexcept;
+
+        const std::vector<double>& UpperBounds() const noexcept { return m_upperBounds; }
+
+        // Per-bucket (not cumulative) counts, one more than UpperBounds for +Inf, and the sum of all values.
+        void Snapshot(std::vector<uint64_t>& buckets, double& sum) const;
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::unique_ptr<std::atomic<uint64_t>[]>    buckets;
+            std::atomic<uint64_t>                       sumBits{ 0 };
+        };
+
+        std::vector<double>                 m_upperBounds;
+        std::array<Shard, c_MetricShards>   m_shards;
+    };
+
+    // count bounds starting at start, each factor times the previous.
+    std::vector<double> ExponentialBuckets(double start, double factor, size_t count);
+
+    class MetricsRegistry
+    {
+    public:
+        // The process-wide registry the viewer publishes to.
+        static MetricsRegistry& Default();
+
+        // name must match [a-zA-Z_:][a-zA-Z0-9_:]*. labels is the text between the braces, e.g. kind="real",
+        // already escaped. Registering an existing name and labels returns the existing metric;
+        // reusing a name for a different type throws std::invalid_argument.
+        Counter& AddCounter(const std::string& name, const std::string& help, const std::string& labels = {});
+        Gauge& AddGauge(const std::string& name, const std::string& help, const std::string& labels = {});
+        Histogram& AddHistogram(const std::string& name, const std::string& help, std::vector<double> upperBounds, const std::string& labels = {});
+
+        // Run before every export on the exporting thread, e.g. to sample process memory into a gauge.
+        void AddCollector(std::function<void()> collect);
+
+        // Prometheus text exposition format 0.0.4.
+        std::string WritePrometheus();
+
+        // Write the exposition to path through a temporary file, so readers never see a partial file.
+        bool WriteFile(const std::string& path);
+
+    private:
+        enum class MetricType
+        {
+            Counter,
+            Gauge,
+            Histogram,
+        };
+
+        struct Entry
+        {
+            MetricType                  type;
+            std::string                 name;
+            std::string                 help;
+            std::string                 labels;
+            std::unique_ptr<Counter>    counter;
+            std::unique_ptr<Gauge>      gauge;
+            std::unique_ptr<Histogram>  histogram;
+        };
+
+        Entry& Register(MetricType type, const std::string& name, const std::string& help, const std::string& labels);
+
+        std::mutex                              m_mutex;
+        std::vector<std::unique_ptr<Entry>>     m_entries;
+        std::vector<std::function<void()>>      m_collectors;
+    };
+}
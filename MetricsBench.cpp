@@ -0,0 +1,94 @@
+//
+// MetricsBench.cpp - Cost of metric updates across threads, and a self-scrape of the HTTP endpoint
+//
+
+#include "ToolMain.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Nanoseconds per update when every thread updates back to back.
+    template<typename TUpdate>
+    double MeasureUpdates(uint32_t threads, uint64_t updates, const TUpdate& update)
+    {
+        auto work = [&] {
+            for (uint64_t i = 0; i < updates; i++)
+                update(i);
+        };
+
+        const auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (uint32_t t = 1; t < threads; t++)
+            workers.emplace_back(work);
+        work();
+        for (auto& worker : workers)
+            worker.join();
+        return 1e9 * std::chrono::duration<double>(Clock::now() - start).count() / double(updates);
+    }
+}
+
+int DX::MetricsBenchMain(const ToolArgs& args)
+{
+    const uint32_t threads = std::max(1u, args.GetUInt("threads", 1));
+    const uint64_t updates = args.GetUInt("updates", 10000000);
+
+    // A registry of its own, shaped like the viewer's.
+    MetricsRegistry registry;
+    Counter& frames = registry.AddCounter("hfv_frames_presented_total", "Frames presented.", "kind=\"interpolated\"");
+    registry.AddCounter("hfv_frames_presented_total", "Frames presented.", "kind=\"real\"");
+    Gauge& memory = registry.AddGauge("hfv_texture_pool_resident_bytes", "Bytes held by pooled textures.");
+    Histogram& interpolate = registry.AddHistogram("hfv_interpolate_seconds", "Time spent interpolating one frame.", ExponentialBuckets(0.0005, 2.0, 8));
+
+    const double counter = MeasureUpdates(threads, updates, [&](uint64_t) { frames.Increment(); });
+    const double gauge = MeasureUpdates(threads, updates, [&](uint64_t i) { memory.Set(double(i)); });
+    const double histogram = MeasureUpdates(threads, updates, [&](uint64_t i) { interpolate.Observe(0.001 * double(i & 63)); });
+
+    printf("metricsbench: %u threads, %llu updates per thread\n", threads, static_cast<unsigned long long>(updates));
+    printf("metricsbench: counter %.2f ns, gauge %.2f ns, histogram %.2f ns per update (wall time per thread)\n", counter, gauge, histogram);
+    if (frames.Value() != uint64_t(threads) * updates)
+        throw std::runtime_error("Counter lost updates");
+
+    const std::string output = args.Get("out");
+    if (!output.empty())
+    {
+        if (!registry.WriteFile(output))
+            throw std::runtime_error("Cannot write " + output);
+        printf("metricsbench: wrote %s\n", output.c_str());
+    }
+
+    if (!args.Has("port"))
+        return 0;
+
+    // Scrape the endpoint the same way Prometheus would, then keep serving for an external scraper.
+    MetricsServer server;
+    if (!server.Start(registry, static_cast<uint16_t>(args.GetUInt("port", MetricsServer::DefaultPort))))
+        throw std::runtime_error("Cannot listen on 127.0.0.1:" + args.Get("port"));
+
+    std::string body;
+    const int status = HttpGetLoopback(server.Port(), "/metrics", body);
+    if (status != 200 || body != registry.WritePrometheus())
+        throw std::runtime_error("Scrape of 127.0.0.1:" + std::to_string(server.Port()) + "/metrics failed with status " + std::to_string(status));
+    printf("metricsbench: scraped %zu bytes from http://127.0.0.1:%u/metrics\n", body.size(), server.Port());
+
+    const double seconds = args.GetNumber("seconds", 0.0);
+    if (seconds > 0.0)
+    {
+        printf("metricsbench: serving for %.0f s\n", seconds);
+        fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        printf("metricsbench: %llu scrapes\n", static_cast<unsigned long long>(server.Scrapes()));
+    }
+    return 0;
+}
@@ -0,0 +1,258 @@
+//
+// MetricsServer.cpp - Loopback HTTP endpoint serving a MetricsRegistry to a Prometheus scraper
+//
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "MetricsServer.h"
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+#ifdef _WIN32
+    using Socket = SOCKET;
+    const Socket c_InvalidSocket = INVALID_SOCKET;
+    void CloseSocket(Socket socket) { closesocket(socket); }
+
+    // Winsock has to be started before the first socket call.
+    struct SocketLibrary
+    {
+        bool ready = false;
+        SocketLibrary() { WSADATA data; ready = WSAStartup(MAKEWORD(2, 2), &data) == 0; }
+        ~SocketLibrary() { if (ready) WSACleanup(); }
+    };
+#else
+    using Socket = int;
+    const Socket c_InvalidSocket = -1;
+    void CloseSocket(Socket socket) { close(socket); }
+
+    struct SocketLibrary
+    {
+        bool ready = true;
+    };
+#endif
+
+    bool SocketsReady()
+    {
+        static SocketLibrary library;
+        return library.ready;
+    }
+
+    // Requests and responses are small; anything slower than this is not a scraper.
+    constexpr int c_IoTimeoutMs = 2000;
+
+    // How often the serving thread checks for Stop.
+    constexpr int c_PollMs = 100;
+
+    constexpr size_t c_MaxRequestBytes = 4096;
+
+    bool WaitReadable(Socket socket, int timeoutMs)
+    {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(socket, &readable);
+        timeval timeout = { timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+        return select(static_cast<int>(socket) + 1, &readable, nullptr, nullptr, &timeout) > 0;
+    }
+
+    void SetTimeouts(Socket socket)
+    {
+#ifdef _WIN32
+        const DWORD timeout = c_IoTimeoutMs;
+#else
+        const timeval timeout = { c_IoTimeoutMs / 1000, (c_IoTimeoutMs % 1000) * 1000 };
+#endif
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    }
+
+    bool SendAll(Socket socket, const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const int chunk = send(socket, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+            if (chunk <= 0)
+                return false;
+            sent += static_cast<size_t>(chunk);
+        }
+        return true;
+    }
+
+    sockaddr_in LoopbackAddress(uint16_t port)
+    {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return address;
+    }
+
+    std::string Response(const char* status, const char* contentType, const std::string& body)
+    {
+        return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + contentType +
+            "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    }
+}
+
+bool MetricsServer::Start(MetricsRegistry& registry, uint16_t port)
+{
+    Stop();
+
+    if (!SocketsReady())
+        return false;
+
+    const Socket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == c_InvalidSocket)
+        return false;
+
+    // Let a restarted viewer rebind while the previous socket sits in TIME_WAIT.
+#ifndef _WIN32
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    sockaddr_in address = LoopbackAddress(port);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0)
+    {
+        CloseSocket(listener);
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+    m_registry = &registry;
+    m_listener = static_cast<intptr_t>(listener);
+    m_port = ntohs(address.sin_port);
+    m_stop.store(false);
+    m_thread = std::thread([this] { Serve(); });
+    return true;
+}
+
+void MetricsServer::Stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    m_stop.store(true);
+    m_thread.join();
+    CloseSocket(static_cast<Socket>(m_listener));
+    m_listener = -1;
+}
+
+void MetricsServer::Serve()
+{
+    const Socket listener = static_cast<Socket>(m_listener);
+    while (!m_stop.load())
+    {
+        if (!WaitReadable(listener, c_PollMs))
+            continue;
+
+        const Socket client = accept(listener, nullptr, nullptr);
+        if (client == c_InvalidSocket)
+            continue;
+
+        SetTimeouts(client);
+        Answer(static_cast<intptr_t>(client));
+        CloseSocket(client);
+    }
+}
+
+void MetricsServer::Answer(intptr_t clientHandle)
+{
+    const Socket client = static_cast<Socket>(clientHandle);
+
+    // Read the request head; the body of a GET is ignored.
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < c_MaxRequestBytes)
+    {
+        const int received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            break;
+        request.append(buffer, static_cast<size_t>(received));
+    }
+
+    const size_t lineEnd = request.find("\r\n");
+    const std::string line = request.substr(0, lineEnd);
+    const size_t pathStart = line.find(' ');
+    const size_t pathEnd = pathStart == std::string::npos ? std::string::npos : line.find(' ', pathStart + 1);
+    if (lineEnd == std::string::npos || pathEnd == std::string::npos)
+    {
+        SendAll(client, Response("400 Bad Request", "text/plain", "Bad request\n"));
+        return;
+    }
+
+    const std::string method = line.substr(0, pathStart);
+    std::string path = line.substr(pathStart + 1, pathEnd - pathStart - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET" && method != "HEAD")
+        SendAll(client, Response("405 Method Not Allowed", "text/plain", "Only GET is supported\n"));
+    else if (path == "/metrics")
+    {
+        m_scrapes.fetch_add(1, std::memory_order_relaxed);
+        const std::string response = Response("200 OK", "text/plain; version=0.0.4; charset=utf-8", m_registry->WritePrometheus());
+        SendAll(client, method == "HEAD" ? response.substr(0, response.find("\r\n\r\n") + 4) : response);
+    }
+    else if (path == "/")
+        SendAll(client, Response("200 OK", "text/plain", "Metrics are served at /metrics\n"));
+    else
+        SendAll(client, Response("404 Not Found", "text/plain", "Not found\n"));
+}
+
+int DX::HttpGetLoopback(uint16_t port, const std::string& path, std::string& body)
+{
+    body.clear();
+    if (!SocketsReady())
+        return 0;
+
+    const Socket connection = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connection == c_InvalidSocket)
+        return 0;
+    SetTimeouts(connection);
+
+    sockaddr_in address = LoopbackAddress(port);
+    std::string response;
+    if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0 &&
+        SendAll(connection, "GET " + path + " HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n"))
+    {
+        char buffer[4096];
+        int received = 0;
+        while ((received = recv(connection, buffer, sizeof(buffer), 0)) > 0)
+            response.append(buffer, static_cast<size_t>(received));
+    }
+    CloseSocket(connection);
+
+    // "HTTP/1.x NNN reason", headers, blank line, body.
+    const size_t headerEnd = response.find("\r\n\r\n");
+    if (response.compare(0, 5, "HTTP/") != 0 || headerEnd == std::string::npos)
+        return 0;
+
+    const size_t statusStart = response.find(' ');
+    if (statusStart == std::string::npos || statusStart > headerEnd)
+        return 0;
+    body = response.substr(headerEnd + 4);
+    return atoi(response.c_str() + statusStart + 1);
+}
@@ -0,0 +1,52 @@
+//
+// MetricsServer.h - Loopback HTTP endpoint serving a MetricsRegistry to a Prometheus scraper
+//
+
+#pragma once
+
+#include "Metrics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace DX
+{
+    // Listens on 127.0.0.1 only and answers GET /metrics from its own thread, one connection at a time.
+    class MetricsServer
+    {
+    public:
+        // Default port; the same one OpenTelemetry's Prometheus exporter uses.
+        static constexpr uint16_t DefaultPort = 9464;
+
+        MetricsServer() = default;
+        ~MetricsServer() { Stop(); }
+
+        MetricsServer(MetricsServer const&) = delete;
+        MetricsServer& operator= (MetricsServer const&) = delete;
+
+        // Bind and start serving. Port 0 picks a free port, see Port(). Returns false if the port can't be bound.
+        bool Start(MetricsRegistry& registry, uint16_t port = DefaultPort);
+        void Stop();
+
+        bool IsRunning() const noexcept { return m_thread.joinable(); }
+        uint16_t Port() const noexcept { return m_port; }
+        uint64_t Scrapes() const noexcept { return m_scrapes.load(std::memory_order_relaxed); }
+
+    private:
+        void Serve();
+        void Answer(intptr_t client);
+
+        MetricsRegistry*        m_registry = nullptr;
+        intptr_t                m_listener = -1;
+        uint16_t                m_port = 0;
+        std::atomic<bool>       m_stop{ false };
+        std::atomic<uint64_t>   m_scrapes{ 0 };
+        std::thread             m_thread;
+    };
+
+    // Minimal HTTP/1.0 GET against 127.0.0.1, for the metrics tool to scrape its own endpoint.
+    // Returns the status code, or 0 if the request failed; body receives the response body.
+    int HttpGetLoopback(uint16_t port, const std::string& path, std::string& body);
+}
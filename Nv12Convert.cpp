@@ -0,0 +1,178 @@
+//
+// Nv12Convert.cpp - Conversion between rgba8 and nv12, with SSE2 paths that match the scalar ones exactly
+//
+
+#include "Nv12Convert.h"
+#include "ColorConvert.h"
+
+using namespace DX;
+
+namespace
+{
+#if DX_HAS_SSE2
+    // (w0 * c0 + w1 * c1 + w2 * c2 + 128) >> 8 of four pixels whose channels are 16-bit, two pixels in
+    // each of lo and hi, for weights given as (w0, w1, w2, 0) twice.
+    inline __m128i WeighChannels(__m128i lo, __m128i hi, __m128i weights) noexcept
+    {
+        const __m128 a = _mm_castsi128_ps(_mm_madd_epi16(lo, weights));
+        const __m128 b = _mm_castsi128_ps(_mm_madd_epi16(hi, weights));
+
+        // Each pixel produced (w0 c0 + w1 c1, w2 c2); add the halves.
+        const __m128i pairs = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i singles = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(pairs, singles), _mm_set1_epi32(128)), 8);
+    }
+
+    uint32_t LumaRowSse2(const uint8_t* in, uint8_t* out, uint32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(47, 157, 16, 0, 47, 157, 16, 0);
+        const __m128i offset = _mm_set1_epi16(16);
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4));
+            const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x * 4 + 16));
+            const __m128i y0 = WeighChannels(_mm_unpacklo_epi8(p0, zero), _mm_unpackhi_epi8(p0, zero), weights);
+            const __m128i y1 = WeighChannels(_mm_unpacklo_epi8(p1, zero), _mm_unpackhi_epi8(p1, zero), weights);
+            const __m128i y = _mm_add_epi16(_mm_packs_epi32(y0, y1), offset);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(y, y));
+        }
+        return x;
+    }
+
+    // Four chroma pairs from eight pixels of two rows; returns the pixels done.
+    uint32_t ChromaRowSse2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        const __m128i uWeights = _mm_setr_epi16(-26, -87, 112, 0, -26, -87, 112, 0);
+        const __m128i vWeights = _mm_setr_epi16(112, -102, -10, 0, 112, -102, -10, 0);
+        const __m128i offset = _mm_set1_epi32(128);
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 4));
+            const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 4 + 16));
+            const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 4));
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 4 + 16));
+
+            // Add the rows in 16 bits, two pixels a register, then the two pixels of each block.
+            const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+            const __m128i blocks01 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1)), two), 2);
+            const __m128i blocks23 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3)), two), 2);
+
+            const __m128i u = _mm_add_epi32(WeighChannels(blocks01, blocks23, uWeights), offset);
+            const __m128i v = _mm_add_epi32(WeighChannels(blocks01, blocks23, vWeights), offset);
+            const __m128i uv = _mm_packs_epi32(_mm_unpacklo_epi32(u, v), _mm_unpackhi_epi32(u, v));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(uv, uv));
+        }
+        return x;
+    }
+
+    uint32_t RgbaRowSse2(const uint8_t* luma, const uint8_t* chroma, uint8_t* out, uint32_t width) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i lumaWeights = _mm_setr_epi16(298, 128, 298, 128, 298, 128, 298, 128);
+        const __m128i rWeights = _mm_setr_epi16(0, 459, 0, 459, 0, 459, 0, 459);
+        const __m128i gWeights = _mm_setr_epi16(-55, -136, -55, -136, -55, -136, -55, -136);
+        const __m128i bWeights = _mm_setr_epi16(541, 0, 541, 0, 541, 0, 541, 0);
+        const __m128i alpha = _mm_set1_epi32(255);
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            const __m128i y = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(luma + x)), zero), _mm_set1_epi16(16));
+            const __m128i uv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(chroma + x)), zero), _mm_set1_epi16(128));
+            for (int half = 0; half < 2; half++)
+            {
+                // Per pixel, (y - 16, 1) and its block's (Cb - 128, Cr - 128), so each channel is two multiply-adds.
+                const __m128i luma1 = half == 0 ? _mm_unpacklo_epi16(y, one) : _mm_unpackhi_epi16(y, one);
+                const __m128i pair = half == 0 ? _mm_unpacklo_epi32(uv, uv) : _mm_unpackhi_epi32(uv, uv);
+                const __m128i base = _mm_madd_epi16(luma1, lumaWeights);
+                const __m128i r = _mm_srai_epi32(_mm_add_epi32(base, _mm_madd_epi16(pair, rWeights)), 8);
+                const __m128i g = _mm_srai_epi32(_mm_add_epi32(base, _mm_madd_epi16(pair, gWeights)), 8);
+                const __m128i b = _mm_srai_epi32(_mm_add_epi32(base, _mm_madd_epi16(pair, bWeights)), 8);
+
+                const __m128i rb = _mm_packs_epi32(r, b);
+                const __m128i ga = _mm_packs_epi32(g, alpha);
+                const __m128i rg = _mm_unpacklo_epi16(rb, ga);
+                const __m128i ba = _mm_unpackhi_epi16(rb, ga);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x + 4 * half) * 4),
+                    _mm_packus_epi16(_mm_unpacklo_epi32(rg, ba), _mm_unpackhi_epi32(rg, ba)));
+            }
+        }
+        return x;
+    }
+#endif
+}
+
+void DX::ConvertRgba8ToNv12(ConstImageView rgba, ImageView nv12, SimdTier tier)
+{
+    const Nv12Planes planes = SplitNv12(nv12);
+    for (uint32_t y = 0; y < planes.luma.height; y++)
+    {
+        const uint8_t* in = rgba.Row(y);
+        uint8_t* out = planes.luma.Row(y);
+        uint32_t x = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+            x = LumaRowSse2(in, out, planes.luma.width);
+#endif
+        for (; x < planes.luma.width; x++)
+            out[x] = Detail::RgbToY(in[x * 4], in[x * 4 + 1], in[x * 4 + 2]);
+    }
+
+    for (uint32_t cy = 0; cy < planes.chroma.height; cy++)
+    {
+        const uint8_t* row0 = rgba.Row(cy * 2);
+        const uint8_t* row1 = rgba.Row(cy * 2 + 1);
+        uint8_t* out = planes.chroma.Row(cy);
+        uint32_t x = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+            x = ChromaRowSse2(row0, row1, out, planes.luma.width);
+#endif
+        for (; x < planes.luma.width; x += 2)
+        {
+            const uint32_t x0 = x * 4;
+            const uint32_t x1 = x0 + 4;
+            const int r = (row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2;
+            const int g = (row0[x0 + 1] + row0[x1 + 1] + row1[x0 + 1] + row1[x1 + 1] + 2) >> 2;
+            const int b = (row0[x0 + 2] + row0[x1 + 2] + row1[x0 + 2] + row1[x1 + 2] + 2) >> 2;
+            out[x] = Detail::RgbToU(r, g, b);
+            out[x + 1] = Detail::RgbToV(r, g, b);
+        }
+    }
+    (void)tier;
+}
+
+void DX::ConvertNv12ToRgba8(ConstImageView nv12, ImageView rgba, SimdTier tier)
+{
+    const ConstNv12Planes planes = SplitNv12(nv12);
+    for (uint32_t y = 0; y < planes.luma.height; y++)
+    {
+        const uint8_t* inY = planes.luma.Row(y);
+        const uint8_t* inUV = planes.chroma.Row(y / 2);
+        uint8_t* out = rgba.Row(y);
+        uint32_t x = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+            x = RgbaRowSse2(inY, inUV, out, planes.luma.width);
+#endif
+        for (; x < planes.luma.width; x++)
+        {
+            const int c = (inY[x] - 16) * 298;
+            const int d = inUV[x & ~1u] - 128;
+            const int e = inUV[x | 1u] - 128;
+            out[x * 4 + 0] = Detail::ClampByte((c + 459 * e + 128) >> 8);
+            out[x * 4 + 1] = Detail::ClampByte((c - 55 * d - 136 * e + 128) >> 8);
+            out[x * 4 + 2] = Detail::ClampByte((c + 541 * d + 128) >> 8);
+            out[x * 4 + 3] = 255;
+        }
+    }
+    (void)tier;
+}
@@ -0,0 +1,41 @@
+//
+// Nv12Convert.h - The nv12 frame layout, and conversion between it and rgba8
+//
+// An nv12 frame is one 8-bit view of PixelFormatRows rows: the luma rows, then half as many rows of
+// interleaved Cb and Cr at the same pitch, which is how D3D11 maps and uploads DXGI_FORMAT_NV12. Width
+// and height are even. The values are ColorConvert.h's BT.709 limited range, so a frame converted here
+// and split into planes is the I420 the recorder writes.
+//
+
+#pragma once
+
+#include "Image.h"
+#include "Simd.h"
+
+namespace DX
+{
+    template<typename T>
+    struct BasicNv12Planes
+    {
+        BasicImageView<T> luma;
+        BasicImageView<T> chroma;       // Width and height in Cb/Cr pairs.
+    };
+
+    using Nv12Planes = BasicNv12Planes<uint8_t>;
+    using ConstNv12Planes = BasicNv12Planes<const uint8_t>;
+
+    // The planes of an nv12 frame's view.
+    template<typename T>
+    BasicNv12Planes<T> SplitNv12(BasicImageView<T> frame) noexcept
+    {
+        const uint32_t height = frame.height / 3 * 2;
+        return { { frame.data, frame.width, height, frame.pitch },
+                 { frame.Row(height), frame.width / 2, height / 2, frame.pitch } };
+    }
+
+    // rgba8 to nv12 of the same size; chroma is the rounded average of each 2x2 block. Alpha is dropped.
+    void ConvertRgba8ToNv12(ConstImageView rgba, ImageView nv12, SimdTier tier = BestSimdTier());
+
+    // nv12 to opaque rgba8, each chroma sample covering its 2x2 block. rgba's size is the picture's.
+    void ConvertNv12ToRgba8(ConstImageView nv12, ImageView rgba, SimdTier tier = BestSimdTier());
+}
@@ -0,0 +1,118 @@
+//
+// PacingSim.cpp - Simulated viewer pacing loop that drives LatencyTracker without a GPU
+//
+// Mirrors Game::Render: an interpolated present once a new capture is ready, then the previous
+// real frame after sleeping for the average capture and interpolation time. Present waits for the
+// next vblank, so each frame is shown on the first refresh after its Present call.
+//
+
+#include "ToolMain.h"
+#include "LatencyTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_NanosecondsPerMillisecond = 1e6;
+
+    // Simulated time starts well above zero, which LatencyTracker treats as "no timestamp".
+    constexpr double c_StartMilliseconds = 1000.0;
+
+    uint64_t ToTicks(double milliseconds) noexcept
+    {
+        return static_cast<uint64_t>(milliseconds * c_NanosecondsPerMillisecond);
+    }
+}
+
+int DX::PacingSimMain(const ToolArgs& args)
+{
+    const double sourcePeriod = 1000.0 / args.GetNumber("source-fps", 60.0);
+    const double refreshPeriod = 1000.0 / args.GetNumber("refresh", 120.0);
+    const double captureMs = args.GetNumber("capture-ms", 0.5);
+    const double interpolateMs = args.GetNumber("interp-ms", 4.0);
+    const double jitterMs = args.GetNumber("jitter-ms", 1.0);
+    const uint32_t frames = args.GetUInt("frames", 1000);
+    const uint32_t ringDepth = std::max(3u, args.GetUInt("ring", 3));
+    if (sourcePeriod <= 0.0 || refreshPeriod <= 0.0)
+        throw std::runtime_error("--source-fps and --refresh must be positive");
+
+    std::mt19937 random(args.GetUInt("seed", 1));
+    std::uniform_real_distribution<double> jitter(0.0, jitterMs);
+
+    // Source frame k appears on the duplicated monitor at sourceTime(k).
+    std::vector<double> sourceTimes;
+    auto sourceTime = [&](size_t k) {
+        while (sourceTimes.size() <= k)
+            sourceTimes.push_back(c_StartMilliseconds + sourceTimes.size() * sourcePeriod + jitter(random));
+        return sourceTimes[k];
+    };
+
+    LatencyTracker tracker;
+    tracker.Start(size_t(frames) * 2);
+
+    double now = c_StartMilliseconds;
+    double lastVBlank = c_StartMilliseconds;
+    double workTotal = 0.0;
+    uint32_t workCount = 0;
+    uint32_t presentId = 0;
+    size_t nextSource = 0;
+    uint64_t dropped = 0;
+    double lastInterpolated = 0.0;
+
+    auto present = [&](LatencyFrameKind kind, double source) {
+        // Shown on the first vblank after the call, never two frames on one vblank.
+        const double vblank = std::max(lastVBlank + refreshPeriod, std::ceil(now / refreshPeriod) * refreshPeriod);
+        presentId++;
+        tracker.OnPresent(kind, ToTicks(source), ToTicks(now), presentId);
+        tracker.OnDisplayed(presentId, ToTicks(vblank));
+        lastVBlank = vblank;
+        now = vblank;
+    };
+
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        // The ring keeps the previous and presented frames plus ringDepth - 2 captures; older captures are recycled.
+        size_t available = nextSource;
+        while (sourceTime(available) + captureMs <= now)
+            available++;
+        if (available > nextSource + (ringDepth - 2))
+        {
+            dropped += available - (ringDepth - 2) - nextSource;
+            nextSource = available - (ringDepth - 2);
+        }
+
+        // Interpolated: wait for a new capture, then interpolate it against the previous one.
+        const double start = now;
+        const double source = sourceTime(nextSource);
+        now = std::max(now, source + captureMs) + interpolateMs;
+        workTotal += now - start;
+        workCount++;
+        const double previousSource = lastInterpolated;
+        lastInterpolated = source;
+        nextSource++;
+        present(LatencyFrameKind::Interpolated, source);
+
+        // Real: sleep for the average work time, then show the previous capture.
+        now += workTotal / workCount;
+        if (previousSource > 0.0)
+            present(LatencyFrameKind::Real, previousSource);
+        else
+            now = std::ceil(now / refreshPeriod) * refreshPeriod;
+    }
+
+    printf("pacingsim: %u loop iterations, source %.2f ms, refresh %.2f ms, capture %.2f ms, interpolate %.2f ms, %llu captures dropped\n",
+        frames, sourcePeriod, refreshPeriod, captureMs, interpolateMs, static_cast<unsigned long long>(dropped));
+    printf("%s", tracker.Summary().c_str());
+
+    const std::string csv = args.Get("csv");
+    if (!csv.empty() && !tracker.WriteCsv(csv))
+        throw std::runtime_error("Cannot write " + csv);
+    return 0;
+}
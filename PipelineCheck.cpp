@@ -0,0 +1,550 @@
+//
+// PipelineCheck.cpp - Drive the texture pool, capture ring and fence timeline with fakes and check their bookkeeping
+//
+
+#include "ToolMain.h"
+#include "CaptureRing.h"
+#include "FenceTimeline.h"
+#include "TexturePool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    struct FakeTexture
+    {
+        TextureKey key;
+    };
+
+    // Counts what the pool creates and destroys, per descriptor, and fails creation on request.
+    struct FakeAllocator
+    {
+        std::set<FakeTexture*> live;
+        std::map<uint32_t, uint64_t> creates;     // By width, which tells the test keys apart.
+        uint64_t destroys = 0;
+        uint64_t failures = 0;                    // Pending creations to refuse.
+
+        FakeTexture* Create(const TextureKey& key)
+        {
+            if (failures != 0)
+            {
+                failures--;
+                return nullptr;
+            }
+            FakeTexture* texture = new FakeTexture{ key };
+            live.insert(texture);
+            creates[key.width]++;
+            return texture;
+        }
+
+        void Destroy(FakeTexture* texture)
+        {
+            live.erase(texture);
+            destroys++;
+            delete texture;
+        }
+
+        uint64_t SizeInBytes(const TextureKey& key) const { return uint64_t(key.width) * key.height * 4; }
+
+        uint64_t LiveBytes() const
+        {
+            uint64_t bytes = 0;
+            for (const FakeTexture* texture : live)
+                bytes += SizeInBytes(texture->key);
+            return bytes;
+        }
+    };
+
+    using FakePool = TexturePool<FakeTexture, FakeAllocator>;
+
+    TextureKey MakeKey(uint32_t width, uint32_t format = 28)
+    {
+        TextureKey key;
+        key.width = width;
+        key.height = 16;
+        key.format = format;
+        key.bindFlags = 0x28;
+        return key;
+    }
+
+    // The pool's counters against what the allocator actually holds.
+    uint64_t CheckAccounting(FakePool& pool, size_t leases, uint64_t leasedBytes)
+    {
+        const TexturePoolStats& stats = pool.GetStats();
+        const FakeAllocator& allocator = pool.GetAllocator();
+        uint64_t failures = 0;
+        failures += stats.residentCount == allocator.live.size() && stats.residentBytes == allocator.LiveBytes() ? 0 : 1;
+        failures += stats.leasedCount == leases && stats.leasedBytes == leasedBytes ? 0 : 1;
+        failures += pool.IdleBytes() == stats.residentBytes - stats.leasedBytes ? 0 : 1;
+        return failures;
+    }
+
+    // Leases, shared leases, the idle budget, Trim and Clear on fixed sequences.
+    uint64_t CheckPoolSequences()
+    {
+        uint64_t failures = 0;
+        const TextureKey a = MakeKey(64);
+        const TextureKey b = MakeKey(128);
+        const TextureKey otherFormat = MakeKey(64, 24);
+        const uint64_t sizeA = FakeAllocator{}.SizeInBytes(a);
+        const uint64_t sizeB = FakeAllocator{}.SizeInBytes(b);
+
+        // Misses per descriptor, then a hit that hands back the released texture.
+        FakePool pool{ FakeAllocator{} };
+        FakeTexture* first = pool.Acquire(a);
+        FakeTexture* second = pool.Acquire(b);
+        FakeTexture* third = pool.Acquire(otherFormat);
+        failures += pool.GetStats().misses == 3 && pool.GetStats().hits == 0 ? 0 : 1;
+        failures += CheckAccounting(pool, 3, 2 * sizeA + sizeB);
+        pool.Release(first);
+        failures += pool.Acquire(otherFormat) != first && pool.GetStats().misses == 4 ? 0 : 1;
+        failures += pool.Acquire(a) == first && pool.GetStats().hits == 1 ? 0 : 1;
+        failures += pool.GetAllocator().creates[64] == 3 && pool.GetAllocator().creates[128] == 1 ? 0 : 1;
+
+        // A shared lease only goes back to the pool with its last reference.
+        pool.AddRef(second);
+        pool.Release(second);
+        failures += pool.Acquire(b) != second && pool.GetStats().misses == 5 ? 0 : 1;
+        pool.Release(second);
+        failures += pool.Acquire(b) == second && pool.GetStats().hits == 2 ? 0 : 1;
+        failures += CheckAccounting(pool, 5, 3 * sizeA + 2 * sizeB);
+
+        // Releasing what isn't leased changes nothing.
+        pool.Release(nullptr);
+        failures += CheckAccounting(pool, 5, 3 * sizeA + 2 * sizeB);
+
+        // A failed creation is neither a hit nor a miss.
+        pool.GetAllocator().failures = 1;
+        failures += pool.Acquire(MakeKey(256)) == nullptr && pool.GetStats().misses == 5 && pool.GetStats().hits == 2 ? 0 : 1;
+        (void)third;
+
+        // The idle budget: two idle textures of a fit, the third release destroys one.
+        FakePool budgeted{ FakeAllocator{}, 2 * sizeA };
+        FakeTexture* leased[3] = { budgeted.Acquire(a), budgeted.Acquire(a), budgeted.Acquire(a) };
+        for (FakeTexture* texture : leased)
+            budgeted.Release(texture);
+        failures += budgeted.IdleBytes() == 2 * sizeA && budgeted.GetAllocator().destroys == 1 ? 0 : 1;
+        failures += CheckAccounting(budgeted, 0, 0);
+        budgeted.SetIdleBudget(sizeA);
+        failures += budgeted.IdleBytes() == sizeA && budgeted.GetAllocator().destroys == 2 ? 0 : 1;
+
+        // Trim to a budget, then to nothing; leases survive both.
+        FakePool trimmed{ FakeAllocator{} };
+        FakeTexture* kept = trimmed.Acquire(b);
+        FakeTexture* idle[4] = { trimmed.Acquire(a), trimmed.Acquire(a), trimmed.Acquire(b), trimmed.Acquire(b) };
+        for (FakeTexture* texture : idle)
+            trimmed.Release(texture);
+        failures += trimmed.IdleBytes() == 2 * sizeA + 2 * sizeB ? 0 : 1;
+        trimmed.Trim(sizeB);
+        failures += trimmed.IdleBytes() <= sizeB ? 0 : 1;
+        failures += CheckAccounting(trimmed, 1, sizeB);
+        trimmed.Trim();
+        failures += trimmed.IdleBytes() == 0 && trimmed.GetAllocator().live.count(kept) == 1 ? 0 : 1;
+        failures += CheckAccounting(trimmed, 1, sizeB);
+
+        // Clear destroys leases too, as after a lost device.
+        trimmed.Clear();
+        failures += trimmed.GetAllocator().live.empty() && trimmed.GetStats().residentBytes == 0 && trimmed.GetStats().residentCount == 0 ? 0 : 1;
+        failures += CheckAccounting(trimmed, 0, 0);
+        return failures;
+    }
+
+    // Outputs resizing through several descriptors the way the viewer does: hand the ring back, lease one
+    // at the new size, then budget two rings per output and trim to one. Resident bytes stay within the
+    // leases plus the budget, going back to the previous size reuses its textures, and older sizes go first.
+    uint64_t CheckIdleBudget(std::mt19937& random)
+    {
+        uint64_t failures = 0;
+        const size_t ringTextures = 5;            // Four captures and the interpolation target.
+        const TextureKey keys[] = { MakeKey(64), MakeKey(128), MakeKey(96), MakeKey(64, 24), MakeKey(128, 24) };
+        FakePool pool{ FakeAllocator{}, 0 };
+
+        std::vector<std::vector<FakeTexture*>> rings(2);
+        std::vector<TextureKey> ringKeys(rings.size());
+        auto leasedBytes = [&]() {
+            uint64_t bytes = 0;
+            for (size_t output = 0; output < rings.size(); output++)
+                bytes += rings[output].size() * pool.GetAllocator().SizeInBytes(ringKeys[output]);
+            return bytes;
+        };
+        auto checkBound = [&]() {
+            failures += pool.GetStats().residentBytes <= leasedBytes() + pool.IdleBudget() ? 0 : 1;
+            failures += pool.GetAllocator().LiveBytes() == pool.GetStats().residentBytes ? 0 : 1;
+        };
+        auto resize = [&](size_t output, const TextureKey& key) {
+            for (FakeTexture* texture : rings[output])
+            {
+                pool.Release(texture);
+                checkBound();
+            }
+            rings[output].clear();
+            ringKeys[output] = key;
+            for (size_t i = 0; i < ringTextures; i++)
+                rings[output].push_back(pool.Acquire(key));
+            pool.SetIdleBudget(2 * leasedBytes());
+            pool.Trim(leasedBytes());
+            checkBound();
+            failures += pool.IdleBytes() <= leasedBytes() ? 0 : 1;
+        };
+
+        // One output: 64 -> 128 -> 64 is all hits, and 64 -> 64 in another format then drops what is left
+        // of the oldest, 128, rather than the 64 just handed back.
+        rings.resize(1);
+        ringKeys.resize(1);
+        resize(0, keys[0]);
+        resize(0, keys[1]);
+        const uint64_t misses = pool.GetStats().misses;
+        resize(0, keys[0]);
+        failures += pool.GetStats().misses == misses && pool.GetStats().hits == ringTextures ? 0 : 1;
+        resize(0, keys[3]);
+        failures += pool.GetAllocator().creates[128] == ringTextures && pool.IdleBytes() == ringTextures * pool.GetAllocator().SizeInBytes(keys[0]) ? 0 : 1;
+        for (const FakeTexture* texture : pool.GetAllocator().live)
+            failures += texture->key == keys[0] || texture->key == keys[3] ? 0 : 1;
+
+        // Two outputs resizing in turn through random descriptors.
+        rings.resize(2);
+        ringKeys.resize(2);
+        resize(1, keys[2]);
+        for (int step = 0; step < 200; step++)
+        {
+            const size_t output = std::uniform_int_distribution<size_t>(0, rings.size() - 1)(random);
+            resize(output, keys[std::uniform_int_distribution<size_t>(0, std::size(keys) - 1)(random)]);
+        }
+        failures += CheckAccounting(pool, 2 * ringTextures, leasedBytes());
+        return failures;
+    }
+
+    // A fence the test completes by hand. A wait either lands the value it waits for or times out.
+    struct ManualFence
+    {
+        uint64_t completed = 0;
+        bool landOnWait = true;
+        uint64_t blockingWaits = 0;
+
+        uint64_t GetCompletedValue() const { return completed; }
+
+        bool WaitForValue(uint64_t value, uint32_t)
+        {
+            blockingWaits++;
+            if (!landOnWait)
+                return false;
+            completed = std::max(completed, value);
+            return true;
+        }
+    };
+
+    // Signal, completion in jumps and out of order, waits that block, return at once or time out, and retire.
+    uint64_t CheckFenceTimeline()
+    {
+        uint64_t failures = 0;
+        FenceTimeline<ManualFence> timeline{ ManualFence{}, 10 };
+        ManualFence& fence = timeline.GetFence();
+        fence.completed = 10;
+
+        for (uint64_t i = 1; i <= 5; i++)
+            failures += timeline.Signal() == 10 + i ? 0 : 1;
+        failures += timeline.InFlight() == 5 && timeline.LastSignaled() == 15 && timeline.GetStats().maxInFlight == 5 ? 0 : 1;
+
+        // The GPU reaches 13 in one jump: waiting on an earlier value neither blocks nor leaves it in flight.
+        fence.completed = 13;
+        failures += timeline.IsComplete(12) && !timeline.IsComplete(14) ? 0 : 1;
+        failures += timeline.WaitFor(12) && fence.blockingWaits == 0 && timeline.InFlight() == 2 ? 0 : 1;
+        failures += timeline.WaitFor(0) && timeline.GetStats().waits == 0 ? 0 : 1;
+
+        // A signal that lands late moves the fence back (an out-of-order GPU signal); nothing past it is retired.
+        fence.completed = 11;
+        timeline.Retire();
+        failures += !timeline.IsComplete(13) && timeline.InFlight() == 2 ? 0 : 1;
+
+        // Waiting on a later value blocks once and retires everything up to it.
+        failures += timeline.WaitFor(15) && fence.blockingWaits == 1 && timeline.InFlight() == 0 ? 0 : 1;
+
+        // A wait that times out stays in flight and is counted.
+        const uint64_t pending = timeline.Signal();
+        fence.landOnWait = false;
+        failures += !timeline.WaitFor(pending, 5) && timeline.InFlight() == 1 ? 0 : 1;
+        fence.landOnWait = true;
+        fence.completed = pending;
+        timeline.Retire();
+        failures += timeline.InFlight() == 0 ? 0 : 1;
+
+        const FenceTimelineStats& stats = timeline.GetStats();
+        failures += stats.signals == 6 && stats.waits == 2 && stats.timeouts == 1 && stats.maxInFlight == 5 ? 0 : 1;
+        failures += stats.maxWaitSeconds >= 0.0 && stats.totalWaitSeconds >= stats.maxWaitSeconds ? 0 : 1;
+
+        // Frames nobody waits on, as in pass-through: Signal retires what the GPU has reached, so the
+        // in-flight list stays as deep as the GPU is behind.
+        FenceTimeline<ManualFence> passThrough{ ManualFence{} };
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            passThrough.GetFence().completed = passThrough.LastSignaled() > 2 ? passThrough.LastSignaled() - 2 : 0;
+            passThrough.Signal();
+        }
+        failures += passThrough.InFlight() <= 3 && passThrough.GetStats().maxInFlight <= 3 ? 0 : 1;
+
+        timeline.ResetStats();
+        failures += timeline.GetStats().signals == 0 && timeline.GetStats().timeouts == 0 ? 0 : 1;
+        return failures;
+    }
+
+    struct PoolRun
+    {
+        uint64_t failures = 0;
+        TexturePoolStats stats;
+        uint64_t destroys = 0;
+    };
+
+    // Random acquires, shared leases, releases, trims and budget changes over a few descriptors. A
+    // miss while a texture of the descriptor is idle, or a texture of another descriptor, is a failure.
+    PoolRun RunPool(std::mt19937& random, uint32_t steps)
+    {
+        const TextureKey keys[] = { MakeKey(32), MakeKey(64), MakeKey(96), MakeKey(64, 24) };
+        const uint64_t largest = FakeAllocator{}.SizeInBytes(keys[2]);
+        FakePool pool{ FakeAllocator{}, std::uniform_int_distribution<uint64_t>(0, 6)(random) * largest };
+
+        PoolRun run;
+        std::vector<FakeTexture*> references;     // One entry per reference held.
+        uint64_t acquires = 0;
+        std::uniform_int_distribution<int> action(0, 99);
+        for (uint32_t step = 0; step < steps; step++)
+        {
+            const int kind = action(random);
+            if (kind < 45)
+            {
+                const TextureKey& key = keys[std::uniform_int_distribution<size_t>(0, std::size(keys) - 1)(random)];
+                size_t idle = 0;
+                for (const FakeTexture* texture : pool.GetAllocator().live)
+                {
+                    if (texture->key == key && std::find(references.begin(), references.end(), texture) == references.end())
+                        idle++;
+                }
+                const uint64_t misses = pool.GetStats().misses;
+                FakeTexture* texture = pool.Acquire(key);
+                acquires++;
+                run.failures += texture != nullptr && texture->key == key ? 0 : 1;
+                run.failures += (pool.GetStats().misses == misses) == (idle != 0) ? 0 : 1;
+                references.push_back(texture);
+            }
+            else if (kind < 55 && !references.empty())
+            {
+                FakeTexture* texture = references[std::uniform_int_distribution<size_t>(0, references.size() - 1)(random)];
+                pool.AddRef(texture);
+                references.push_back(texture);
+            }
+            else if (kind < 95 && !references.empty())
+            {
+                const size_t index = std::uniform_int_distribution<size_t>(0, references.size() - 1)(random);
+                pool.Release(references[index]);
+                references.erase(references.begin() + ptrdiff_t(index));
+            }
+            else if (kind < 98)
+            {
+                const uint64_t budget = std::uniform_int_distribution<uint64_t>(0, 4)(random) * largest;
+                pool.Trim(budget);
+                run.failures += pool.IdleBytes() <= budget ? 0 : 1;
+            }
+            else
+            {
+                const uint64_t budget = std::uniform_int_distribution<uint64_t>(0, 6)(random) * largest;
+                pool.SetIdleBudget(budget);
+                run.failures += pool.IdleBytes() <= budget ? 0 : 1;
+            }
+
+            std::set<FakeTexture*> leased(references.begin(), references.end());
+            uint64_t leasedBytes = 0;
+            for (FakeTexture* texture : leased)
+                leasedBytes += pool.GetAllocator().SizeInBytes(texture->key);
+            run.failures += CheckAccounting(pool, leased.size(), leasedBytes);
+            run.failures += pool.GetStats().hits + pool.GetStats().misses == acquires ? 0 : 1;
+        }
+
+        run.stats = pool.GetStats();
+        pool.Clear();
+        run.failures += pool.GetAllocator().live.empty() ? 0 : 1;
+        run.destroys = pool.GetAllocator().destroys;
+        return run;
+    }
+
+    struct RingRun
+    {
+        uint64_t failures = 0;
+        uint64_t captured = 0;
+        uint64_t overwritten = 0;                 // Ready frames recycled by BeginCapture.
+        uint64_t skipped = 0;                     // Captures with no slot to write to.
+        uint64_t presented = 0;
+    };
+
+    // Capture, interpolation and present run at random rates against a model of the ring. Every
+    // slot handed out is predicted, may only be held by one stage, and every step leaves the ring
+    // consistent with the model.
+    RingRun RunRing(std::mt19937& random, uint32_t steps)
+    {
+        struct ModelSlot
+        {
+            SlotState state = SlotState::Free;
+            uint64_t sequence = 0;
+        };
+
+        const size_t depth = std::uniform_int_distribution<size_t>(2, 6)(random);
+        CaptureRing ring(depth);
+        std::vector<ModelSlot> model(depth);
+        uint64_t nextSequence = 1;
+
+        // The oldest slot in a state by sequence, as the ring picks it; free slots by index.
+        auto oldest = [&](SlotState state) {
+            int found = CaptureRing::InvalidSlot;
+            for (size_t i = 0; i < depth; i++)
+            {
+                if (model[i].state == state && (found == CaptureRing::InvalidSlot || model[i].sequence < model[size_t(found)].sequence))
+                    found = int(i);
+            }
+            return found;
+        };
+
+        std::uniform_real_distribution<double> rate(0.1, 1.0);
+        std::discrete_distribution<int> actor({ rate(random), rate(random), rate(random) });
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+        RingRun run;
+        int capturing = CaptureRing::InvalidSlot;
+        int interpolating = CaptureRing::InvalidSlot;
+        std::deque<int> presenting;                // The presenter keeps up to two, like previous and current.
+        uint64_t fenceValue = 0;
+        for (uint32_t step = 0; step < steps; step++)
+        {
+            auto leased = [&](int slot) {
+                return slot == capturing || slot == interpolating
+                    || std::find(presenting.begin(), presenting.end(), slot) != presenting.end();
+            };
+
+            switch (actor(random))
+            {
+            case 0:
+                if (capturing == CaptureRing::InvalidSlot)
+                {
+                    int expected = oldest(SlotState::Free);
+                    const bool overwrite = expected == CaptureRing::InvalidSlot;
+                    if (overwrite)
+                        expected = oldest(SlotState::Ready);
+                    const int slot = ring.BeginCapture();
+                    run.failures += slot == expected ? 0 : 1;
+                    if (slot == CaptureRing::InvalidSlot)
+                    {
+                        run.skipped++;
+                        break;
+                    }
+                    run.failures += leased(slot) ? 1 : 0;
+                    run.overwritten += overwrite ? 1 : 0;
+                    model[size_t(slot)] = ModelSlot{ SlotState::Capturing, 0 };
+                    capturing = slot;
+                }
+                else if (chance(random) < 0.05)
+                {
+                    run.failures += ring.AbortCapture(capturing) ? 0 : 1;
+                    model[size_t(capturing)] = ModelSlot{};
+                    capturing = CaptureRing::InvalidSlot;
+                }
+                else
+                {
+                    run.failures += ring.EndCapture(capturing, ++fenceValue) && ring.GetFenceValue(capturing) == fenceValue ? 0 : 1;
+                    model[size_t(capturing)] = ModelSlot{ SlotState::Ready, nextSequence++ };
+                    capturing = CaptureRing::InvalidSlot;
+                    run.captured++;
+                }
+                break;
+
+            case 1:
+                if (interpolating == CaptureRing::InvalidSlot)
+                {
+                    const int slot = ring.AcquireForInterpolation();
+                    run.failures += slot == oldest(SlotState::Ready) ? 0 : 1;
+                    if (slot == CaptureRing::InvalidSlot)
+                        break;
+                    run.failures += leased(slot) ? 1 : 0;
+                    model[size_t(slot)].state = SlotState::Interpolating;
+                    interpolating = slot;
+                }
+                else if (presenting.size() < 2)
+                {
+                    run.failures += ring.EndInterpolation(interpolating, ++fenceValue) ? 0 : 1;
+                    model[size_t(interpolating)].state = SlotState::Presenting;
+                    presenting.push_back(interpolating);
+                    interpolating = CaptureRing::InvalidSlot;
+                }
+                break;
+
+            default:
+                if (!presenting.empty() && (presenting.size() == 2 || chance(random) < 0.3))
+                {
+                    run.failures += ring.Retire(presenting.front()) ? 0 : 1;
+                    model[size_t(presenting.front())] = ModelSlot{};
+                    presenting.pop_front();
+                    run.presented++;
+                }
+                break;
+            }
+
+            // A transition from the wrong state is refused and changes nothing.
+            const int stray = std::uniform_int_distribution<int>(-1, int(depth))(random);
+            if (stray < 0 || size_t(stray) >= depth || model[size_t(stray)].state != SlotState::Presenting)
+                run.failures += ring.Retire(stray) ? 1 : 0;
+            if (stray < 0 || size_t(stray) >= depth || model[size_t(stray)].state != SlotState::Capturing)
+                run.failures += ring.EndCapture(stray, 0) ? 1 : 0;
+
+            run.failures += ring.IsConsistent() ? 0 : 1;
+            run.failures += ring.GetDroppedFrames() == run.overwritten ? 0 : 1;
+            for (size_t i = 0; i < depth; i++)
+            {
+                run.failures += ring.GetState(int(i)) == model[i].state && ring.GetSequence(int(i)) == model[i].sequence ? 0 : 1;
+            }
+        }
+        return run;
+    }
+}
+
+int DX::PipelineCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+    const bool check = args.Has("check");
+    const uint32_t rounds = std::max(1u, args.GetUInt("check", 200));
+
+    // --check N: the texture pool and fence timeline on fixed sequences, the pool's idle budget across resizes,
+    // then N random runs of the pool and of the capture ring.
+    uint64_t failures = CheckPoolSequences() + CheckIdleBudget(random) + CheckFenceTimeline();
+    TexturePoolStats pool;
+    uint64_t destroys = 0;
+    RingRun ring;
+    for (uint32_t i = 0; i < rounds; i++)
+    {
+        const PoolRun poolRun = RunPool(random, 500);
+        failures += poolRun.failures;
+        pool.hits += poolRun.stats.hits;
+        pool.misses += poolRun.stats.misses;
+        destroys += poolRun.destroys;
+
+        const RingRun ringRun = RunRing(random, 2000);
+        failures += ringRun.failures;
+        ring.captured += ringRun.captured;
+        ring.overwritten += ringRun.overwritten;
+        ring.skipped += ringRun.skipped;
+        ring.presented += ringRun.presented;
+    }
+
+    printf("pipeline: texture pool %llu hits, %llu misses (%.1f%% reused), %llu destroyed\n", static_cast<unsigned long long>(pool.hits),
+        static_cast<unsigned long long>(pool.misses), 100.0 * pool.HitRate(), static_cast<unsigned long long>(destroys));
+    printf("pipeline: capture ring %llu captured, %llu overwritten, %llu skipped, %llu presented\n", static_cast<unsigned long long>(ring.captured),
+        static_cast<unsigned long long>(ring.overwritten), static_cast<unsigned long long>(ring.skipped), static_cast<unsigned long long>(ring.presented));
+    printf("pipeline: %u rounds, %llu failures\n", rounds, static_cast<unsigned long long>(failures));
+    if (check && failures != 0)
+        throw std::runtime_error("Pipeline bookkeeping failed its checks");
+    return 0;
+}
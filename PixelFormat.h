@@ -0,0 +1,467 @@
+//
+// PixelFormat.h - Internal pixel formats, their transfer functions, and per-pixel traits for the CPU kernels
+//
+// Every internal format has one transfer function, so a frame's meaning never depends on where it came
+// from. Conversions go through scRGB: linear light with BT.709 primaries where 1.0 is 80 nits.
+//   rgba8    8-bit sRGB-encoded BT.709, SDR white near 1.0 and brighter light soft-clipped below it.
+//   rgb10a2  HDR10: BT.2020 primaries, PQ-encoded up to 10000 nits.
+//   rgba16f  scRGB as half floats.
+//   nv12     sRGB-encoded BT.709 as limited-range YCbCr 4:2:0, like the recordings: 1.5 bytes a pixel.
+// ColorTransfer.hlsli has the same functions for the capture and present shaders. The kernels take the
+// traits below as a template argument, so each format is compiled into its own loops. nv12 is planar and
+// has no per-pixel traits; Nv12Convert.h has its layout and conversions, and callers handle it first.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace DX
+{
+    enum class PixelFormat
+    {
+        Rgba8,
+        Rgb10a2,
+        Rgba16f,
+        Nv12,
+        Count
+    };
+
+    enum class TransferFunction
+    {
+        Srgb,
+        Linear,     // scRGB
+        Pq,
+    };
+
+    inline const char* PixelFormatName(PixelFormat format) noexcept
+    {
+        switch (format)
+        {
+        case PixelFormat::Rgb10a2:  return "rgb10a2";
+        case PixelFormat::Rgba16f:  return "rgba16f";
+        case PixelFormat::Nv12:     return "nv12";
+        default:                    return "rgba8";
+        }
+    }
+
+    // Inverse of PixelFormatName. Returns false for unknown names.
+    inline bool PixelFormatFromName(const char* name, PixelFormat& format) noexcept
+    {
+        for (int i = 0; i < static_cast<int>(PixelFormat::Count); i++)
+        {
+            if (std::strcmp(name, PixelFormatName(static_cast<PixelFormat>(i))) == 0)
+            {
+                format = static_cast<PixelFormat>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline const char* TransferFunctionName(TransferFunction transfer) noexcept
+    {
+        switch (transfer)
+        {
+        case TransferFunction::Linear:  return "scrgb";
+        case TransferFunction::Pq:      return "pq";
+        default:                        return "srgb";
+        }
+    }
+
+    inline TransferFunction PixelFormatTransfer(PixelFormat format) noexcept
+    {
+        switch (format)
+        {
+        case PixelFormat::Rgb10a2:  return TransferFunction::Pq;
+        case PixelFormat::Rgba16f:  return TransferFunction::Linear;
+        default:                    return TransferFunction::Srgb;
+        }
+    }
+
+    inline bool PixelFormatPlanar(PixelFormat format) noexcept
+    {
+        return format == PixelFormat::Nv12;
+    }
+
+    // Bytes of a pixel, or of a luma sample for nv12.
+    inline uint32_t PixelFormatBytes(PixelFormat format) noexcept
+    {
+        switch (format)
+        {
+        case PixelFormat::Rgba16f:  return 8;
+        case PixelFormat::Nv12:     return 1;
+        default:                    return 4;
+        }
+    }
+
+    // Rows of a frame's view: nv12's interleaved chroma rows follow its luma rows at the same pitch, as
+    // D3D11 maps and uploads DXGI_FORMAT_NV12.
+    inline uint32_t PixelFormatRows(PixelFormat format, uint32_t height) noexcept
+    {
+        return format == PixelFormat::Nv12 ? height + height / 2 : height;
+    }
+
+    // Frame sizes are multiples of this: nv12 subsamples chroma 2x2.
+    inline uint32_t PixelFormatSizeStep(PixelFormat format) noexcept
+    {
+        return format == PixelFormat::Nv12 ? 2 : 1;
+    }
+
+    // Bytes of a frame without row padding.
+    inline uint64_t PixelFormatFrameBytes(PixelFormat format, uint32_t width, uint32_t height) noexcept
+    {
+        return uint64_t(width) * PixelFormatBytes(format) * PixelFormatRows(format, height);
+    }
+
+    // The DXGI_FORMAT of ring textures in the format, without the Windows headers.
+    inline uint32_t PixelFormatDxgi(PixelFormat format) noexcept
+    {
+        switch (format)
+        {
+        case PixelFormat::Rgb10a2:  return 24;     // DXGI_FORMAT_R10G10B10A2_UNORM
+        case PixelFormat::Rgba16f:  return 10;     // DXGI_FORMAT_R16G16B16A16_FLOAT
+        case PixelFormat::Nv12:     return 103;    // DXGI_FORMAT_NV12
+        default:                    return 28;     // DXGI_FORMAT_R8G8B8A8_UNORM
+        }
+    }
+
+    // How a duplicated desktop of a DXGI_FORMAT is encoded: FP16 desktops are scRGB, 8 and 10-bit ones
+    // are SDR sRGB.
+    inline TransferFunction DesktopTransfer(uint32_t dxgiFormat) noexcept
+    {
+        return dxgiFormat == 10 ? TransferFunction::Linear : TransferFunction::Srgb;
+    }
+
+    // Half floats, rounded to nearest even; out-of-range values become infinities.
+    inline float HalfToFloat(uint16_t half) noexcept
+    {
+        const uint32_t sign = uint32_t(half & 0x8000) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1f;
+        const uint32_t mantissa = half & 0x3ff;
+        uint32_t bits;
+        if (exponent == 0x1f)
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        else if (exponent != 0)
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        else if (mantissa == 0)
+            bits = sign;
+        else
+        {
+            // Subnormal: scale it up by hand.
+            float value = float(mantissa) * (1.0f / 16777216.0f);
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits |= sign;
+        }
+        float result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    inline uint16_t FloatToHalf(float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+        const uint32_t magnitude = bits & 0x7fffffff;
+        if (magnitude > 0x7f800000)
+            return uint16_t(sign | 0x7e00);                                 // NaN
+        if (magnitude >= 0x477ff000)
+            return uint16_t(sign | 0x7c00);                                 // Rounds past 65504.
+        if (magnitude < 0x38800000)
+        {
+            // Subnormal or zero: let the float unit do the rounding.
+            float scaled;
+            std::memcpy(&scaled, &magnitude, sizeof(scaled));
+            return uint16_t(sign | uint16_t(std::nearbyint(scaled * 16777216.0f)));
+        }
+        const uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+        return uint16_t(sign | ((rounded - 0x38000000) >> 13));
+    }
+
+    namespace Transfer
+    {
+        constexpr float ScRgbWhiteNits = 80.0f;
+        constexpr float PqPeakNits = 10000.0f;
+        constexpr float SoftClipKnee = 0.9f;         // SDR white lands at 96%, leaving the rest for highlights.
+
+        inline float SrgbToLinear(float v) noexcept
+        {
+            v = std::max(v, 0.0f);
+            return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+
+        inline float LinearToSrgb(float v) noexcept
+        {
+            v = std::clamp(v, 0.0f, 1.0f);
+            return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+        }
+
+        // SMPTE ST 2084, with 1.0 at PqPeakNits.
+        inline float LinearToPq(float v) noexcept
+        {
+            const float p = std::pow(std::max(v, 0.0f), 0.1593017578125f);
+            return std::pow((0.8359375f + 18.8515625f * p) / (1.0f + 18.6875f * p), 78.84375f);
+        }
+
+        inline float PqToLinear(float v) noexcept
+        {
+            const float p = std::pow(std::clamp(v, 0.0f, 1.0f), 1.0f / 78.84375f);
+            return std::pow(std::max(p - 0.8359375f, 0.0f) / (18.8515625f - 18.6875f * p), 1.0f / 0.1593017578125f);
+        }
+
+        // Identity up to the knee, then an exponential shoulder that reaches 1.0 only at infinity.
+        inline float SoftClip(float v) noexcept
+        {
+            if (v <= SoftClipKnee)
+                return v;
+            const float range = 1.0f - SoftClipKnee;
+            return SoftClipKnee + range * (1.0f - std::exp(-(v - SoftClipKnee) / range));
+        }
+
+        inline void Bt709ToBt2020(const float in[3], float out[3]) noexcept
+        {
+            out[0] = 0.6274040f * in[0] + 0.3292820f * in[1] + 0.0433136f * in[2];
+            out[1] = 0.0690970f * in[0] + 0.9195400f * in[1] + 0.0113612f * in[2];
+            out[2] = 0.0163916f * in[0] + 0.0880132f * in[1] + 0.8955950f * in[2];
+        }
+
+        inline void Bt2020ToBt709(const float in[3], float out[3]) noexcept
+        {
+            out[0] =  1.6604910f * in[0] - 0.5876411f * in[1] - 0.0728499f * in[2];
+            out[1] = -0.1245505f * in[0] + 1.1328999f * in[1] - 0.0083494f * in[2];
+            out[2] = -0.0181508f * in[0] - 0.1005789f * in[1] + 1.1187297f * in[2];
+        }
+
+        // Encoded values of a transfer function to scRGB. SDR white is sdrWhiteNits.
+        inline void Decode(TransferFunction transfer, const float in[3], float out[3], float sdrWhiteNits) noexcept
+        {
+            switch (transfer)
+            {
+            case TransferFunction::Srgb:
+                for (int c = 0; c < 3; c++)
+                    out[c] = SrgbToLinear(in[c]) * sdrWhiteNits / ScRgbWhiteNits;
+                break;
+            case TransferFunction::Pq:
+            {
+                float linear[3];
+                for (int c = 0; c < 3; c++)
+                    linear[c] = PqToLinear(in[c]) * PqPeakNits / ScRgbWhiteNits;
+                Bt2020ToBt709(linear, out);
+                break;
+            }
+            default:
+                std::copy(in, in + 3, out);
+                break;
+            }
+        }
+
+        // scRGB to encoded values of a transfer function.
+        inline void Encode(TransferFunction transfer, const float in[3], float out[3], float sdrWhiteNits) noexcept
+        {
+            switch (transfer)
+            {
+            case TransferFunction::Srgb:
+                for (int c = 0; c < 3; c++)
+                    out[c] = LinearToSrgb(SoftClip(in[c] * ScRgbWhiteNits / sdrWhiteNits));
+                break;
+            case TransferFunction::Pq:
+            {
+                float wide[3];
+                Bt709ToBt2020(in, wide);
+                for (int c = 0; c < 3; c++)
+                    out[c] = LinearToPq(wide[c] * ScRgbWhiteNits / PqPeakNits);
+                break;
+            }
+            default:
+                std::copy(in, in + 3, out);
+                break;
+            }
+        }
+    }
+
+    // Tables the traits share, built once.
+    namespace Detail
+    {
+        // 8-bit PQ code of scRGB luma, indexed by the luma as a half float. Negative halves map to zero.
+        inline const std::array<uint8_t, 65536>& PqLumaTable()
+        {
+            static const std::array<uint8_t, 65536> table = [] {
+                std::array<uint8_t, 65536> t = {};
+                for (uint32_t i = 0; i < t.size(); i++)
+                {
+                    const float value = HalfToFloat(uint16_t(i));
+                    const float code = value > 0.0f ? Transfer::LinearToPq(std::min(value, 125.0f) * Transfer::ScRgbWhiteNits / Transfer::PqPeakNits) : 0.0f;
+                    t[i] = uint8_t(std::lround(std::clamp(code, 0.0f, 1.0f) * 255.0f));
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        // scRGB of each 10-bit PQ code, still in BT.2020 primaries.
+        inline const std::array<float, 1024>& PqLinearTable()
+        {
+            static const std::array<float, 1024> table = [] {
+                std::array<float, 1024> t = {};
+                for (uint32_t i = 0; i < t.size(); i++)
+                    t[i] = Transfer::PqToLinear(float(i) / 1023.0f) * Transfer::PqPeakNits / Transfer::ScRgbWhiteNits;
+                return t;
+            }();
+            return table;
+        }
+    }
+
+    // Per-pixel operations of each format. Luma is 8-bit and perceptually even, for motion search;
+    // Average rounds half up in the format's own code values, like _mm_avg_epu8.
+    struct Rgba8Pixel
+    {
+        static constexpr PixelFormat Format = PixelFormat::Rgba8;
+        static constexpr uint32_t Bytes = 4;
+        static constexpr float ChannelMax = 255.0f;
+        static constexpr float AlphaMax = 255.0f;
+
+        // Channels as floats in the format's own units, and back, rounded to nearest even and saturated.
+        static void Unpack(const uint8_t* p, float* channels) noexcept
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                channels[c] = p[c];
+        }
+
+        static void Pack(const float* channels, uint8_t* p) noexcept
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                p[c] = static_cast<uint8_t>(std::clamp(std::nearbyint(channels[c]), 0.0f, ChannelMax));
+        }
+
+        static uint8_t Luma(const uint8_t* p) noexcept
+        {
+            return static_cast<uint8_t>((54 * p[0] + 183 * p[1] + 19 * p[2] + 128) >> 8);
+        }
+
+        static void Average(const uint8_t* a, const uint8_t* b, uint8_t* out) noexcept
+        {
+            for (uint32_t i = 0; i < Bytes; i++)
+                out[i] = static_cast<uint8_t>((a[i] + b[i] + 1) >> 1);
+        }
+    };
+
+    // R in the low 10 bits, then G, B and a 2-bit alpha, as DXGI_FORMAT_R10G10B10A2_UNORM.
+    struct Rgb10a2Pixel
+    {
+        static constexpr PixelFormat Format = PixelFormat::Rgb10a2;
+        static constexpr uint32_t Bytes = 4;
+        static constexpr float ChannelMax = 1023.0f;
+        static constexpr float AlphaMax = 3.0f;
+
+        // Bits a halving shift moves into the top of the field below; cleared so fields don't mix.
+        static constexpr uint32_t FieldCarries = (1u << 9) | (1u << 19) | (1u << 29);
+
+        static uint32_t Load(const uint8_t* p) noexcept
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        // Codes as floats, and back, rounded to nearest even and saturated.
+        static void Unpack(const uint8_t* p, float* channels) noexcept
+        {
+            const uint32_t v = Load(p);
+            for (uint32_t c = 0; c < 3; c++)
+                channels[c] = float((v >> (10 * c)) & 0x3ff);
+            channels[3] = float(v >> 30);
+        }
+
+        static void Pack(const float* channels, uint8_t* p) noexcept
+        {
+            uint32_t value = uint32_t(std::clamp(std::nearbyint(channels[3]), 0.0f, AlphaMax)) << 30;
+            for (uint32_t c = 0; c < 3; c++)
+                value |= uint32_t(std::clamp(std::nearbyint(channels[c]), 0.0f, ChannelMax)) << (10 * c);
+            std::memcpy(p, &value, sizeof(value));
+        }
+
+        // BT.2020 weights over PQ codes.
+        static uint8_t Luma(const uint8_t* p) noexcept
+        {
+            const uint32_t v = Load(p);
+            const uint32_t sum = 67 * (v & 0x3ff) + 174 * ((v >> 10) & 0x3ff) + 15 * ((v >> 20) & 0x3ff);
+            return static_cast<uint8_t>(std::min((sum + 512) >> 10, 255u));
+        }
+
+        // (a + b + 1) >> 1 in every field at once: (a | b) - ((a ^ b) >> 1).
+        static uint32_t AveragePacked(uint32_t a, uint32_t b) noexcept
+        {
+            return (a | b) - (((a ^ b) >> 1) & ~FieldCarries);
+        }
+
+        static void Average(const uint8_t* a, const uint8_t* b, uint8_t* out) noexcept
+        {
+            const uint32_t value = AveragePacked(Load(a), Load(b));
+            std::memcpy(out, &value, sizeof(value));
+        }
+    };
+
+    // Four half floats of scRGB.
+    struct Rgba16fPixel
+    {
+        static constexpr PixelFormat Format = PixelFormat::Rgba16f;
+        static constexpr uint32_t Bytes = 8;
+        static constexpr float ChannelMax = 1.0f;   // SDR white; scRGB goes past it, so nothing saturates.
+        static constexpr float AlphaMax = 1.0f;
+
+        static float Channel(const uint8_t* p, uint32_t c) noexcept
+        {
+            uint16_t half;
+            std::memcpy(&half, p + c * 2, sizeof(half));
+            return HalfToFloat(half);
+        }
+
+        static void Unpack(const uint8_t* p, float* channels) noexcept
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                channels[c] = Channel(p, c);
+        }
+
+        static void Pack(const float* channels, uint8_t* p) noexcept
+        {
+            const uint16_t halves[4] = { FloatToHalf(channels[0]), FloatToHalf(channels[1]), FloatToHalf(channels[2]), FloatToHalf(channels[3]) };
+            std::memcpy(p, halves, sizeof(halves));
+        }
+
+        // BT.709 luma of the linear light, PQ-encoded through a table.
+        static uint8_t Luma(const uint8_t* p, const std::array<uint8_t, 65536>& pqLuma) noexcept
+        {
+            const float y = 0.2126f * Channel(p, 0) + 0.7152f * Channel(p, 1) + 0.0722f * Channel(p, 2);
+            return pqLuma[FloatToHalf(y)];
+        }
+
+        static uint8_t Luma(const uint8_t* p) noexcept { return Luma(p, Detail::PqLumaTable()); }
+
+        static void Average(const uint8_t* a, const uint8_t* b, uint8_t* out) noexcept
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const uint16_t half = FloatToHalf(0.5f * (Channel(a, c) + Channel(b, c)));
+                std::memcpy(out + c * 2, &half, sizeof(half));
+            }
+        }
+    };
+
+    // Call work with the traits of a packed format, so the choice is made once outside the loops. nv12
+    // has none; PixelFormatPlanar formats must not be passed.
+    template<typename TWork>
+    decltype(auto) VisitPixelFormat(PixelFormat format, TWork&& work)
+    {
+        switch (format)
+        {
+        case PixelFormat::Rgb10a2:  return work(Rgb10a2Pixel{});
+        case PixelFormat::Rgba16f:  return work(Rgba16fPixel{});
+        default:                    return work(Rgba8Pixel{});
+        }
+    }
+}
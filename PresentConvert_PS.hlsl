@@ -0,0 +1,23 @@
+//
+// PresentConvert_PS.hlsl - SpriteBatch pixel shader that converts frames from the internal format to the swap chain's
+//
+
+#include "ColorTransfer.hlsli"
+
+Texture2D<float4> Texture : register(t0);
+SamplerState TextureSampler : register(s0);
+
+cbuffer Constants : register(b0)
+{
+    uint SourceTransfer;        // Of the internal format.
+    uint DestinationTransfer;   // Of the swap chain's color space.
+    float SdrWhiteNits;
+    uint Padding;
+};
+
+float4 main(float4 color : COLOR0, float2 texCoord : TEXCOORD0) : SV_Target0
+{
+    // The tint is in the source's transfer, as sRGB overlays are drawn in it.
+    float4 texel = Texture.Sample(TextureSampler, texCoord) * color;
+    return float4(ConvertTransfer(texel.rgb, SourceTransfer, DestinationTransfer, SdrWhiteNits), texel.a);
+}
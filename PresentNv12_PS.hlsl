@@ -0,0 +1,23 @@
+//
+// PresentNv12_PS.hlsl - PresentConvert_PS.hlsl for nv12 frames, which SpriteBatch draws by their luma plane
+//
+
+#include "ColorTransfer.hlsli"
+
+Texture2D<float> Texture : register(t0);           // Luma plane view.
+Texture2D<float2> Chroma : register(t1);           // Chroma plane view, sampled at the same coordinates.
+SamplerState TextureSampler : register(s0);
+
+cbuffer Constants : register(b0)
+{
+    uint SourceTransfer;        // Of the internal format.
+    uint DestinationTransfer;   // Of the swap chain's color space.
+    float SdrWhiteNits;
+    uint Padding;
+};
+
+float4 main(float4 color : COLOR0, float2 texCoord : TEXCOORD0) : SV_Target0
+{
+    float3 rgb = LumaChromaToRgb(Texture.Sample(TextureSampler, texCoord), Chroma.Sample(TextureSampler, texCoord));
+    return float4(ConvertTransfer(rgb, SourceTransfer, DestinationTransfer, SdrWhiteNits), 1.0f) * color;
+}
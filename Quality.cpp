@@ -0,0 +1,184 @@
+//
+// Quality.cpp - Interpolation quality benchmark against held-out frames
+//
+// Takes a high frame rate clip, drops every other frame, rebuilds the dropped frames through
+// IFrameInterpolator and scores them against the originals. A plain blend of the neighbours is
+// scored alongside as the baseline that motion compensation has to beat.
+//
+
+#include "ToolMain.h"
+#include "FrameIO.h"
+#include "FrameInterpolator.h"
+#include "QualityMetrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    FILE* Open(const std::string& path, const char* mode)
+    {
+        FILE* file = nullptr;
+#ifdef _WIN32
+        fopen_s(&file, path.c_str(), mode);
+#else
+        file = fopen(path.c_str(), mode);
+#endif
+        return file;
+    }
+
+    // Append to an existing CSV so runs with different settings collect into one file.
+    FILE* OpenCsv(const std::string& path, const char* header)
+    {
+        if (path.empty() || path == "-")
+        {
+            fprintf(stdout, "%s\n", header);
+            return stdout;
+        }
+
+        bool empty = true;
+        if (FILE* existing = Open(path, "rb"))
+        {
+            empty = fgetc(existing) == EOF;
+            fclose(existing);
+        }
+        FILE* file = Open(path, "ab");
+        if (file == nullptr)
+            throw std::runtime_error("Cannot open " + path);
+        if (empty)
+            fprintf(file, "%s\n", header);
+        return file;
+    }
+
+    void CloseCsv(FILE* file)
+    {
+        if (file != nullptr && file != stdout)
+            fclose(file);
+    }
+}
+
+int DX::QualityMain(const ToolArgs& args)
+{
+    const std::string input = args.Get("in");
+    if (input.empty())
+        throw std::runtime_error("--in is required");
+
+    FrameFormat rawFormat;
+    args.GetSize("size", rawFormat.width, rawFormat.height);
+    rawFormat.rateNumerator = args.GetUInt("rate", 120);
+
+    auto source = OpenFrameSource(input, FrameFileFormatFromPath(input), rawFormat);
+    const FrameFormat& inFormat = source->Format();
+
+    // Score at the resolution the interpolator runs at, same resFactor semantics as the viewer.
+    const double scale = args.GetNumber("scale", 1.0);
+    const uint32_t width = static_cast<uint32_t>(inFormat.width / scale);
+    const uint32_t height = static_cast<uint32_t>(inFormat.height / scale);
+    const ScaleFilter filter = args.GetFilter("filter", ScaleFilter::Bilinear);
+    const bool scaling = width != inFormat.width || height != inFormat.height;
+
+    CpuInterpolatorSettings settings;
+    settings.threads = args.GetUInt("threads", 1);
+    settings.blockSize = args.GetUInt("block", settings.blockSize);
+    if (args.Has("scalar"))
+        settings.tier = SimdTier::Scalar;
+    CpuFrameInterpolator interpolator(settings);
+
+    QualityMeter meter(args.GetUInt("tile", 128), settings.tier);
+    QualityMeter blendMeter(meter.TileSize(), settings.tier);
+    Resampler<Rgba8Pixel> resampler;
+    resampler.Configure(inFormat.width, inFormat.height, width, height, filter);
+
+    // Blending with a zero motion field gives the baseline.
+    const uint32_t blocksX = (width + settings.blockSize - 1) / settings.blockSize;
+    const uint32_t blocksY = (height + settings.blockSize - 1) / settings.blockSize;
+    const std::vector<MotionVector> zeroField(size_t(blocksX) * blocksY);
+
+    Image sourceFrame(inFormat.width, inFormat.height, 4);
+    Image previous(width, height, 4);
+    Image heldOut(width, height, 4);
+    Image next(width, height, 4);
+    Image interpolated(width, height, 4);
+    Image blended(width, height, 4);
+
+    auto readFrame = [&](Image& frame) {
+        if (!scaling)
+            return source->Read(frame.View());
+        if (!source->Read(sourceFrame.View()))
+            return false;
+        resampler.Process(sourceFrame.View(), frame.View(), settings.tier);
+        return true;
+    };
+
+    const std::string label = args.Get("label", interpolator.Name());
+    FILE* csv = OpenCsv(args.Get("csv"), "label,width,height,filter,block,threads,tier,frame,interpolate_ms,psnr,ssim,blend_psnr,blend_ssim");
+    FILE* tilesCsv = args.Has("tiles") ? OpenCsv(args.Get("tiles"), "label,frame,tile_x,tile_y,psnr,ssim,blend_psnr,blend_ssim") : nullptr;
+
+    // Prime the interpolator with the first kept frame.
+    const uint32_t maxFrames = args.GetUInt("frames", UINT32_MAX);
+    const double frameInterval = 1.0 / inFormat.FramesPerSecond();
+    if (!readFrame(previous))
+        throw std::runtime_error("No frames in " + input);
+    interpolator.Process(previous.View(), 0.0, interpolated.View(), nullptr);
+
+    uint32_t scored = 0;
+    double totalSeconds = 0.0;
+    double meanMSE = 0.0, meanSSIM = 0.0;
+    double blendMSE = 0.0, blendSSIM = 0.0;
+    double worstSSIM = 1.0;
+    for (uint32_t frame = 1; scored < maxFrames && readFrame(heldOut) && readFrame(next); frame += 2, scored++)
+    {
+        const auto start = Clock::now();
+        interpolator.Process(next.View(), double(frame + 1) * frameInterval, interpolated.View(), nullptr);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        totalSeconds += seconds;
+
+        Kernels::ComposeMidpoint(previous.View(), next.View(), zeroField, settings, blended.View(), 0, blocksY);
+
+        const QualityScore score = meter.Score(heldOut.View(), interpolated.View());
+        const QualityScore blend = blendMeter.Score(heldOut.View(), blended.View());
+
+        fprintf(csv, "%s,%u,%u,%s,%u,%u,%s,%u,%.3f,%.3f,%.5f,%.3f,%.5f\n", label.c_str(), width, height, ScaleFilterName(filter),
+            settings.blockSize, settings.threads, SimdTierName(settings.tier), frame, seconds * 1000.0,
+            score.psnr, score.ssim, blend.psnr, blend.ssim);
+        if (tilesCsv != nullptr)
+        {
+            const auto& tiles = meter.Tiles();
+            const auto& blendTiles = blendMeter.Tiles();
+            for (size_t tile = 0; tile < tiles.size(); tile++)
+            {
+                fprintf(tilesCsv, "%s,%u,%u,%u,%.3f,%.5f,%.3f,%.5f\n", label.c_str(), frame,
+                    uint32_t(tile % meter.TilesX()), uint32_t(tile / meter.TilesX()),
+                    tiles[tile].psnr, tiles[tile].ssim, blendTiles[tile].psnr, blendTiles[tile].ssim);
+            }
+        }
+
+        meanMSE += score.mse;
+        meanSSIM += score.ssim;
+        blendMSE += blend.mse;
+        blendSSIM += blend.ssim;
+        worstSSIM = std::min(worstSSIM, score.ssim);
+
+        std::swap(previous, next);
+    }
+
+    CloseCsv(csv);
+    CloseCsv(tilesCsv);
+    if (scored == 0)
+        throw std::runtime_error("Need at least three frames");
+
+    // PSNR of the mean MSE, which doesn't let a few perfect frames hide the bad ones.
+    fprintf(stderr, "quality: %u held-out frames at %ux%u, %s backend, %u threads, %s\n",
+        scored, width, height, interpolator.Name(), settings.threads, SimdTierName(settings.tier));
+    fprintf(stderr, "quality: interpolated PSNR %.3f dB, SSIM %.5f (worst %.5f), %.3f ms/frame\n",
+        PSNRFromMSE(meanMSE / scored), meanSSIM / scored, worstSSIM, 1000.0 * totalSeconds / scored);
+    fprintf(stderr, "quality: blend baseline PSNR %.3f dB, SSIM %.5f\n",
+        PSNRFromMSE(blendMSE / scored), blendSSIM / scored);
+    return 0;
+}
@@ -0,0 +1,223 @@
+//
+// QualityMetrics.cpp - Full-reference image quality (PSNR and SSIM) for scoring interpolated frames
+//
+
+#include "QualityMetrics.h"
+#include "FrameInterpolator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // SSIM stabilisers for 8-bit data, (0.01 * 255)^2 and (0.03 * 255)^2.
+    constexpr double c_C1 = 6.5025;
+    constexpr double c_C2 = 58.5225;
+    constexpr double c_WindowPixels = 64.0;
+}
+
+double DX::PSNRFromMSE(double mse) noexcept
+{
+    if (mse <= 0.0)
+        return c_MaxPSNR;
+    return std::min(c_MaxPSNR, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+uint64_t Kernels::SumSquaredError(ConstImageView a, ConstImageView b, uint32_t x, uint32_t y, uint32_t w, uint32_t h, SimdTier tier)
+{
+    const uint32_t bytes = w * 4;
+    uint64_t total = 0;
+    for (uint32_t row = y; row < y + h; row++)
+    {
+        const uint8_t* pa = a.Row(row) + size_t(x) * 4;
+        const uint8_t* pb = b.Row(row) + size_t(x) * 4;
+        uint32_t i = 0;
+#if DX_HAS_SSE2
+        if (tier == SimdTier::SSE2)
+        {
+            // Zero alpha in both inputs so it drops out of the differences.
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+            __m128i acc = _mm_setzero_si128();
+            for (; i + 16 <= bytes; i += 16)
+            {
+                const __m128i va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i)), rgbMask);
+                const __m128i vb = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i)), rgbMask);
+                const __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+                const __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+                acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+            }
+
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+            total += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        }
+#endif
+        for (; i < bytes; i++)
+        {
+            if ((i & 3) == 3)
+                continue;
+            const int d = int(pa[i]) - int(pb[i]);
+            total += uint64_t(d * d);
+        }
+    }
+    (void)tier;
+    return total;
+}
+
+void Kernels::SSIMBlockSums(const uint8_t* a, size_t pitchA, const uint8_t* b, size_t pitchB, uint32_t width, int32_t* sums, SimdTier tier)
+{
+    const uint32_t blocks = width / 4;
+    uint32_t block = 0;
+#if DX_HAS_SSE2
+    if (tier == SimdTier::SSE2)
+    {
+        // Two blocks per iteration: 8 pixels widened to 16 bits, accumulated over the 4 rows.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; block + 2 <= blocks; block += 2)
+        {
+            __m128i sumA = _mm_setzero_si128();
+            __m128i sumB = _mm_setzero_si128();
+            __m128i sumSquares = _mm_setzero_si128();
+            __m128i sumProducts = _mm_setzero_si128();
+            for (uint32_t row = 0; row < 4; row++)
+            {
+                const __m128i va = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + row * pitchA + block * 4)), zero);
+                const __m128i vb = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + row * pitchB + block * 4)), zero);
+                sumA = _mm_add_epi16(sumA, va);
+                sumB = _mm_add_epi16(sumB, vb);
+                sumSquares = _mm_add_epi32(sumSquares, _mm_add_epi32(_mm_madd_epi16(va, va), _mm_madd_epi16(vb, vb)));
+                sumProducts = _mm_add_epi32(sumProducts, _mm_madd_epi16(va, vb));
+            }
+
+            // Lanes 0-1 belong to the first block and 2-3 to the second.
+            alignas(16) int32_t lanes[4][4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), _mm_madd_epi16(sumA, ones));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), _mm_madd_epi16(sumB, ones));
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), sumSquares);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes[3]), sumProducts);
+            for (int sum = 0; sum < 4; sum++)
+            {
+                sums[block * 4 + sum] = lanes[sum][0] + lanes[sum][1];
+                sums[block * 4 + 4 + sum] = lanes[sum][2] + lanes[sum][3];
+            }
+        }
+    }
+#endif
+    for (; block < blocks; block++)
+    {
+        int32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+        for (uint32_t row = 0; row < 4; row++)
+        {
+            for (uint32_t x = block * 4; x < block * 4 + 4; x++)
+            {
+                const int32_t va = a[row * pitchA + x];
+                const int32_t vb = b[row * pitchB + x];
+                s1 += va;
+                s2 += vb;
+                ss += va * va + vb * vb;
+                s12 += va * vb;
+            }
+        }
+        sums[block * 4 + 0] = s1;
+        sums[block * 4 + 1] = s2;
+        sums[block * 4 + 2] = ss;
+        sums[block * 4 + 3] = s12;
+    }
+    (void)tier;
+}
+
+double Kernels::SSIMWindow(const int32_t* topLeft, const int32_t* topRight, const int32_t* bottomLeft, const int32_t* bottomRight) noexcept
+{
+    double s[4];
+    for (int i = 0; i < 4; i++)
+        s[i] = double(topLeft[i]) + topRight[i] + bottomLeft[i] + bottomRight[i];
+
+    const double meanA = s[0] / c_WindowPixels;
+    const double meanB = s[1] / c_WindowPixels;
+    const double variances = s[2] / c_WindowPixels - meanA * meanA - meanB * meanB;
+    const double covariance = s[3] / c_WindowPixels - meanA * meanB;
+    return ((2.0 * meanA * meanB + c_C1) * (2.0 * covariance + c_C2))
+        / ((meanA * meanA + meanB * meanB + c_C1) * (variances + c_C2));
+}
+
+QualityScore QualityMeter::Score(ConstImageView reference, ConstImageView test)
+{
+    if (reference.width != test.width || reference.height != test.height)
+        throw std::runtime_error("QualityMeter: reference and test sizes differ");
+
+    const uint32_t width = reference.width;
+    const uint32_t height = reference.height;
+    m_tilesX = (width + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (height + m_tileSize - 1) / m_tileSize;
+    m_tiles.assign(size_t(m_tilesX) * m_tilesY, QualityScore{});
+    m_tileSSIM.assign(m_tiles.size(), 0.0);
+    m_tileWindows.assign(m_tiles.size(), 0);
+
+    // PSNR per tile, summed for the frame.
+    uint64_t frameError = 0;
+    for (uint32_t ty = 0; ty < m_tilesY; ty++)
+    {
+        for (uint32_t tx = 0; tx < m_tilesX; tx++)
+        {
+            const uint32_t x = tx * m_tileSize;
+            const uint32_t y = ty * m_tileSize;
+            const uint32_t w = std::min(m_tileSize, width - x);
+            const uint32_t h = std::min(m_tileSize, height - y);
+            const uint64_t error = Kernels::SumSquaredError(reference, test, x, y, w, h, m_tier);
+            frameError += error;
+
+            QualityScore& tile = m_tiles[size_t(ty) * m_tilesX + tx];
+            tile.mse = double(error) / (double(w) * h * 3);
+            tile.psnr = PSNRFromMSE(tile.mse);
+        }
+    }
+
+    QualityScore frame;
+    frame.mse = width * height == 0 ? 0.0 : double(frameError) / (double(width) * height * 3);
+    frame.psnr = PSNRFromMSE(frame.mse);
+
+    // SSIM on luma, keeping two rows of 4x4 block sums.
+    m_referenceLuma.Resize(width, height, 1);
+    m_testLuma.Resize(width, height, 1);
+    Kernels::ComputeLuma(reference, m_referenceLuma.View(), m_tier);
+    Kernels::ComputeLuma(test, m_testLuma.View(), m_tier);
+
+    const uint32_t blocksX = width / 4;
+    const uint32_t blocksY = height / 4;
+    for (auto& sums : m_blockSums)
+        sums.resize(size_t(blocksX) * 4);
+
+    ConstImageView referenceLuma = m_referenceLuma.View();
+    ConstImageView testLuma = m_testLuma.View();
+    double frameSSIM = 0.0;
+    uint64_t frameWindows = 0;
+    for (uint32_t by = 0; by < blocksY; by++)
+    {
+        int32_t* current = m_blockSums[by & 1].data();
+        Kernels::SSIMBlockSums(referenceLuma.Row(by * 4), referenceLuma.pitch, testLuma.Row(by * 4), testLuma.pitch, width, current, m_tier);
+        if (by == 0)
+            continue;
+
+        const int32_t* previous = m_blockSums[(by - 1) & 1].data();
+        const uint32_t tileY = std::min(m_tilesY - 1, (by * 4) / m_tileSize);
+        for (uint32_t bx = 0; bx + 1 < blocksX; bx++)
+        {
+            const double ssim = Kernels::SSIMWindow(previous + bx * 4, previous + bx * 4 + 4, current + bx * 4, current + bx * 4 + 4);
+            const size_t tile = size_t(tileY) * m_tilesX + std::min(m_tilesX - 1, (bx * 4 + 4) / m_tileSize);
+            m_tileSSIM[tile] += ssim;
+            m_tileWindows[tile]++;
+            frameSSIM += ssim;
+            frameWindows++;
+        }
+    }
+
+    for (size_t tile = 0; tile < m_tiles.size(); tile++)
+        m_tiles[tile].ssim = m_tileWindows[tile] == 0 ? 1.0 : m_tileSSIM[tile] / m_tileWindows[tile];
+    frame.ssim = frameWindows == 0 ? 1.0 : frameSSIM / double(frameWindows);
+    return frame;
+}
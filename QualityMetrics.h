@@ -0,0 +1,65 @@
+//
+// QualityMetrics.h - Full-reference image quality (PSNR and SSIM) for scoring interpolated frames
+//
+
+#pragma once
+
+#include "Image.h"
+#include "Simd.h"
+
+#include <vector>
+
+namespace DX
+{
+    struct QualityScore
+    {
+        double mse = 0.0;       // Mean squared error over the R, G and B channels.
+        double psnr = 0.0;      // In dB, capped at c_MaxPSNR for identical images.
+        double ssim = 1.0;      // Mean SSIM over the 8x8 luma windows.
+    };
+
+    constexpr double c_MaxPSNR = 100.0;
+
+    double PSNRFromMSE(double mse) noexcept;
+
+    namespace Kernels
+    {
+        // Sum of squared differences over the R, G and B channels of the w x h region at (x, y).
+        uint64_t SumSquaredError(ConstImageView a, ConstImageView b, uint32_t x, uint32_t y, uint32_t w, uint32_t h, SimdTier tier);
+
+        // Per 4x4 block sums of two luma planes: a, b, a^2 + b^2 and ab, four ints per block.
+        // sums must hold 4 * (width / 4) entries; trailing columns that don't fill a block are ignored.
+        void SSIMBlockSums(const uint8_t* a, size_t pitchA, const uint8_t* b, size_t pitchB, uint32_t width, int32_t* sums, SimdTier tier);
+
+        // SSIM of one 8x8 window from the four 4x4 block sums that cover it.
+        double SSIMWindow(const int32_t* topLeft, const int32_t* topRight, const int32_t* bottomLeft, const int32_t* bottomRight) noexcept;
+    }
+
+    // Scores a test frame against a reference, for the whole frame and per square tile.
+    // SSIM uses 8x8 windows on a 4 pixel grid, as x264 does; each window counts towards the tile holding its centre.
+    class QualityMeter
+    {
+    public:
+        explicit QualityMeter(uint32_t tileSize = 128, SimdTier tier = BestSimdTier()) : m_tileSize(tileSize), m_tier(tier) {}
+
+        QualityScore Score(ConstImageView reference, ConstImageView test);
+
+        // Results of the last Score call, row-major.
+        const std::vector<QualityScore>& Tiles() const noexcept { return m_tiles; }
+        uint32_t TilesX() const noexcept { return m_tilesX; }
+        uint32_t TilesY() const noexcept { return m_tilesY; }
+        uint32_t TileSize() const noexcept { return m_tileSize; }
+
+    private:
+        uint32_t                    m_tileSize;
+        SimdTier                    m_tier;
+        uint32_t                    m_tilesX = 0;
+        uint32_t                    m_tilesY = 0;
+        Image                       m_referenceLuma;
+        Image                       m_testLuma;
+        std::vector<int32_t>        m_blockSums[2];
+        std::vector<double>         m_tileSSIM;
+        std::vector<uint32_t>       m_tileWindows;
+        std::vector<QualityScore>   m_tiles;
+    };
+}
@@ -0,0 +1,106 @@
+//
+// ReadbackRing.h - Slot bookkeeping for GPU-to-CPU copies that are mapped a few frames after they are issued
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+    // Each slot stands for one staging texture:
+    //     Free -> Copying (copy issued on frame N) -> Free (mapped on frame N + latency or later)
+    // Mapping that late means the GPU has long finished the copy, so Map never stalls the render
+    // thread. When every slot is still waiting to be mapped the new frame is dropped, not queued.
+    class ReadbackRing
+    {
+    public:
+        static constexpr int InvalidSlot = -1;
+
+        explicit ReadbackRing(size_t depth = 4, uint32_t latency = 3) { Reset(depth, latency); }
+
+        // Resize the ring and mark every slot free. latency is in frames and should be below depth.
+        void Reset(size_t depth, uint32_t latency)
+        {
+            m_slots.assign(depth, Slot{});
+            m_latency = latency;
+            m_copied = 0;
+            m_mapped = 0;
+            m_droppedFrames = 0;
+        }
+
+        // Claim a slot for a copy issued on the given frame. Returns InvalidSlot and counts a drop if none is free.
+        int BeginCopy(uint64_t frame)
+        {
+            for (size_t i = 0; i < m_slots.size(); i++)
+            {
+                if (m_slots[i].copying)
+                    continue;
+                m_slots[i].copying = true;
+                m_slots[i].frame = frame;
+                m_copied++;
+                return static_cast<int>(i);
+            }
+            m_droppedFrames++;
+            return InvalidSlot;
+        }
+
+        // Oldest copy that has aged at least the latency by the given frame, or InvalidSlot.
+        // Pass UINT64_MAX to get the oldest copy regardless of age, e.g. when draining at the end.
+        int NextToMap(uint64_t frame) const
+        {
+            int found = InvalidSlot;
+            for (size_t i = 0; i < m_slots.size(); i++)
+            {
+                if (!m_slots[i].copying || m_slots[i].frame > frame || frame - m_slots[i].frame < m_latency)
+                    continue;
+                if (found == InvalidSlot || m_slots[i].frame < m_slots[found].frame)
+                    found = static_cast<int>(i);
+            }
+            return found;
+        }
+
+        // The slot's bytes have been read (or abandoned) and the staging texture can be reused.
+        bool EndMap(int slot)
+        {
+            if (slot < 0 || static_cast<size_t>(slot) >= m_slots.size() || !m_slots[slot].copying)
+                return false;
+            m_slots[slot].copying = false;
+            m_mapped++;
+            return true;
+        }
+
+        size_t Pending() const
+        {
+            size_t count = 0;
+            for (auto const& slot : m_slots)
+            {
+                if (slot.copying)
+                    count++;
+            }
+            return count;
+        }
+
+        size_t Depth() const noexcept { return m_slots.size(); }
+        uint32_t Latency() const noexcept { return m_latency; }
+        uint64_t GetFrame(int slot) const { return m_slots[slot].frame; }
+        uint64_t GetCopiedFrames() const noexcept { return m_copied; }
+        uint64_t GetMappedFrames() const noexcept { return m_mapped; }
+        uint64_t GetDroppedFrames() const noexcept { return m_droppedFrames; }
+
+    private:
+        struct Slot
+        {
+            bool copying = false;
+            uint64_t frame = 0;
+        };
+
+        std::vector<Slot>   m_slots;
+        uint32_t            m_latency = 0;
+        uint64_t            m_copied = 0;
+        uint64_t            m_mapped = 0;
+        uint64_t            m_droppedFrames = 0;
+    };
+}
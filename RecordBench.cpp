@@ -0,0 +1,125 @@
+//
+// RecordBench.cpp - The recorder's cost on the render thread and its writer throughput, against RAM or a file
+//
+
+#include "ToolMain.h"
+#include "FrameRecorder.h"
+#include "ReadbackRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Stand-in for a mapped staging texture: a gradient that differs per slot.
+    void FillStaging(Image& image, uint32_t seed)
+    {
+        for (uint32_t y = 0; y < image.Height(); y++)
+        {
+            uint8_t* row = image.View().Row(y);
+            for (uint32_t x = 0; x < image.Width(); x++)
+            {
+                row[x * 4 + 0] = static_cast<uint8_t>(x + seed * 16);
+                row[x * 4 + 1] = static_cast<uint8_t>(y + seed * 32);
+                row[x * 4 + 2] = static_cast<uint8_t>((x ^ y) + seed);
+                row[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
+
+int DX::RecordBenchMain(const ToolArgs& args)
+{
+    FrameFormat format;
+    if (!args.GetSize("size", format.width, format.height))
+    {
+        format.width = 1920;
+        format.height = 1080;
+    }
+    const double rate = args.GetNumber("rate", 0.0);
+    format.rateNumerator = rate > 0.0 ? static_cast<uint32_t>(rate) : 240;
+
+    const uint32_t frames = std::max(1u, args.GetUInt("frames", 600));
+    const uint32_t depth = std::max(2u, args.GetUInt("ring", 4));
+    const uint32_t latency = std::min(depth - 1, args.GetUInt("latency", 3));
+    const std::string fileFormatName = args.Get("format", "y4m");
+    if (fileFormatName != "y4m" && fileFormatName != "raw")
+        throw std::runtime_error("--format must be y4m or raw");
+    const FrameFileFormat fileFormat = fileFormatName == "y4m" ? FrameFileFormat::Y4M : FrameFileFormat::RawRGBA;
+
+    // RAM unless --out names a file, so the numbers exclude the disk.
+    const std::string output = args.Get("out");
+    std::unique_ptr<RecordSink> sink;
+    if (output.empty())
+        sink = std::make_unique<MemoryRecordSink>();
+    else
+        sink = CreateFileRecordSink(output);
+    FrameRecorder recorder(std::move(sink), fileFormat, format, args.GetUInt("queue", 8));
+
+    std::vector<Image> staging(depth);
+    for (uint32_t i = 0; i < depth; i++)
+    {
+        staging[i].Resize(format.width, format.height, 4);
+        FillStaging(staging[i], i);
+    }
+
+    // Drive the ring the way the viewer does: copy on every present, map latency frames later.
+    ReadbackRing ring(depth, latency);
+    std::vector<double> submitSeconds;
+    submitSeconds.reserve(frames);
+    const auto interval = std::chrono::duration<double>(rate > 0.0 ? 1.0 / rate : 0.0);
+    const auto start = Clock::now();
+    auto drain = [&](uint64_t frame) {
+        for (int slot = ring.NextToMap(frame); slot != ReadbackRing::InvalidSlot; slot = ring.NextToMap(frame))
+        {
+            const auto submitStart = Clock::now();
+            recorder.Submit(staging[slot].View());
+            submitSeconds.push_back(std::chrono::duration<double>(Clock::now() - submitStart).count());
+            ring.EndMap(slot);
+        }
+    };
+    for (uint64_t frame = 0; frame < frames; frame++)
+    {
+        if (rate > 0.0)
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(interval * double(frame)));
+        drain(frame);
+        ring.BeginCopy(frame);
+    }
+    drain(UINT64_MAX);
+    const double renderSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (!recorder.Stop())
+        throw std::runtime_error("Recording failed");
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const FrameRecorderStats stats = recorder.Stats();
+
+    std::sort(submitSeconds.begin(), submitSeconds.end());
+    double submitTotal = 0.0;
+    for (double seconds : submitSeconds)
+        submitTotal += seconds;
+    const double submitMean = submitSeconds.empty() ? 0.0 : submitTotal / double(submitSeconds.size());
+    const double submitP99 = submitSeconds.empty() ? 0.0 : submitSeconds[std::min(submitSeconds.size() - 1, submitSeconds.size() * 99 / 100)];
+
+    char pace[32] = "full speed";
+    if (rate > 0.0)
+        snprintf(pace, sizeof(pace), "%.0f fps", rate);
+    printf("recordbench: %ux%u %s to %s, %u frames at %s, ring %u with latency %u\n", format.width, format.height, fileFormatName.c_str(),
+        output.empty() ? "RAM" : output.c_str(), frames, pace, depth, latency);
+    printf("recordbench: submit %.3f ms mean, %.3f ms p99 on the render thread\n", 1000.0 * submitMean, 1000.0 * submitP99);
+    printf("recordbench: %llu written, %llu dropped (%llu by the readback ring), %.1f MB\n",
+        static_cast<unsigned long long>(stats.writtenFrames), static_cast<unsigned long long>(stats.droppedFrames),
+        static_cast<unsigned long long>(ring.GetDroppedFrames()), double(stats.bytesWritten) / (1 << 20));
+    printf("recordbench: writer %.1f frames/s and %.1f MB/s while busy; render loop %.2f s, drained after %.2f s\n",
+        stats.writerBusySeconds > 0 ? double(stats.writtenFrames) / stats.writerBusySeconds : 0.0,
+        stats.writerBusySeconds > 0 ? double(stats.bytesWritten) / (1 << 20) / stats.writerBusySeconds : 0.0,
+        renderSeconds, wallSeconds);
+    return 0;
+}
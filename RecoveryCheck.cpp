@@ -0,0 +1,404 @@
+//
+// RecoveryCheck.cpp - Inject duplication faults into simulated outputs and check how the viewer recovers
+//
+
+#include "ToolMain.h"
+#include "CaptureRecovery.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr double c_FrameSeconds = 1.0 / 120.0;
+
+    // What the system does to an output, as the viewer sees it through AcquireNextFrame, DuplicateOutput
+    // and EnumOutputs.
+    struct SimOutput
+    {
+        // The system's side.
+        uint32_t    modeWidth = 2560, modeHeight = 1440;
+        bool        sessionValid = true;
+        double      deniedUntil = -1.0;         // Secure desktop.
+        double      unavailableUntil = -1.0;    // Too many sessions.
+        double      goneUntil = -1.0;           // Unplugged.
+        uint32_t    failingDuplicates = 0;      // DuplicateOutput calls that fail before one works.
+        uint32_t    failedDuplicates = 0;       // Of those, since the output last recovered.
+        double      clearSeconds = 0.0;         // When the last injected condition is over.
+        bool        outputRebuildNeeded = false;
+
+        // The viewer's side.
+        bool        hasSession = true;
+        uint32_t    capturedWidth = 2560, capturedHeight = 1440;
+        CaptureRecovery recovery;
+        uint64_t    shownFrame = 1;             // The last good frame, kept on screen while recovering.
+        uint64_t    attempts = 0;
+        uint64_t    rebuilds[4] = {};
+        uint64_t    unneededOutputRebuilds = 0;
+    };
+
+    struct SimWorld
+    {
+        std::vector<SimOutput> outputs;
+        bool        deviceRemoved = false;
+        uint64_t    deviceRemovals = 0;
+        uint64_t    deviceRebuilds = 0;
+        uint64_t    nextFrame = 2;
+        uint64_t    presented = 0;
+        uint64_t    blankPresents = 0;
+        uint64_t    injected[9] = {};
+    };
+
+    // One injected fault, from what the system does; every kind takes the session down.
+    void InjectFault(SimWorld& world, SimOutput& output, double now, std::mt19937& random, const RecoverySettings& settings)
+    {
+        const int kind = std::uniform_int_distribution<int>(0, 99)(random);
+        std::uniform_real_distribution<double> seconds(0.1, 6.0);
+        output.sessionValid = false;
+        output.clearSeconds = std::max(output.clearSeconds, now);
+        if (kind < 40)
+        {
+            world.injected[size_t(CaptureFault::AccessLost)]++;
+        }
+        else if (kind < 55)
+        {
+            // A resolution or rotation change.
+            static const uint32_t modes[][2] = { { 2560, 1440 }, { 1920, 1080 }, { 1440, 2560 }, { 3840, 2160 }, { 1280, 720 } };
+            const auto& mode = modes[std::uniform_int_distribution<size_t>(0, std::size(modes) - 1)(random)];
+            if (mode[0] != output.modeWidth || mode[1] != output.modeHeight)
+                output.outputRebuildNeeded = true;
+            output.modeWidth = mode[0];
+            output.modeHeight = mode[1];
+            world.injected[size_t(CaptureFault::ModeChanged)]++;
+        }
+        else if (kind < 70)
+        {
+            output.deniedUntil = now + seconds(random);
+            output.clearSeconds = std::max(output.clearSeconds, output.deniedUntil);
+            world.injected[size_t(CaptureFault::AccessDenied)]++;
+        }
+        else if (kind < 78)
+        {
+            output.unavailableUntil = now + seconds(random);
+            output.clearSeconds = std::max(output.clearSeconds, output.unavailableUntil);
+            world.injected[size_t(CaptureFault::Unavailable)]++;
+        }
+        else if (kind < 86)
+        {
+            output.goneUntil = now + seconds(random);
+            output.clearSeconds = std::max(output.clearSeconds, output.goneUntil);
+            output.outputRebuildNeeded = true;
+            world.injected[size_t(CaptureFault::OutputGone)]++;
+        }
+        else if (kind < 96)
+        {
+            // A session that takes a few tries to come back; enough of them is worth an output rebuild.
+            output.failingDuplicates += std::uniform_int_distribution<uint32_t>(1, settings.escalateAfter + 2)(random);
+            world.injected[size_t(CaptureFault::Other)]++;
+        }
+        else
+        {
+            world.deviceRemovals += world.deviceRemoved ? 0 : 1;
+            world.deviceRemoved = true;
+            world.injected[size_t(CaptureFault::DeviceRemoved)]++;
+        }
+    }
+
+    CaptureFault AcquireNextFrame(const SimWorld& world, const SimOutput& output)
+    {
+        if (world.deviceRemoved)
+            return CaptureFault::DeviceRemoved;
+        return output.sessionValid ? CaptureFault::None : CaptureFault::AccessLost;
+    }
+
+    // DuplicateOutput on the output the viewer holds. A session at another mode than the one captured
+    // works, but the viewer finds the mode changed.
+    CaptureFault DuplicateOutput(const SimWorld& world, SimOutput& output, double now)
+    {
+        if (world.deviceRemoved)
+            return CaptureFault::DeviceRemoved;
+        if (now < output.goneUntil)
+            return CaptureFault::OutputGone;
+        if (now < output.deniedUntil)
+            return CaptureFault::AccessDenied;
+        if (now < output.unavailableUntil)
+            return CaptureFault::Unavailable;
+        if (output.failingDuplicates > 0)
+        {
+            output.failingDuplicates--;
+            output.failedDuplicates++;
+            return CaptureFault::AccessLost;
+        }
+        output.sessionValid = true;
+        output.hasSession = true;
+        return CaptureFault::None;
+    }
+
+    // The viewer's rebuilds, as Game::RecreateDuplication and Game::RecreateOutput do them.
+    CaptureFault Rebuild(SimWorld& world, SimOutput& output, RecoveryLayer layer, double now)
+    {
+        output.hasSession = false;
+        const CaptureFault fault = DuplicateOutput(world, output, now);
+        if (fault != CaptureFault::None)
+            return fault;
+        if (layer == RecoveryLayer::Output)
+        {
+            output.capturedWidth = output.modeWidth;
+            output.capturedHeight = output.modeHeight;
+            return CaptureFault::None;
+        }
+        return output.capturedWidth == output.modeWidth && output.capturedHeight == output.modeHeight ? CaptureFault::None : CaptureFault::ModeChanged;
+    }
+
+    // Device removal rebuilds every output, as OnDeviceLost and OnDeviceRestored do. An output that
+    // can't be duplicated yet starts out recovering.
+    void RebuildDevice(SimWorld& world, double now, const RecoverySettings& settings)
+    {
+        world.deviceRemoved = false;
+        world.deviceRebuilds++;
+        for (SimOutput& output : world.outputs)
+        {
+            const bool available = now >= output.goneUntil && now >= output.deniedUntil && now >= output.unavailableUntil;
+            output.recovery = CaptureRecovery(settings);
+            output.sessionValid = available;
+            output.hasSession = available;
+            output.failingDuplicates = 0;
+            output.failedDuplicates = 0;
+            if (available)
+            {
+                output.capturedWidth = output.modeWidth;
+                output.capturedHeight = output.modeHeight;
+                output.outputRebuildNeeded = false;
+            }
+        }
+    }
+
+    // One frame of the viewer: capture what it can, rebuild what is due, and present.
+    void Step(SimWorld& world, double now, const RecoverySettings& settings)
+    {
+        for (SimOutput& output : world.outputs)
+        {
+            if (output.recovery.Recovering())
+                continue;
+            const CaptureFault fault = AcquireNextFrame(world, output);
+            if (fault == CaptureFault::None)
+                output.shownFrame = world.nextFrame++;
+            else
+                output.recovery.OnFault(fault, now);
+        }
+
+        for (SimOutput& output : world.outputs)
+        {
+            const RecoveryLayer layer = output.recovery.Due(now);
+            if (layer == RecoveryLayer::None)
+                continue;
+            output.attempts++;
+            output.rebuilds[size_t(layer)]++;
+            if (layer == RecoveryLayer::Device)
+            {
+                RebuildDevice(world, now, settings);
+                break;
+            }
+            if (layer == RecoveryLayer::Output && !output.outputRebuildNeeded && output.failedDuplicates < settings.escalateAfter)
+                output.unneededOutputRebuilds++;
+            const CaptureFault result = Rebuild(world, output, layer, now);
+            if (layer == RecoveryLayer::Output && result == CaptureFault::None)
+                output.outputRebuildNeeded = false;
+            output.recovery.OnRebuilt(result, now);
+            if (!output.recovery.Recovering())
+                output.failedDuplicates = 0;
+        }
+
+        // Every output still has its last good frame to show.
+        for (const SimOutput& output : world.outputs)
+            world.blankPresents += output.shownFrame == 0 ? 1 : 0;
+        world.presented++;
+    }
+
+    struct SimRun
+    {
+        uint64_t failures = 0;
+        uint64_t faults = 0;
+        uint64_t recoveries = 0;
+        uint64_t attempts = 0;
+        uint64_t rebuilds[4] = {};
+        double   recoveringSeconds = 0.0;
+        double   worstRecoverySeconds = 0.0;
+    };
+
+    // Faults at random for a while, then quiet until every condition is over; every output must be
+    // capturing its current mode again within a bounded time.
+    SimRun Simulate(uint32_t outputs, double seconds, double faultsPerSecond, const RecoverySettings& settings, std::mt19937& random, SimWorld& world)
+    {
+        world = SimWorld();
+        world.outputs.assign(outputs, SimOutput());
+        for (SimOutput& output : world.outputs)
+            output.recovery = CaptureRecovery(settings);
+
+        std::bernoulli_distribution fault(faultsPerSecond * c_FrameSeconds);
+        double now = 0.0;
+        for (; now < seconds; now += c_FrameSeconds)
+        {
+            for (SimOutput& output : world.outputs)
+            {
+                if (fault(random))
+                    InjectFault(world, output, now, random, settings);
+            }
+            Step(world, now, settings);
+        }
+
+        // Quiet: the longest backoff after the last condition clears, plus the attempts still to fail
+        // and an escalation's.
+        double settle = now;
+        for (const SimOutput& output : world.outputs)
+            settle = std::max(settle, output.clearSeconds + (output.failingDuplicates + settings.escalateAfter + 2) * settings.maxBackoffSeconds);
+        for (; now < settle; now += c_FrameSeconds)
+            Step(world, now, settings);
+
+        SimRun run;
+        for (const SimOutput& output : world.outputs)
+        {
+            const bool recovered = !output.recovery.Recovering() && output.sessionValid && output.hasSession
+                && output.capturedWidth == output.modeWidth && output.capturedHeight == output.modeHeight;
+            run.failures += recovered ? 0 : 1;
+            run.failures += output.unneededOutputRebuilds;
+            run.faults += output.recovery.Faults();
+            run.recoveries += output.recovery.Recoveries();
+            run.attempts += output.attempts;
+            run.recoveringSeconds += output.recovery.RecoveringSeconds();
+            for (size_t layer = 0; layer < 4; layer++)
+                run.rebuilds[layer] += output.rebuilds[layer];
+        }
+
+        // The device is rebuilt once per removal at most, and the screen never goes blank.
+        run.failures += run.rebuilds[size_t(RecoveryLayer::Device)] <= world.deviceRemovals && world.deviceRebuilds == world.deviceRemovals ? 0 : 1;
+        run.failures += world.blankPresents;
+        return run;
+    }
+
+    // The state machine alone, on fixed sequences.
+    uint64_t CheckTransitions()
+    {
+        uint64_t failures = 0;
+        const RecoverySettings settings;
+
+        static const struct { uint32_t hresult; CaptureFault fault; } results[] =
+        {
+            { 0x00000000, CaptureFault::None }, { 0x00000001, CaptureFault::None }, { 0x887A0027, CaptureFault::Timeout },
+            { 0x887A0026, CaptureFault::AccessLost }, { 0x80070005, CaptureFault::AccessDenied }, { 0x887A0022, CaptureFault::Unavailable },
+            { 0x887A0002, CaptureFault::OutputGone }, { 0x887A0005, CaptureFault::DeviceRemoved }, { 0x887A0007, CaptureFault::DeviceRemoved },
+            { 0x80004005, CaptureFault::Other },
+        };
+        for (auto const& entry : results)
+            failures += ClassifyCaptureResult(static_cast<int32_t>(entry.hresult)) == entry.fault ? 0 : 1;
+
+        // A timeout is not a fault.
+        CaptureRecovery recovery(settings);
+        failures += recovery.OnFault(CaptureFault::Timeout, 0.0) == RecoveryLayer::None && !recovery.Recovering() ? 0 : 1;
+
+        // Access lost: a new session at once; a session that keeps failing escalates to the output.
+        failures += recovery.OnFault(CaptureFault::AccessLost, 1.0) == RecoveryLayer::Duplication && recovery.Due(1.0) == RecoveryLayer::Duplication ? 0 : 1;
+        double now = 1.0;
+        for (uint32_t i = 0; i + 1 < settings.escalateAfter; i++)
+        {
+            recovery.OnRebuilt(CaptureFault::AccessLost, now);
+            failures += recovery.Due(now) == RecoveryLayer::None && recovery.Pending() == RecoveryLayer::Duplication ? 0 : 1;
+            now += settings.maxBackoffSeconds;
+        }
+        recovery.OnRebuilt(CaptureFault::AccessLost, now);
+        failures += recovery.Due(now) == RecoveryLayer::Output ? 0 : 1;
+        recovery.OnRebuilt(CaptureFault::None, now);
+        failures += !recovery.Recovering() && recovery.Recoveries() == 1 && recovery.LastRecoverySeconds() == now - 1.0 ? 0 : 1;
+
+        // A mode change found while re-duplicating escalates at once; a smaller fault doesn't lower the layer.
+        recovery.OnFault(CaptureFault::AccessLost, 10.0);
+        recovery.OnRebuilt(CaptureFault::ModeChanged, 10.0);
+        failures += recovery.Due(10.0) == RecoveryLayer::Output ? 0 : 1;
+        failures += recovery.OnFault(CaptureFault::AccessLost, 10.0) == RecoveryLayer::Output ? 0 : 1;
+        recovery.OnRebuilt(CaptureFault::None, 10.0);
+
+        // The secure desktop only backs off, up to the limit, however long it lasts.
+        recovery.OnFault(CaptureFault::AccessLost, 20.0);
+        now = 20.0;
+        double lastGap = 0.0;
+        for (int i = 0; i < 50; i++)
+        {
+            recovery.OnRebuilt(CaptureFault::AccessDenied, now);
+            double due = now;
+            while (recovery.Due(due) == RecoveryLayer::None)
+                due += 0.001;
+            lastGap = due - now;
+            failures += recovery.Pending() == RecoveryLayer::Duplication && lastGap <= settings.maxBackoffSeconds + 0.002 ? 0 : 1;
+            now = due;
+        }
+        failures += lastGap >= settings.maxBackoffSeconds - 0.002 ? 0 : 1;
+
+        // Device removal goes straight to the device and stays there.
+        failures += recovery.OnFault(CaptureFault::DeviceRemoved, now) == RecoveryLayer::Device && recovery.Due(now) == RecoveryLayer::Device ? 0 : 1;
+        recovery.OnRebuilt(CaptureFault::AccessLost, now);
+        failures += recovery.Pending() == RecoveryLayer::Device ? 0 : 1;
+        return failures;
+    }
+
+    void PrintRun(const SimRun& run, const SimWorld& world, uint32_t outputs, double seconds)
+    {
+        printf("recovery: %u outputs, %.0f s, %llu frames presented, %llu with an output blank\n", outputs, seconds,
+            static_cast<unsigned long long>(world.presented), static_cast<unsigned long long>(world.blankPresents));
+        printf("recovery: injected");
+        for (CaptureFault fault : { CaptureFault::AccessLost, CaptureFault::ModeChanged, CaptureFault::AccessDenied, CaptureFault::Unavailable,
+                                    CaptureFault::OutputGone, CaptureFault::Other, CaptureFault::DeviceRemoved })
+            printf(" %s %llu", CaptureFaultName(fault), static_cast<unsigned long long>(world.injected[size_t(fault)]));
+        printf("\n");
+        printf("recovery: %llu recoveries in %llu attempts; rebuilt duplication %llu, output %llu, device %llu times\n",
+            static_cast<unsigned long long>(run.recoveries), static_cast<unsigned long long>(run.attempts),
+            static_cast<unsigned long long>(run.rebuilds[size_t(RecoveryLayer::Duplication)]),
+            static_cast<unsigned long long>(run.rebuilds[size_t(RecoveryLayer::Output)]),
+            static_cast<unsigned long long>(run.rebuilds[size_t(RecoveryLayer::Device)]));
+        printf("recovery: %.1f s spent recovering, %.0f ms per recovery, %llu failures\n", run.recoveringSeconds,
+            run.recoveries != 0 ? 1000.0 * run.recoveringSeconds / double(run.recoveries) : 0.0, static_cast<unsigned long long>(run.failures));
+    }
+}
+
+int DX::RecoveryCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+    RecoverySettings settings;
+    settings.maxBackoffSeconds = args.GetNumber("max-backoff", settings.maxBackoffSeconds);
+    settings.escalateAfter = std::max(1u, args.GetUInt("escalate-after", settings.escalateAfter));
+
+    // --check N: the transitions on fixed sequences, then N random runs of injected faults.
+    if (args.Has("check"))
+    {
+        const uint32_t runs = std::max(1u, args.GetUInt("check", 100));
+        uint64_t failures = CheckTransitions();
+        uint64_t faults = 0;
+        for (uint32_t i = 0; i < runs; i++)
+        {
+            SimWorld world;
+            const uint32_t outputs = std::uniform_int_distribution<uint32_t>(1, 4)(random);
+            const double rate = std::uniform_real_distribution<double>(0.02, 0.5)(random);
+            const SimRun run = Simulate(outputs, 30.0, rate, settings, random, world);
+            failures += run.failures;
+            faults += run.faults;
+        }
+
+        printf("recovery: %u runs, %llu faults, %llu failures\n", runs, static_cast<unsigned long long>(faults), static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Capture recovery failed its checks");
+        return 0;
+    }
+
+    const uint32_t outputs = std::max(1u, args.GetUInt("outputs", 2));
+    const double seconds = std::max(1.0, args.GetNumber("seconds", 60.0));
+    const double rate = std::max(0.0, args.GetNumber("faults", 0.1));
+    SimWorld world;
+    const SimRun run = Simulate(outputs, seconds, rate, settings, random, world);
+    PrintRun(run, world, outputs, seconds);
+    return 0;
+}
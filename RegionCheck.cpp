@@ -0,0 +1,213 @@
+//
+// RegionCheck.cpp - Follow a simulated window with a CaptureRegion, and check the crop on random motion
+//
+
+#include "ToolMain.h"
+#include "CaptureRegion.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    struct RegionRun
+    {
+        uint64_t updates = 0;
+        uint64_t grows = 0;
+        uint64_t shrinks = 0;
+        uint64_t failures = 0;
+        double cropPixels = 0.0;        // Summed over updates.
+        double wantedPixels = 0.0;
+    };
+
+    // A window dragged and resized around the output: it keeps heading for a random target and
+    // sometimes changes size, with a few pixels of jitter on every update.
+    class WindowPath
+    {
+    public:
+        WindowPath(uint32_t outputWidth, uint32_t outputHeight, uint32_t width, uint32_t height, uint32_t jitter, std::mt19937& random)
+            : m_outputWidth(int32_t(outputWidth)), m_outputHeight(int32_t(outputHeight)), m_width(int32_t(width)), m_height(int32_t(height)),
+              m_jitter(int32_t(jitter)), m_random(random)
+        {
+            NewTarget();
+            m_x = m_targetX;
+            m_y = m_targetY;
+        }
+
+        DesktopRect Next()
+        {
+            if (std::abs(m_x - m_targetX) < 8 && std::abs(m_y - m_targetY) < 8)
+                NewTarget();
+            m_x += std::clamp(m_targetX - m_x, -24, 24);
+            m_y += std::clamp(m_targetY - m_y, -24, 24);
+            if (std::uniform_int_distribution<int>(0, 199)(m_random) == 0)
+            {
+                m_width = std::uniform_int_distribution<int32_t>(64, m_outputWidth)(m_random);
+                m_height = std::uniform_int_distribution<int32_t>(64, m_outputHeight)(m_random);
+            }
+            std::uniform_int_distribution<int32_t> jitter(-m_jitter, m_jitter);
+            const int32_t left = m_x + jitter(m_random);
+            const int32_t top = m_y + jitter(m_random);
+            return { left, top, left + m_width + jitter(m_random), top + m_height + jitter(m_random) };
+        }
+
+    private:
+        void NewTarget()
+        {
+            // Partly off the output now and then, as windows are.
+            m_targetX = std::uniform_int_distribution<int32_t>(-m_width / 4, m_outputWidth - m_width * 3 / 4)(m_random);
+            m_targetY = std::uniform_int_distribution<int32_t>(-m_height / 4, m_outputHeight - m_height * 3 / 4)(m_random);
+        }
+
+        int32_t         m_outputWidth, m_outputHeight;
+        int32_t         m_width, m_height;
+        int32_t         m_jitter;
+        int32_t         m_x = 0, m_y = 0;
+        int32_t         m_targetX = 0, m_targetY = 0;
+        std::mt19937&   m_random;
+    };
+
+    bool Contains(const DesktopRect& outer, const DesktopRect& inner)
+    {
+        return inner.left >= outer.left && inner.top >= outer.top && inner.right <= outer.right && inner.bottom <= outer.bottom;
+    }
+
+    // The crop is a size class, inside the output, and contains the part of the region on the output.
+    void Step(CaptureRegion& region, const DesktopRect& wanted, uint32_t outputWidth, uint32_t outputHeight, RegionRun& run)
+    {
+        const uint32_t width = region.Width();
+        const uint32_t height = region.Height();
+        const bool resized = region.Update(wanted);
+        const DesktopRect& crop = region.Crop();
+        const DesktopRect whole = { 0, 0, int32_t(outputWidth), int32_t(outputHeight) };
+
+        const bool sizeOk = RegionSizeClass(region.Width(), outputWidth) == region.Width() && RegionSizeClass(region.Height(), outputHeight) == region.Height();
+        const bool resizeOk = resized == (width != region.Width() || height != region.Height());
+        run.failures += Contains(whole, crop) && Contains(crop, region.Wanted()) && Contains(whole, region.Wanted()) && sizeOk && resizeOk ? 0 : 1;
+
+        run.updates++;
+        run.grows += resized && (region.Width() > width || region.Height() > height) ? 1 : 0;
+        run.shrinks += resized && region.Width() <= width && region.Height() <= height ? 1 : 0;
+        run.cropPixels += double(crop.Width()) * crop.Height();
+        run.wantedPixels += double(region.Wanted().Width()) * region.Wanted().Height();
+    }
+
+    // A rectangle on a rotated output maps inside the image rectangle DesktopToImageRect gives for it.
+    uint64_t CheckImageRects(std::mt19937& random, uint32_t count)
+    {
+        uint64_t failures = 0;
+        std::uniform_int_distribution<int32_t> size(480, 3840), offset(-4000, 4000), rotation(0, 3);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            DesktopLayout layout;
+            DesktopRect bounds;
+            bounds.left = offset(random);
+            bounds.top = offset(random);
+            bounds.right = bounds.left + size(random);
+            bounds.bottom = bounds.top + size(random);
+            layout.AddOutput(0, "output", bounds, static_cast<OutputRotation>(rotation(random)));
+            const DesktopOutput& output = layout.Output(0);
+
+            std::uniform_int_distribution<int32_t> x(bounds.left - 500, bounds.right + 500), y(bounds.top - 500, bounds.bottom + 500);
+            DesktopRect desktop = { x(random), y(random), 0, 0 };
+            desktop.right = desktop.left + std::uniform_int_distribution<int32_t>(1, 2000)(random);
+            desktop.bottom = desktop.top + std::uniform_int_distribution<int32_t>(1, 2000)(random);
+            const DesktopRect image = DesktopToImageRect(output, desktop);
+            const DesktopRect clipped = { std::max(desktop.left, bounds.left), std::max(desktop.top, bounds.top),
+                std::min(desktop.right, bounds.right), std::min(desktop.bottom, bounds.bottom) };
+            if (clipped.Width() <= 0 || clipped.Height() <= 0)
+            {
+                failures += image.Width() <= 0 || image.Height() <= 0 ? 0 : 1;
+                continue;
+            }
+            std::uniform_real_distribution<double> u(clipped.left, clipped.right), v(clipped.top, clipped.bottom);
+            for (int j = 0; j < 64; j++)
+            {
+                const Point2D p = output.desktopToImage.Apply({ u(random), v(random) });
+                failures += p.x >= image.left && p.x <= image.right && p.y >= image.top && p.y <= image.bottom ? 0 : 1;
+            }
+            failures += image.Width() * image.Height() == clipped.Width() * clipped.Height() ? 0 : 1;
+        }
+        return failures;
+    }
+}
+
+int DX::RegionCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+
+    // --check N: random outputs and windows, including a region jittering across a class boundary,
+    // which must not re-create the interpolator more than once.
+    if (args.Has("check"))
+    {
+        const uint32_t scenarios = std::max(1u, args.GetUInt("check", 200));
+        std::uniform_int_distribution<uint32_t> outputSize(640, 3840), jitter(0, 6);
+        uint64_t failures = 0, updates = 0;
+        for (uint32_t i = 0; i < scenarios; i++)
+        {
+            const uint32_t outputWidth = outputSize(random);
+            const uint32_t outputHeight = outputSize(random);
+            CaptureRegion region;
+            region.Reset(outputWidth, outputHeight);
+            RegionRun run;
+            WindowPath path(outputWidth, outputHeight, std::uniform_int_distribution<uint32_t>(64, outputWidth)(random),
+                std::uniform_int_distribution<uint32_t>(64, outputHeight)(random), jitter(random), random);
+            for (int j = 0; j < 2000; j++)
+                Step(region, path.Next(), outputWidth, outputHeight, run);
+
+            // Shrinking takes RegionShrinkUpdates updates each time.
+            failures += run.failures + (run.shrinks * RegionShrinkUpdates <= run.updates ? 0 : 1);
+
+            // A fixed region on a class boundary, a few pixels either side.
+            const uint32_t boundary = std::min(RegionSizeClass(RegionMinExtent + 1, outputWidth), outputWidth - 8);
+            CaptureRegion edge;
+            edge.Reset(outputWidth, outputHeight);
+            RegionRun edgeRun;
+            std::uniform_int_distribution<int32_t> wobble(-4, 4);
+            for (int j = 0; j < 2000; j++)
+                Step(edge, { 0, 0, int32_t(boundary) + wobble(random), int32_t(RegionMinExtent) }, outputWidth, outputHeight, edgeRun);
+            failures += edgeRun.failures + (edgeRun.grows + edgeRun.shrinks <= 3 ? 0 : 1);
+            updates += run.updates + edgeRun.updates;
+        }
+        failures += CheckImageRects(random, scenarios * 10);
+
+        printf("region: %u scenarios, %llu updates, %llu failures\n", scenarios, static_cast<unsigned long long>(updates), static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Capture region failed its checks");
+        return 0;
+    }
+
+    uint32_t outputWidth = 0, outputHeight = 0, windowWidth = 0, windowHeight = 0;
+    if (!args.GetSize("output", outputWidth, outputHeight))
+    {
+        outputWidth = 2560;
+        outputHeight = 1440;
+    }
+    if (!args.GetSize("window", windowWidth, windowHeight))
+    {
+        windowWidth = 1280;
+        windowHeight = 720;
+    }
+    const uint32_t updates = std::max(1u, args.GetUInt("updates", 6000));
+    const uint32_t jitter = args.GetUInt("jitter", 2);
+
+    CaptureRegion region;
+    region.Reset(outputWidth, outputHeight);
+    RegionRun run;
+    WindowPath path(outputWidth, outputHeight, std::min(windowWidth, outputWidth), std::min(windowHeight, outputHeight), jitter, random);
+    for (uint32_t i = 0; i < updates; i++)
+        Step(region, path.Next(), outputWidth, outputHeight, run);
+
+    const double outputPixels = double(outputWidth) * outputHeight * double(run.updates);
+    printf("region: %ux%u output, %ux%u window resized now and then, %llu updates\n", outputWidth, outputHeight, windowWidth, windowHeight,
+        static_cast<unsigned long long>(run.updates));
+    printf("region: crop averages %.1f%% of the output (window %.1f%%), %llu re-creations (%llu grow, %llu shrink), %llu failures\n",
+        100.0 * run.cropPixels / outputPixels, 100.0 * run.wantedPixels / outputPixels,
+        static_cast<unsigned long long>(run.grows + run.shrinks), static_cast<unsigned long long>(run.grows),
+        static_cast<unsigned long long>(run.shrinks), static_cast<unsigned long long>(run.failures));
+    return 0;
+}
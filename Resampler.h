@@ -0,0 +1,344 @@
+//
+// Resampler.h - Separable image resampling with precomputed weight tables
+//
+
+#pragma once
+
+#include "Image.h"
+#include "PixelFormat.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace DX
+{
+    enum class ScaleFilter
+    {
+        Bilinear,
+        Bicubic,
+        Lanczos3,
+        Area,
+        Count
+    };
+
+    inline const char* ScaleFilterName(ScaleFilter filter) noexcept
+    {
+        switch (filter)
+        {
+        case ScaleFilter::Bicubic:  return "bicubic";
+        case ScaleFilter::Lanczos3: return "lanczos3";
+        case ScaleFilter::Area:     return "area";
+        default:                    return "bilinear";
+        }
+    }
+
+    // Inverse of ScaleFilterName. Returns false for unknown names.
+    inline bool ScaleFilterFromName(const char* name, ScaleFilter& filter) noexcept
+    {
+        for (int i = 0; i < static_cast<int>(ScaleFilter::Count); i++)
+        {
+            if (std::strcmp(name, ScaleFilterName(static_cast<ScaleFilter>(i))) == 0)
+            {
+                filter = static_cast<ScaleFilter>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Weights for one axis. Destination index i reads taps source texels starting at start[i].
+    struct ResampleWeights
+    {
+        uint32_t srcSize = 0;
+        uint32_t dstSize = 0;
+        uint32_t taps = 0;
+        std::vector<int32_t> start;
+        std::vector<float> weights;     // dstSize * taps, each row sums to one.
+    };
+
+    namespace Detail
+    {
+        constexpr double Pi = 3.14159265358979323846;
+
+        inline double Sinc(double x) noexcept
+        {
+            if (std::abs(x) < 1e-8)
+                return 1.0;
+            return std::sin(Pi * x) / (Pi * x);
+        }
+
+        // Filter support radius in source texels at unit scale.
+        inline double FilterRadius(ScaleFilter filter) noexcept
+        {
+            switch (filter)
+            {
+            case ScaleFilter::Bicubic:  return 2.0;
+            case ScaleFilter::Lanczos3: return 3.0;
+            case ScaleFilter::Area:     return 0.5;
+            default:                    return 1.0;
+            }
+        }
+
+        inline double FilterKernel(ScaleFilter filter, double x) noexcept
+        {
+            x = std::abs(x);
+            switch (filter)
+            {
+            case ScaleFilter::Bicubic:
+                // Catmull-Rom keeps text edges sharp.
+                if (x < 1.0) return 1.5 * x * x * x - 2.5 * x * x + 1.0;
+                if (x < 2.0) return -0.5 * x * x * x + 2.5 * x * x - 4.0 * x + 2.0;
+                return 0.0;
+            case ScaleFilter::Lanczos3:
+                return x < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+            case ScaleFilter::Area:
+                return x <= 0.5 ? 1.0 : 0.0;
+            default:
+                return x < 1.0 ? 1.0 - x : 0.0;
+            }
+        }
+    }
+
+    inline ResampleWeights BuildResampleWeights(uint32_t srcSize, uint32_t dstSize, ScaleFilter filter)
+    {
+        ResampleWeights table;
+        table.srcSize = srcSize;
+        table.dstSize = dstSize;
+        if (srcSize == 0 || dstSize == 0)
+            return table;
+
+        // Widen the kernel when shrinking so every source texel contributes.
+        const double ratio = double(srcSize) / double(dstSize);
+        const double scale = std::max(ratio, 1.0);
+        const double radius = Detail::FilterRadius(filter) * scale;
+        table.taps = std::min<uint32_t>(srcSize, static_cast<uint32_t>(std::ceil(radius * 2.0)) + 1);
+        table.start.resize(dstSize);
+        table.weights.assign(size_t(dstSize) * table.taps, 0.f);
+
+        std::vector<double> row(table.taps);
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            const double center = (i + 0.5) * ratio;
+            const int first = static_cast<int>(std::floor(center - radius + 0.5));
+            const int start = std::clamp(first, 0, int(srcSize - table.taps));
+            table.start[i] = start;
+
+            std::fill(row.begin(), row.end(), 0.0);
+            double sum = 0.0;
+            for (int j = first; j < first + int(table.taps); j++)
+            {
+                double weight;
+                if (filter == ScaleFilter::Area)
+                {
+                    // Exact overlap of texel [j, j + 1) with the destination footprint.
+                    const double lo = std::max(double(j), center - ratio * 0.5);
+                    const double hi = std::min(double(j + 1), center + ratio * 0.5);
+                    weight = std::max(hi - lo, 0.0);
+                }
+                else
+                {
+                    weight = Detail::FilterKernel(filter, (j + 0.5 - center) / scale);
+                }
+
+                // Texels past the edge fold back onto the border texel.
+                const int clamped = std::clamp(j, 0, int(srcSize) - 1);
+                row[std::clamp(clamped - start, 0, int(table.taps) - 1)] += weight;
+                sum += weight;
+            }
+
+            for (uint32_t k = 0; k < table.taps; k++)
+            {
+                table.weights[size_t(i) * table.taps + k] = static_cast<float>(sum != 0.0 ? row[k] / sum : 0.0);
+            }
+        }
+        return table;
+    }
+
+    // Two-pass resampler over the pixels of a packed format, filtering each channel in the format's own
+    // units. The horizontal pass writes a float intermediate so negative lobes survive.
+    template<typename TPixel>
+    class Resampler
+    {
+    public:
+        void Configure(uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, ScaleFilter filter)
+        {
+            if (m_filter == filter && m_horizontal.srcSize == srcWidth && m_horizontal.dstSize == dstWidth
+                && m_vertical.srcSize == srcHeight && m_vertical.dstSize == dstHeight)
+                return;
+
+            m_filter = filter;
+            m_horizontal = BuildResampleWeights(srcWidth, dstWidth, filter);
+            m_vertical = BuildResampleWeights(srcHeight, dstHeight, filter);
+            m_intermediate.assign(size_t(dstWidth) * srcHeight * 4, 0.f);
+            m_accumulator.assign(size_t(dstWidth) * 4 + 4, 0.f);
+        }
+
+        // Resample src into dst. swapRedBlue turns a BGRA source into RGBA output.
+        void Process(ConstImageView src, ImageView dst, SimdTier tier = BestSimdTier(), bool swapRedBlue = false)
+        {
+            Configure(src.width, src.height, dst.width, dst.height, m_filter);
+#if DX_HAS_SSE2
+            if (tier == SimdTier::SSE2)
+            {
+                HorizontalSSE2(src, swapRedBlue);
+                VerticalSSE2(dst);
+                return;
+            }
+#endif
+            (void)tier;
+            HorizontalScalar(src, swapRedBlue);
+            VerticalScalar(dst);
+        }
+
+        ScaleFilter Filter() const noexcept { return m_filter; }
+        const ResampleWeights& Horizontal() const noexcept { return m_horizontal; }
+        const ResampleWeights& Vertical() const noexcept { return m_vertical; }
+
+    private:
+        void HorizontalScalar(ConstImageView src, bool swapRedBlue)
+        {
+            const uint32_t dstWidth = m_horizontal.dstSize;
+            const uint32_t taps = m_horizontal.taps;
+            for (uint32_t y = 0; y < src.height; y++)
+            {
+                const uint8_t* in = src.Row(y);
+                float* out = &m_intermediate[size_t(y) * dstWidth * 4];
+                for (uint32_t x = 0; x < dstWidth; x++)
+                {
+                    const uint8_t* texel = in + size_t(m_horizontal.start[x]) * TPixel::Bytes;
+                    const float* weights = &m_horizontal.weights[size_t(x) * taps];
+                    float sum[4] = {};
+                    for (uint32_t k = 0; k < taps; k++, texel += TPixel::Bytes)
+                    {
+                        float channels[4];
+                        TPixel::Unpack(texel, channels);
+                        for (int c = 0; c < 4; c++)
+                            sum[c] += weights[k] * channels[c];
+                    }
+                    out[x * 4 + 0] = sum[swapRedBlue ? 2 : 0];
+                    out[x * 4 + 1] = sum[1];
+                    out[x * 4 + 2] = sum[swapRedBlue ? 0 : 2];
+                    out[x * 4 + 3] = sum[3];
+                }
+            }
+        }
+
+        void VerticalScalar(ImageView dst)
+        {
+            const size_t rowFloats = size_t(m_horizontal.dstSize) * 4;
+            const uint32_t taps = m_vertical.taps;
+            for (uint32_t y = 0; y < dst.height; y++)
+            {
+                std::fill(m_accumulator.begin(), m_accumulator.end(), 0.f);
+                for (uint32_t k = 0; k < taps; k++)
+                {
+                    const float weight = m_vertical.weights[size_t(y) * taps + k];
+                    const float* in = &m_intermediate[(size_t(m_vertical.start[y]) + k) * rowFloats];
+                    for (size_t i = 0; i < rowFloats; i++)
+                        m_accumulator[i] += weight * in[i];
+                }
+
+                uint8_t* out = dst.Row(y);
+                for (uint32_t x = 0; x < m_horizontal.dstSize; x++)
+                    TPixel::Pack(&m_accumulator[size_t(x) * 4], out + size_t(x) * TPixel::Bytes);
+            }
+        }
+
+#if DX_HAS_SSE2
+        // One texel's channels as floats; 10-bit fields are unpacked in scalar code.
+        static __m128 LoadSSE2(const uint8_t* texel) noexcept
+        {
+            if constexpr (TPixel::Format == PixelFormat::Rgba8)
+            {
+                int packed;
+                std::memcpy(&packed, texel, sizeof(packed));
+                const __m128i zero = _mm_setzero_si128();
+                return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero));
+            }
+            else if constexpr (TPixel::Format == PixelFormat::Rgba16f)
+            {
+                return HalvesToFloats(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(texel)));
+            }
+            else
+            {
+                float channels[4];
+                TPixel::Unpack(texel, channels);
+                return _mm_loadu_ps(channels);
+            }
+        }
+
+        void HorizontalSSE2(ConstImageView src, bool swapRedBlue)
+        {
+            const uint32_t dstWidth = m_horizontal.dstSize;
+            const uint32_t taps = m_horizontal.taps;
+            for (uint32_t y = 0; y < src.height; y++)
+            {
+                const uint8_t* in = src.Row(y);
+                float* out = &m_intermediate[size_t(y) * dstWidth * 4];
+                for (uint32_t x = 0; x < dstWidth; x++)
+                {
+                    const uint8_t* texel = in + size_t(m_horizontal.start[x]) * TPixel::Bytes;
+                    const float* weights = &m_horizontal.weights[size_t(x) * taps];
+                    __m128 sum = _mm_setzero_ps();
+                    for (uint32_t k = 0; k < taps; k++, texel += TPixel::Bytes)
+                        sum = _mm_add_ps(sum, _mm_mul_ps(LoadSSE2(texel), _mm_set1_ps(weights[k])));
+                    if (swapRedBlue)
+                        sum = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 0, 1, 2));
+                    _mm_storeu_ps(out + x * 4, sum);
+                }
+            }
+        }
+
+        void VerticalSSE2(ImageView dst)
+        {
+            const size_t rowFloats = size_t(m_horizontal.dstSize) * 4;
+            const uint32_t taps = m_vertical.taps;
+            float* acc = m_accumulator.data();
+            for (uint32_t y = 0; y < dst.height; y++)
+            {
+                std::fill(m_accumulator.begin(), m_accumulator.end(), 0.f);
+                for (uint32_t k = 0; k < taps; k++)
+                {
+                    const __m128 weight = _mm_set1_ps(m_vertical.weights[size_t(y) * taps + k]);
+                    const float* in = &m_intermediate[(size_t(m_vertical.start[y]) + k) * rowFloats];
+                    for (size_t i = 0; i < rowFloats; i += 4)
+                        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(in + i), weight)));
+                }
+
+                // rgba8 rounds to nearest even and saturates four texels at a time where possible, and
+                // rgba16f rounds to halves two at a time.
+                uint8_t* out = dst.Row(y);
+                size_t i = 0;
+                if constexpr (TPixel::Format == PixelFormat::Rgba8)
+                {
+                    for (; i + 16 <= rowFloats; i += 16)
+                    {
+                        const __m128i a = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(acc + i)), _mm_cvtps_epi32(_mm_loadu_ps(acc + i + 4)));
+                        const __m128i b = _mm_packs_epi32(_mm_cvtps_epi32(_mm_loadu_ps(acc + i + 8)), _mm_cvtps_epi32(_mm_loadu_ps(acc + i + 12)));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+                    }
+                }
+                else if constexpr (TPixel::Format == PixelFormat::Rgba16f)
+                {
+                    for (; i + 8 <= rowFloats; i += 8)
+                    {
+                        const __m128i halves = _mm_packs_epi32(FloatsToHalves(_mm_loadu_ps(acc + i)), FloatsToHalves(_mm_loadu_ps(acc + i + 4)));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), halves);
+                    }
+                }
+                for (; i < rowFloats; i += 4)
+                    TPixel::Pack(acc + i, out + i / 4 * TPixel::Bytes);
+            }
+        }
+#endif
+
+        ScaleFilter             m_filter = ScaleFilter::Bilinear;
+        ResampleWeights         m_horizontal;
+        ResampleWeights         m_vertical;
+        std::vector<float>      m_intermediate;
+        std::vector<float>      m_accumulator;
+    };
+}
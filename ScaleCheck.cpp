@@ -0,0 +1,236 @@
+//
+// ScaleCheck.cpp - Score each resampling filter, in each format, against an exactly known downscale of a synthetic pattern
+//
+
+#include "ToolMain.h"
+#include "QualityMetrics.h"
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Lowest PSNR each filter may score against the reference, by ScaleFilter. The pattern changes
+    // slowly next to the destination's pixels, so the interpolating filters get within a fraction of a
+    // code of it; area averages whole texels and steps when enlarging, so it is held to less.
+    constexpr double c_MinPSNR[] = { 48.0, 50.0, 50.0, 36.0 };
+    static_assert(std::size(c_MinPSNR) == size_t(ScaleFilter::Count));
+
+    // A smooth pattern defined everywhere, so it can be sampled at any size: a few waves per channel,
+    // the shortest still 12 destination pixels long.
+    struct Pattern
+    {
+        struct Wave
+        {
+            double fx, fy, phase, amplitude;
+        };
+        Wave waves[3][3];
+
+        Pattern(std::mt19937& random, double shortestWavelength)
+        {
+            std::uniform_real_distribution<double> frequency(-1.0 / shortestWavelength, 1.0 / shortestWavelength);
+            std::uniform_real_distribution<double> phase(0.0, 2.0 * Detail::Pi);
+            for (auto& channel : waves)
+            {
+                for (Wave& wave : channel)
+                {
+                    const double scale = 1.0 / std::sqrt(2.0);
+                    wave = Wave{ frequency(random) * scale, frequency(random) * scale, phase(random), 30.0 };
+                }
+            }
+        }
+
+        // Value at (x, y) in source pixels.
+        double At(int channel, double x, double y) const
+        {
+            double value = 128.0;
+            for (const Wave& wave : waves[channel])
+                value += wave.amplitude * std::sin(2.0 * Detail::Pi * (wave.fx * x + wave.fy * y) + wave.phase);
+            return value;
+        }
+
+        // The pattern sampled at pixel centres of a width x height image covering sourceWidth x sourceHeight.
+        Image Render(uint32_t width, uint32_t height, uint32_t sourceWidth, uint32_t sourceHeight) const
+        {
+            const double scaleX = double(sourceWidth) / width;
+            const double scaleY = double(sourceHeight) / height;
+            Image image(width, height, 4);
+            for (uint32_t y = 0; y < height; y++)
+            {
+                uint8_t* row = image.View().Row(y);
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    for (int c = 0; c < 3; c++)
+                        row[x * 4 + c] = static_cast<uint8_t>(std::lround(At(c, (x + 0.5) * scaleX, (y + 0.5) * scaleY)));
+                    row[x * 4 + 3] = 255;
+                }
+            }
+            return image;
+        }
+    };
+
+    struct FilterScore
+    {
+        double psnr = 0.0;
+        double minPsnr = c_MaxPSNR;
+    };
+
+    // rgba8 codes in a format's own units, and back: the same image at each format's precision.
+    template<typename TPixel>
+    Image ToFormat(const Image& bytes)
+    {
+        Image image(bytes.Width(), bytes.Height(), TPixel::Bytes);
+        for (uint32_t y = 0; y < bytes.Height(); y++)
+        {
+            const uint8_t* in = bytes.View().Row(y);
+            uint8_t* out = image.View().Row(y);
+            for (uint32_t x = 0; x < bytes.Width(); x++)
+            {
+                const float channels[4] = { in[x * 4] * TPixel::ChannelMax / 255.0f, in[x * 4 + 1] * TPixel::ChannelMax / 255.0f,
+                    in[x * 4 + 2] * TPixel::ChannelMax / 255.0f, in[x * 4 + 3] * TPixel::AlphaMax / 255.0f };
+                TPixel::Pack(channels, out + x * TPixel::Bytes);
+            }
+        }
+        return image;
+    }
+
+    template<typename TPixel>
+    Image ToBytes(const Image& image)
+    {
+        Image bytes(image.Width(), image.Height(), 4);
+        for (uint32_t y = 0; y < image.Height(); y++)
+        {
+            const uint8_t* in = image.View().Row(y);
+            uint8_t* out = bytes.View().Row(y);
+            for (uint32_t x = 0; x < image.Width(); x++)
+            {
+                float channels[4];
+                TPixel::Unpack(in + x * TPixel::Bytes, channels);
+                for (int c = 0; c < 4; c++)
+                {
+                    const float max = c == 3 ? TPixel::AlphaMax : TPixel::ChannelMax;
+                    out[x * 4 + c] = static_cast<uint8_t>(std::clamp(std::lround(channels[c] * 255.0f / max), 0l, 255l));
+                }
+            }
+        }
+        return bytes;
+    }
+
+    // PSNR of the pattern resampled in a format against the pattern rendered straight at the destination size.
+    template<typename TPixel>
+    double ScoreFilter(ScaleFilter filter, const Pattern& pattern, uint32_t srcWidth, uint32_t srcHeight, uint32_t dstWidth, uint32_t dstHeight, SimdTier tier)
+    {
+        const Image source = ToFormat<TPixel>(pattern.Render(srcWidth, srcHeight, srcWidth, srcHeight));
+        const Image reference = pattern.Render(dstWidth, dstHeight, srcWidth, srcHeight);
+        Image scaled(dstWidth, dstHeight, TPixel::Bytes);
+        Resampler<TPixel> resampler;
+        resampler.Configure(srcWidth, srcHeight, dstWidth, dstHeight, filter);
+        resampler.Process(source.View(), scaled.View(), tier);
+        return QualityMeter(64, tier).Score(reference.View(), ToBytes<TPixel>(scaled).View()).psnr;
+    }
+
+    // The SIMD tier resamples exactly as the scalar one does, in every format, edge texels and swapped
+    // channels included.
+    template<typename TPixel>
+    uint64_t CheckTiers(std::mt19937& random, ScaleFilter filter)
+    {
+        std::uniform_int_distribution<uint32_t> side(1, 97);
+        const uint32_t srcWidth = side(random), srcHeight = side(random), dstWidth = side(random), dstHeight = side(random);
+        const bool swapRedBlue = random() % 2 == 0;
+        Image bytes(srcWidth, srcHeight, 4);
+        for (uint32_t y = 0; y < srcHeight; y++)
+        {
+            for (uint32_t i = 0; i < srcWidth * 4; i++)
+                bytes.View().Row(y)[i] = static_cast<uint8_t>(random());
+        }
+        const Image source = ToFormat<TPixel>(bytes);
+
+        Image scalar(dstWidth, dstHeight, TPixel::Bytes), simd(dstWidth, dstHeight, TPixel::Bytes);
+        Resampler<TPixel> resampler;
+        resampler.Configure(srcWidth, srcHeight, dstWidth, dstHeight, filter);
+        resampler.Process(source.View(), scalar.View(), SimdTier::Scalar, swapRedBlue);
+        resampler.Process(source.View(), simd.View(), BestSimdTier(), swapRedBlue);
+        uint64_t failures = 0;
+        for (uint32_t y = 0; y < dstHeight; y++)
+            failures += std::memcmp(scalar.View().Row(y), simd.View().Row(y), size_t(dstWidth) * TPixel::Bytes) == 0 ? 0 : 1;
+        return failures;
+    }
+}
+
+int DX::ScaleCheckMain(const ToolArgs& args)
+{
+    std::mt19937 random(args.GetUInt("seed", 1));
+    constexpr uint32_t filterCount = static_cast<uint32_t>(ScaleFilter::Count);
+
+    // --check N: N random sizes and patterns, each downscaled (and upscaled) with every filter on every SIMD tier
+    // and in every format, and random images resampled on both tiers.
+    if (args.Has("check"))
+    {
+        const uint32_t count = std::max(1u, args.GetUInt("check", 10));
+        std::uniform_int_distribution<uint32_t> side(48, 320);
+        std::uniform_real_distribution<double> ratio(1.0, 3.0);
+        uint64_t failures = 0;
+        FilterScore scores[filterCount];
+        for (uint32_t round = 0; round < count; round++)
+        {
+            const uint32_t dstWidth = side(random);
+            const uint32_t dstHeight = side(random);
+            const double shrink = ratio(random);
+            const uint32_t srcWidth = uint32_t(dstWidth * shrink);
+            const uint32_t srcHeight = uint32_t(dstHeight * shrink);
+            const Pattern pattern(random, 12.0 * shrink);
+            for (uint32_t f = 0; f < filterCount; f++)
+            {
+                for (SimdTier tier : { SimdTier::Scalar, BestSimdTier() })
+                {
+                    const double down = ScoreFilter<Rgba8Pixel>(ScaleFilter(f), pattern, srcWidth, srcHeight, dstWidth, dstHeight, tier);
+                    const double up = ScoreFilter<Rgba8Pixel>(ScaleFilter(f), pattern, dstWidth, dstHeight, srcWidth, srcHeight, tier);
+                    failures += down >= c_MinPSNR[f] ? 0 : 1;
+                    failures += up >= c_MinPSNR[f] ? 0 : 1;
+                    scores[f].psnr += down / (2.0 * count);
+                    scores[f].minPsnr = std::min(scores[f].minPsnr, down);
+
+                    // The wider formats filter the same way, so they are held to the same floor.
+                    failures += ScoreFilter<Rgb10a2Pixel>(ScaleFilter(f), pattern, srcWidth, srcHeight, dstWidth, dstHeight, tier) >= c_MinPSNR[f] ? 0 : 1;
+                    failures += ScoreFilter<Rgba16fPixel>(ScaleFilter(f), pattern, srcWidth, srcHeight, dstWidth, dstHeight, tier) >= c_MinPSNR[f] ? 0 : 1;
+                }
+                for (int i = 0; i < 10; i++)
+                    failures += CheckTiers<Rgba8Pixel>(random, ScaleFilter(f)) + CheckTiers<Rgb10a2Pixel>(random, ScaleFilter(f)) + CheckTiers<Rgba16fPixel>(random, ScaleFilter(f));
+            }
+        }
+
+        for (uint32_t f = 0; f < filterCount; f++)
+            printf("scale: %-9s mean %.1f dB, worst %.1f dB downscaled\n", ScaleFilterName(ScaleFilter(f)), scores[f].psnr, scores[f].minPsnr);
+        printf("scale: %u rounds, %llu failures\n", count, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Resampling filters failed their checks");
+        return 0;
+    }
+
+    uint32_t width = 1920, height = 1080;
+    if (!args.GetSize("size", width, height))
+        throw std::runtime_error("--size must be WxH");
+    const double scale = args.GetNumber("scale", 2.0);
+    if (!(scale >= 0.25 && scale <= 8.0))
+        throw std::runtime_error("--scale must be between 0.25 and 8");
+
+    const uint32_t dstWidth = std::max(1u, uint32_t(width / scale));
+    const uint32_t dstHeight = std::max(1u, uint32_t(height / scale));
+    const Pattern pattern(random, 12.0 * std::max(scale, 1.0));
+    printf("scale: %ux%u to %ux%u\n", width, height, dstWidth, dstHeight);
+    for (uint32_t f = 0; f < filterCount; f++)
+    {
+        printf("scale: %-9s %.2f dB\n", ScaleFilterName(ScaleFilter(f)),
+            ScoreFilter<Rgba8Pixel>(ScaleFilter(f), pattern, width, height, dstWidth, dstHeight, BestSimdTier()));
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+//
+// ScaleH_CS.hlsl - Horizontal pass of the separable capture scaler
+//
+
+Texture2D<float4> Source : register(t0);
+Buffer<float> Weights : register(t1);
+Buffer<int> Starts : register(t2);
+RWTexture2D<float4> Destination : register(u0);
+
+cbuffer Constants : register(b0)
+{
+    uint2 DestinationSize;
+    uint Taps;
+    uint Padding;
+    int2 SourceOffset;          // Top-left of the crop in the source.
+    uint2 Padding2;
+};
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    if (any(id.xy >= DestinationSize))
+        return;
+
+    // BGRA views already return channels in RGBA order.
+    int start = Starts[id.x];
+    float4 sum = 0.0f;
+    for (uint k = 0; k < Taps; k++)
+    {
+        sum += Weights[id.x * Taps + k] * Source.Load(int3(SourceOffset.x + start + int(k), SourceOffset.y + int(id.y), 0));
+    }
+    Destination[id.xy] = sum;
+}
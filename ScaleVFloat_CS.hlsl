@@ -0,0 +1,6 @@
+//
+// ScaleVFloat_CS.hlsl - ScaleV_CS.hlsl for half-float ring slots
+//
+
+#define FLOAT_DESTINATION 1
+#include "ScaleV_CS.hlsl"
@@ -0,0 +1,6 @@
+//
+// ScaleVNv12_CS.hlsl - ScaleV_CS.hlsl for nv12 ring slots
+//
+
+#define NV12_DESTINATION 1
+#include "ScaleV_CS.hlsl"
@@ -0,0 +1,75 @@
+//
+// ScaleV_CS.hlsl - Vertical pass of the separable capture scaler, written into the ring slot
+//
+
+#include "ColorTransfer.hlsli"
+
+// Half-float slots are written through a float UAV; ScaleVFloat_CS.hlsl sets this.
+#ifndef FLOAT_DESTINATION
+#define FLOAT_DESTINATION 0
+#endif
+// nv12 slots are written through their luma and chroma plane UAVs; ScaleVNv12_CS.hlsl sets this.
+#ifndef NV12_DESTINATION
+#define NV12_DESTINATION 0
+#endif
+
+Texture2D<float4> Source : register(t0);
+Buffer<float> Weights : register(t1);
+Buffer<int> Starts : register(t2);
+#if NV12_DESTINATION
+RWTexture2D<unorm float> Destination : register(u0);
+RWTexture2D<unorm float2> ChromaDestination : register(u1);
+#elif FLOAT_DESTINATION
+RWTexture2D<float4> Destination : register(u0);
+#else
+RWTexture2D<unorm float4> Destination : register(u0);
+#endif
+
+cbuffer Constants : register(b0)
+{
+    uint2 DestinationSize;
+    uint Taps;
+    uint SourceTransfer;        // Of the desktop; the filter runs on its encoded values, as before.
+    uint DestinationTransfer;   // Of the internal format.
+    float SdrWhiteNits;
+};
+
+float3 Filter(uint2 position)
+{
+    int start = Starts[position.y];
+    float4 sum = 0.0f;
+    for (uint k = 0; k < Taps; k++)
+    {
+        sum += Weights[position.y * Taps + k] * Source.Load(int3(position.x, start + int(k), 0));
+    }
+    float3 rgb = ConvertTransfer(sum.rgb, SourceTransfer, DestinationTransfer, SdrWhiteNits);
+#if !FLOAT_DESTINATION
+    rgb = saturate(rgb);
+#endif
+    return rgb;
+}
+
+[numthreads(8, 8, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+#if NV12_DESTINATION
+    // One thread per 2x2 block, dispatched over the chroma plane.
+    if (any(id.xy * 2 >= DestinationSize))
+        return;
+
+    float3 sum = 0.0f;
+    for (uint i = 0; i < 4; i++)
+    {
+        uint2 position = id.xy * 2 + uint2(i & 1, i >> 1);
+        float3 rgb = Filter(position);
+        Destination[position] = RgbToLuma(rgb);
+        sum += rgb;
+    }
+    ChromaDestination[id.xy] = RgbToChroma(sum * 0.25f);
+#else
+    if (any(id.xy >= DestinationSize))
+        return;
+
+    Destination[id.xy] = float4(Filter(id.xy), 1.0f);
+#endif
+}
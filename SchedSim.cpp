@@ -0,0 +1,299 @@
+//
+// SchedSim.cpp - Drive CaptureScheduler with simulated outputs and check it stays fair and in budget
+//
+// Each simulated output produces source frames at its own rate and costs a jittery amount of GPU
+// and CPU time to interpolate, as the outputs the viewer captures do. A round is one interpolated
+// present. A frame still waiting when the next one arrives is dropped, which is what the capture
+// ring does with a Ready slot nobody took.
+//
+
+#include "ToolMain.h"
+#include "CaptureScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Fraction of its max-min fair share an output must get in --check. Whole serves don't pack
+    // into rounds exactly, outputs that don't fit together take turns, and the rounds after an
+    // oversize serve pay it back, so an output can get well under what a fluid split would give
+    // it; the wait bound is what guards against starvation.
+    constexpr double c_FairShareTolerance = 0.3;
+
+    struct SimOutput
+    {
+        double gpuMs = 4.0;
+        double cpuMs = 0.5;
+        double weight = 1.0;
+        double fps = 0.0;           // Source frame rate; zero means a new frame every round.
+    };
+
+    struct SimResult
+    {
+        std::vector<SchedulerStats> stats;
+        std::vector<uint64_t>       frames;
+        std::vector<uint64_t>       dropped;
+        uint64_t                    overBudgetRounds = 0;
+        uint64_t                    budgetViolations = 0;   // Rounds that left total spending past the budget.
+    };
+
+    // "GPU_MS:CPU_MS[:WEIGHT[:FPS]]" outputs separated by ','.
+    std::vector<SimOutput> ParseOutputs(const std::string& spec)
+    {
+        std::vector<SimOutput> outputs;
+        size_t start = 0;
+        while (start < spec.size())
+        {
+            const size_t end = std::min(spec.find(',', start), spec.size());
+            const std::string item = spec.substr(start, end - start);
+            SimOutput output;
+            char* cursor = nullptr;
+            output.gpuMs = std::strtod(item.c_str(), &cursor);
+            if (*cursor == ':')
+                output.cpuMs = std::strtod(cursor + 1, &cursor);
+            if (*cursor == ':')
+                output.weight = std::strtod(cursor + 1, &cursor);
+            if (*cursor == ':')
+                output.fps = std::strtod(cursor + 1, &cursor);
+            if (*cursor != '\0' || output.gpuMs < 0.0 || output.cpuMs < 0.0 || output.weight < 0.0 || output.fps < 0.0)
+                throw std::runtime_error("Bad output " + item + ", expected GPU_MS:CPU_MS[:WEIGHT[:FPS]]");
+            outputs.push_back(output);
+            start = end + 1;
+        }
+        if (outputs.empty())
+            throw std::runtime_error("--outputs needs at least one output");
+        return outputs;
+    }
+
+    SimResult Simulate(const std::vector<SimOutput>& outputs, const SchedulerCost& budget, double roundHz, uint32_t rounds, double jitter,
+        std::mt19937& random)
+    {
+        const size_t count = outputs.size();
+        CaptureScheduler scheduler(count);
+        for (size_t i = 0; i < count; i++)
+            scheduler.SetWeight(i, outputs[i].weight);
+
+        std::normal_distribution<double> noise(0.0, jitter);
+        std::uniform_real_distribution<double> phase(0.0, 1.0);
+        std::vector<double> nextFrame(count);
+        std::vector<bool> pending(count, false);
+        for (size_t i = 0; i < count; i++)
+            nextFrame[i] = outputs[i].fps > 0.0 ? phase(random) / outputs[i].fps : 0.0;
+
+        SimResult result;
+        SchedulerCost spent;
+        result.frames.assign(count, 0);
+        result.dropped.assign(count, 0);
+        for (uint32_t round = 0; round < rounds; round++)
+        {
+            const double now = double(round) / roundHz;
+            for (size_t i = 0; i < count; i++)
+            {
+                // Frames that arrived since the last round; all but the newest are dropped.
+                while (nextFrame[i] <= now)
+                {
+                    result.dropped[i] += pending[i] ? 1 : 0;
+                    pending[i] = true;
+                    result.frames[i]++;
+                    nextFrame[i] += outputs[i].fps > 0.0 ? 1.0 / outputs[i].fps : 1.0 / roundHz;
+                }
+                scheduler.SetWork(i, pending[i]);
+            }
+
+            // Spending may run ahead of the budget by at most one serve per output.
+            const std::vector<size_t>& plan = scheduler.Plan(budget);
+            double ahead = 0.0;
+            for (size_t i = 0; i < count; i++)
+                ahead += std::max(scheduler.Estimate(i).gpuSeconds / budget.gpuSeconds, scheduler.Estimate(i).cpuSeconds / budget.cpuSeconds);
+            for (size_t i : plan)
+            {
+                spent.gpuSeconds += scheduler.Estimate(i).gpuSeconds;
+                spent.cpuSeconds += scheduler.Estimate(i).cpuSeconds;
+            }
+            const double allowed = double(round + 1) + ahead + 1e-9;
+            if (spent.gpuSeconds / budget.gpuSeconds > allowed || spent.cpuSeconds / budget.cpuSeconds > allowed)
+                result.budgetViolations++;
+            result.overBudgetRounds = scheduler.OverBudgetRounds();
+
+            for (size_t i : plan)
+            {
+                pending[i] = false;
+                const double scale = std::max(0.0, 1.0 + noise(random));
+                scheduler.Report(i, { outputs[i].gpuMs * scale / 1000.0, outputs[i].cpuMs * scale / 1000.0 });
+            }
+        }
+
+        for (size_t i = 0; i < count; i++)
+            result.stats.push_back(scheduler.Stats(i));
+        return result;
+    }
+
+    void PrintResult(const std::vector<SimOutput>& outputs, const SimResult& result, uint32_t rounds)
+    {
+        double totalService = 0.0, totalWeight = 0.0;
+        for (size_t i = 0; i < outputs.size(); i++)
+        {
+            totalService += result.stats[i].serviceShare;
+            totalWeight += outputs[i].weight;
+        }
+        for (size_t i = 0; i < outputs.size(); i++)
+        {
+            const SchedulerStats& stats = result.stats[i];
+            printf("schedsim: output %zu  weight %4.2f  served %6llu of %6llu rounds with work  share %5.1f%% (weight %5.1f%%)  dropped %6llu of %6llu  max wait %u\n",
+                i, outputs[i].weight, static_cast<unsigned long long>(stats.served), static_cast<unsigned long long>(stats.rounds),
+                totalService > 0.0 ? 100.0 * stats.serviceShare / totalService : 0.0, totalWeight > 0.0 ? 100.0 * outputs[i].weight / totalWeight : 0.0,
+                static_cast<unsigned long long>(result.dropped[i]), static_cast<unsigned long long>(result.frames[i]), stats.maxWait);
+        }
+        printf("schedsim: %u rounds, %llu over budget with an oversize output, %llu budget violations\n", rounds,
+            static_cast<unsigned long long>(result.overBudgetRounds), static_cast<unsigned long long>(result.budgetViolations));
+    }
+
+    // Every property for one scenario where all outputs are always backlogged; returns the number of failures.
+    uint64_t CheckBacklogged(const std::vector<SimOutput>& outputs, const SchedulerCost& budget, uint32_t rounds, std::mt19937& random, std::string& why)
+    {
+        const SimResult result = Simulate(outputs, budget, 60.0, rounds, 0.0, random);
+        uint64_t failures = 0;
+        if (result.budgetViolations != 0)
+        {
+            failures++;
+            why = "planned past the budget";
+        }
+
+        // Weighted max-min shares of what was actually delivered: outputs that want less than their
+        // share get what they want and the rest is split again. Packing whole serves into rounds
+        // wastes some budget, so the delivered total rather than the budget is what's shared.
+        const size_t count = outputs.size();
+        std::vector<double> costs(count), fair(count, 0.0);
+        double delivered = 0.0, totalWeight = 0.0, totalDemand = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            costs[i] = std::max(outputs[i].gpuMs / 1000.0 / budget.gpuSeconds, outputs[i].cpuMs / 1000.0 / budget.cpuSeconds);
+            delivered += result.stats[i].serviceShare / double(rounds);
+            totalWeight += outputs[i].weight;
+            totalDemand += costs[i];
+        }
+        std::vector<bool> capped(count, false);
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            double capacity = delivered, weights = 0.0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (capped[i])
+                    capacity -= fair[i];
+                else
+                    weights += outputs[i].weight;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                if (capped[i])
+                    continue;
+                fair[i] = weights > 0.0 ? capacity * outputs[i].weight / weights : 0.0;
+                if (fair[i] > costs[i])
+                {
+                    fair[i] = costs[i];
+                    capped[i] = true;
+                    changed = true;
+                }
+            }
+        }
+
+        double payback = 0.0;
+        for (size_t i = 0; i < count; i++)
+            payback += std::ceil(std::max(costs[i], 1.0));
+        for (size_t i = 0; i < count; i++)
+        {
+            const double quantum = outputs[i].weight / totalWeight;
+            const double cost = costs[i];
+            const SchedulerStats& stats = result.stats[i];
+
+            const double share = stats.serviceShare / double(rounds);
+            if (outputs[i].weight > 0.0 && share < fair[i] * c_FairShareTolerance)
+            {
+                failures++;
+                why = "output " + std::to_string(i) + " got " + std::to_string(share) + " of the budget, fair share " + std::to_string(fair[i]);
+            }
+
+            // Never waits longer than it takes to earn one serve, plus a turn for each of the others
+            // and the rounds that pay back their overspend.
+            const double bound = std::ceil(std::max(cost, 1.0) / quantum) + payback + 1.0;
+            if (outputs[i].weight > 0.0 && double(stats.maxWait) > bound)
+            {
+                failures++;
+                why = "output " + std::to_string(i) + " waited " + std::to_string(stats.maxWait) + " rounds, bound " + std::to_string(bound);
+            }
+        }
+
+        // With room for everyone, everyone is served every round.
+        if (totalDemand <= 1.0)
+        {
+            for (size_t i = 0; i < outputs.size(); i++)
+            {
+                if (outputs[i].weight > 0.0 && result.stats[i].served != result.stats[i].rounds)
+                {
+                    failures++;
+                    why = "output " + std::to_string(i) + " skipped with budget to spare";
+                }
+            }
+        }
+        return failures;
+    }
+}
+
+int DX::SchedSimMain(const ToolArgs& args)
+{
+    const SchedulerCost budget = { args.GetNumber("budget-gpu-ms", 8.0) / 1000.0, args.GetNumber("budget-cpu-ms", 2.0) / 1000.0 };
+    if (budget.gpuSeconds <= 0.0 || budget.cpuSeconds <= 0.0)
+        throw std::runtime_error("--budget-gpu-ms and --budget-cpu-ms must be positive");
+    std::mt19937 random(args.GetUInt("seed", 1));
+
+    // --check N: random sets of one to six backlogged outputs, some cheap, some over the whole budget.
+    if (args.Has("check"))
+    {
+        const uint32_t scenarios = std::max(1u, args.GetUInt("check", 500));
+        std::uniform_int_distribution<int> count(1, 6);
+        std::uniform_real_distribution<double> gpu(0.2, 12.0), cpu(0.05, 2.5), weight(0.25, 4.0);
+        uint64_t failures = 0;
+        std::string why;
+        for (uint32_t i = 0; i < scenarios; i++)
+        {
+            std::vector<SimOutput> outputs(static_cast<size_t>(count(random)));
+            for (SimOutput& output : outputs)
+                output = { gpu(random), cpu(random), weight(random), 0.0 };
+            const uint64_t failed = CheckBacklogged(outputs, budget, 2000, random, why);
+            if (failed != 0 && failures == 0)
+            {
+                printf("schedsim: scenario %u failed: %s, outputs", i, why.c_str());
+                for (size_t j = 0; j < outputs.size(); j++)
+                    printf("%s%.3f:%.3f:%.3f", j == 0 ? " " : ",", outputs[j].gpuMs, outputs[j].cpuMs, outputs[j].weight);
+                printf("\n");
+            }
+            failures += failed;
+        }
+
+        printf("schedsim: %u random scenarios, %llu failures\n", scenarios, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Capture scheduler failed its checks");
+        return 0;
+    }
+
+    const std::vector<SimOutput> outputs = ParseOutputs(args.Get("outputs", "6:1:1:60,3:0.5:1:60,9:1.5:2:30"));
+    const double roundHz = args.GetNumber("round-hz", 60.0);
+    const uint32_t rounds = std::max(1u, args.GetUInt("rounds", 6000));
+    if (roundHz <= 0.0)
+        throw std::runtime_error("--round-hz must be positive");
+
+    printf("schedsim: %zu outputs, budget %.2f ms GPU, %.2f ms CPU per round, %.0f rounds/s\n", outputs.size(),
+        budget.gpuSeconds * 1000.0, budget.cpuSeconds * 1000.0, roundHz);
+    const SimResult result = Simulate(outputs, budget, roundHz, rounds, args.GetNumber("jitter", 0.1), random);
+    PrintResult(outputs, result, rounds);
+    return 0;
+}
@@ -0,0 +1,568 @@
+//
+// Settings.cpp - Viewer settings from the command line and a settings file, and what changing them rebuilds
+//
+
+#include "Settings.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+using namespace DX;
+
+namespace
+{
+    struct Setting
+    {
+        const char*     key;
+        const char*     description;
+        SettingsChange  change;
+        bool            isSwitch;       // A bare --key on the command line means true.
+        const char*     examples;       // Valid values separated by '|', for checks.
+        bool (*parse)(ViewerSettings& settings, const std::string& value, std::string& error);
+        std::string (*format)(const ViewerSettings& settings);
+    };
+
+    std::string Trim(const std::string& text)
+    {
+        const size_t begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos)
+            return {};
+        const size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    // Strings may be quoted to keep spaces at either end.
+    std::string Unquote(const std::string& text)
+    {
+        if (text.size() >= 2 && text.front() == '"' && text.back() == '"')
+            return text.substr(1, text.size() - 2);
+        return text;
+    }
+
+    std::string Quote(const std::string& text)
+    {
+        return "\"" + text + "\"";
+    }
+
+    bool ParseBool(const std::string& value, bool& out, std::string& error)
+    {
+        if (value == "true" || value == "on" || value == "yes" || value == "1")
+            out = true;
+        else if (value == "false" || value == "off" || value == "no" || value == "0")
+            out = false;
+        else
+        {
+            error = "expected true or false, not \"" + value + "\"";
+            return false;
+        }
+        return true;
+    }
+
+    bool ParseUInt(const std::string& value, uint32_t min, uint32_t max, uint32_t& out, std::string& error)
+    {
+        char* end = nullptr;
+        const unsigned long long number = value.empty() || value[0] == '-' ? 0 : std::strtoull(value.c_str(), &end, 10);
+        if (end == nullptr || *end != '\0' || end == value.c_str())
+        {
+            error = "expected a whole number, not \"" + value + "\"";
+            return false;
+        }
+        if (number < min || number > max)
+        {
+            error = value + " is outside " + std::to_string(min) + " to " + std::to_string(max);
+            return false;
+        }
+        out = static_cast<uint32_t>(number);
+        return true;
+    }
+
+    bool ParseNumber(const std::string& value, double min, double max, double& out, std::string& error)
+    {
+        char* end = nullptr;
+        const double number = value.empty() ? 0.0 : std::strtod(value.c_str(), &end);
+        if (end == nullptr || *end != '\0' || end == value.c_str() || !std::isfinite(number))
+        {
+            error = "expected a number, not \"" + value + "\"";
+            return false;
+        }
+        if (number < min || number > max)
+        {
+            char range[64];
+            snprintf(range, sizeof(range), " is outside %g to %g", min, max);
+            error = value + range;
+            return false;
+        }
+        out = number;
+        return true;
+    }
+
+    // Shortest text that reads back as the same number.
+    std::string FormatNumber(double value)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%g", value);
+        if (std::strtod(text, nullptr) != value)
+            snprintf(text, sizeof(text), "%.17g", value);
+        return text;
+    }
+
+    // "1,2,0": outputs of the first adapter, each once.
+    bool ParseIndices(const std::string& value, std::vector<uint32_t>& out, std::string& error)
+    {
+        std::vector<uint32_t> indices;
+        std::istringstream items(value);
+        for (std::string item; std::getline(items, item, ',');)
+        {
+            uint32_t index = 0;
+            if (!ParseUInt(Trim(item), 0, 15, index, error))
+                return false;
+            if (std::find(indices.begin(), indices.end(), index) != indices.end())
+            {
+                error = "output " + std::to_string(index) + " is listed twice";
+                return false;
+            }
+            indices.push_back(index);
+        }
+        if (indices.empty())
+        {
+            error = "expected at least one output index";
+            return false;
+        }
+        out = std::move(indices);
+        return true;
+    }
+
+    std::string FormatIndices(const std::vector<uint32_t>& indices)
+    {
+        std::string text;
+        for (uint32_t index : indices)
+            text += (text.empty() ? "" : ",") + std::to_string(index);
+        return text;
+    }
+
+    // "X,Y,WxH" on the virtual desktop, or "none".
+    bool ParseRect(const std::string& value, DesktopRect& out, std::string& error)
+    {
+        if (value.empty() || value == "none")
+        {
+            out = {};
+            return true;
+        }
+        long x = 0, y = 0;
+        unsigned long width = 0, height = 0;
+        int consumed = 0;
+        if (sscanf(value.c_str(), "%ld,%ld,%lux%lu%n", &x, &y, &width, &height, &consumed) != 4 || consumed != static_cast<int>(value.size())
+            || width == 0 || height == 0 || std::labs(x) > 65536 || std::labs(y) > 65536 || width > 65536 || height > 65536)
+        {
+            error = "expected X,Y,WxH or none, not \"" + value + "\"";
+            return false;
+        }
+        out = { int32_t(x), int32_t(y), int32_t(x + long(width)), int32_t(y + long(height)) };
+        return true;
+    }
+
+    std::string FormatRect(const DesktopRect& rect)
+    {
+        if (rect.Width() <= 0 || rect.Height() <= 0)
+            return "none";
+        return std::to_string(rect.left) + "," + std::to_string(rect.top) + "," + std::to_string(rect.Width()) + "x" + std::to_string(rect.Height());
+    }
+
+    // Shared memory names are kept to characters every platform accepts.
+    bool ParseName(const std::string& value, std::string& out, std::string& error)
+    {
+        if (value.empty() || value.size() > 64
+            || !std::all_of(value.begin(), value.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.'; }))
+        {
+            error = "expected 1 to 64 letters, digits, '-', '_' or '.', not \"" + value + "\"";
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    bool ParseFilter(const std::string& value, ScaleFilter& out, std::string& error)
+    {
+        if (ScaleFilterFromName(value.c_str(), out))
+            return true;
+        error = "unknown filter \"" + value + "\"";
+        return false;
+    }
+
+    bool ParseFormat(const std::string& value, PixelFormat& out, std::string& error)
+    {
+        if (PixelFormatFromName(value.c_str(), out))
+            return true;
+        error = "unknown pixel format \"" + value + "\"";
+        return false;
+    }
+
+    bool ParsePrediction(const std::string& value, CursorPrediction& out, std::string& error)
+    {
+        if (CursorPredictionFromName(value.c_str(), out))
+            return true;
+        error = "unknown cursor prediction \"" + value + "\"";
+        return false;
+    }
+
+    bool ParseLogLevel(const std::string& value, LogLevel& out, std::string& error)
+    {
+        if (LogLevelFromName(value.c_str(), out))
+            return true;
+        error = "unknown log level \"" + value + "\"";
+        return false;
+    }
+
+    // The names LogLevelFromName reads; LogLevelName's are for log lines.
+    std::string FormatLogLevel(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug:   return "debug";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Error:   return "error";
+        default:                return "info";
+        }
+    }
+
+    // Every setting, in the order FormatSettings writes them.
+    const Setting c_Settings[] =
+    {
+        { "monitorIndices", "Outputs of the first adapter to capture, the first shown first", SettingsChangeCaptures, false, "1|0|0,1|2,0,1",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseIndices(v, s.monitorIndices, e); },
+            [](const ViewerSettings& s) { return FormatIndices(s.monitorIndices); } },
+        { "tileOutputs", "Show every output in a grid instead of the active one", SettingsChangeLayout, true, "true|false",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseBool(v, s.tileOutputs, e); },
+            [](const ViewerSettings& s) { return std::string(s.tileOutputs ? "true" : "false"); } },
+        { "useRegion", "Capture the region of interest rather than whole outputs", SettingsChangeRegions, true, "true|false",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseBool(v, s.useRegion, e); },
+            [](const ViewerSettings& s) { return std::string(s.useRegion ? "true" : "false"); } },
+        { "roiRect", "Region of interest on the virtual desktop, X,Y,WxH, or none", SettingsChangeRegions, false, "none|0,0,1280x720|-1920,100,800x600",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseRect(v, s.roiRect, e); },
+            [](const ViewerSettings& s) { return FormatRect(s.roiRect); } },
+        { "roiWindowTitle", "Follow the bounds of the window with this title instead", SettingsChangeRegions, false, "\"\"|Untitled - Notepad|\" padded \"",
+            [](ViewerSettings& s, const std::string& v, std::string&) { s.roiWindowTitle = Unquote(v); return true; },
+            [](const ViewerSettings& s) { return Quote(s.roiWindowTitle); } },
+        { "resFactor", "Downscale captured pixels by this factor before interpolation", SettingsChangeInterpolators, false, "1|1.5|2|3.25",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseNumber(v, 1.0, 8.0, s.resFactor, e); },
+            [](const ViewerSettings& s) { return FormatNumber(s.resFactor); } },
+        { "captureRingDepth", "Captured frames kept per output for NvOFFRUC", SettingsChangeInterpolators, false, "3|4|6",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseUInt(v, 3, 8, s.captureRingDepth, e); },
+            [](const ViewerSettings& s) { return std::to_string(s.captureRingDepth); } },
+        { "scaleFilter", "Downscaling filter: bilinear, bicubic, lanczos3 or area", SettingsChangeScalers, false, "bilinear|bicubic|lanczos3|area",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseFilter(v, s.scaleFilter, e); },
+            [](const ViewerSettings& s) { return std::string(ScaleFilterName(s.scaleFilter)); } },
+        { "internalFormat", "Format frames are captured and interpolated in: rgba8, rgb10a2 (HDR10), rgba16f (scRGB) or nv12 (YUV 4:2:0)", SettingsChangeInterpolators, false, "rgba8|rgb10a2|rgba16f|nv12",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseFormat(v, s.internalFormat, e); },
+            [](const ViewerSettings& s) { return std::string(PixelFormatName(s.internalFormat)); } },
+        { "sdrWhiteNits", "Brightness of SDR white in HDR formats, or 0 for each output's level in Windows", SettingsChangeValue, false, "0|80|240.5",
+            [](ViewerSettings& s, const std::string& v, std::string& e) {
+                double nits = 0.0;
+                if (!ParseNumber(v, 0.0, 1000.0, nits, e))
+                    return false;
+                if (nits != 0.0 && nits < 80.0)
+                {
+                    e = "SDR white " + v + " is below 80 nits";
+                    return false;
+                }
+                s.sdrWhiteNits = nits;
+                return true;
+            },
+            [](const ViewerSettings& s) { return FormatNumber(s.sdrWhiteNits); } },
+        { "interpolationBudget", "Share of each source frame all outputs' interpolation may take", SettingsChangeValue, false, "0.5|0.75|1",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseNumber(v, 0.05, 1.0, s.interpolationBudget, e); },
+            [](const ViewerSettings& s) { return FormatNumber(s.interpolationBudget); } },
+        { "frameRate", "Output frame rate, or 0 for twice the first output's refresh rate", SettingsChangePacing, false, "0|120|143.856",
+            [](ViewerSettings& s, const std::string& v, std::string& e) {
+                double rate = 0.0;
+                if (!ParseNumber(v, 0.0, 1000.0, rate, e))
+                    return false;
+                if (rate != 0.0 && rate < 20.0)
+                {
+                    e = "frame rate " + v + " is below 20";
+                    return false;
+                }
+                s.frameRate = rate;
+                return true;
+            },
+            [](const ViewerSettings& s) { return FormatNumber(s.frameRate); } },
+        { "vsync", "Wait for vblank on present instead of presenting with tearing", SettingsChangePresent, true, "true|false",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseBool(v, s.vsync, e); },
+            [](const ViewerSettings& s) { return std::string(s.vsync ? "true" : "false"); } },
+        { "showCursor", "Draw the pointer", SettingsChangeCursor, true, "true|false",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseBool(v, s.showCursor, e); },
+            [](const ViewerSettings& s) { return std::string(s.showCursor ? "true" : "false"); } },
+        { "cursorPrediction", "Pointer extrapolation: off, velocity or kalman", SettingsChangeCursor, false, "off|velocity|kalman",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParsePrediction(v, s.cursorPrediction, e); },
+            [](const ViewerSettings& s) { return std::string(CursorPredictionName(s.cursorPrediction)); } },
+        { "cursorVblanks", "Vblanks ahead the pointer is extrapolated to", SettingsChangeValue, false, "1|2|4",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseUInt(v, 1, 4, s.cursorVblanks, e); },
+            [](const ViewerSettings& s) { return std::to_string(s.cursorVblanks); } },
+        { "showHud", "Show the performance overlay", SettingsChangeValue, true, "true|false",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseBool(v, s.showHud, e); },
+            [](const ViewerSettings& s) { return std::string(s.showHud ? "true" : "false"); } },
+        { "metricsPort", "Loopback port of the metrics endpoint, 0 for any", SettingsChangeMetricsServer, false, "9464|0|19464",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseUInt(v, 0, 65535, s.metricsPort, e); },
+            [](const ViewerSettings& s) { return std::to_string(s.metricsPort); } },
+        { "sharedOutputName", "Name of the shared-memory frame ring", SettingsChangeSharedOutput, false, "hfv-output|viewer_2|a.b",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseName(Unquote(v), s.sharedOutputName, e); },
+            [](const ViewerSettings& s) { return Quote(s.sharedOutputName); } },
+        { "readbackRingDepth", "Staging textures presented frames are read back through", SettingsChangeReadback, false, "4|6|16",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseUInt(v, 2, 16, s.readbackRingDepth, e); },
+            [](const ViewerSettings& s) { return std::to_string(s.readbackRingDepth); } },
+        { "readbackLatency", "Frames a copy waits before it is mapped, less than readbackRingDepth", SettingsChangeReadback, false, "1|2|3",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseUInt(v, 1, 15, s.readbackLatency, e); },
+            [](const ViewerSettings& s) { return std::to_string(s.readbackLatency); } },
+        { "logLevel", "Least severe log records kept: debug, info, warning or error", SettingsChangeValue, false, "debug|info|warning|error",
+            [](ViewerSettings& s, const std::string& v, std::string& e) { return ParseLogLevel(v, s.logLevel, e); },
+            [](const ViewerSettings& s) { return FormatLogLevel(s.logLevel); } },
+    };
+
+    const Setting* FindSetting(const std::string& key)
+    {
+        for (auto const& setting : c_Settings)
+        {
+            if (key == setting.key)
+                return &setting;
+        }
+        return nullptr;
+    }
+}
+
+const char* DX::SettingsChangeName(SettingsChange change) noexcept
+{
+    switch (change)
+    {
+    case SettingsChangeCaptures:        return "captures";
+    case SettingsChangeInterpolators:   return "interpolators";
+    case SettingsChangeScalers:         return "scalers";
+    case SettingsChangeLayout:          return "layout";
+    case SettingsChangeRegions:         return "regions";
+    case SettingsChangePacing:          return "pacing";
+    case SettingsChangePresent:         return "present";
+    case SettingsChangeCursor:          return "cursor";
+    case SettingsChangeMetricsServer:   return "metrics server";
+    case SettingsChangeSharedOutput:    return "shared output";
+    case SettingsChangeReadback:        return "readback";
+    case SettingsChangeValue:           return "value";
+    default:                            return "none";
+    }
+}
+
+bool DX::SetSetting(ViewerSettings& settings, const std::string& key, const std::string& value, std::string& error)
+{
+    const Setting* setting = FindSetting(key);
+    if (setting == nullptr)
+    {
+        error = "unknown setting \"" + key + "\"";
+        return false;
+    }
+
+    // Parse into a copy, so a value rejected halfway leaves nothing behind.
+    ViewerSettings parsed = settings;
+    std::string message;
+    if (!setting->parse(parsed, value, message))
+    {
+        error = key + ": " + message;
+        return false;
+    }
+    settings = std::move(parsed);
+    return true;
+}
+
+bool DX::ValidateSettings(ViewerSettings& settings, std::vector<std::string>& errors)
+{
+    const ViewerSettings defaults;
+    bool valid = true;
+    if (settings.readbackLatency >= settings.readbackRingDepth)
+    {
+        errors.push_back("readbackLatency " + std::to_string(settings.readbackLatency) + " must be less than readbackRingDepth "
+            + std::to_string(settings.readbackRingDepth));
+        settings.readbackLatency = defaults.readbackLatency;
+        settings.readbackRingDepth = defaults.readbackRingDepth;
+        valid = false;
+    }
+    return valid;
+}
+
+bool DX::ParseSettingsIni(const std::string& text, const std::string& source, ViewerSettings& settings, std::vector<std::string>& errors)
+{
+    const size_t errorCount = errors.size();
+    std::istringstream lines(text);
+    int number = 0;
+    for (std::string line; std::getline(lines, line);)
+    {
+        number++;
+
+        // Whole-line comments only, so window titles may contain '#' and ';'.
+        line = Trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';' || (line.front() == '[' && line.back() == ']'))
+            continue;
+
+        const std::string where = source + ":" + std::to_string(number) + ": ";
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos)
+        {
+            errors.push_back(where + "expected key = value");
+            continue;
+        }
+        std::string error;
+        if (!SetSetting(settings, Trim(line.substr(0, equals)), Trim(line.substr(equals + 1)), error))
+            errors.push_back(where + error);
+    }
+
+    ValidateSettings(settings, errors);
+    return errors.size() == errorCount;
+}
+
+bool DX::ParseSettingsArguments(const std::vector<std::string>& arguments, const std::vector<std::string>& otherKeys,
+    ViewerSettings& settings, std::vector<std::string>& errors)
+{
+    const size_t errorCount = errors.size();
+    for (size_t i = 0; i < arguments.size(); i++)
+    {
+        const std::string& argument = arguments[i];
+        if (argument.compare(0, 2, "--") != 0)
+            continue;
+
+        std::string key = argument.substr(2);
+        std::string value;
+        bool hasValue = false;
+        if (const size_t equals = key.find('='); equals != std::string::npos)
+        {
+            value = key.substr(equals + 1);
+            key.resize(equals);
+            hasValue = true;
+        }
+        const bool nextIsValue = i + 1 < arguments.size() && arguments[i + 1].compare(0, 2, "--") != 0;
+
+        if (std::find(otherKeys.begin(), otherKeys.end(), key) != otherKeys.end())
+        {
+            i += !hasValue && nextIsValue ? 1 : 0;
+            continue;
+        }
+
+        const Setting* setting = FindSetting(key);
+        if (!hasValue && nextIsValue)
+        {
+            value = arguments[++i];
+            hasValue = true;
+        }
+        if (!hasValue && setting != nullptr && setting->isSwitch)
+        {
+            value = "true";
+            hasValue = true;
+        }
+
+        std::string error;
+        if (!hasValue && setting != nullptr)
+            errors.push_back("--" + key + ": expected a value");
+        else if (!SetSetting(settings, key, value, error))
+            errors.push_back("--" + error);
+    }
+
+    ValidateSettings(settings, errors);
+    return errors.size() == errorCount;
+}
+
+std::string DX::FormatSettings(const ViewerSettings& settings)
+{
+    std::string text;
+    for (auto const& setting : c_Settings)
+        text += std::string(setting.key) + " = " + setting.format(settings) + "\n";
+    return text;
+}
+
+std::string DX::FormatSetting(const ViewerSettings& settings, const std::string& key)
+{
+    const Setting* setting = FindSetting(key);
+    return setting == nullptr ? std::string() : setting->format(settings);
+}
+
+SettingsPlan DX::PlanSettingsChange(const ViewerSettings& from, const ViewerSettings& to)
+{
+    // Settings compare by their text, which reads back to the same value.
+    SettingsPlan plan;
+    for (auto const& setting : c_Settings)
+    {
+        if (setting.format(from) != setting.format(to))
+        {
+            plan.changes |= setting.change;
+            plan.keys.push_back(setting.key);
+        }
+    }
+
+    if (plan.Has(SettingsChangeCaptures))
+        plan.changes &= ~uint32_t(SettingsChangeInterpolators | SettingsChangeScalers | SettingsChangeLayout | SettingsChangeRegions);
+    if (plan.Has(SettingsChangeInterpolators))
+        plan.changes &= ~uint32_t(SettingsChangeScalers);
+    return plan;
+}
+
+std::vector<SettingInfo> DX::DescribeSettings()
+{
+    std::vector<SettingInfo> settings;
+    for (auto const& setting : c_Settings)
+        settings.push_back({ setting.key, setting.description, setting.change });
+    return settings;
+}
+
+std::vector<std::string> DX::SettingExamples(const std::string& key)
+{
+    std::vector<std::string> examples;
+    const Setting* setting = FindSetting(key);
+    if (setting == nullptr)
+        return examples;
+
+    std::istringstream items(setting->examples);
+    for (std::string item; std::getline(items, item, '|');)
+        examples.push_back(item);
+    return examples;
+}
+
+SettingsFile::SettingsFile(std::string path)
+    : m_path(std::move(path))
+{
+    Changed();
+}
+
+bool SettingsFile::Exists() const
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(m_path, error);
+}
+
+bool SettingsFile::Changed()
+{
+    std::error_code error;
+    const bool exists = std::filesystem::is_regular_file(m_path, error);
+    int64_t writeTime = 0;
+    uint64_t size = 0;
+    if (exists)
+    {
+        writeTime = static_cast<int64_t>(std::filesystem::last_write_time(m_path, error).time_since_epoch().count());
+        size = static_cast<uint64_t>(std::filesystem::file_size(m_path, error));
+    }
+
+    const bool changed = exists != m_exists || writeTime != m_writeTime || size != m_size;
+    m_exists = exists;
+    m_writeTime = writeTime;
+    m_size = size;
+    return changed;
+}
+
+bool SettingsFile::Read(std::string& text) const
+{
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file)
+        return false;
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
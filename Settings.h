@@ -0,0 +1,144 @@
+//
+// Settings.h - Viewer settings from the command line and a settings file, and what changing them rebuilds
+//
+// Settings are read from "key = value" lines (an INI file; [sections] and # or ; comments are
+// allowed and sections are only for grouping), then from "--key value" command line arguments,
+// which win. Keys are the Game members they set. Every key says which resources depend on it, so
+// a settings file edited while the viewer runs rebuilds only those: PlanSettingsChange compares
+// two settings and names the rebuilds, and the viewer applies them in order.
+//
+
+#pragma once
+
+#include "CursorPredictor.h"
+#include "DesktopLayout.h"
+#include "Logger.h"
+#include "MetricsServer.h"
+#include "PixelFormat.h"
+#include "Resampler.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    struct ViewerSettings
+    {
+        std::vector<uint32_t>   monitorIndices = { 1 };
+        bool                    tileOutputs = false;
+        bool                    useRegion = true;
+        DesktopRect             roiRect;
+        std::string             roiWindowTitle;
+        double                  resFactor = 2.0;
+        uint32_t                captureRingDepth = 3;
+        ScaleFilter             scaleFilter = ScaleFilter::Bilinear;
+        PixelFormat             internalFormat = PixelFormat::Rgba8;
+        double                  sdrWhiteNits = 0.0;     // 0: each output's SDR white level in Windows.
+        double                  interpolationBudget = 0.75;
+        double                  frameRate = 0.0;        // 0: twice the first output's refresh rate.
+        bool                    vsync = true;           // Otherwise present with tearing when the display allows it.
+        bool                    showCursor = true;
+        CursorPrediction        cursorPrediction = CursorPrediction::Kalman;
+        uint32_t                cursorVblanks = 1;
+        bool                    showHud = false;
+        uint32_t                metricsPort = MetricsServer::DefaultPort;
+        std::string             sharedOutputName = "hfv-output";
+        uint32_t                readbackRingDepth = 4;
+        uint32_t                readbackLatency = 3;
+        LogLevel                logLevel = LogLevel::Info;
+    };
+
+    // What a setting's value is used by, from the most to the least that has to be rebuilt. A change
+    // to an earlier one also covers the later ones it implies (see PlanSettingsChange).
+    enum SettingsChange : uint32_t
+    {
+        SettingsChangeNone          = 0,
+        SettingsChangeCaptures      = 0x1,      // Duplication sessions, and everything per output.
+        SettingsChangeInterpolators = 0x2,      // Each output's ring and NvOFFRUC instance, and its scaler.
+        SettingsChangeScalers       = 0x4,      // Weight tables of the capture scalers.
+        SettingsChangeLayout        = 0x8,      // Where outputs are drawn in the window.
+        SettingsChangeRegions       = 0x10,     // The region of interest followed.
+        SettingsChangePacing        = 0x20,     // Output frame rate.
+        SettingsChangePresent       = 0x40,     // Present mode.
+        SettingsChangeCursor        = 0x80,     // Cursor predictor.
+        SettingsChangeMetricsServer = 0x100,    // Metrics endpoint, if serving.
+        SettingsChangeSharedOutput  = 0x200,    // Shared-memory publisher, if publishing.
+        SettingsChangeReadback      = 0x400,    // Staging textures, if recording or publishing.
+        SettingsChangeValue         = 0x800,    // Nothing to rebuild; the value is read as it is used.
+    };
+
+    const char* SettingsChangeName(SettingsChange change) noexcept;
+
+    struct SettingsPlan
+    {
+        uint32_t                    changes = SettingsChangeNone;
+        std::vector<std::string>    keys;       // Settings whose value changed.
+
+        bool Has(SettingsChange change) const noexcept { return (changes & change) != 0; }
+        bool Empty() const noexcept { return keys.empty(); }
+    };
+
+    // Set one setting from its text. Returns false with a message, leaving settings as they were,
+    // for unknown keys and invalid values.
+    bool SetSetting(ViewerSettings& settings, const std::string& key, const std::string& value, std::string& error);
+
+    // Checks that span several settings. Each that fails appends a message and puts the settings it
+    // involves back to their defaults. Returns false if any failed.
+    bool ValidateSettings(ViewerSettings& settings, std::vector<std::string>& errors);
+
+    // Apply a settings file's text. Lines that can't be used are reported as "source:line: message"
+    // and skipped; the rest still apply. Returns false if there were any, or if validation fails.
+    bool ParseSettingsIni(const std::string& text, const std::string& source, ViewerSettings& settings, std::vector<std::string>& errors);
+
+    // Apply "--key value" and "--key=value" arguments; a switch such as --vsync alone means true.
+    // Keys in otherKeys, and their values, belong to the caller and are skipped.
+    bool ParseSettingsArguments(const std::vector<std::string>& arguments, const std::vector<std::string>& otherKeys,
+        ViewerSettings& settings, std::vector<std::string>& errors);
+
+    // Every setting as "key = value" lines that ParseSettingsIni reads back to the same settings.
+    std::string FormatSettings(const ViewerSettings& settings);
+
+    // One setting's value as FormatSettings writes it. Empty for unknown keys.
+    std::string FormatSetting(const ViewerSettings& settings, const std::string& key);
+
+    // The settings that differ and the least that must be rebuilt to go from one to the other. New
+    // captures cover new interpolators, scalers, layout and regions; new interpolators cover new scalers.
+    SettingsPlan PlanSettingsChange(const ViewerSettings& from, const ViewerSettings& to);
+
+    // Every key, in FormatSettings order, with a one-line description and what changing it rebuilds.
+    struct SettingInfo
+    {
+        const char*     key;
+        const char*     description;
+        SettingsChange  change;
+    };
+    std::vector<SettingInfo> DescribeSettings();
+
+    // Valid example values of a key, for checks; empty for unknown keys.
+    std::vector<std::string> SettingExamples(const std::string& key);
+
+    // A settings file to be re-read when it changes. Changed() looks at its time and size, so it is
+    // cheap enough to call a few times a second.
+    class SettingsFile
+    {
+    public:
+        SettingsFile() = default;
+        explicit SettingsFile(std::string path);
+
+        const std::string& Path() const noexcept { return m_path; }
+        bool Exists() const;
+
+        // True once for every change since the last call, including the file appearing or going away.
+        bool Changed();
+
+        // Read the whole file. Returns false if it can't be opened.
+        bool Read(std::string& text) const;
+
+    private:
+        std::string     m_path;
+        bool            m_exists = false;
+        int64_t         m_writeTime = 0;
+        uint64_t        m_size = 0;
+    };
+}
@@ -0,0 +1,280 @@
+//
+// SettingsCheck.cpp - Print the settings a command line and settings file give, and check the parser and change planner
+//
+
+#include "ToolMain.h"
+#include "Settings.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Keys the tool itself takes; everything else is a setting.
+    const std::vector<std::string> c_ToolKeys = { "config", "against", "check", "seed", "log", "log-level" };
+
+    ViewerSettings RandomSettings(std::mt19937& random)
+    {
+        ViewerSettings settings;
+        for (const SettingInfo& info : DescribeSettings())
+        {
+            const std::vector<std::string> examples = SettingExamples(info.key);
+            std::string error;
+            SetSetting(settings, info.key, examples[std::uniform_int_distribution<size_t>(0, examples.size() - 1)(random)], error);
+        }
+        return settings;
+    }
+
+    std::vector<std::string> ToArguments(const ViewerSettings& settings)
+    {
+        std::vector<std::string> arguments = { "CleanProject.exe" };
+        for (const SettingInfo& info : DescribeSettings())
+        {
+            arguments.push_back(std::string("--") + info.key);
+            arguments.push_back(FormatSetting(settings, info.key));
+        }
+        return arguments;
+    }
+
+    // Formatting reads back to the same settings, through a file and through the command line.
+    uint64_t CheckRoundTrip(const ViewerSettings& settings)
+    {
+        uint64_t failures = 0;
+        std::vector<std::string> errors;
+        ViewerSettings parsed;
+        failures += ParseSettingsIni(FormatSettings(settings), "round-trip", parsed, errors) && PlanSettingsChange(settings, parsed).Empty() ? 0 : 1;
+
+        ViewerSettings fromArguments;
+        failures += ParseSettingsArguments(ToArguments(settings), {}, fromArguments, errors) && PlanSettingsChange(settings, fromArguments).Empty() ? 0 : 1;
+        for (const std::string& error : errors)
+            fprintf(stderr, "settings: round trip: %s\n", error.c_str());
+        return failures;
+    }
+
+    // Changing one setting plans exactly that key and what it rebuilds.
+    uint64_t CheckSingleChanges(const ViewerSettings& settings, std::mt19937& random)
+    {
+        uint64_t failures = 0;
+        for (const SettingInfo& info : DescribeSettings())
+        {
+            std::vector<std::string> examples = SettingExamples(info.key);
+            std::shuffle(examples.begin(), examples.end(), random);
+            for (const std::string& example : examples)
+            {
+                ViewerSettings changed = settings;
+                std::string error;
+                if (!SetSetting(changed, info.key, example, error))
+                {
+                    fprintf(stderr, "settings: example %s = %s: %s\n", info.key, example.c_str(), error.c_str());
+                    failures++;
+                    continue;
+                }
+                if (FormatSetting(changed, info.key) == FormatSetting(settings, info.key))
+                    continue;
+
+                const SettingsPlan plan = PlanSettingsChange(settings, changed);
+                failures += plan.keys.size() == 1 && plan.keys[0] == info.key && plan.changes == uint32_t(info.change) ? 0 : 1;
+                break;
+            }
+        }
+        return failures;
+    }
+
+    // Rejected values leave the settings as they were.
+    uint64_t CheckInvalidValues()
+    {
+        static const struct { const char* key; const char* value; } invalid[] =
+        {
+            { "resFactor", "0.5" }, { "resFactor", "two" }, { "resFactor", "2x" }, { "resFactor", "nan" },
+            { "captureRingDepth", "2" }, { "captureRingDepth", "-3" }, { "captureRingDepth", "" },
+            { "monitorIndices", "1,1" }, { "monitorIndices", "" }, { "monitorIndices", "1,,2" }, { "monitorIndices", "16" },
+            { "roiRect", "0,0,0x5" }, { "roiRect", "0,0,100" }, { "roiRect", "0,0,100x100 junk" },
+            { "scaleFilter", "nearest" }, { "internalFormat", "i420" }, { "internalFormat", "RGBA8" }, { "sdrWhiteNits", "40" }, { "sdrWhiteNits", "1001" }, { "cursorPrediction", "linear" }, { "logLevel", "verbose" },
+            { "frameRate", "10" }, { "frameRate", "-60" }, { "interpolationBudget", "0" },
+            { "sharedOutputName", "a b" }, { "sharedOutputName", "\"\"" }, { "metricsPort", "70000" },
+            { "tileOutputs", "maybe" }, { "cursorVblanks", "0" }, { "readbackRingDepth", "17" }, { "nope", "1" },
+        };
+
+        uint64_t failures = 0;
+        const ViewerSettings defaults;
+        for (auto const& entry : invalid)
+        {
+            ViewerSettings settings;
+            std::string error;
+            const bool accepted = SetSetting(settings, entry.key, entry.value, error);
+            failures += !accepted && !error.empty() && PlanSettingsChange(defaults, settings).Empty() ? 0 : 1;
+            if (accepted)
+                fprintf(stderr, "settings: accepted %s = \"%s\"\n", entry.key, entry.value);
+        }
+
+        ViewerSettings settings;
+        std::string error;
+        std::vector<std::string> errors;
+        failures += SetSetting(settings, "readbackLatency", "4", error) && !ValidateSettings(settings, errors) && errors.size() == 1
+            && PlanSettingsChange(defaults, settings).Empty() ? 0 : 1;
+        return failures;
+    }
+
+    // Comments, sections, CRLF line ends and quoted strings; a broken line is reported with its number
+    // and the rest still applies.
+    uint64_t CheckIniSyntax()
+    {
+        const std::string text =
+            "# Viewer settings\r\n"
+            "[capture]\r\n"
+            "  monitorIndices = 2, 0 \r\n"
+            "; resFactor = 4\r\n"
+            "resFactor 3\r\n"
+            "roiWindowTitle = \"Notes # 2; draft\"\r\n"
+            "[present]\r\n"
+            "vsync=off\r\n";
+        ViewerSettings settings;
+        std::vector<std::string> errors;
+        const bool parsed = ParseSettingsIni(text, "viewer.ini", settings, errors);
+
+        uint64_t failures = 0;
+        failures += !parsed && errors.size() == 1 && errors[0].rfind("viewer.ini:5: ", 0) == 0 ? 0 : 1;
+        failures += settings.monitorIndices == std::vector<uint32_t>{ 2, 0 } && settings.resFactor == 2.0 && !settings.vsync
+            && settings.roiWindowTitle == "Notes # 2; draft" ? 0 : 1;
+        return failures;
+    }
+
+    // Switches, --key=value, the caller's own keys, and a missing value.
+    uint64_t CheckArguments()
+    {
+        uint64_t failures = 0;
+        ViewerSettings settings;
+        std::vector<std::string> errors;
+        const bool parsed = ParseSettingsArguments({ "viewer", "--config", "other.ini", "--vsync=false", "--showHud", "--tileOutputs=true", "--resFactor", "1.5", "--scaleFilter=area" },
+            { "config" }, settings, errors);
+        failures += parsed && errors.empty() && !settings.vsync && settings.showHud && settings.tileOutputs && settings.resFactor == 1.5 && settings.scaleFilter == ScaleFilter::Area ? 0 : 1;
+
+        errors.clear();
+        ViewerSettings missing;
+        failures += !ParseSettingsArguments({ "viewer", "--resFactor", "--showHud" }, {}, missing, errors) && errors.size() == 1 && missing.showHud ? 0 : 1;
+        return failures;
+    }
+
+    // Several changes plan the biggest rebuild that covers them.
+    uint64_t CheckPlans()
+    {
+        uint64_t failures = 0;
+        const ViewerSettings from;
+        ViewerSettings to = from;
+        std::string error;
+        SetSetting(to, "resFactor", "3", error);
+        SetSetting(to, "scaleFilter", "lanczos3", error);
+        SetSetting(to, "vsync", "false", error);
+        SettingsPlan plan = PlanSettingsChange(from, to);
+        failures += plan.changes == uint32_t(SettingsChangeInterpolators | SettingsChangePresent) && plan.keys.size() == 3 ? 0 : 1;
+
+        SetSetting(to, "monitorIndices", "0,1", error);
+        SetSetting(to, "tileOutputs", "true", error);
+        SetSetting(to, "roiRect", "0,0,640x480", error);
+        plan = PlanSettingsChange(from, to);
+        failures += plan.changes == uint32_t(SettingsChangeCaptures | SettingsChangePresent) && plan.keys.size() == 6 ? 0 : 1;
+        return failures;
+    }
+
+    // The file reports a change once when it is rewritten and when it goes away.
+    uint64_t CheckFileWatch()
+    {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "hfv-settings-check.ini";
+        std::error_code error;
+        std::filesystem::remove(path, error);
+
+        uint64_t failures = 0;
+        SettingsFile file(path.string());
+        failures += !file.Exists() && !file.Changed() ? 0 : 1;
+        std::ofstream(path) << "resFactor = 2\n";
+        failures += file.Changed() && !file.Changed() ? 0 : 1;
+        std::ofstream(path) << "resFactor = 2.5\n";
+        std::string text;
+        failures += file.Changed() && file.Read(text) && text == "resFactor = 2.5\n" ? 0 : 1;
+        std::filesystem::remove(path, error);
+        failures += file.Changed() && !file.Exists() ? 0 : 1;
+        return failures;
+    }
+}
+
+int DX::SettingsCheckMain(const ToolArgs& args)
+{
+    if (args.Has("check"))
+    {
+        const uint32_t count = std::max(1u, args.GetUInt("check", 500));
+        std::mt19937 random(args.GetUInt("seed", 1));
+        uint64_t failures = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const ViewerSettings settings = RandomSettings(random);
+            failures += CheckRoundTrip(settings) + CheckSingleChanges(settings, random);
+        }
+        failures += CheckInvalidValues() + CheckIniSyntax() + CheckArguments() + CheckPlans() + CheckFileWatch();
+
+        printf("settings: %u random settings, %llu failures\n", count, static_cast<unsigned long long>(failures));
+        if (failures != 0)
+            throw std::runtime_error("Settings failed their checks");
+        return 0;
+    }
+
+    // The viewer's order: defaults, then the file, then the command line.
+    ViewerSettings settings;
+    std::vector<std::string> errors;
+    const std::string config = args.Get("config");
+    if (!config.empty())
+    {
+        std::string text;
+        if (!SettingsFile(config).Read(text))
+            throw std::runtime_error("Cannot open " + config);
+        ParseSettingsIni(text, config, settings, errors);
+    }
+    std::vector<std::string> arguments = { "settings" };
+    for (const auto& [key, value] : args.Values())
+    {
+        arguments.push_back("--" + key);
+        if (!value.empty())
+            arguments.push_back(value);
+    }
+    ParseSettingsArguments(arguments, c_ToolKeys, settings, errors);
+    for (const std::string& error : errors)
+        fprintf(stderr, "settings: %s\n", error.c_str());
+    if (!errors.empty())
+        throw std::runtime_error("Invalid settings");
+
+    // --against: what editing the file to another one would rebuild in a running viewer.
+    const std::string against = args.Get("against");
+    if (!against.empty())
+    {
+        std::string text;
+        if (!SettingsFile(against).Read(text))
+            throw std::runtime_error("Cannot open " + against);
+        ViewerSettings edited;
+        if (!ParseSettingsIni(text, against, edited, errors))
+        {
+            for (const std::string& error : errors)
+                fprintf(stderr, "settings: %s\n", error.c_str());
+            throw std::runtime_error("Invalid settings in " + against);
+        }
+        const SettingsPlan plan = PlanSettingsChange(settings, edited);
+        for (const std::string& key : plan.keys)
+            printf("changed %s: %s -> %s\n", key.c_str(), FormatSetting(settings, key).c_str(), FormatSetting(edited, key).c_str());
+        for (uint32_t change = SettingsChangeCaptures; change <= SettingsChangeValue; change <<= 1)
+        {
+            if (plan.Has(static_cast<SettingsChange>(change)))
+                printf("rebuild %s\n", SettingsChangeName(static_cast<SettingsChange>(change)));
+        }
+        if (plan.Empty())
+            printf("no change\n");
+        return 0;
+    }
+
+    for (const SettingInfo& info : DescribeSettings())
+        printf("# %s (%s)\n%s = %s\n", info.description, SettingsChangeName(info.change), info.key, FormatSetting(settings, info.key).c_str());
+    return 0;
+}
@@ -0,0 +1,203 @@
+//
+// ShareBench.cpp - Exercise the shared-memory frame ring in one process, or read the viewer's from another
+//
+
+#include "ToolMain.h"
+#include "FrameShare.h"
+#include "FrameIO.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // How long a consumer sleeps when no new frame has been published.
+    constexpr auto c_PollInterval = std::chrono::microseconds(200);
+
+    uint64_t NowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+    }
+
+    // Every byte of row y of frame n is (n * 7 + y) & 255, so a torn frame is visible to a check.
+    void FillFrame(Image& image, uint64_t frame)
+    {
+        for (uint32_t y = 0; y < image.Height(); y++)
+            std::memset(image.View().Row(y), static_cast<int>((frame * 7 + y) & 255), size_t(image.Width()) * 4);
+    }
+
+    bool CheckFrame(ConstImageView view, uint64_t frame)
+    {
+        const size_t last = size_t(view.width) * 4 - 1;
+        for (uint32_t y = 0; y < view.height; y++)
+        {
+            const uint8_t expected = static_cast<uint8_t>((frame * 7 + y) & 255);
+            if (view.Row(y)[0] != expected || view.Row(y)[last] != expected)
+                return false;
+        }
+        return true;
+    }
+}
+
+int DX::ShareBenchMain(const ToolArgs& args)
+{
+    SharedFrameFormat format;
+    if (!args.GetSize("size", format.width, format.height))
+    {
+        format.width = 1280;
+        format.height = 720;
+    }
+    format.slotCount = std::max(2u, args.GetUInt("slots", 4));
+    const double rate = args.GetNumber("rate", 240.0);
+    format.rateNumerator = static_cast<uint32_t>(rate);
+    const uint32_t frames = std::max(1u, args.GetUInt("frames", 960));
+    const bool copy = args.Has("copy");
+    const std::string name = args.Get("name", "hfv-sharebench");
+
+    FramePublisher publisher(name, format);
+    FrameConsumer consumer;
+    if (!consumer.Open(name))
+        throw std::runtime_error("Cannot open shared memory " + name);
+
+    // The consumer runs on its own thread through its own mapping, as another process would.
+    std::atomic<bool> done{ false };
+    uint64_t consumed = 0;
+    uint64_t corrupt = 0;
+    double latencyTotal = 0.0;
+    std::thread reader([&] {
+        Image local(format.width, format.height, 4);
+        SharedFrame frame;
+        while (!done.load(std::memory_order_acquire))
+        {
+            bool acquired = false;
+            bool intact = false;
+            if (copy)
+            {
+                acquired = consumer.CopyLatest(local.View(), frame);
+                intact = acquired && CheckFrame(local.View(), frame.frame);
+            }
+            else if (consumer.AcquireLatest(frame))
+            {
+                // Zero-copy: read in place, then trust the result only if the slot wasn't rewritten meanwhile.
+                const bool matches = CheckFrame(frame.view, frame.frame);
+                acquired = consumer.IsValid(frame);
+                intact = acquired && matches;
+            }
+
+            if (!acquired)
+            {
+                std::this_thread::sleep_for(c_PollInterval);
+                continue;
+            }
+            consumed++;
+            corrupt += intact ? 0 : 1;
+            latencyTotal += double(NowNs() - frame.sourceTicks) * 1e-9;
+        }
+    });
+
+    std::vector<Image> sources(2);
+    for (auto& source : sources)
+        source.Resize(format.width, format.height, 4);
+    std::vector<double> publishSeconds;
+    publishSeconds.reserve(frames);
+
+    const auto interval = std::chrono::duration<double>(rate > 0.0 ? 1.0 / rate : 0.0);
+    const auto start = Clock::now();
+    for (uint64_t i = 0; i < frames; i++)
+    {
+        // The pattern is drawn before timing starts, standing in for the mapped staging texture.
+        Image& source = sources[i & 1];
+        FillFrame(source, i + 1);
+        if (rate > 0.0)
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(interval * double(i)));
+
+        const auto publishStart = Clock::now();
+        publisher.Publish(source.View(), (i & 1) != 0, NowNs());
+        publishSeconds.push_back(std::chrono::duration<double>(Clock::now() - publishStart).count());
+    }
+
+    // Let the consumer see the last frame before stopping it.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    std::sort(publishSeconds.begin(), publishSeconds.end());
+    double publishTotal = 0.0;
+    for (double seconds : publishSeconds)
+        publishTotal += seconds;
+    const double frameBytes = double(format.width) * 4 * format.height;
+
+    printf("sharebench: %ux%u, %u slots, %u frames at %.0f fps, %s consumer\n", format.width, format.height, format.slotCount, frames, rate,
+        copy ? "copying" : "zero-copy");
+    printf("sharebench: publish %.3f ms mean, %.3f ms p99 (%.1f GB/s)\n", 1000.0 * publishTotal / frames,
+        1000.0 * publishSeconds[std::min(publishSeconds.size() - 1, publishSeconds.size() * 99 / 100)],
+        frameBytes * frames / publishTotal / 1e9);
+    printf("sharebench: consumed %llu, skipped %llu, torn %llu, corrupt %llu, publish-to-read %.3f ms mean\n",
+        static_cast<unsigned long long>(consumed), static_cast<unsigned long long>(consumer.SkippedFrames()),
+        static_cast<unsigned long long>(consumer.TornFrames()), static_cast<unsigned long long>(corrupt),
+        consumed ? 1000.0 * latencyTotal / double(consumed) : 0.0);
+    if (corrupt != 0)
+        throw std::runtime_error("A validated frame did not match what was published");
+    return 0;
+}
+
+int DX::ShareReadMain(const ToolArgs& args)
+{
+    const std::string name = args.Get("name", "hfv-output");
+    FrameConsumer consumer;
+    if (!consumer.Open(name))
+        throw std::runtime_error("No frame ring named " + name + " (is the viewer publishing?)");
+
+    const SharedFrameHeader& header = consumer.Header();
+    printf("shareread: %s is %ux%u in %u slots at %u/%u fps\n", name.c_str(), header.width, header.height, header.slotCount,
+        header.rateNumerator, header.rateDenominator);
+
+    // Recording needs a private copy; without --out frames are only counted, in place.
+    const std::string output = args.Get("out");
+    std::unique_ptr<IFrameSink> sink;
+    Image local;
+    if (!output.empty())
+    {
+        FrameFormat format;
+        format.width = header.width;
+        format.height = header.height;
+        format.rateNumerator = header.rateNumerator;
+        format.rateDenominator = header.rateDenominator;
+        sink = CreateFrameSink(output, FrameFileFormatFromPath(output), format);
+        local.Resize(header.width, header.height, 4);
+    }
+
+    const double seconds = args.GetNumber("seconds", 10.0);
+    const auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    uint64_t frames = 0;
+    uint64_t interpolated = 0;
+    SharedFrame frame;
+    while (Clock::now() < end && !consumer.IsPublisherClosed())
+    {
+        const bool acquired = sink ? consumer.CopyLatest(local.View(), frame) : consumer.AcquireLatest(frame);
+        if (!acquired)
+        {
+            std::this_thread::sleep_for(c_PollInterval);
+            continue;
+        }
+        frames++;
+        interpolated += frame.interpolated ? 1 : 0;
+        if (sink && !sink->Write(local.View()))
+            throw std::runtime_error("Cannot write " + output);
+    }
+
+    printf("shareread: %llu frames (%llu interpolated), %llu skipped, %llu torn%s\n", static_cast<unsigned long long>(frames),
+        static_cast<unsigned long long>(interpolated), static_cast<unsigned long long>(consumer.SkippedFrames()),
+        static_cast<unsigned long long>(consumer.TornFrames()), consumer.IsPublisherClosed() ? ", publisher closed" : "");
+    return 0;
+}
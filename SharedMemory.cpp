@@ -0,0 +1,156 @@
+//
+// SharedMemory.cpp - Named shared memory mappings (POSIX shm_open or Windows file mappings)
+//
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SharedMemory.h"
+
+#include <utility>
+
+using namespace DX;
+
+namespace
+{
+#ifdef _WIN32
+    // Session-local, so no privilege is needed to create it.
+    std::string SystemName(const std::string& name) { return "Local\\" + name; }
+#else
+    std::string SystemName(const std::string& name) { return "/" + name; }
+#endif
+}
+
+SharedMemory& SharedMemory::operator= (SharedMemory&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_name = std::move(other.m_name);
+        m_owner = std::exchange(other.m_owner, false);
+        m_handle = std::exchange(other.m_handle, nullptr);
+    }
+    return *this;
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size)
+{
+    Close();
+#ifdef _WIN32
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), SystemName(name).c_str());
+    if (mapping == NULL)
+        return false;
+
+    // An existing mapping keeps its old size, which may be too small for this one.
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+#else
+    // A name left behind by a crashed publisher is replaced.
+    const std::string systemName = SystemName(name);
+    shm_unlink(systemName.c_str());
+    const int fd = shm_open(systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return false;
+
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0)
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        shm_unlink(systemName.c_str());
+        return false;
+    }
+#endif
+    m_data = static_cast<uint8_t*>(view);
+    m_size = size;
+    m_name = name;
+    m_owner = true;
+    return true;
+}
+
+bool SharedMemory::Open(const std::string& name, bool writable)
+{
+    Close();
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, FALSE, SystemName(name).c_str());
+    if (mapping == NULL)
+        return false;
+
+    void* view = MapViewOfFile(mapping, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info = {};
+    if (view == nullptr || VirtualQuery(view, &info, sizeof(info)) == 0)
+    {
+        if (view != nullptr)
+            UnmapViewOfFile(view);
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+    m_size = info.RegionSize;
+#else
+    const int fd = shm_open(SystemName(name).c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat status = {};
+    void* view = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size > 0)
+        view = mmap(nullptr, static_cast<size_t>(status.st_size), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    m_size = static_cast<size_t>(status.st_size);
+#endif
+    m_data = static_cast<uint8_t*>(view);
+    m_name = name;
+    m_owner = false;
+    return true;
+}
+
+void SharedMemory::Close() noexcept
+{
+    if (m_data != nullptr)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(static_cast<HANDLE>(m_handle));
+#else
+        munmap(m_data, m_size);
+        if (m_owner)
+            shm_unlink(SystemName(m_name).c_str());
+#endif
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_name.clear();
+    m_owner = false;
+    m_handle = nullptr;
+}
@@ -0,0 +1,49 @@
+//
+// SharedMemory.h - Named shared memory mappings (POSIX shm_open or Windows file mappings)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace DX
+{
+    // A named mapping other processes can open. The creator removes the name when it is destroyed;
+    // processes that already opened it keep their mapping until they close it.
+    class SharedMemory
+    {
+    public:
+        SharedMemory() = default;
+        ~SharedMemory() { Close(); }
+
+        SharedMemory(SharedMemory&& other) noexcept { *this = std::move(other); }
+        SharedMemory& operator= (SharedMemory&& other) noexcept;
+
+        SharedMemory(SharedMemory const&) = delete;
+        SharedMemory& operator= (SharedMemory const&) = delete;
+
+        // Create a zero-filled mapping of size bytes. name is a plain identifier such as "hfv-output".
+        // A POSIX name left behind by a crashed creator is replaced; on Windows a live name can't be.
+        bool Create(const std::string& name, size_t size);
+
+        // Map an existing mapping, sized as its creator made it.
+        bool Open(const std::string& name, bool writable = false);
+
+        void Close() noexcept;
+
+        bool IsOpen() const noexcept { return m_data != nullptr; }
+        uint8_t* Data() const noexcept { return m_data; }
+        size_t Size() const noexcept { return m_size; }
+        const std::string& Name() const noexcept { return m_name; }
+
+    private:
+        uint8_t*        m_data = nullptr;
+        size_t          m_size = 0;
+        std::string     m_name;
+        bool            m_owner = false;
+        void*           m_handle = nullptr;     // Windows file mapping handle.
+    };
+}
@@ -0,0 +1,76 @@
+//
+// Simd.h - Instruction set tiers for the CPU reference kernels, and the conversions they share
+//
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define DX_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define DX_HAS_SSE2 0
+#endif
+
+namespace DX
+{
+    // Kernels take the tier explicitly so benchmarks can pin each one.
+    enum class SimdTier
+    {
+        Scalar,
+        SSE2,
+    };
+
+    inline const char* SimdTierName(SimdTier tier) noexcept
+    {
+        switch (tier)
+        {
+        case SimdTier::SSE2:    return "sse2";
+        default:                return "scalar";
+        }
+    }
+
+    // Best tier this build can run. SSE2 is baseline on every x64 target.
+    constexpr SimdTier BestSimdTier() noexcept
+    {
+        return DX_HAS_SSE2 ? SimdTier::SSE2 : SimdTier::Scalar;
+    }
+
+#if DX_HAS_SSE2
+    // Four halves in the low 64 bits to floats, exactly as HalfToFloat: the exponent is rebiased by a
+    // multiply, which also normalises subnormals, and infinities and NaNs get the float's top exponent.
+    inline __m128 HalvesToFloats(__m128i halves) noexcept
+    {
+        const __m128i h = _mm_unpacklo_epi16(halves, _mm_setzero_si128());
+        const __m128i magnitude = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+        const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, magnitude), 16);
+        const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)), _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+        const __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7bff)), _mm_set1_epi32(0x7f800000));
+        return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+    }
+
+    // Four floats to halves in 32-bit lanes, sign-extended so _mm_packs_epi32 keeps them, rounded to
+    // nearest even exactly as FloatToHalf.
+    inline __m128i FloatsToHalves(__m128 floats) noexcept
+    {
+        const __m128i bits = _mm_castps_si128(floats);
+        const __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(int(0x80000000u)));
+        const __m128i magnitude = _mm_xor_si128(bits, sign);
+
+        // Subnormal halves: adding a magic number leaves the rounded half in the low bits.
+        const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+        // Normal halves: rebias and round half to even, carrying into the exponent and on to infinity.
+        const __m128i odd = _mm_srai_epi32(_mm_slli_epi32(magnitude, 31 - 13), 31);
+        const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(magnitude, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), odd), 13);
+
+        const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), magnitude);
+        const __m128i isFinite = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), magnitude);
+        const __m128i isNan = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7f800000));
+        const __m128i infNan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNan, _mm_set1_epi32(0x200)));
+        const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        const __m128i joined = _mm_or_si128(_mm_and_si128(isFinite, finite), _mm_andnot_si128(isFinite, infNan));
+        return _mm_or_si128(joined, _mm_srai_epi32(sign, 16));
+    }
+#endif
+}
@@ -0,0 +1,227 @@
+//
+// TexturePool.h - A descriptor-keyed pool of textures with reference-counted leases
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    // Describes everything that makes two textures interchangeable.
+    struct TextureKey
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t format = 0;
+        uint32_t bindFlags = 0;
+        uint32_t miscFlags = 0;
+
+        bool operator==(const TextureKey& other) const noexcept
+        {
+            return width == other.width && height == other.height && format == other.format
+                && bindFlags == other.bindFlags && miscFlags == other.miscFlags;
+        }
+        bool operator!=(const TextureKey& other) const noexcept { return !(*this == other); }
+    };
+
+    struct TextureKeyHash
+    {
+        size_t operator()(const TextureKey& key) const noexcept
+        {
+            // FNV-1a over the descriptor fields.
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t value : { key.width, key.height, key.format, key.bindFlags, key.miscFlags })
+            {
+                hash ^= value;
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct TexturePoolStats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t residentBytes = 0;
+        uint64_t leasedBytes = 0;
+        size_t residentCount = 0;
+        size_t leasedCount = 0;
+
+        double HitRate() const noexcept
+        {
+            const uint64_t total = hits + misses;
+            return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+        }
+    };
+
+    // Hands out textures keyed on their descriptor and keeps released ones around for reuse.
+    //
+    // TAllocator must provide:
+    //     TResource* Create(const TextureKey& key);
+    //     void Destroy(TResource* resource);
+    //     uint64_t SizeInBytes(const TextureKey& key) const;
+    template<typename TResource, typename TAllocator>
+    class TexturePool
+    {
+    public:
+        explicit TexturePool(TAllocator allocator, uint64_t idleBudgetBytes = UINT64_MAX) :
+            m_allocator(std::move(allocator)),
+            m_idleBudgetBytes(idleBudgetBytes)
+        {
+        }
+
+        ~TexturePool() { Clear(); }
+
+        TexturePool(TexturePool const&) = delete;
+        TexturePool& operator= (TexturePool const&) = delete;
+
+        // Lease a texture matching key, reusing an idle one when possible. Returns nullptr if creation failed.
+        TResource* Acquire(const TextureKey& key)
+        {
+            TResource* resource = nullptr;
+
+            auto idle = m_idle.find(key);
+            if (idle != m_idle.end())
+                idle->second.lastUse = ++m_useClock;
+            if (idle != m_idle.end() && !idle->second.textures.empty())
+            {
+                resource = idle->second.textures.back();
+                idle->second.textures.pop_back();
+                m_stats.hits++;
+            }
+            else
+            {
+                resource = m_allocator.Create(key);
+                if (resource == nullptr)
+                    return nullptr;
+
+                m_stats.misses++;
+                m_stats.residentBytes += m_allocator.SizeInBytes(key);
+                m_stats.residentCount++;
+            }
+
+            m_leases[resource] = Lease{ key, 1 };
+            m_stats.leasedBytes += m_allocator.SizeInBytes(key);
+            m_stats.leasedCount++;
+            return resource;
+        }
+
+        // Add another reference to an outstanding lease.
+        void AddRef(TResource* resource)
+        {
+            auto lease = m_leases.find(resource);
+            if (lease != m_leases.end())
+                lease->second.refCount++;
+        }
+
+        // Drop a reference. The texture returns to the idle list when the last reference goes away.
+        void Release(TResource* resource)
+        {
+            auto lease = m_leases.find(resource);
+            if (lease == m_leases.end() || --lease->second.refCount != 0)
+                return;
+
+            const TextureKey key = lease->second.key;
+            m_leases.erase(lease);
+            m_stats.leasedBytes -= m_allocator.SizeInBytes(key);
+            m_stats.leasedCount--;
+            IdleBucket& bucket = m_idle[key];
+            bucket.textures.push_back(resource);
+            bucket.lastUse = ++m_useClock;
+
+            EnforceIdleBudget();
+        }
+
+        // Destroy idle textures until the idle set fits in the given budget. Descriptors that were
+        // acquired or released longest ago go first, so after a resize the old size is dropped
+        // before the one in use.
+        void Trim(uint64_t idleBudgetBytes = 0)
+        {
+            while (IdleBytes() > idleBudgetBytes && !m_idle.empty())
+            {
+                auto oldest = m_idle.begin();
+                for (auto bucket = m_idle.begin(); bucket != m_idle.end(); ++bucket)
+                {
+                    if (bucket->second.lastUse < oldest->second.lastUse)
+                        oldest = bucket;
+                }
+
+                const uint64_t size = m_allocator.SizeInBytes(oldest->first);
+                std::vector<TResource*>& textures = oldest->second.textures;
+                while (!textures.empty() && IdleBytes() > idleBudgetBytes)
+                {
+                    DestroyResident(textures.back(), size);
+                    textures.pop_back();
+                }
+                if (textures.empty())
+                    m_idle.erase(oldest);
+            }
+        }
+
+        // Destroy everything, including outstanding leases (used when the device is lost).
+        void Clear()
+        {
+            for (auto& lease : m_leases)
+            {
+                DestroyResident(lease.first, m_allocator.SizeInBytes(lease.second.key));
+            }
+            m_leases.clear();
+            m_stats.leasedBytes = 0;
+            m_stats.leasedCount = 0;
+
+            Trim(0);
+            m_idle.clear();
+        }
+
+        // Keep at most this many idle bytes from now on, trimming what is over it.
+        void SetIdleBudget(uint64_t idleBudgetBytes)
+        {
+            m_idleBudgetBytes = idleBudgetBytes;
+            EnforceIdleBudget();
+        }
+
+        uint64_t IdleBytes() const noexcept { return m_stats.residentBytes - m_stats.leasedBytes; }
+        uint64_t IdleBudget() const noexcept { return m_idleBudgetBytes; }
+        const TexturePoolStats& GetStats() const noexcept { return m_stats; }
+        TAllocator& GetAllocator() noexcept { return m_allocator; }
+
+    private:
+        struct Lease
+        {
+            TextureKey key;
+            uint32_t refCount;
+        };
+
+        struct IdleBucket
+        {
+            std::vector<TResource*> textures;
+            uint64_t lastUse = 0;           // m_useClock when the descriptor was last acquired or released.
+        };
+
+        void EnforceIdleBudget()
+        {
+            if (IdleBytes() > m_idleBudgetBytes)
+                Trim(m_idleBudgetBytes);
+        }
+
+        void DestroyResident(TResource* resource, uint64_t size)
+        {
+            m_allocator.Destroy(resource);
+            m_stats.residentBytes -= size;
+            m_stats.residentCount--;
+        }
+
+        TAllocator                                                          m_allocator;
+        uint64_t                                                            m_idleBudgetBytes;
+        std::unordered_map<TResource*, Lease>                               m_leases;
+        std::unordered_map<TextureKey, IdleBucket, TextureKeyHash>          m_idle;
+        uint64_t                                                            m_useClock = 0;
+        TexturePoolStats                                                    m_stats;
+    };
+}
@@ -0,0 +1,204 @@
+//
+// ToolMain.cpp - Entry point and argument helpers for the headless offline tools
+//
+// On Windows the viewer executable dispatches here when its first argument names a tool.
+// Elsewhere this file provides main(), so the tools build without the D3D11 viewer, e.g.
+//     g++ -O2 -std=c++20 -pthread ToolMain.cpp Transcode.cpp Quality.cpp QualityMetrics.cpp TraceBench.cpp Trace.cpp PacingSim.cpp LatencyTracker.cpp FrameIO.cpp FrameInterpolator.cpp WorkerPool.cpp Nv12Convert.cpp Benchmark.cpp Benchmarks.cpp MetricsBench.cpp Metrics.cpp MetricsServer.cpp LogBench.cpp Logger.cpp RecordBench.cpp FrameRecorder.cpp ShareBench.cpp FrameShare.cpp SharedMemory.cpp CursorSim.cpp CursorPredictor.cpp LayoutCheck.cpp DesktopLayout.cpp SchedSim.cpp CaptureScheduler.cpp RegionCheck.cpp CaptureRegion.cpp SettingsCheck.cpp Settings.cpp RecoveryCheck.cpp CaptureRecovery.cpp FormatCheck.cpp PipelineCheck.cpp ScaleCheck.cpp HudCheck.cpp -o hfv-tools
+//
+
+#include "ToolMain.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    struct Tool
+    {
+        const char* name;
+        const char* usage;
+        int (*main)(const ToolArgs& args);
+    };
+
+    const Tool c_Tools[] =
+    {
+        { "transcode", "--in <file> --out <file> [--size WxH] [--rate N] [--scale F] [--filter name] [--threads N] [--frames N] [--scalar]", TranscodeMain },
+        { "quality",   "--in <file> [--size WxH] [--rate N] [--scale F] [--filter name] [--threads N] [--block N] [--tile N] [--frames N] [--scalar] [--csv file] [--tiles file] [--label text]", QualityMain },
+        { "tracebench", "[--threads N] [--spans N] [--out trace.json]", TraceBenchMain },
+        { "pacingsim", "[--source-fps F] [--refresh F] [--capture-ms F] [--interp-ms F] [--jitter-ms F] [--frames N] [--ring N] [--seed N] [--csv file]", PacingSimMain },
+        { "bench",     "[--filter text] [--min-time S] [--repetitions N] [--threads N,N] [--out file.json] [--baseline file.json] [--threshold F]", BenchMain },
+        { "metricsbench", "[--threads N] [--updates N] [--out file.prom] [--port N] [--seconds S]", MetricsBenchMain },
+        { "logbench", "[--threads N] [--records N]", LogBenchMain },
+        { "recordbench", "[--size WxH] [--frames N] [--format y4m|raw] [--rate F] [--ring N] [--latency N] [--queue N] [--out file]", RecordBenchMain },
+        { "sharebench", "[--size WxH] [--slots N] [--frames N] [--rate F] [--copy] [--name text]", ShareBenchMain },
+        { "shareread", "[--name text] [--seconds S] [--out file]", ShareReadMain },
+        { "cursorsim", "[--trace file.csv | --pattern flick|circle|scribble] [--seconds S] [--poll-hz F] [--source-fps F] [--refresh F] [--vblanks N] [--no-latch] [--seed N] [--out file.csv] [--check]", CursorSimMain },
+        { "layout",    "[--outputs X,Y,WxH[,ROT];...] [--output N] [--viewer WxH] [--point X,Y] | --check [N] [--seed N]", LayoutCheckMain },
+        { "schedsim",  "[--outputs GPU_MS:CPU_MS[:WEIGHT[:FPS]],...] [--budget-gpu-ms F] [--budget-cpu-ms F] [--round-hz F] [--rounds N] [--jitter F] [--seed N] | --check [N]", SchedSimMain },
+        { "region",    "[--output WxH] [--window WxH] [--updates N] [--jitter PX] [--seed N] | --check [N]", RegionCheckMain },
+        { "settings",  "[--config file.ini] [--against file.ini] [--KEY VALUE ...] | --check [N] [--seed N]", SettingsCheckMain },
+        { "recovery",  "[--outputs N] [--seconds S] [--faults PER_S] [--max-backoff S] [--escalate-after N] [--seed N] | --check [N]", RecoveryCheckMain },
+        { "formats",   "[--size WxH] [--sdr-white N] | --check [N] [--seed N]", FormatCheckMain },
+        { "pipeline",  "[--seed N] | --check [N] [--seed N]", PipelineCheckMain },
+        { "scale",     "[--size WxH] [--scale F] [--seed N] | --check [N] [--seed N]", ScaleCheckMain },
+        { "hud",       "[--source-fps F] [--refresh F] [--seconds S] [--jitter F] [--seed N] | --check [N] [--seed N]", HudCheckMain },
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "Tools:\n");
+        for (auto const& tool : c_Tools)
+            fprintf(stderr, "  %s %s\n", tool.name, tool.usage);
+        fprintf(stderr, "Every tool also takes [--log file|-] [--log-level debug|info|warning|error]; warnings and errors go to stderr by default.\n");
+    }
+
+    // Route log records to --log (a file, or - for stderr), otherwise warnings and errors to stderr.
+    void StartToolLogging(const ToolArgs& args)
+    {
+        LogLevel level = LogLevel::Info;
+        const std::string levelName = args.Get("log-level", "info");
+        if (!LogLevelFromName(levelName.c_str(), level))
+            throw std::runtime_error("Unknown log level " + levelName);
+        SetLogMinLevel(level);
+
+        const std::string path = args.Get("log");
+        if (path.empty() || path == "-")
+        {
+            auto sink = std::make_unique<StderrLogSink>();
+            if (path.empty())
+                sink->minLevel = LogLevel::Warning;
+            AddLogSink(std::move(sink));
+        }
+        else
+        {
+            auto sink = std::make_unique<FileLogSink>(path);
+            if (!sink->IsOpen())
+                throw std::runtime_error("Cannot open " + path);
+            AddLogSink(std::move(sink));
+        }
+        StartLogThread();
+    }
+}
+
+ToolArgs::ToolArgs(int argc, char** argv)
+{
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::strncmp(argv[i], "--", 2) != 0)
+            continue;
+
+        const std::string key = argv[i] + 2;
+        if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+            m_values[key] = argv[++i];
+        else
+            m_values[key] = {};
+    }
+}
+
+std::string ToolArgs::Get(const std::string& key, const std::string& fallback) const
+{
+    auto value = m_values.find(key);
+    return value == m_values.end() ? fallback : value->second;
+}
+
+double ToolArgs::GetNumber(const std::string& key, double fallback) const
+{
+    auto value = m_values.find(key);
+    return value == m_values.end() || value->second.empty() ? fallback : std::strtod(value->second.c_str(), nullptr);
+}
+
+uint32_t ToolArgs::GetUInt(const std::string& key, uint32_t fallback) const
+{
+    auto value = m_values.find(key);
+    return value == m_values.end() || value->second.empty() ? fallback : static_cast<uint32_t>(std::strtoul(value->second.c_str(), nullptr, 10));
+}
+
+bool ToolArgs::GetSize(const std::string& key, uint32_t& width, uint32_t& height) const
+{
+    const std::string value = Get(key);
+    const size_t x = value.find('x');
+    if (x == std::string::npos)
+        return false;
+
+    width = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    height = static_cast<uint32_t>(std::strtoul(value.c_str() + x + 1, nullptr, 10));
+    return width != 0 && height != 0;
+}
+
+ScaleFilter ToolArgs::GetFilter(const std::string& key, ScaleFilter fallback) const
+{
+    const std::string value = Get(key);
+    if (value.empty())
+        return fallback;
+
+    ScaleFilter filter = fallback;
+    if (!ScaleFilterFromName(value.c_str(), filter))
+        throw std::runtime_error("Unknown filter " + value);
+    return filter;
+}
+
+bool DX::IsToolName(const char* name)
+{
+    if (std::strcmp(name, "help") == 0)
+        return true;
+    for (auto const& tool : c_Tools)
+    {
+        if (std::strcmp(name, tool.name) == 0)
+            return true;
+    }
+    return false;
+}
+
+int DX::RunTool(int argc, char** argv)
+{
+    if (argc < 2)
+        return -1;
+
+    if (std::strcmp(argv[1], "help") == 0)
+    {
+        PrintUsage();
+        return 0;
+    }
+
+    for (auto const& tool : c_Tools)
+    {
+        if (std::strcmp(argv[1], tool.name) != 0)
+            continue;
+
+        int result = 1;
+        try
+        {
+            const ToolArgs args(argc, argv);
+            StartToolLogging(args);
+            result = tool.main(args);
+        }
+        catch (const std::exception& e)
+        {
+            fprintf(stderr, "%s: %s\n", tool.name, e.what());
+        }
+        StopLogThread();
+        RemoveLogSinks();
+        return result;
+    }
+    return -1;
+}
+
+#ifndef _WIN32
+int main(int argc, char** argv)
+{
+    const int result = RunTool(argc, argv);
+    if (result < 0)
+    {
+        PrintUsage();
+        return 1;
+    }
+    return result;
+}
+#endif
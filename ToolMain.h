@@ -0,0 +1,64 @@
+//
+// ToolMain.h - Entry point and argument helpers for the headless offline tools
+//
+
+#pragma once
+
+#include "Resampler.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace DX
+{
+    // "--key value" pairs and bare "--flag" switches following the tool name.
+    class ToolArgs
+    {
+    public:
+        ToolArgs(int argc, char** argv);
+
+        bool Has(const std::string& key) const { return m_values.count(key) != 0; }
+        std::string Get(const std::string& key, const std::string& fallback = {}) const;
+        double GetNumber(const std::string& key, double fallback) const;
+        uint32_t GetUInt(const std::string& key, uint32_t fallback) const;
+
+        // Parse "WIDTHxHEIGHT". Returns false if the key is missing or malformed.
+        bool GetSize(const std::string& key, uint32_t& width, uint32_t& height) const;
+
+        // Parse a ScaleFilterName. Throws std::runtime_error for unknown names.
+        ScaleFilter GetFilter(const std::string& key, ScaleFilter fallback) const;
+
+        const std::map<std::string, std::string>& Values() const noexcept { return m_values; }
+
+    private:
+        std::map<std::string, std::string> m_values;
+    };
+
+    // True if name selects a tool (or "help"), so the caller can skip creating a window.
+    bool IsToolName(const char* name);
+
+    // Run the tool named by argv[1]. Returns -1 if argv[1] does not name a tool.
+    int RunTool(int argc, char** argv);
+
+    int TranscodeMain(const ToolArgs& args);
+    int QualityMain(const ToolArgs& args);
+    int TraceBenchMain(const ToolArgs& args);
+    int PacingSimMain(const ToolArgs& args);
+    int BenchMain(const ToolArgs& args);
+    int MetricsBenchMain(const ToolArgs& args);
+    int LogBenchMain(const ToolArgs& args);
+    int RecordBenchMain(const ToolArgs& args);
+    int ShareBenchMain(const ToolArgs& args);
+    int ShareReadMain(const ToolArgs& args);
+    int CursorSimMain(const ToolArgs& args);
+    int LayoutCheckMain(const ToolArgs& args);
+    int SchedSimMain(const ToolArgs& args);
+    int RegionCheckMain(const ToolArgs& args);
+    int SettingsCheckMain(const ToolArgs& args);
+    int RecoveryCheckMain(const ToolArgs& args);
+    int FormatCheckMain(const ToolArgs& args);
+    int PipelineCheckMain(const ToolArgs& args);
+    int ScaleCheckMain(const ToolArgs& args);
+    int HudCheckMain(const ToolArgs& args);
+}
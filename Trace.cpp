@@ -0,0 +1,203 @@
+//
+// Trace.cpp - Scoped timeline spans recorded per thread and exported as Chrome trace JSON
+//
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace DX;
+
+std::atomic<bool> DX::g_traceEnabled{ false };
+
+namespace
+{
+    static_assert((c_TraceRingCapacity & (c_TraceRingCapacity - 1)) == 0, "Trace ring capacity must be a power of two");
+
+    // Fields are relaxed atomics so the exporter can read a ring while its thread writes.
+    struct TraceEvent
+    {
+        std::atomic<const char*>    name{ nullptr };
+        std::atomic<uint64_t>       begin{ 0 };
+        std::atomic<uint64_t>       end{ 0 };
+    };
+
+    // Single producer (the owning thread), read by the exporter.
+    struct TraceRing
+    {
+        uint32_t                            threadId = 0;
+        std::string                         threadName;     // Guarded by the registry mutex.
+        alignas(64) std::atomic<uint64_t>   head{ 0 };      // Own cache line, away from other rings.
+        std::unique_ptr<TraceEvent[]>       events{ new TraceEvent[c_TraceRingCapacity] };
+    };
+
+    // Rings outlive their threads so a dump after a worker exits still has its events.
+    struct TraceRegistry
+    {
+        std::mutex                              mutex;
+        std::vector<std::unique_ptr<TraceRing>> rings;
+        std::atomic<uint64_t>                   clearedAt{ 0 };
+    };
+
+    TraceRegistry& Registry()
+    {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    thread_local TraceRing* t_ring = nullptr;
+
+    TraceRing& ThreadRing()
+    {
+        if (t_ring == nullptr)
+        {
+            auto& registry = Registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.rings.push_back(std::make_unique<TraceRing>());
+            t_ring = registry.rings.back().get();
+            t_ring->threadId = static_cast<uint32_t>(registry.rings.size());
+        }
+        return *t_ring;
+    }
+
+    struct ExportedEvent
+    {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Copy the events that survive the read; the owner may be overwriting the oldest ones meanwhile.
+    void SnapshotRing(const TraceRing& ring, uint64_t clearedAt, std::vector<ExportedEvent>& out)
+    {
+        out.clear();
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        const uint64_t first = head > c_TraceRingCapacity ? head - c_TraceRingCapacity : 0;
+        for (uint64_t i = first; i < head; i++)
+        {
+            const TraceEvent& event = ring.events[i & (c_TraceRingCapacity - 1)];
+            out.push_back({ event.name.load(std::memory_order_relaxed),
+                            event.begin.load(std::memory_order_relaxed),
+                            event.end.load(std::memory_order_relaxed) });
+        }
+
+        // Anything the writer has since reached may be torn.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t headAfter = ring.head.load(std::memory_order_relaxed);
+        const uint64_t torn = headAfter >= first + c_TraceRingCapacity ? headAfter + 1 - (first + c_TraceRingCapacity) : 0;
+        out.erase(out.begin(), out.begin() + std::min<size_t>(out.size(), size_t(torn)));
+
+        out.erase(std::remove_if(out.begin(), out.end(), [clearedAt](const ExportedEvent& event) {
+            return event.name == nullptr || event.begin < clearedAt;
+        }), out.end());
+    }
+
+    void WriteJsonString(FILE* file, const char* text)
+    {
+        fputc('"', file);
+        for (; *text != '\0'; text++)
+        {
+            if (*text == '"' || *text == '\\')
+                fputc('\\', file);
+            if (static_cast<unsigned char>(*text) >= 0x20)
+                fputc(*text, file);
+        }
+        fputc('"', file);
+    }
+}
+
+void DX::SetTraceEnabled(bool enabled) noexcept
+{
+    g_traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t DX::TraceNow() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void DX::TraceRecord(const char* name, uint64_t begin, uint64_t end) noexcept
+{
+    TraceRing& ring = ThreadRing();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    TraceEvent& event = ring.events[head & (c_TraceRingCapacity - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void DX::SetTraceThreadName(const char* name)
+{
+    TraceRing& ring = ThreadRing();
+    std::lock_guard<std::mutex> lock(Registry().mutex);
+    ring.threadName = name;
+}
+
+void DX::ClearTrace() noexcept
+{
+    Registry().clearedAt.store(TraceNow(), std::memory_order_relaxed);
+}
+
+bool DX::WriteChromeTrace(const std::string& path, size_t* eventsWritten)
+{
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, path.c_str(), "wb");
+#else
+    file = fopen(path.c_str(), "wb");
+#endif
+    if (file == nullptr)
+        return false;
+
+    auto& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    const uint64_t clearedAt = registry.clearedAt.load(std::memory_order_relaxed);
+
+    // Snapshot first so timestamps can be made relative to the earliest event.
+    std::vector<std::vector<ExportedEvent>> snapshots(registry.rings.size());
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < registry.rings.size(); i++)
+    {
+        SnapshotRing(*registry.rings[i], clearedAt, snapshots[i]);
+        for (auto const& event : snapshots[i])
+            origin = std::min(origin, event.begin);
+    }
+
+    size_t count = 0;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < registry.rings.size(); i++)
+    {
+        const TraceRing& ring = *registry.rings[i];
+        if (!ring.threadName.empty())
+        {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", count == 0 ? "" : ",\n", ring.threadId);
+            WriteJsonString(file, ring.threadName.c_str());
+            fprintf(file, "}}");
+            count++;
+        }
+
+        // Chrome trace timestamps are microseconds.
+        for (auto const& event : snapshots[i])
+        {
+            fprintf(file, "%s{\"name\":", count == 0 ? "" : ",\n");
+            WriteJsonString(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", ring.threadId,
+                double(event.begin - origin) / 1000.0, double(event.end - event.begin) / 1000.0);
+            count++;
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    const bool written = ferror(file) == 0;
+    fclose(file);
+    if (eventsWritten != nullptr)
+        *eventsWritten = count;
+    return written;
+}
@@ -0,0 +1,65 @@
+//
+// Trace.h - Scoped timeline spans recorded per thread and exported as Chrome trace JSON
+//
+// Wrap a pipeline stage in DX_TRACE_SPAN("Name") and load the dump in chrome://tracing or
+// ui.perfetto.dev. Span names must be string literals; only the pointer is recorded.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DX
+{
+    // Events kept per thread; older ones are overwritten.
+    constexpr size_t c_TraceRingCapacity = size_t(1) << 16;
+
+    // Checked once when a span opens, so a disabled span costs a relaxed load and a branch.
+    extern std::atomic<bool> g_traceEnabled;
+
+    inline bool IsTraceEnabled() noexcept { return g_traceEnabled.load(std::memory_order_relaxed); }
+    void SetTraceEnabled(bool enabled) noexcept;
+
+    // Nanoseconds on the steady clock.
+    uint64_t TraceNow() noexcept;
+
+    // Append a completed span to the calling thread's ring. Lock-free after the thread's first event.
+    void TraceRecord(const char* name, uint64_t begin, uint64_t end) noexcept;
+
+    // Label the calling thread in the exported timeline.
+    void SetTraceThreadName(const char* name);
+
+    // Drop everything recorded so far.
+    void ClearTrace() noexcept;
+
+    // Write every thread's events as Chrome trace JSON. Safe to call while other threads record;
+    // events overwritten during the copy are skipped. Returns false if the file can't be written.
+    bool WriteChromeTrace(const std::string& path, size_t* eventsWritten = nullptr);
+
+    class TraceSpan
+    {
+    public:
+        explicit TraceSpan(const char* name) noexcept
+            : m_name(IsTraceEnabled() ? name : nullptr), m_begin(m_name != nullptr ? TraceNow() : 0) {}
+
+        ~TraceSpan()
+        {
+            if (m_name != nullptr)
+                TraceRecord(m_name, m_begin, TraceNow());
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t    m_begin;
+    };
+}
+
+#define DX_TRACE_CONCAT_INNER(a, b) a##b
+#define DX_TRACE_CONCAT(a, b) DX_TRACE_CONCAT_INNER(a, b)
+#define DX_TRACE_SPAN(name) ::DX::TraceSpan DX_TRACE_CONCAT(traceSpan, __LINE__)(name)
@@ -0,0 +1,67 @@
+//
+// TraceBench.cpp - Cost of trace spans, disabled and recording, across threads
+//
+
+#include "ToolMain.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Nanoseconds per span when every thread opens and closes spans back to back.
+    double MeasureSpans(uint32_t threads, uint64_t spans)
+    {
+        auto work = [spans] {
+            for (uint64_t i = 0; i < spans; i++)
+            {
+                DX_TRACE_SPAN("TraceBench");
+            }
+        };
+
+        const auto start = Clock::now();
+        std::vector<std::thread> workers;
+        for (uint32_t t = 1; t < threads; t++)
+            workers.emplace_back(work);
+        work();
+        for (auto& worker : workers)
+            worker.join();
+        return 1e9 * std::chrono::duration<double>(Clock::now() - start).count() / double(spans);
+    }
+}
+
+int DX::TraceBenchMain(const ToolArgs& args)
+{
+    const uint32_t threads = std::max(1u, args.GetUInt("threads", 1));
+    const uint64_t spans = args.GetUInt("spans", 10000000);
+
+    SetTraceEnabled(false);
+    const double disabled = MeasureSpans(threads, spans);
+
+    SetTraceEnabled(true);
+    const double enabled = MeasureSpans(threads, spans);
+    SetTraceEnabled(false);
+
+    printf("tracebench: %u threads, %llu spans per thread\n", threads, static_cast<unsigned long long>(spans));
+    printf("tracebench: disabled %.2f ns/span, recording %.2f ns/span (wall time per thread)\n", disabled, enabled);
+
+    const std::string output = args.Get("out");
+    if (!output.empty())
+    {
+        size_t events = 0;
+        const auto start = Clock::now();
+        if (!WriteChromeTrace(output, &events))
+            throw std::runtime_error("Cannot write " + output);
+        printf("tracebench: wrote %zu events in %.1f ms\n", events, 1000.0 * std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+//
+// Transcode.cpp - Offline frame doubling of a video file, as fast as possible
+//
+// Runs the capture-side scaler and the interpolation contract over a file instead of a monitor,
+// with no display pacing, so it doubles as the throughput benchmark.
+//
+
+#include "ToolMain.h"
+#include "FrameIO.h"
+#include "FrameInterpolator.h"
+#include "Resampler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum Stage
+    {
+        StageRead,
+        StageScale,
+        StageInterpolate,
+        StageWrite,
+        StageCount
+    };
+
+    const char* const c_StageNames[StageCount] = { "read", "scale", "interpolate", "write" };
+
+    class StageTimer
+    {
+    public:
+        explicit StageTimer(double& total) : m_total(total), m_start(Clock::now()) {}
+        ~StageTimer() { m_total += std::chrono::duration<double>(Clock::now() - m_start).count(); }
+
+    private:
+        double&             m_total;
+        Clock::time_point   m_start;
+    };
+}
+
+int DX::TranscodeMain(const ToolArgs& args)
+{
+    const std::string input = args.Get("in");
+    const std::string output = args.Get("out");
+    if (input.empty() || output.empty())
+        throw std::runtime_error("--in and --out are required");
+
+    FrameFormat rawFormat;
+    args.GetSize("size", rawFormat.width, rawFormat.height);
+    rawFormat.rateNumerator = args.GetUInt("rate", 60);
+
+    auto source = OpenFrameSource(input, FrameFileFormatFromPath(input), rawFormat);
+    const FrameFormat& inFormat = source->Format();
+
+    // Same resFactor semantics as the viewer.
+    const double scale = args.GetNumber("scale", 1.0);
+    FrameFormat outFormat = inFormat;
+    outFormat.width = static_cast<uint32_t>(inFormat.width / scale);
+    outFormat.height = static_cast<uint32_t>(inFormat.height / scale);
+    outFormat.rateNumerator = inFormat.rateNumerator * 2;
+    auto sink = CreateFrameSink(output, FrameFileFormatFromPath(output), outFormat);
+
+    CpuInterpolatorSettings settings;
+    settings.threads = args.GetUInt("threads", 1);
+    settings.blockSize = args.GetUInt("block", settings.blockSize);
+    if (args.Has("scalar"))
+        settings.tier = SimdTier::Scalar;
+    CpuFrameInterpolator interpolator(settings);
+
+    Resampler<Rgba8Pixel> resampler;
+    resampler.Configure(inFormat.width, inFormat.height, outFormat.width, outFormat.height, args.GetFilter("filter", ScaleFilter::Bilinear));
+    const bool scaling = outFormat.width != inFormat.width || outFormat.height != inFormat.height;
+
+    Image sourceFrame(inFormat.width, inFormat.height, 4);
+    Image scaledFrame(outFormat.width, outFormat.height, 4);
+    Image interpolated(outFormat.width, outFormat.height, 4);
+
+    const uint32_t maxFrames = args.GetUInt("frames", UINT32_MAX);
+    double stageSeconds[StageCount] = {};
+    uint64_t framesIn = 0;
+    uint64_t framesOut = 0;
+    uint64_t repeats = 0;
+    const double frameInterval = 1.0 / inFormat.FramesPerSecond();
+    const auto start = Clock::now();
+
+    for (; framesIn < maxFrames; framesIn++)
+    {
+        {
+            StageTimer timer(stageSeconds[StageRead]);
+            if (!source->Read(sourceFrame.View()))
+                break;
+        }
+
+        ImageView frame = sourceFrame.View();
+        if (scaling)
+        {
+            StageTimer timer(stageSeconds[StageScale]);
+            resampler.Process(sourceFrame.View(), scaledFrame.View(), settings.tier);
+            frame = scaledFrame.View();
+        }
+
+        bool repeated = false;
+        {
+            StageTimer timer(stageSeconds[StageInterpolate]);
+            interpolator.Process(frame, double(framesIn) * frameInterval, interpolated.View(), &repeated);
+        }
+
+        // Presentation order: the midpoint between the previous frame and this one, then this one.
+        StageTimer timer(stageSeconds[StageWrite]);
+        if (!repeated)
+        {
+            sink->Write(interpolated.View());
+            framesOut++;
+        }
+        else
+        {
+            repeats++;
+        }
+        sink->Write(frame);
+        framesOut++;
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    fprintf(stderr, "transcode: %llu frames in, %llu frames out (%llu repeats) in %.3f s\n",
+        static_cast<unsigned long long>(framesIn), static_cast<unsigned long long>(framesOut),
+        static_cast<unsigned long long>(repeats), seconds);
+    fprintf(stderr, "transcode: %.1f input fps, %.1f output fps, %s backend, %u threads, %s\n",
+        framesIn / seconds, framesOut / seconds, interpolator.Name(), settings.threads, SimdTierName(settings.tier));
+    for (int stage = 0; stage < StageCount; stage++)
+    {
+        fprintf(stderr, "transcode: %-12s %8.3f ms/frame\n", c_StageNames[stage],
+            framesIn == 0 ? 0.0 : 1000.0 * stageSeconds[stage] / framesIn);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+//
+// WorkerPool.cpp - Persistent threads that split row ranges between them
+//
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+WorkerPool::WorkerPool(uint32_t threads)
+{
+    m_threads.reserve(threads);
+    for (uint32_t i = 0; i < threads; i++)
+        m_threads.emplace_back([this] { WorkerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+WorkerPool& WorkerPool::Shared()
+{
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void WorkerPool::ParallelFor(uint32_t rows, uint32_t parts, const RowWork& work)
+{
+    parts = std::min(parts, rows);
+    if (parts <= 1 || m_threads.empty())
+    {
+        if (rows != 0)
+            work(0u, rows);
+        return;
+    }
+
+    Batch batch;
+    batch.work = &work;
+    batch.rows = rows;
+    batch.chunk = (rows + parts - 1) / parts;
+    batch.parts = (rows + batch.chunk - 1) / batch.chunk;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches.push_back(&batch);
+    }
+    m_wake.notify_all();
+
+    // Take chunks alongside the workers, then wait for the ones they took. The batch lives on this
+    // stack, so no worker may still be inside it on return.
+    RunChunks(batch);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto queued = std::find(m_batches.begin(), m_batches.end(), &batch);
+    if (queued != m_batches.end())
+        m_batches.erase(queued);
+    m_done.wait(lock, [&batch] { return batch.users == 0 && batch.done.load(std::memory_order_acquire) == batch.parts; });
+}
+
+void WorkerPool::RunChunks(Batch& batch)
+{
+    for (uint32_t part = batch.next.fetch_add(1, std::memory_order_relaxed); part < batch.parts; part = batch.next.fetch_add(1, std::memory_order_relaxed))
+    {
+        const uint32_t first = part * batch.chunk;
+        (*batch.work)(first, std::min(batch.rows, first + batch.chunk));
+        batch.done.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void WorkerPool::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_stopping || !m_batches.empty(); });
+        if (m_stopping)
+            return;
+
+        Batch* batch = m_batches.front();
+        batch->users++;
+        lock.unlock();
+        RunChunks(*batch);
+        lock.lock();
+
+        // Every chunk is taken, so nobody else needs to find the batch.
+        batch->users--;
+        const auto queued = std::find(m_batches.begin(), m_batches.end(), batch);
+        if (queued != m_batches.end())
+            m_batches.erase(queued);
+        m_done.notify_all();
+    }
+}
@@ -0,0 +1,65 @@
+//
+// WorkerPool.h - Persistent threads that split row ranges between them
+//
+// Every CpuFrameInterpolator hands its rows to the one shared pool, so a frame costs a wake-up of
+// threads that already exist rather than creating and joining them, and several outputs don't each
+// start their own. The calling thread takes chunks too, so a pool of N threads runs N + 1 at once.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    class WorkerPool
+    {
+    public:
+        using RowWork = std::function<void(uint32_t first, uint32_t last)>;
+
+        explicit WorkerPool(uint32_t threads);
+        ~WorkerPool();
+
+        WorkerPool(WorkerPool const&) = delete;
+        WorkerPool& operator= (WorkerPool const&) = delete;
+
+        // One thread per hardware thread besides the caller, started on first use.
+        static WorkerPool& Shared();
+
+        // Run work over [0, rows) in up to parts contiguous chunks and return once every chunk is done.
+        // Safe to call from several threads at once; their chunks share the workers.
+        void ParallelFor(uint32_t rows, uint32_t parts, const RowWork& work);
+
+        // Threads that can run chunks at once, the caller included.
+        uint32_t Concurrency() const noexcept { return static_cast<uint32_t>(m_threads.size()) + 1; }
+
+    private:
+        struct Batch
+        {
+            const RowWork*          work = nullptr;
+            uint32_t                rows = 0;
+            uint32_t                chunk = 0;
+            uint32_t                parts = 0;
+            std::atomic<uint32_t>   next{ 0 };
+            std::atomic<uint32_t>   done{ 0 };
+            uint32_t                users = 0;      // Workers inside RunChunks; guarded by m_mutex.
+        };
+
+        static void RunChunks(Batch& batch);
+        void WorkerLoop();
+
+        std::vector<std::thread>    m_threads;
+        std::mutex                  m_mutex;
+        std::condition_variable     m_wake;         // Workers: a batch was queued, or the pool is stopping.
+        std::condition_variable     m_done;         // Callers: a worker left a batch.
+        std::deque<Batch*>          m_batches;
+        bool                        m_stopping = false;
+    };
+}